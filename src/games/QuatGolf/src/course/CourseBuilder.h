@@ -12,59 +12,173 @@
  *   - Water hazard (flat, low area)
  *   - Pin marker position
  *
- * Also generates gentle rolling hills for the base terrain.
+ * Every feature is a signed-distance test evaluated per vertex, so a hole
+ * is stamped in one parallel pass over its bounding box (one terrain
+ * edit) instead of overlapping brush strokes. The fairway is the exact
+ * distance field of the circles swept along its polyline, with the width
+ * interpolated linearly between control points.
+ *
+ * Also generates the base terrain: domain-warped fractal noise blended
+ * with ridged noise, evaluated in parallel row bands with the SIMD noise
+ * batches (see math/Noise.h).
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 #include "../terrain/Surface.h"
 #include "../terrain/Terrain.h"
 #include "Hole.h"
+#include "core/Parallel.h"
+#include "math/Noise.h"
 #include "math/Vec3.h"
 
 namespace qg {
 namespace course {
 
+/** Shape of the procedural base terrain (world units are metres). */
+struct BaseTerrainParams {
+  uint32_t seed = 1;
+  float amplitude = 1.6f;       // Peak height of the fBm field
+  float wavelength = 90.0f;     // Metres per cycle of the first octave
+  int octaves = 5;
+  float ridge_weight = 0.2f;    // 0 = pure fBm, 1 = pure ridged
+  float warp_strength = 25.0f;  // Domain warp displacement in metres
+};
+
 class CourseBuilder {
  public:
-  /** Generate base terrain with gentle rolling hills. */
-  static void generate_base(terrain::Terrain& t, int w, int d, float cs) {
-    std::vector<float> heights(w * d, 0.0f);
-    std::vector<terrain::SurfaceType> surfaces(w * d, terrain::SurfaceType::Rough);
-
-    // Gentle rolling hills using layered sine waves
-    for (int z = 0; z < d; ++z) {
-      for (int x = 0; x < w; ++x) {
-        float wx = static_cast<float>(x) / w;
-        float wz = static_cast<float>(z) / d;
-
-        float h = 0.0f;
-        // Large rolling hills
-        h += std::sin(wx * 3.14159f * 2) * 0.8f;
-        h += std::cos(wz * 3.14159f * 3) * 0.5f;
-        // Medium bumps
-        h += std::sin(wx * 7 + wz * 5) * 0.3f;
-        h += std::cos(wx * 11 - wz * 3) * 0.2f;
-        // Fine detail
-        h += std::sin(wx * 23 + wz * 17) * 0.05f;
-
-        heights[z * w + x] = h;
-      }
-    }
+  /** Generate base terrain (rough everywhere) from seeded fractal noise. */
+  static void generate_base(terrain::Terrain& t, int w, int d, float cs,
+                            const BaseTerrainParams& params = {}) {
+    std::vector<float> heights(static_cast<size_t>(w) * d, 0.0f);
+    std::vector<terrain::SurfaceType> surfaces(heights.size(), terrain::SurfaceType::Rough);
+
+    const qe::math::Noise noise(params.seed);
+    qe::math::FractalParams fractal;
+    fractal.octaves = params.octaves;
+    fractal.frequency = 1.0f / params.wavelength;
+
+    // Rows are independent: one band per worker, each with its own scratch
+    qe::core::parallel_for(
+        0, d,
+        [&](int z0, int z1) {
+          std::vector<float> xs(w), zs(w), ridge(w);
+          for (int x = 0; x < w; ++x)
+            xs[x] = (x - w / 2.0f) * cs;
+          for (int z = z0; z < z1; ++z) {
+            std::fill(zs.begin(), zs.end(), (z - d / 2.0f) * cs);
+            float* row = &heights[static_cast<size_t>(z) * w];
+            noise.warped_batch(xs.data(), zs.data(), row, w, fractal, params.warp_strength);
+            if (params.ridge_weight > 0.0f)
+              noise.ridged_batch(xs.data(), zs.data(), ridge.data(), w, fractal);
+            for (int x = 0; x < w; ++x) {
+              float r = params.ridge_weight > 0.0f ? ridge[x] * 2.0f - 1.0f : 0.0f;
+              row[x] = params.amplitude * (row[x] + (r - row[x]) * params.ridge_weight);
+            }
+          }
+        },
+        16);
 
     t.set_data(w, d, cs, std::move(heights), std::move(surfaces));
   }
 
-  /** Stamp a hole onto the terrain. */
+  /**
+   * Stamp a hole onto the terrain.
+   *
+   * Features are layered per vertex in a fixed order — fairway and rough
+   * border, tee, green (+ slope), bunkers, water — so later ones win.
+   */
   static void stamp_hole(terrain::Terrain& t, const Hole& hole) {
-    stamp_fairway(t, hole);
-    stamp_tee(t, hole.tee);
-    stamp_green(t, hole.green);
-    for (const auto& b : hole.bunkers)
-      stamp_bunker(t, b);
-    if (hole.has_water)
-      stamp_water(t, hole.water_center, hole.water_radius);
+    terrain::GridRect region = hole_rect(t, hole);
+    if (region.clamped(t.width, t.depth).empty())
+      return;
+    auto e = t.edit(region);
+    const terrain::GridRect r = e.rect();
+
+    const GreenDef& green = hole.green;
+    float slope_rad = green.slope_angle * 3.14159f / 180.0f;
+    float slope_dx = 0.0f, slope_dz = 0.0f;
+    if (green.slope_angle > 0.01f) {
+      slope_dx = std::cos(green.slope_dir) * std::tan(slope_rad);
+      slope_dz = std::sin(green.slope_dir) * std::tan(slope_rad);
+    }
+    const float tee_radius = std::max(hole.tee.width, hole.tee.depth);
+
+    // Rows are independent and write disjoint vertices of the edit
+    qe::core::parallel_for(
+        r.z0, r.z1 + 1,
+        [&](int z0, int z1) {
+          for (int z = z0; z < z1; ++z) {
+            for (int x = r.x0; x <= r.x1; ++x) {
+              float wx = (x - t.width / 2.0f) * t.cell_size;
+              float wz = (z - t.depth / 2.0f) * t.cell_size;
+              float h = e.height(x, z);
+              terrain::SurfaceType s = e.surface(x, z);
+
+              // Fairway, with a shallow dip, inside a rough border
+              float fd = fairway_distance(hole, wx, wz);
+              if (fd <= 0.0f) {
+                s = terrain::SurfaceType::Fairway;
+                h -= kFairwayDip * std::min(-fd / kFairwayDipRamp, 1.0f);
+              } else if (fd <= kRoughBorder) {
+                s = terrain::SurfaceType::Rough;
+              }
+
+              float d = distance_2d(wx, wz, hole.tee.position);
+              if (d <= tee_radius) {
+                s = terrain::SurfaceType::Tee;
+                h = flatten(h, d, tee_radius, 0.1f);
+              }
+
+              float gdx = wx - green.center.x, gdz = wz - green.center.z;
+              d = std::sqrt(gdx * gdx + gdz * gdz);
+              if (d <= green.radius) {
+                s = terrain::SurfaceType::Green;
+                h += gdx * slope_dx + gdz * slope_dz;
+              }
+
+              for (const auto& b : hole.bunkers) {
+                d = distance_2d(wx, wz, b.center);
+                if (d <= b.radius) {
+                  s = terrain::SurfaceType::Sand;
+                  h = flatten(h, d, b.radius, -b.depth);
+                }
+              }
+
+              if (hole.has_water) {
+                d = distance_2d(wx, wz, hole.water_center);
+                if (d <= hole.water_radius) {
+                  s = terrain::SurfaceType::Water;
+                  h = flatten(h, d, hole.water_radius, -0.5f);
+                }
+              }
+
+              e.set_height(x, z, h);
+              e.set_surface(x, z, s);
+            }
+          }
+        },
+        16);
+  }
+
+  /**
+   * Signed distance (metres, negative inside) from a world XZ point to the
+   * fairway: the union of circles swept along the control polyline with
+   * linearly interpolated width. +infinity for fewer than two points.
+   */
+  static float fairway_distance(const Hole& hole, float wx, float wz) {
+    float best = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i + 1 < hole.fairway.size(); ++i) {
+      const auto& p0 = hole.fairway[i];
+      const auto& p1 = hole.fairway[i + 1];
+      best = std::min(best, tapered_capsule_distance(wx, wz, p0.position, p0.width * 0.5f,
+                                                     p1.position, p1.width * 0.5f));
+    }
+    return best;
   }
 
   /** Build a default 3-hole course for testing. */
@@ -127,194 +241,80 @@ class CourseBuilder {
   }
 
  private:
+  static constexpr float kRoughBorder = 5.0f;     // Rough ring outside the fairway (m)
+  static constexpr float kFairwayDip = 0.05f;     // Fairway sits this far below the rough
+  static constexpr float kFairwayDipRamp = 2.0f;  // ... reached this far inside the edge
+
   /** Grid coordinates from world position. */
   static void world_to_grid(const terrain::Terrain& t, float wx, float wz, int& gx, int& gz) {
     gx = static_cast<int>(wx / t.cell_size + t.width / 2.0f);
     gz = static_cast<int>(wz / t.cell_size + t.depth / 2.0f);
   }
 
-  /** Paint a circular patch of surface type. */
-  static void paint_circle(terrain::Terrain& t, std::vector<terrain::SurfaceType>& surfaces,
-                           std::vector<float>& heights, float cx, float cz, float radius,
-                           terrain::SurfaceType surface, float height_offset = 0.0f,
-                           bool flatten = false) {
-    int gx0, gz0;
-    world_to_grid(t, cx - radius, cz - radius, gx0, gz0);
-    int gx1, gz1;
-    world_to_grid(t, cx + radius, cz + radius, gx1, gz1);
-
-    gx0 = std::max(0, gx0);
-    gz0 = std::max(0, gz0);
-    gx1 = std::min(t.width - 1, gx1);
-    gz1 = std::min(t.depth - 1, gz1);
-
-    for (int z = gz0; z <= gz1; ++z) {
-      for (int x = gx0; x <= gx1; ++x) {
-        float wx = (x - t.width / 2.0f) * t.cell_size;
-        float wz = (z - t.depth / 2.0f) * t.cell_size;
-        float dx = wx - cx;
-        float dz = wz - cz;
-        float dist = std::sqrt(dx * dx + dz * dz);
-
-        if (dist <= radius) {
-          int idx = z * t.width + x;
-          surfaces[idx] = surface;
-          if (flatten) {
-            // Smooth transition
-            float blend = dist / radius;
-            float target = t.height_at(x, z) + height_offset;
-            heights[idx] = heights[idx] * blend + target * (1 - blend) + height_offset;
-          } else if (height_offset != 0.0f) {
-            float blend = 1.0f - (dist / radius);
-            heights[idx] += height_offset * blend;
-          }
-        }
-      }
-    }
+  /** Vertex rectangle covering a world-space circle. */
+  static terrain::GridRect circle_rect(const terrain::Terrain& t, float cx, float cz,
+                                       float radius) {
+    terrain::GridRect r;
+    world_to_grid(t, cx - radius, cz - radius, r.x0, r.z0);
+    world_to_grid(t, cx + radius, cz + radius, r.x1, r.z1);
+    return r;
   }
 
-  /** Stamp fairway strip following control points. */
-  static void stamp_fairway(terrain::Terrain& t, const Hole& hole) {
-    auto& heights = const_cast<std::vector<float>&>(*reinterpret_cast<const std::vector<float>*>(
-        reinterpret_cast<const char*>(&t) + sizeof(int) * 2 + sizeof(float) +
-        sizeof(qe::renderer::Mesh)));
-    // NOTE: This is hacky — we need Terrain to expose mutable access.
-    // For now use a simpler approach: rebuild after stamping.
-
-    // Get mutable data (we'll rebuild the mesh after)
-    std::vector<float> h(t.width * t.depth);
-    std::vector<terrain::SurfaceType> s(t.width * t.depth);
-
-    for (int z = 0; z < t.depth; ++z) {
-      for (int x = 0; x < t.width; ++x) {
-        h[z * t.width + x] = t.height_at(x, z);
-        s[z * t.width + x] = t.surface_at(x, z);
-      }
-    }
-
-    // Paint fairway along control points
-    for (size_t i = 0; i + 1 < hole.fairway.size(); ++i) {
-      auto& p0 = hole.fairway[i];
-      auto& p1 = hole.fairway[i + 1];
-      float len = p0.position.distance_to(p1.position);
-      int steps = static_cast<int>(len / 0.5f) + 1;
-
-      for (int s_idx = 0; s_idx <= steps; ++s_idx) {
-        float t_val = static_cast<float>(s_idx) / steps;
-        auto pos = p0.position.lerp(p1.position, t_val);
-        float width = p0.width + (p1.width - p0.width) * t_val;
-
-        // Paint fairway
-        paint_circle(t, s, h, pos.x, pos.z, width * 0.5f, terrain::SurfaceType::Fairway, -0.05f,
-                     false);
-        // Paint rough border
-        paint_circle(t, s, h, pos.x, pos.z, width * 0.5f + 5.0f, terrain::SurfaceType::Rough, 0,
-                     false);
-      }
-    }
-
-    // Repaint fairway over rough (rough was painted with bigger radius)
-    for (size_t i = 0; i + 1 < hole.fairway.size(); ++i) {
-      auto& p0 = hole.fairway[i];
-      auto& p1 = hole.fairway[i + 1];
-      float len = p0.position.distance_to(p1.position);
-      int steps = static_cast<int>(len / 0.5f) + 1;
-
-      for (int s_idx = 0; s_idx <= steps; ++s_idx) {
-        float t_val = static_cast<float>(s_idx) / steps;
-        auto pos = p0.position.lerp(p1.position, t_val);
-        float width = p0.width + (p1.width - p0.width) * t_val;
-
-        paint_circle(t, s, h, pos.x, pos.z, width * 0.5f, terrain::SurfaceType::Fairway, 0, false);
-      }
+  /** Vertices any feature of the hole can touch. */
+  static terrain::GridRect hole_rect(const terrain::Terrain& t, const Hole& hole) {
+    terrain::GridRect r;
+    if (hole.fairway.size() >= 2) {
+      for (const auto& p : hole.fairway)
+        r = r.united(circle_rect(t, p.position.x, p.position.z, p.width * 0.5f + kRoughBorder));
     }
-
-    t.set_data(t.width, t.depth, t.cell_size, std::move(h), std::move(s));
-  }
-
-  static void stamp_tee(terrain::Terrain& t, const TeeDef& tee) {
-    std::vector<float> h(t.width * t.depth);
-    std::vector<terrain::SurfaceType> s(t.width * t.depth);
-    for (int z = 0; z < t.depth; ++z)
-      for (int x = 0; x < t.width; ++x) {
-        h[z * t.width + x] = t.height_at(x, z);
-        s[z * t.width + x] = t.surface_at(x, z);
-      }
-
-    paint_circle(t, s, h, tee.position.x, tee.position.z, std::max(tee.width, tee.depth),
-                 terrain::SurfaceType::Tee, 0.1f, true);
-
-    t.set_data(t.width, t.depth, t.cell_size, std::move(h), std::move(s));
+    r = r.united(circle_rect(t, hole.tee.position.x, hole.tee.position.z,
+                             std::max(hole.tee.width, hole.tee.depth)));
+    r = r.united(circle_rect(t, hole.green.center.x, hole.green.center.z, hole.green.radius));
+    for (const auto& b : hole.bunkers)
+      r = r.united(circle_rect(t, b.center.x, b.center.z, b.radius));
+    if (hole.has_water)
+      r = r.united(circle_rect(t, hole.water_center.x, hole.water_center.z, hole.water_radius));
+    return r;
   }
 
-  static void stamp_green(terrain::Terrain& t, const GreenDef& green) {
-    std::vector<float> h(t.width * t.depth);
-    std::vector<terrain::SurfaceType> s(t.width * t.depth);
-    for (int z = 0; z < t.depth; ++z)
-      for (int x = 0; x < t.width; ++x) {
-        h[z * t.width + x] = t.height_at(x, z);
-        s[z * t.width + x] = t.surface_at(x, z);
-      }
-
-    // Green surface — slightly flattened with gentle slope
-    paint_circle(t, s, h, green.center.x, green.center.z, green.radius, terrain::SurfaceType::Green,
-                 0, true);
-
-    // Add slope if nonzero
-    if (green.slope_angle > 0.01f) {
-      int gx0, gz0, gx1, gz1;
-      world_to_grid(t, green.center.x - green.radius, green.center.z - green.radius, gx0, gz0);
-      world_to_grid(t, green.center.x + green.radius, green.center.z + green.radius, gx1, gz1);
-      gx0 = std::max(0, gx0);
-      gz0 = std::max(0, gz0);
-      gx1 = std::min(t.width - 1, gx1);
-      gz1 = std::min(t.depth - 1, gz1);
-
-      float slope_rad = green.slope_angle * 3.14159f / 180.0f;
-      float slope_dx = std::cos(green.slope_dir) * std::tan(slope_rad);
-      float slope_dz = std::sin(green.slope_dir) * std::tan(slope_rad);
-
-      for (int z = gz0; z <= gz1; ++z)
-        for (int x = gx0; x <= gx1; ++x) {
-          float wx = (x - t.width / 2.0f) * t.cell_size - green.center.x;
-          float wz = (z - t.depth / 2.0f) * t.cell_size - green.center.z;
-          float dist = std::sqrt(wx * wx + wz * wz);
-          if (dist <= green.radius) {
-            h[z * t.width + x] += wx * slope_dx + wz * slope_dz;
-          }
-        }
-    }
-
-    t.set_data(t.width, t.depth, t.cell_size, std::move(h), std::move(s));
+  static float distance_2d(float wx, float wz, const qe::math::Vec3& c) {
+    float dx = wx - c.x, dz = wz - c.z;
+    return std::sqrt(dx * dx + dz * dz);
   }
 
-  static void stamp_bunker(terrain::Terrain& t, const Bunker& bunker) {
-    std::vector<float> h(t.width * t.depth);
-    std::vector<terrain::SurfaceType> s(t.width * t.depth);
-    for (int z = 0; z < t.depth; ++z)
-      for (int x = 0; x < t.width; ++x) {
-        h[z * t.width + x] = t.height_at(x, z);
-        s[z * t.width + x] = t.surface_at(x, z);
-      }
-
-    paint_circle(t, s, h, bunker.center.x, bunker.center.z, bunker.radius,
-                 terrain::SurfaceType::Sand, -bunker.depth, true);
-
-    t.set_data(t.width, t.depth, t.cell_size, std::move(h), std::move(s));
+  /** Blend toward h + offset at the centre, fading out at the rim. */
+  static float flatten(float h, float dist, float radius, float offset) {
+    float blend = dist / radius;
+    float target = h + offset;
+    return h * blend + target * (1 - blend) + offset;
   }
 
-  static void stamp_water(terrain::Terrain& t, qe::math::Vec3 center, float radius) {
-    std::vector<float> h(t.width * t.depth);
-    std::vector<terrain::SurfaceType> s(t.width * t.depth);
-    for (int z = 0; z < t.depth; ++z)
-      for (int x = 0; x < t.width; ++x) {
-        h[z * t.width + x] = t.height_at(x, z);
-        s[z * t.width + x] = t.surface_at(x, z);
-      }
-
-    paint_circle(t, s, h, center.x, center.z, radius, terrain::SurfaceType::Water, -0.5f, true);
-
-    t.set_data(t.width, t.depth, t.cell_size, std::move(h), std::move(s));
+  /**
+   * Signed distance to the convex hull of circle (a, ra) and circle (b, rb)
+   * in XZ — the area swept by a circle moving and growing linearly from
+   * one to the other.
+   */
+  static float tapered_capsule_distance(float wx, float wz, const qe::math::Vec3& a, float ra,
+                                        const qe::math::Vec3& b, float rb) {
+    float ax = b.x - a.x, az = b.z - a.z;
+    float len = std::sqrt(ax * ax + az * az);
+    float px = wx - a.x, pz = wz - a.z;
+    float da = std::sqrt(px * px + pz * pz) - ra;
+    float db = distance_2d(wx, wz, b) - rb;
+    float slope = (ra - rb) / std::max(len, 1e-6f);
+    if (slope * slope >= 1.0f)  // One circle contains the other
+      return std::min(da, db);
+
+    // Segment frame: u along a→b, v perpendicular (mirror-symmetric)
+    float u = (px * ax + pz * az) / len;
+    float v = std::abs(px * az - pz * ax) / len;
+    float cosa = std::sqrt(1.0f - slope * slope);
+    float k = v * -slope + u * cosa;
+    if (k < 0.0f)
+      return da;
+    if (k > cosa * len)
+      return db;
+    return v * cosa + u * slope - ra;
   }
 };
 
@@ -0,0 +1,401 @@
+#pragma once
+/**
+ * @file CourseFile.h
+ * @brief Versioned binary course file: holes, final terrain, baked mesh/nav.
+ *
+ * Layout (little-endian, every section 16-byte aligned):
+ *
+ *   Header   "QGCF", version, section count, grid width/depth, cell size
+ *   Table    { id, offset, size } per section
+ *   Holes    hole definitions (tee, green, fairway points, bunkers, water)
+ *   Heights  float[width * depth]
+ *   Surfaces uint8[width * depth]
+ *   Mesh     Vertex[width * depth]                       (optional)
+ *   Nav      width, depth, scale, uint8 walkable[w * d]  (optional)
+ *
+ * The file is memory-mapped; heights and the baked mesh are read straight
+ * out of the mapping, so loading costs a copy into Terrain plus one GPU
+ * upload instead of generate → stamp → build_mesh. Indices are not stored:
+ * Terrain regenerates its small 16-bit band pattern on upload.
+ *
+ * Design by Contract:
+ *   - Precondition: write() is given a terrain with width, depth >= 2
+ *   - Postcondition: open() == true  ⇒  every section lies inside the file
+ *     and matches the header's grid size
+ *   - Errors are reported to std::cerr; callers fall back to generation
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../terrain/Terrain.h"
+#include "Hole.h"
+#include "ai/NavigationSystem.h"
+#include "core/MappedFile.h"
+#include "renderer/Mesh.h"
+
+namespace qg {
+namespace course {
+
+struct CourseWriteOptions {
+  bool bake_mesh = true;                          // Store build_geometry() output
+  const qe::ai::NavigationSystem* nav = nullptr;  // Store walkability grid
+};
+
+class CourseFile {
+ public:
+  static constexpr uint32_t kVersion = 1;
+
+  enum SectionId : uint32_t {
+    kHoles = 1,
+    kHeights = 2,
+    kSurfaces = 3,
+    kMeshVertices = 4,
+    kNav = 5,
+  };
+
+  /** Serialize a finished course. */
+  static bool write(const std::string& path, const std::vector<Hole>& holes,
+                    const terrain::Terrain& t, const CourseWriteOptions& opts = {}) {
+    if (t.width < 2 || t.depth < 2) {
+      std::cerr << "CourseFile: terrain is empty" << std::endl;
+      return false;
+    }
+    const size_t n = static_cast<size_t>(t.width) * t.depth;
+
+    std::vector<Blob> sections;
+    {
+      Blob b{kHoles, {}};
+      write_holes(b.bytes, holes);
+      sections.push_back(std::move(b));
+    }
+    {
+      Blob b{kHeights, std::vector<uint8_t>(n * sizeof(float))};
+      auto* h = reinterpret_cast<float*>(b.bytes.data());
+      for (int z = 0; z < t.depth; ++z)
+        for (int x = 0; x < t.width; ++x)
+          h[static_cast<size_t>(z) * t.width + x] = t.height_at(x, z);
+      sections.push_back(std::move(b));
+    }
+    {
+      Blob b{kSurfaces, std::vector<uint8_t>(n)};
+      for (int z = 0; z < t.depth; ++z)
+        for (int x = 0; x < t.width; ++x)
+          b.bytes[static_cast<size_t>(z) * t.width + x] = static_cast<uint8_t>(t.surface_at(x, z));
+      sections.push_back(std::move(b));
+    }
+    if (opts.bake_mesh) {
+      std::vector<qe::renderer::Vertex> verts;
+      t.build_vertices(verts);
+      sections.push_back({kMeshVertices, to_bytes(verts)});
+    }
+    if (opts.nav && !opts.nav->nodes.empty()) {
+      Blob b{kNav, {}};
+      put(b.bytes, static_cast<int32_t>(opts.nav->width));
+      put(b.bytes, static_cast<int32_t>(opts.nav->depth));
+      put(b.bytes, opts.nav->scale);
+      for (const auto& node : opts.nav->nodes)
+        b.bytes.push_back(node.walkable ? 1 : 0);
+      sections.push_back(std::move(b));
+    }
+
+    // Header + table, then the aligned sections
+    std::vector<uint8_t> out;
+    Header hdr;
+    hdr.section_count = static_cast<uint32_t>(sections.size());
+    hdr.width = t.width;
+    hdr.depth = t.depth;
+    hdr.cell_size = t.cell_size;
+    put(out, hdr);
+    size_t offset = align(sizeof(Header) + sections.size() * sizeof(SectionEntry));
+    for (const auto& s : sections) {
+      put(out, SectionEntry{s.id, 0, offset, s.bytes.size()});
+      offset = align(offset + s.bytes.size());
+    }
+    for (const auto& s : sections) {
+      out.resize(align(out.size()), 0);
+      out.insert(out.end(), s.bytes.begin(), s.bytes.end());
+    }
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f || !f.write(reinterpret_cast<const char*>(out.data()),
+                       static_cast<std::streamsize>(out.size()))) {
+      std::cerr << "CourseFile: cannot write " << path << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /** Map and validate a course file (holes are decoded immediately). */
+  bool open(const std::string& path) {
+    holes_.clear();
+    sections_.clear();
+    if (!file_.open(path))
+      return false;  // Missing file is not an error: caller falls back
+
+    const uint8_t* base = file_.data();
+    size_t size = file_.size();
+    if (size < sizeof(Header))
+      return fail(path, "truncated header");
+    std::memcpy(&header_, base, sizeof(Header));
+    if (std::memcmp(header_.magic, "QGCF", 4) != 0)
+      return fail(path, "not a course file");
+    if (header_.version != kVersion)
+      return fail(path, "unsupported version " + std::to_string(header_.version));
+    if (header_.width < 2 || header_.depth < 2 || !(header_.cell_size > 0.0f))
+      return fail(path, "bad grid size");
+    if (sizeof(Header) + header_.section_count * sizeof(SectionEntry) > size)
+      return fail(path, "truncated section table");
+
+    sections_.resize(header_.section_count);
+    std::memcpy(sections_.data(), base + sizeof(Header),
+                sections_.size() * sizeof(SectionEntry));
+    for (const auto& s : sections_) {
+      if (s.offset > size || s.size > size - s.offset || s.offset % kAlign != 0)
+        return fail(path, "section out of bounds");
+    }
+
+    const size_t n = static_cast<size_t>(header_.width) * header_.depth;
+    const SectionEntry* heights = find(kHeights);
+    const SectionEntry* surfaces = find(kSurfaces);
+    if (!heights || heights->size != n * sizeof(float) || !surfaces || surfaces->size != n)
+      return fail(path, "missing or mis-sized terrain sections");
+    const SectionEntry* verts = find(kMeshVertices);
+    if (verts && verts->size != n * sizeof(qe::renderer::Vertex))
+      return fail(path, "mis-sized mesh section");
+
+    const SectionEntry* holes = find(kHoles);
+    if (!holes || !read_holes(base + holes->offset, holes->size, holes_))
+      return fail(path, "corrupt hole table");
+    return true;
+  }
+
+  int width() const noexcept {
+    return header_.width;
+  }
+  int depth() const noexcept {
+    return header_.depth;
+  }
+  float cell_size() const noexcept {
+    return header_.cell_size;
+  }
+  const std::vector<Hole>& holes() const noexcept {
+    return holes_;
+  }
+
+  /** Fill a terrain (in its current storage mode) from the file. */
+  void load_terrain(terrain::Terrain& t) const {
+    const size_t n = static_cast<size_t>(header_.width) * header_.depth;
+    const auto* h = reinterpret_cast<const float*>(section_data(kHeights));
+    const uint8_t* s = section_data(kSurfaces);
+    std::vector<float> heights(h, h + n);
+    std::vector<terrain::SurfaceType> surfaces(n);
+    for (size_t i = 0; i < n; ++i)
+      surfaces[i] = static_cast<terrain::SurfaceType>(
+          std::min<uint8_t>(s[i], static_cast<uint8_t>(terrain::SurfaceType::OutOfBounds)));
+    t.set_data(header_.width, header_.depth, header_.cell_size, std::move(heights),
+               std::move(surfaces));
+  }
+
+  bool has_mesh() const {
+    return find(kMeshVertices) != nullptr;
+  }
+
+  /**
+   * Upload the baked mesh straight from the mapping (needs a GL context).
+   * @pre has_mesh() and load_terrain(t) was called
+   */
+  void upload_mesh(terrain::Terrain& t) const {
+    const SectionEntry* v = find(kMeshVertices);
+    t.upload_mesh(reinterpret_cast<const qe::renderer::Vertex*>(section_data(kMeshVertices)),
+                  v->size / sizeof(qe::renderer::Vertex));
+  }
+
+  bool has_nav() const {
+    return find(kNav) != nullptr;
+  }
+
+  /** Rebuild a navigation grid from the stored walkability. */
+  bool load_nav(qe::ai::NavigationSystem& nav) const {
+    const SectionEntry* e = find(kNav);
+    if (!e)
+      return false;
+    const uint8_t* p = section_data(kNav);
+    int32_t w = 0, d = 0;
+    float scale = 0.0f;
+    size_t at = 0;
+    if (!get(p, e->size, at, w) || !get(p, e->size, at, d) || !get(p, e->size, at, scale) ||
+        w <= 0 || d <= 0 || e->size - at != static_cast<size_t>(w) * d)
+      return false;
+    nav.init(w, d, scale);
+    for (size_t i = 0; i < nav.nodes.size(); ++i)
+      nav.nodes[i].walkable = p[at + i] != 0;
+    return true;
+  }
+
+ private:
+  static constexpr size_t kAlign = 16;
+
+  struct Header {
+    char magic[4] = {'Q', 'G', 'C', 'F'};
+    uint32_t version = kVersion;
+    uint32_t section_count = 0;
+    int32_t width = 0;
+    int32_t depth = 0;
+    float cell_size = 1.0f;
+    uint32_t reserved[2] = {0, 0};
+  };
+  static_assert(sizeof(Header) == 32, "CourseFile header layout");
+
+  struct SectionEntry {
+    uint32_t id = 0;
+    uint32_t flags = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+  static_assert(sizeof(SectionEntry) == 24, "CourseFile section layout");
+
+  struct Blob {
+    uint32_t id;
+    std::vector<uint8_t> bytes;
+  };
+
+  qe::core::MappedFile file_;
+  Header header_;
+  std::vector<SectionEntry> sections_;
+  std::vector<Hole> holes_;
+
+  static size_t align(size_t v) {
+    return (v + kAlign - 1) & ~(kAlign - 1);
+  }
+
+  bool fail(const std::string& path, const std::string& why) {
+    std::cerr << "CourseFile: " << path << ": " << why << std::endl;
+    file_.close();
+    sections_.clear();
+    holes_.clear();
+    return false;
+  }
+
+  const SectionEntry* find(uint32_t id) const {
+    for (const auto& s : sections_)
+      if (s.id == id)
+        return &s;
+    return nullptr;
+  }
+
+  const uint8_t* section_data(uint32_t id) const {
+    const SectionEntry* s = find(id);
+    return s ? file_.data() + s->offset : nullptr;
+  }
+
+  // --- Plain little-endian encoding (host order on every supported target) ---
+
+  template <typename T>
+  static void put(std::vector<uint8_t>& out, const T& v) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+  }
+
+  template <typename T>
+  static bool get(const uint8_t* data, size_t size, size_t& at, T& v) {
+    if (size - at < sizeof(T) || at > size)
+      return false;
+    std::memcpy(&v, data + at, sizeof(T));
+    at += sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  static std::vector<uint8_t> to_bytes(const std::vector<T>& v) {
+    const auto* p = reinterpret_cast<const uint8_t*>(v.data());
+    return std::vector<uint8_t>(p, p + v.size() * sizeof(T));
+  }
+
+  static void put_vec3(std::vector<uint8_t>& out, const qe::math::Vec3& v) {
+    put(out, v.x);
+    put(out, v.y);
+    put(out, v.z);
+  }
+
+  static bool get_vec3(const uint8_t* d, size_t n, size_t& at, qe::math::Vec3& v) {
+    return get(d, n, at, v.x) && get(d, n, at, v.y) && get(d, n, at, v.z);
+  }
+
+  static void write_holes(std::vector<uint8_t>& out, const std::vector<Hole>& holes) {
+    put(out, static_cast<uint32_t>(holes.size()));
+    for (const auto& h : holes) {
+      put(out, static_cast<int32_t>(h.number));
+      put(out, static_cast<int32_t>(h.par));
+      put(out, h.yards);
+      put_vec3(out, h.tee.position);
+      put(out, h.tee.width);
+      put(out, h.tee.depth);
+      put_vec3(out, h.green.center);
+      put(out, h.green.radius);
+      put_vec3(out, h.green.pin);
+      put(out, h.green.slope_angle);
+      put(out, h.green.slope_dir);
+      put(out, static_cast<uint32_t>(h.fairway.size()));
+      for (const auto& p : h.fairway) {
+        put_vec3(out, p.position);
+        put(out, p.width);
+      }
+      put(out, static_cast<uint32_t>(h.bunkers.size()));
+      for (const auto& b : h.bunkers) {
+        put_vec3(out, b.center);
+        put(out, b.radius);
+        put(out, b.depth);
+      }
+      put(out, static_cast<uint32_t>(h.has_water ? 1 : 0));
+      put_vec3(out, h.water_center);
+      put(out, h.water_radius);
+    }
+  }
+
+  static bool read_holes(const uint8_t* d, size_t n, std::vector<Hole>& holes) {
+    size_t at = 0;
+    uint32_t count = 0;
+    if (!get(d, n, at, count))
+      return false;
+    for (uint32_t k = 0; k < count; ++k) {
+      Hole h;
+      int32_t number = 0, par = 0;
+      uint32_t fairway = 0, bunkers = 0, water = 0;
+      bool ok = get(d, n, at, number) && get(d, n, at, par) && get(d, n, at, h.yards) &&
+                get_vec3(d, n, at, h.tee.position) && get(d, n, at, h.tee.width) &&
+                get(d, n, at, h.tee.depth) && get_vec3(d, n, at, h.green.center) &&
+                get(d, n, at, h.green.radius) && get_vec3(d, n, at, h.green.pin) &&
+                get(d, n, at, h.green.slope_angle) && get(d, n, at, h.green.slope_dir) &&
+                get(d, n, at, fairway);
+      if (!ok || fairway > (n - at) / 16)
+        return false;
+      h.number = number;
+      h.par = par;
+      h.fairway.resize(fairway);
+      for (auto& p : h.fairway)
+        if (!get_vec3(d, n, at, p.position) || !get(d, n, at, p.width))
+          return false;
+      if (!get(d, n, at, bunkers) || bunkers > (n - at) / 20)
+        return false;
+      h.bunkers.resize(bunkers);
+      for (auto& b : h.bunkers)
+        if (!get_vec3(d, n, at, b.center) || !get(d, n, at, b.radius) || !get(d, n, at, b.depth))
+          return false;
+      if (!get(d, n, at, water) || !get_vec3(d, n, at, h.water_center) ||
+          !get(d, n, at, h.water_radius))
+        return false;
+      h.has_water = water != 0;
+      holes.push_back(std::move(h));
+    }
+    return at == n;
+  }
+};
+
+}  // namespace course
+}  // namespace qg
@@ -0,0 +1,382 @@
+#pragma once
+/**
+ * @file GolfSim.h
+ * @brief Gameplay state and rules of a QuatGolf round, free of SDL and GL.
+ *
+ * GolfSim owns everything that decides the outcome of a round: terrain,
+ * hole layouts, the ball and its physics, enemies and the scorecard. One
+ * step(dt) advances enemies and the ball, resolves enemy hits, water
+ * penalties and holing, and reports what happened as SimEvents. The game
+ * loop turns those events into console output, sound and particles; the
+ * headless runner (HeadlessRunner.h) just counts them.
+ *
+ * With the same course, shots and dt a round replays bit-identically: the
+ * step is single-threaded float math with no clocks or random numbers.
+ * save_state() / restore_state() capture everything step() reads or writes
+ * except the course itself, for rewind (game/Snapshot.h).
+ *
+ * The ball normally plays on `terrain`. Pointing `streamed` at an open
+ * StreamingTerrain plays it on paged tiles instead (the holes keep their
+ * positions); with_ground() hands callers whichever one is in use. Paging
+ * is the owner's job: the game feeds the ball and camera, the headless
+ * runner the ball.
+ *
+ * Once the ball has been waiting for a shot for sleep_delay seconds with no
+ * player input the sim falls asleep: enemies freeze and step() returns at
+ * once, so an unattended tee costs nothing. shoot() and setup_hole() wake
+ * it, as does apply_input() on every tick with input, so enemies keep
+ * moving while the player aims or charges.
+ *
+ * Design by Contract:
+ *   - Precondition: setup_hole() after the course is loaded or generated
+ *   - Invariant: current_hole indexes holes once a hole is set up
+ *   - Postcondition: a shot ends in at most max_shot_time simulated seconds
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "../course/CourseBuilder.h"
+#include "../course/CourseFile.h"
+#include "../course/Hole.h"
+#include "../physics/BallPhysics.h"
+#include "../terrain/StreamingTerrain.h"
+#include "../terrain/Terrain.h"
+#include "Club.h"
+#include "core/AllocTracker.h"
+#include "core/ByteStream.h"
+#include "core/Profiler.h"
+#include "game/EnemyManager.h"
+#include "input/InputFrame.h"
+#include "math/Vec3.h"
+
+namespace qg {
+namespace game {
+
+/** Everything one step() changed that the front end may want to report. */
+struct SimEvents {
+  int enemy_points = 0;         // Points from an enemy hit this step
+  bool water = false;           // Penalty stroke taken, ball back on the tee
+  int holed = -1;               // Index of the hole finished this step, or -1
+  int hole_strokes = 0;         // Strokes recorded for that hole
+  bool picked_up = false;       // Hole ended at max_strokes rather than holed
+  bool round_complete = false;  // Last hole finished; scorecard reset
+  int round_strokes = 0;        // Total strokes of the completed round
+};
+
+class GolfSim {
+ public:
+  terrain::Terrain terrain;
+  terrain::StreamingTerrain* streamed = nullptr;  // Plays on these tiles instead when set
+  std::vector<course::Hole> holes;
+  physics::BallPhysics physics;
+  physics::BallState ball;
+  qe::game::EnemyManager enemies;
+
+  int current_hole = 0;
+  bool ball_in_play = false;
+  int stroke_count = 0;
+  int total_score = 0;      // Game score (points)
+  std::vector<int> scores;  // Per-hole stroke count
+
+  float hole_radius = 0.3f;     // Stopping this close to the pin (in plan) holes out
+  int max_strokes = 0;          // Pick up at this many strokes (0 = never)
+  float max_shot_time = 60.0f;  // Simulated seconds before a shot is stopped
+  float sleep_delay = 2.0f;     // Seconds at rest before sleeping (<= 0 = never)
+
+  /** Generate the default course: noise terrain with every hole stamped. */
+  static void generate_course(terrain::Terrain& t, std::vector<course::Hole>& hs) {
+    course::CourseBuilder::generate_base(t, 256, 256, 1.0f);
+    hs = course::CourseBuilder::default_course();
+    for (auto& hole : hs)
+      course::CourseBuilder::stamp_hole(t, hole);
+  }
+
+  void generate() {
+    generate_course(terrain, holes);
+  }
+
+  /** fn(ground) with the ground the ball plays on: the streamed tiles if set, else terrain. */
+  template <typename Fn>
+  decltype(auto) with_ground(Fn&& fn) const {
+    if (streamed)
+      return fn(static_cast<const terrain::StreamingTerrain&>(*streamed));
+    return fn(terrain);
+  }
+
+  /** Take terrain and holes from an opened course file. */
+  void load(const course::CourseFile& file) {
+    holes = file.holes();
+    file.load_terrain(terrain);
+  }
+
+  /** Spawn the course's enemies; rigless proxies when no URDF was loaded. */
+  void spawn_enemies() {
+    const qe::math::Vec3 spots[] = {{2.0f, 0.0f, 2.0f}, {-2.0f, 0.0f, 3.0f}, {0.0f, 0.0f, 5.0f}};
+    const bool rigged = enemies.rigs.count("grunt") > 0;
+    for (const auto& p : spots) {
+      if (rigged)
+        enemies.spawn("grunt", p);
+      else
+        enemies.spawn_proxy(p);
+    }
+  }
+
+  /** Tee up on a hole. Out-of-range indices are ignored. */
+  void setup_hole(int hole_idx) {
+    if (hole_idx < 0 || hole_idx >= static_cast<int>(holes.size()))
+      return;
+    current_hole = hole_idx;
+    place_on_tee();
+    stroke_count = 0;
+    wake();
+  }
+
+  const course::Hole& hole() const {
+    return holes[current_hole];
+  }
+
+  /** True when the ball is at rest and waiting for the next shot. */
+  bool ready() const {
+    return ball.stopped && !ball_in_play;
+  }
+
+  /** True while nothing in the sim moves (see sleep_delay). */
+  bool asleep() const noexcept {
+    return asleep_;
+  }
+
+  /** Resume enemies and restart the idle countdown (shots, holes and player input). */
+  void wake() {
+    asleep_ = false;
+    idle_time_ = 0.0f;
+    enemies.wake_all();
+  }
+
+  /**
+   * The input of the tick about to step: any aim, charge or button keeps
+   * the sim awake. The game and replay playback both call it before step().
+   */
+  void apply_input(const qe::input::InputFrame& input) {
+    if (input.any())
+      wake();
+  }
+
+  /** Horizontal unit vector for a yaw (radians, 0 = -Z, positive toward +X). */
+  static qe::math::Vec3 yaw_dir(float yaw) {
+    return {std::sin(yaw), 0, -std::cos(yaw)};
+  }
+
+  /** Yaw (radians, 0 = -Z) that points from the ball at the pin. */
+  float pin_yaw() const {
+    auto aim = hole().green.pin - ball.position;
+    return std::atan2(aim.x, -aim.z);
+  }
+
+  /** Horizontal distance from the ball to the pin (pin.y is not on the ground). */
+  float distance_to_pin() const {
+    const auto& pin = hole().green.pin;
+    float dx = pin.x - ball.position.x, dz = pin.z - ball.position.z;
+    return std::sqrt(dx * dx + dz * dz);
+  }
+
+  /** Opening club for the hole: 5 Iron on short par 3s, else Driver. */
+  int tee_club() const {
+    return hole().par <= 3 && hole().yards < 200 ? 2 : 0;
+  }
+
+  /** Sum of par over the course. */
+  int course_par() const {
+    return std::accumulate(holes.begin(), holes.end(), 0,
+                           [](int sum, const course::Hole& h) { return sum + h.par; });
+  }
+
+  /** Hit the ball with CLUBS[club] along aim_yaw at power in [0, 1]. */
+  void shoot(int club, float aim_yaw, float power) {
+    const Club& c = CLUBS[std::clamp(club, 0, NUM_CLUBS - 1)];
+    shoot(club, aim_yaw, power, c.default_spin(yaw_dir(aim_yaw)));
+  }
+
+  /** As shoot(), with an explicit spin vector (rad/s) instead of the club default. */
+  void shoot(int club, float aim_yaw, float power, const qe::math::Vec3& spin) {
+    const Club& c = CLUBS[std::clamp(club, 0, NUM_CLUBS - 1)];
+    physics.launch(ball, c.launch_velocity(yaw_dir(aim_yaw), std::clamp(power, 0.0f, 1.0f)),
+                   spin);
+    ball_in_play = true;
+    shot_time_ = 0.0f;
+    stroke_count++;
+    wake();
+  }
+
+  /**
+   * Append the round state: enemies, ball, strokes, points and scorecard.
+   * Fixed-width fields in a fixed order, so consecutive saves XOR-delta well.
+   */
+  void save_state(qe::core::ByteWriter& out) const {
+    out.put_u32(static_cast<uint32_t>(holes.size()));
+    enemies.save_state(out);
+    out.put_u32(static_cast<uint32_t>(current_hole));
+    out.put_u8(static_cast<uint8_t>(ball.in_flight | ball.rolling << 1 | ball.stopped << 2 |
+                                    ball.in_water << 3 | ball_in_play << 4 | asleep_ << 5));
+    for (const auto* v : {&ball.position, &ball.velocity, &ball.spin}) {
+      out.put_f32(v->x);
+      out.put_f32(v->y);
+      out.put_f32(v->z);
+    }
+    out.put_f32(shot_time_);
+    out.put_f32(idle_time_);
+    out.put_u32(static_cast<uint32_t>(stroke_count));
+    out.put_u32(static_cast<uint32_t>(total_score));
+    out.put_u32(static_cast<uint32_t>(scores.size()));
+    for (int s : scores)
+      out.put_u32(static_cast<uint32_t>(s));
+  }
+
+  /**
+   * Step over a save_state() record, checking it fits this course and
+   * enemy set; false if it does not or is truncated.
+   */
+  bool skip_state(qe::core::ByteReader& in) const {
+    if (in.get_u32() != holes.size() || !in.ok() || !enemies.skip_state(in))
+      return false;
+    const uint32_t hole = in.get_u32();
+    in.skip(1 + 9 * 4 + 2 * 4 + 2 * 4);  // Flags, ball vectors, timers, strokes, points
+    const uint32_t n = in.get_u32();
+    return in.ok() && hole < holes.size() && in.skip(n * sizeof(uint32_t));
+  }
+
+  /**
+   * Inverse of save_state() on the same course and enemy set. The record is
+   * checked first (skip_state()), so on false nothing has changed: it was
+   * for another course or enemy set, or truncated.
+   */
+  bool restore_state(qe::core::ByteReader& in) {
+    qe::core::ByteReader probe = in;
+    if (!skip_state(probe))
+      return false;
+    in.get_u32();
+    enemies.restore_state(in);
+    current_hole = static_cast<int>(in.get_u32());
+    uint8_t flags = in.get_u8();
+    ball.in_flight = flags & 1;
+    ball.rolling = flags & 2;
+    ball.stopped = flags & 4;
+    ball.in_water = flags & 8;
+    ball_in_play = flags & 16;
+    asleep_ = flags & 32;
+    for (auto* v : {&ball.position, &ball.velocity, &ball.spin})
+      *v = {in.get_f32(), in.get_f32(), in.get_f32()};
+    shot_time_ = in.get_f32();
+    idle_time_ = in.get_f32();
+    stroke_count = static_cast<int>(in.get_u32());
+    total_score = static_cast<int>(in.get_u32());
+    scores.resize(in.get_u32());
+    for (int& s : scores)
+      s = static_cast<int>(in.get_u32());
+    return in.ok();
+  }
+
+  /** Advance enemies and the ball by dt and apply the rules. */
+  SimEvents step(float dt) {
+    SimEvents ev;
+    if (asleep_)
+      return ev;
+    QE_PROFILE_SCOPE("sim step");
+    QE_ALLOC_TAG(Sim);
+    enemies.update(dt, ball.position);
+    {
+      // Scoped here rather than in BallPhysics: caddie predictions step it thousands of times
+      QE_PROFILE_SCOPE("physics");
+      QE_ALLOC_TAG(Physics);
+      with_ground([&](const auto& ground) { physics.update(ball, ground, dt); });
+    }
+
+    if (ball_in_play && !ball.stopped) {
+      shot_time_ += dt;
+      if (shot_time_ >= max_shot_time)
+        stop_ball();
+    }
+
+    // Enemy collision
+    if (ball.in_flight || ball.rolling) {
+      qe::math::Vec3 normal;
+      int points = enemies.check_collision(ball.position, physics.constants.radius, normal);
+      float v_dot_n = ball.velocity.dot(normal);
+      // Only reflect if moving towards the enemy
+      if (points > 0 && v_dot_n < 0) {
+        ball.velocity = (ball.velocity - normal * (2.0f * v_dot_n)) * 0.7f;
+        total_score += points;
+        ev.enemy_points = points;
+      }
+    }
+
+    // Water — one stroke penalty, replay from the tee
+    if (ball.in_water) {
+      ev.water = true;
+      stroke_count++;
+      place_on_tee();
+      return ev;
+    }
+
+    if (ball.stopped && ball_in_play) {
+      ball_in_play = false;
+      bool holed = distance_to_pin() < hole_radius;
+      bool pick_up = !holed && max_strokes > 0 && stroke_count >= max_strokes;
+      if (holed || pick_up)
+        finish_hole(ev, pick_up);
+    }
+
+    if (ready() && sleep_delay > 0.0f) {
+      idle_time_ += dt;
+      if (idle_time_ >= sleep_delay) {
+        asleep_ = true;
+        enemies.sleep_all();
+      }
+    }
+    return ev;
+  }
+
+ private:
+  float shot_time_ = 0.0f;
+  float idle_time_ = 0.0f;  // Seconds ready() has held since the last wake()
+  bool asleep_ = false;
+
+  void place_on_tee() {
+    const auto& tee = hole().tee.position;
+    ball = physics::BallState{};
+    ball.position = tee;
+    ball.position.y =
+        with_ground([&](const auto& ground) { return ground.height_at_world(tee.x, tee.z); }) +
+        0.15f;
+    ball.stopped = true;
+    ball_in_play = false;
+  }
+
+  void stop_ball() {
+    ball.velocity = {0, 0, 0};
+    ball.in_flight = false;
+    ball.rolling = false;
+    ball.stopped = true;
+  }
+
+  void finish_hole(SimEvents& ev, bool picked_up) {
+    ev.holed = current_hole;
+    ev.hole_strokes = stroke_count;
+    ev.picked_up = picked_up;
+    scores.push_back(stroke_count);
+
+    if (current_hole + 1 < static_cast<int>(holes.size())) {
+      setup_hole(current_hole + 1);
+      return;
+    }
+    ev.round_complete = true;
+    ev.round_strokes = std::accumulate(scores.begin(), scores.end(), 0);
+    scores.clear();
+    setup_hole(0);
+  }
+};
+
+}  // namespace game
+}  // namespace qg
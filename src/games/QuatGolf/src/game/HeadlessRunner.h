@@ -0,0 +1,182 @@
+#pragma once
+/**
+ * @file HeadlessRunner.h
+ * @brief Play whole QuatGolf rounds with a fixed dt and no window.
+ *
+ * run_headless() tees up hole 1 and loops: whenever the ball is at rest it
+ * takes the next shot from the script (or the AutoCaddie), then steps the
+ * sim by the fixed dt until the requested number of rounds is complete.
+ * Nothing waits on a clock, so rounds run as fast as the CPU allows.
+ *
+ * When the sim plays on streamed tiles (GolfSim::streamed), the tiles
+ * around the ball are paged in, waiting for the loads, before every shot
+ * and step, so streamed runs are as reproducible as in-memory ones.
+ *
+ * Passing a ReplayWriter records the run; replay_headless() plays such a
+ * recording back through the same loop and reproduces its checksum.
+ *
+ * Runs are a pure function of (course, script, dt, max_strokes, seed).
+ * The result carries a checksum (FNV-1a over every shot and its starting
+ * lie, bit-exact floats, and every hole score). Two runs with the same
+ * inputs must agree on it, which makes the runner a regression oracle for
+ * physics and rules changes. Pin it per toolchain: FP contraction or
+ * -ffast-math legitimately change the low bits and with them the sum.
+ *
+ * The result also counts heap allocations made inside sim steps after the
+ * first round, which has sized every container; with core/AllocHooks.h
+ * linked in, a nonzero count means a steady-state step allocates.
+ *
+ * Design by Contract:
+ *   - Precondition: the sim has a course and at least one hole
+ *   - Precondition: dt > 0; max_strokes > 0 so every hole terminates
+ *   - Postcondition: result.rounds == config.rounds
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "GolfSim.h"
+#include "Replay.h"
+#include "ShotScript.h"
+#include "core/AllocTracker.h"
+#include "core/Contracts.h"
+
+namespace qg {
+namespace game {
+
+struct HeadlessConfig {
+  int rounds = 1;
+  float dt = 1.0f / 120.0f;  // Fixed simulation step (seconds)
+  int max_strokes = 10;      // Pick up at this many strokes
+  uint32_t seed = 1;         // AutoCaddie swing error
+};
+
+struct HeadlessResult {
+  int rounds = 0;  // Completed rounds
+  int shots = 0;
+  int penalties = 0;  // Water
+  int pickups = 0;    // Holes ended at max_strokes
+  int enemy_points = 0;
+  uint64_t sim_steps = 0;           // GolfSim::step() calls
+  uint64_t plan_steps = 0;          // Physics steps spent by the caddie
+  uint64_t steady_step_allocs = 0;  // Allocations inside steps after the first round
+  std::vector<int> round_strokes;
+  uint64_t checksum = 14695981039346656037ull;  // FNV-1a offset basis
+
+  void mix(const void* data, size_t n) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < n; ++i)
+      checksum = (checksum ^ p[i]) * 1099511628211ull;
+  }
+  void mix(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    mix(&bits, sizeof(bits));
+  }
+  void mix(int v) {
+    mix(&v, sizeof(v));
+  }
+
+  /** Fold a shot about to be launched from the sim's current lie. */
+  void mix_shot(const GolfSim& sim, int club, float aim_yaw, float power) {
+    mix(sim.ball.position.x);
+    mix(sim.ball.position.y);
+    mix(sim.ball.position.z);
+    mix(club);
+    mix(aim_yaw);
+    mix(power);
+    shots++;
+  }
+
+  /** Fold one step's events. */
+  void count(const SimEvents& ev) {
+    sim_steps++;
+    enemy_points += ev.enemy_points;
+    penalties += ev.water ? 1 : 0;
+    if (ev.holed >= 0) {
+      pickups += ev.picked_up ? 1 : 0;
+      mix(ev.holed);
+      mix(ev.hole_strokes);
+    }
+    if (ev.round_complete) {
+      round_strokes.push_back(ev.round_strokes);
+      rounds++;
+    }
+  }
+};
+
+/** Page in the streamed tiles around the ball, if the sim plays on any. */
+inline void page_ground(GolfSim& sim) {
+  if (sim.streamed)
+    sim.streamed->page_in(&sim.ball.position, 1);
+}
+
+inline HeadlessResult run_headless(GolfSim& sim, ShotScript& script, const HeadlessConfig& cfg,
+                                   ReplayWriter* recorder = nullptr) {
+  QE_REQUIRE(!sim.holes.empty(), "run_headless: no course loaded");
+  QE_REQUIRE(cfg.dt > 0.0f && cfg.max_strokes > 0, "run_headless: bad config");
+
+  HeadlessResult r;
+  AutoCaddie caddie(cfg.seed);
+  sim.max_strokes = cfg.max_strokes;
+  sim.scores.clear();
+  sim.setup_hole(0);
+  if (recorder)
+    recorder->begin(0, cfg.max_strokes);
+
+  ReplayTick tick;
+  tick.dt = cfg.dt;
+  while (r.rounds < cfg.rounds) {
+    tick.has_shot = false;
+    page_ground(sim);
+    if (sim.ready()) {
+      QE_PROFILE_SCOPE("caddie");
+      QE_ALLOC_TAG(Ai);
+      ShotPlan p = caddie.resolve(script.next(), sim, cfg.dt);
+      r.mix_shot(sim, p.club, p.aim_yaw, p.power);
+      tick.shot = record_shot(sim, p.club, p.aim_yaw, p.power);
+      tick.has_shot = true;
+      sim.shoot(p.club, p.aim_yaw, p.power);
+    }
+    if (recorder)
+      recorder->write(tick);
+    const bool steady = r.rounds > 0;
+    const uint64_t allocs = qe::core::AllocTracker::thread_allocs();
+    const SimEvents ev = sim.step(cfg.dt);
+    if (steady)
+      r.steady_step_allocs += qe::core::AllocTracker::thread_allocs() - allocs;
+    r.count(ev);
+  }
+  r.plan_steps = caddie.predicted_steps;
+  return r;
+}
+
+/**
+ * Play a recording back at full speed. The result (checksum included)
+ * matches the recorded run_headless() result; desyncs counts shots whose
+ * recorded lie disagreed with the sim.
+ */
+inline HeadlessResult replay_headless(GolfSim& sim, ReplayReader& replay, int* desyncs = nullptr) {
+  QE_REQUIRE(!sim.holes.empty(), "replay_headless: no course loaded");
+  HeadlessResult r;
+  sim.max_strokes = replay.max_strokes();
+  sim.scores.clear();
+  sim.setup_hole(replay.start_hole());
+
+  int bad = 0;
+  ReplayTick tick;
+  while (replay.next(tick, static_cast<int>(sim.holes.size()))) {
+    if (tick.has_shot)
+      r.mix_shot(sim, tick.shot.club, tick.shot.aim_yaw, tick.shot.power);
+    bad += apply_replay_events(sim, tick) ? 0 : 1;
+    page_ground(sim);
+    r.count(sim.step(tick.dt));
+  }
+  if (desyncs)
+    *desyncs = bad;
+  return r;
+}
+
+}  // namespace game
+}  // namespace qg
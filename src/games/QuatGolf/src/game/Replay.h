@@ -0,0 +1,344 @@
+#pragma once
+/**
+ * @file Replay.h
+ * @brief Compact per-tick input and shot recording with deterministic playback.
+ *
+ * A replay is the sequence of simulation ticks: the dt each tick advanced
+ * by, the resolved InputFrame, and the discrete events that fed the sim —
+ * a hole change or a shot launch (club, power, yaw, spin). GolfSim is a
+ * pure function of those, so playing the ticks back reproduces the round
+ * bit for bit, at real time or as fast as the CPU allows.
+ *
+ * Wire format (core/ByteStream.h varints; floats as IEEE bits):
+ *
+ *   "QGRP" u8 version  varint start_hole  varint max_strokes
+ *   record*: varint tag = flags | (repeat << 4)
+ *     kDt     svarint  dt bits - previous dt bits
+ *     kInput  u8 changed-field mask, then per changed axis
+ *             svarint(bits - previous bits); buttons: varint(xor previous)
+ *     kHole   varint hole index
+ *     kShot   varint club, f32 power, yaw, spin xyz, lie xyz
+ *   repeat = number of further ticks with the same dt and input and no
+ *   events, so a paused or fixed-dt stretch costs one record.
+ *
+ * The lie (ball position at launch) is redundant; playback compares it to
+ * the sim and counts desyncs instead of silently diverging.
+ *
+ * Design by Contract:
+ *   - Precondition: playback starts from the same course as the recording
+ *   - Postcondition: ReplayReader::next() yields the written ticks in order
+ *   - Postcondition: every tick next() yields has a club < NUM_CLUBS and a
+ *     hole < hole_count; a stream that breaks this is corrupt
+ *   - Errors are reported to std::cerr and returned as false
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "GolfSim.h"
+#include "core/ByteStream.h"
+#include "input/InputFrame.h"
+#include "math/Vec3.h"
+
+namespace qg {
+namespace game {
+
+struct ShotRecord {
+  int club = 0;
+  float power = 0.0f;
+  float aim_yaw = 0.0f;
+  qe::math::Vec3 spin;
+  qe::math::Vec3 lie;  // Ball position at launch (desync check)
+};
+
+struct ReplayTick {
+  float dt = 0.0f;
+  qe::input::InputFrame input;
+  int hole = -1;  // setup_hole() before this tick, -1 = none
+  bool has_shot = false;
+  ShotRecord shot;
+
+  bool has_events() const {
+    return hole >= 0 || has_shot;
+  }
+};
+
+namespace replay_detail {
+constexpr char kMagic[4] = {'Q', 'G', 'R', 'P'};
+constexpr uint8_t kVersion = 1;
+constexpr uint32_t kDt = 1, kInput = 2, kHole = 4, kShot = 8;  // Record flags
+constexpr int kFlagBits = 4;
+
+inline bool same_input(const qe::input::InputFrame& a, const qe::input::InputFrame& b) {
+  return std::memcmp(a.axes, b.axes, sizeof(a.axes)) == 0 && a.buttons == b.buttons;
+}
+}  // namespace replay_detail
+
+class ReplayWriter {
+ public:
+  /** Start a recording; the sim will be at start_hole with max_strokes. */
+  void begin(int start_hole, int max_strokes) {
+    out_.clear();
+    for (char c : replay_detail::kMagic)
+      out_.put_u8(static_cast<uint8_t>(c));
+    out_.put_u8(replay_detail::kVersion);
+    out_.put_varint(static_cast<uint64_t>(start_hole));
+    out_.put_varint(static_cast<uint64_t>(max_strokes));
+    prev_ = ReplayTick{};
+    has_pending_ = false;
+    ticks_ = 0;
+  }
+
+  /** Append one tick. */
+  void write(const ReplayTick& t) {
+    ++ticks_;
+    if (has_pending_ && !t.has_events() && repeat_ < kMaxRepeat &&
+        qe::core::float_bits(t.dt) == qe::core::float_bits(pending_.dt) &&
+        replay_detail::same_input(t.input, pending_.input)) {
+      ++repeat_;
+      return;
+    }
+    flush();
+    pending_ = t;
+    repeat_ = 0;
+    has_pending_ = true;
+  }
+
+  /** Encoded stream including every tick written so far. */
+  const std::vector<uint8_t>& data() {
+    flush();
+    return out_.data();
+  }
+
+  bool save(const std::string& path) {
+    const auto& bytes = data();
+    std::ofstream f(path, std::ios::binary);
+    if (!f || !f.write(reinterpret_cast<const char*>(bytes.data()),
+                       static_cast<std::streamsize>(bytes.size()))) {
+      std::cerr << "Replay: cannot write " << path << "\n";
+      return false;
+    }
+    return true;
+  }
+
+  uint64_t ticks() const noexcept {
+    return ticks_;
+  }
+
+ private:
+  static constexpr uint32_t kMaxRepeat = 1u << 20;
+
+  qe::core::ByteWriter out_;
+  ReplayTick prev_;     // Last encoded tick (delta base)
+  ReplayTick pending_;  // Not yet encoded; may still absorb repeats
+  uint32_t repeat_ = 0;
+  bool has_pending_ = false;
+  uint64_t ticks_ = 0;
+
+  void flush() {
+    using namespace replay_detail;
+    if (!has_pending_)
+      return;
+    has_pending_ = false;
+    const ReplayTick& t = pending_;
+
+    uint32_t dt_bits = qe::core::float_bits(t.dt), prev_dt = qe::core::float_bits(prev_.dt);
+    uint8_t mask = 0;
+    for (int i = 0; i < qe::input::InputFrame::kAxes; ++i)
+      if (qe::core::float_bits(t.input.axes[i]) != qe::core::float_bits(prev_.input.axes[i]))
+        mask |= 1u << i;
+    if (t.input.buttons != prev_.input.buttons)
+      mask |= 1u << qe::input::InputFrame::kAxes;
+
+    uint32_t flags = (dt_bits != prev_dt ? kDt : 0) | (mask ? kInput : 0) |
+                     (t.hole >= 0 ? kHole : 0) | (t.has_shot ? kShot : 0);
+    out_.put_varint(flags | (static_cast<uint64_t>(repeat_) << kFlagBits));
+
+    if (flags & kDt)
+      out_.put_svarint(static_cast<int64_t>(dt_bits) - prev_dt);
+    if (flags & kInput) {
+      out_.put_u8(mask);
+      for (int i = 0; i < qe::input::InputFrame::kAxes; ++i)
+        if (mask & (1u << i))
+          out_.put_svarint(static_cast<int64_t>(qe::core::float_bits(t.input.axes[i])) -
+                           qe::core::float_bits(prev_.input.axes[i]));
+      if (mask & (1u << qe::input::InputFrame::kAxes))
+        out_.put_varint(t.input.buttons ^ prev_.input.buttons);
+    }
+    if (flags & kHole)
+      out_.put_varint(static_cast<uint64_t>(t.hole));
+    if (flags & kShot) {
+      const ShotRecord& s = t.shot;
+      out_.put_varint(static_cast<uint64_t>(s.club));
+      for (float v : {s.power, s.aim_yaw, s.spin.x, s.spin.y, s.spin.z, s.lie.x, s.lie.y, s.lie.z})
+        out_.put_f32(v);
+    }
+    prev_ = t;
+  }
+};
+
+class ReplayReader {
+ public:
+  bool open(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+      std::cerr << "Replay: cannot open " << path << "\n";
+      return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(f)),
+                               std::istreambuf_iterator<char>());
+    return load(std::move(bytes));
+  }
+
+  bool load(std::vector<uint8_t> bytes) {
+    bytes_ = std::move(bytes);
+    in_ = qe::core::ByteReader(bytes_);
+    char magic[4];
+    if (!in_.get_bytes(magic, 4) || std::memcmp(magic, replay_detail::kMagic, 4) != 0 ||
+        in_.get_u8() != replay_detail::kVersion) {
+      std::cerr << "Replay: not a version " << static_cast<int>(replay_detail::kVersion)
+                << " replay\n";
+      return false;
+    }
+    start_hole_ = static_cast<int>(in_.get_varint());
+    max_strokes_ = static_cast<int>(in_.get_varint());
+    prev_ = ReplayTick{};
+    repeat_ = 0;
+    failed_ = false;
+    return in_.ok();
+  }
+
+  int start_hole() const noexcept {
+    return start_hole_;
+  }
+  int max_strokes() const noexcept {
+    return max_strokes_;
+  }
+
+  /** True once next() has met a truncated or corrupt stream. */
+  bool failed() const noexcept {
+    return failed_;
+  }
+
+  /**
+   * Decode the next tick; false at the end of the stream or on corruption
+   * (see failed()), including a hole index outside [0, hole_count) or a
+   * club outside CLUBS. The reader stays failed until the next load().
+   */
+  bool next(ReplayTick& t, int hole_count) {
+    using namespace replay_detail;
+    if (failed_)
+      return false;
+    if (repeat_ > 0) {
+      --repeat_;
+      t = prev_;
+      t.hole = -1;
+      t.has_shot = false;
+      return true;
+    }
+    if (in_.at_end())
+      return false;
+
+    uint64_t tag = in_.get_varint();
+    repeat_ = static_cast<uint32_t>(tag >> kFlagBits);
+    t = prev_;
+    t.hole = -1;
+    t.has_shot = false;
+
+    if (tag & kDt)
+      t.dt = qe::core::bits_float(
+          static_cast<uint32_t>(qe::core::float_bits(prev_.dt) + in_.get_svarint()));
+    if (tag & kInput) {
+      uint8_t mask = in_.get_u8();
+      for (int i = 0; i < qe::input::InputFrame::kAxes; ++i)
+        if (mask & (1u << i))
+          t.input.axes[i] = qe::core::bits_float(
+              static_cast<uint32_t>(qe::core::float_bits(prev_.input.axes[i]) + in_.get_svarint()));
+      if (mask & (1u << qe::input::InputFrame::kAxes))
+        t.input.buttons = prev_.input.buttons ^ static_cast<uint32_t>(in_.get_varint());
+    }
+    if (tag & kHole) {
+      const uint64_t hole = in_.get_varint();
+      if (hole_count <= 0 || hole >= static_cast<uint64_t>(hole_count))
+        return fail("hole index out of range");
+      t.hole = static_cast<int>(hole);
+    }
+    if (tag & kShot) {
+      ShotRecord& s = t.shot;
+      t.has_shot = true;
+      const uint64_t club = in_.get_varint();
+      if (club >= static_cast<uint64_t>(NUM_CLUBS))
+        return fail("club index out of range");
+      s.club = static_cast<int>(club);
+      s.power = in_.get_f32();
+      s.aim_yaw = in_.get_f32();
+      s.spin = {in_.get_f32(), in_.get_f32(), in_.get_f32()};
+      s.lie = {in_.get_f32(), in_.get_f32(), in_.get_f32()};
+    }
+    if (!in_.ok())
+      return fail("truncated or corrupt stream");
+    prev_ = t;
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> bytes_;
+  qe::core::ByteReader in_;
+  ReplayTick prev_;
+  uint32_t repeat_ = 0;
+  int start_hole_ = 0;
+  int max_strokes_ = 0;
+  bool failed_ = false;
+
+  bool fail(const char* why) {
+    std::cerr << "Replay: " << why << "\n";
+    failed_ = true;
+    repeat_ = 0;
+    return false;
+  }
+};
+
+/** Shot record for a launch the sim is about to make. */
+inline ShotRecord record_shot(const GolfSim& sim, int club, float aim_yaw, float power) {
+  ShotRecord s;
+  s.club = club;
+  s.power = power;
+  s.aim_yaw = aim_yaw;
+  s.spin = CLUBS[club].default_spin(GolfSim::yaw_dir(aim_yaw));
+  s.lie = sim.ball.position;
+  return s;
+}
+
+/** True when the sim's ball sits bit-exactly on the shot's recorded lie. */
+inline bool same_lie(const GolfSim& sim, const ShotRecord& s) {
+  const auto& b = sim.ball.position;
+  return qe::core::float_bits(s.lie.x) == qe::core::float_bits(b.x) &&
+         qe::core::float_bits(s.lie.y) == qe::core::float_bits(b.y) &&
+         qe::core::float_bits(s.lie.z) == qe::core::float_bits(b.z);
+}
+
+/**
+ * Apply a tick's events and input to the sim, in the game's order (the
+ * caller then steps it by t.dt). Returns false when a shot's recorded lie
+ * differs from the sim's ball.
+ */
+inline bool apply_replay_events(GolfSim& sim, const ReplayTick& t) {
+  if (t.hole >= 0)
+    sim.setup_hole(t.hole);
+  bool in_sync = true;
+  if (t.has_shot) {
+    const ShotRecord& s = t.shot;
+    in_sync = same_lie(sim, s);
+    sim.shoot(s.club, s.aim_yaw, s.power, s.spin);
+  }
+  sim.apply_input(t.input);
+  return in_sync;
+}
+
+}  // namespace game
+}  // namespace qg
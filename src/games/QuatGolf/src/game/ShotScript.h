@@ -0,0 +1,232 @@
+#pragma once
+/**
+ * @file ShotScript.h
+ * @brief Scripted and computed shots for driving GolfSim without input.
+ *
+ * A shot script is plain text, one shot per line, '#' starts a comment:
+ *
+ *     # club  power  aim_deg
+ *     0       1.0    0        Driver, full power, straight at the pin
+ *     8       0.4    -2.5     Putter, 40 %, 2.5 degrees left of the pin
+ *     auto                    Let the caddie choose
+ *
+ * club indexes CLUBS[], aim_deg is relative to the ball-to-pin line
+ * (positive = right). Once the script runs out every shot is "auto".
+ *
+ * AutoCaddie plays an "auto" shot by forward-simulating candidates on a
+ * copy of the ball with the round's own BallPhysics and dt: it takes the
+ * shortest club whose full swing reaches the pin, bisects power on the
+ * distance along the aim line, then corrects aim for the lateral miss.
+ * The chosen swing is then spoiled by a small power and aim error drawn
+ * from a seeded xorshift generator, so rounds differ from seed to seed
+ * but replay exactly for the same seed.
+ *
+ * Design by Contract:
+ *   - Precondition: the sim is ready() when a shot is planned
+ *   - Postcondition: planned club in [0, NUM_CLUBS), power in [0, 1]
+ *   - parse() reports the first malformed line to std::cerr, returns false
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Club.h"
+#include "GolfSim.h"
+
+namespace qg {
+namespace game {
+
+struct Shot {
+  bool automatic = true;  // Let AutoCaddie choose the rest
+  int club = 0;
+  float power = 1.0f;
+  float aim_deg = 0.0f;  // Relative to the pin line, positive = right
+};
+
+class ShotScript {
+ public:
+  /** Parse script text; see the file comment for the format. */
+  bool parse(const std::string& text) {
+    shots_.clear();
+    next_ = 0;
+    std::istringstream in(text);
+    std::string line;
+    for (int n = 1; std::getline(in, line); ++n) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream fields(line);
+      std::string first;
+      if (!(fields >> first))
+        continue;
+      Shot shot;
+      if (first != "auto") {
+        std::istringstream club(first);
+        shot.automatic = false;
+        if (!(club >> shot.club) || !(fields >> shot.power) || shot.club < 0 ||
+            shot.club >= NUM_CLUBS) {
+          std::cerr << "ShotScript: line " << n << ": expected 'club power [aim_deg]'\n";
+          return false;
+        }
+        fields >> shot.aim_deg;
+        shot.power = std::clamp(shot.power, 0.0f, 1.0f);
+      }
+      shots_.push_back(shot);
+    }
+    return true;
+  }
+
+  bool load(const std::string& path) {
+    std::ifstream f(path);
+    if (!f) {
+      std::cerr << "ShotScript: cannot open " << path << "\n";
+      return false;
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return parse(ss.str());
+  }
+
+  /** Next scripted shot, or an automatic one past the end. */
+  Shot next() {
+    return next_ < shots_.size() ? shots_[next_++] : Shot{};
+  }
+
+  void rewind() {
+    next_ = 0;
+  }
+
+  size_t size() const noexcept {
+    return shots_.size();
+  }
+
+ private:
+  std::vector<Shot> shots_;
+  size_t next_ = 0;
+};
+
+/** Club, yaw and power for GolfSim::shoot(). */
+struct ShotPlan {
+  int club = 0;
+  float aim_yaw = 0.0f;
+  float power = 1.0f;
+};
+
+class AutoCaddie {
+ public:
+  int power_iterations = 10;   // Bisection steps on power
+  int aim_iterations = 2;      // Lateral corrections after each power search
+  float putt_range = 20.0f;    // Only putt from inside this distance (m)
+  float max_flight = 30.0f;    // Simulated seconds per prediction
+  float power_error = 0.04f;   // Max relative power error per swing
+  float aim_error_deg = 1.5f;  // Max aim error per swing (degrees)
+
+  /** Physics steps spent on predictions since construction. */
+  uint64_t predicted_steps = 0;
+
+  explicit AutoCaddie(uint32_t seed = 1) : rng_(seed ? seed : 1) {}
+
+  /** Choose the shot for the sim's current lie. */
+  ShotPlan plan(const GolfSim& sim, float dt) {
+    const float target = sim.distance_to_pin();
+    ShotPlan best;
+    best.aim_yaw = sim.pin_yaw();
+
+    // Shortest club whose full swing reaches the pin; Driver if none does
+    const int shortest = target <= putt_range ? NUM_CLUBS - 1 : NUM_CLUBS - 2;
+    for (int c = shortest; c >= 0; --c) {
+      if (carry(sim, c, best.aim_yaw, 1.0f, dt) >= target) {
+        best.club = c;
+        break;
+      }
+    }
+
+    for (int pass = 0; pass <= aim_iterations; ++pass) {
+      best.power = search_power(sim, best.club, best.aim_yaw, target, dt);
+      if (pass == aim_iterations)
+        break;
+      // Rotate the aim by the angle between the predicted rest and the pin
+      qe::math::Vec3 rest = predict(sim, best.club, best.aim_yaw, best.power, dt);
+      float rest_yaw = std::atan2(rest.x - sim.ball.position.x, -(rest.z - sim.ball.position.z));
+      best.aim_yaw += wrap(sim.pin_yaw() - rest_yaw);
+    }
+
+    best.power = std::clamp(best.power * (1.0f + power_error * uniform()), 0.0f, 1.0f);
+    best.aim_yaw += aim_error_deg * 3.14159265f / 180.0f * uniform();
+    return best;
+  }
+
+  /** Turn a script entry into a plan (scripted aim is relative to the pin). */
+  ShotPlan resolve(const Shot& shot, const GolfSim& sim, float dt) {
+    if (shot.automatic)
+      return plan(sim, dt);
+    ShotPlan p;
+    p.club = shot.club;
+    p.power = shot.power;
+    p.aim_yaw = sim.pin_yaw() + shot.aim_deg * 3.14159265f / 180.0f;
+    return p;
+  }
+
+ private:
+  uint32_t rng_;
+
+  /** Uniform in [-1, 1] (xorshift32). */
+  float uniform() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return static_cast<float>(rng_ >> 8) / 8388608.0f - 1.0f;
+  }
+
+  /** Rest position of a shot, ignoring enemies. */
+  qe::math::Vec3 predict(const GolfSim& sim, int club, float yaw, float power, float dt) {
+    const Club& c = CLUBS[club];
+    qe::math::Vec3 aim(std::sin(yaw), 0, -std::cos(yaw));
+    physics::BallPhysics phys = sim.physics;
+    physics::BallState b = sim.ball;
+    phys.launch(b, c.launch_velocity(aim, power), c.default_spin(aim));
+    const int limit = static_cast<int>(max_flight / dt);
+    sim.with_ground([&](const auto& ground) {
+      for (int i = 0; i < limit && !b.stopped && !b.in_water; ++i) {
+        phys.update(b, ground, dt);
+        ++predicted_steps;
+      }
+    });
+    return b.position;
+  }
+
+  /** Distance travelled along the aim line. */
+  float carry(const GolfSim& sim, int club, float yaw, float power, float dt) {
+    qe::math::Vec3 rest = predict(sim, club, yaw, power, dt);
+    return (rest.x - sim.ball.position.x) * std::sin(yaw) -
+           (rest.z - sim.ball.position.z) * std::cos(yaw);
+  }
+
+  float search_power(const GolfSim& sim, int club, float yaw, float target, float dt) {
+    float lo = 0.0f, hi = 1.0f;
+    for (int i = 0; i < power_iterations; ++i) {
+      float mid = 0.5f * (lo + hi);
+      if (carry(sim, club, yaw, mid, dt) < target)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    return 0.5f * (lo + hi);
+  }
+
+  static float wrap(float a) {
+    const float pi = 3.14159265f;
+    while (a > pi)
+      a -= 2 * pi;
+    while (a < -pi)
+      a += 2 * pi;
+    return a;
+  }
+};
+
+}  // namespace game
+}  // namespace qg
@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @file Snapshot.h
+ * @brief World snapshots for mulligans and rewind.
+ *
+ * A world snapshot is GolfSim::save_state() followed by the particle
+ * system's state (particles and spawn RNG), written into a reused,
+ * preallocated ByteWriter — no per-frame allocation, a few microseconds for
+ * a typical world. WorldHistory pushes one per simulated frame into a
+ * core::SnapshotRing, which keeps older frames as XOR + RLE deltas, so the
+ * default 1 MiB budget holds many seconds of play; step_back() walks back
+ * through them one frame at a time.
+ *
+ * Design by Contract:
+ *   - Precondition: snapshots are restored into the world that took them
+ *     (same course and enemy set); anything else is rejected
+ *   - Postcondition: load_world() and step_back() either restore the whole
+ *     snapshot or return false with the world (and history) unchanged;
+ *     snapshots are checked in full before anything is written
+ *   - Postcondition: save_world() after load_world() reproduces the bytes
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GolfSim.h"
+#include "core/ByteStream.h"
+#include "core/SnapshotRing.h"
+#include "game/ParticleSystem.h"
+
+namespace qg {
+namespace game {
+
+/** Serialize the world into out (cleared first). particles may be null. */
+inline void save_world(const GolfSim& sim, const qe::game::ParticleSystem* particles,
+                       qe::core::ByteWriter& out) {
+  out.clear();
+  sim.save_state(out);
+  out.put_u8(particles ? 1 : 0);
+  if (particles)
+    particles->save_state(out);
+}
+
+/**
+ * Restore a save_world() snapshot; false, changing nothing, if it does not
+ * fit this world or is truncated.
+ */
+inline bool load_world(GolfSim& sim, qe::game::ParticleSystem* particles, const uint8_t* data,
+                       size_t n) {
+  qe::core::ByteReader probe(data, n);
+  if (!sim.skip_state(probe))
+    return false;
+  const bool has_particles = probe.get_u8() != 0;
+  if (!probe.ok() || (has_particles && particles && !particles->skip_state(probe)))
+    return false;
+
+  qe::core::ByteReader in(data, n);
+  sim.restore_state(in);
+  in.get_u8();
+  if (has_particles && particles)
+    particles->restore_state(in);
+  return in.ok();
+}
+
+inline bool load_world(GolfSim& sim, qe::game::ParticleSystem* particles,
+                       const std::vector<uint8_t>& bytes) {
+  return load_world(sim, particles, bytes.data(), bytes.size());
+}
+
+class WorldHistory {
+ public:
+  explicit WorldHistory(size_t budget_bytes = size_t{1} << 20, size_t max_frames = 1200)
+      : ring_(budget_bytes, max_frames) {
+    scratch_.reserve(4096);
+  }
+
+  /** Record the current world as the newest frame. */
+  void capture(const GolfSim& sim, const qe::game::ParticleSystem* particles = nullptr) {
+    save_world(sim, particles, scratch_);
+    ring_.push(scratch_.data());
+  }
+
+  /**
+   * Drop the newest frame and restore the one before it. Returns false (and
+   * changes nothing) when no earlier frame is left or it does not load.
+   */
+  bool step_back(GolfSim& sim, qe::game::ParticleSystem* particles = nullptr) {
+    if (ring_.size() < 2 || !ring_.restore(1, previous_) ||
+        !load_world(sim, particles, previous_))
+      return false;
+    return ring_.rewind(1);
+  }
+
+  /** Frames available, the newest included. */
+  size_t size() const noexcept {
+    return ring_.size();
+  }
+
+  /** Bytes held by the delta-coded older frames. */
+  size_t delta_bytes() const noexcept {
+    return ring_.delta_bytes();
+  }
+
+  void clear() noexcept {
+    ring_.clear();
+  }
+
+ private:
+  qe::core::SnapshotRing ring_;
+  qe::core::ByteWriter scratch_;
+  std::vector<uint8_t> previous_;  // Frame step_back() is about to restore
+};
+
+}  // namespace game
+}  // namespace qg
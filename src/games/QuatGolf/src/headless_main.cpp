@@ -0,0 +1,212 @@
+/**
+ * @file headless_main.cpp
+ * @brief QuatGolf without a window — fixed-dt rounds for benchmarks and CI.
+ *
+ * Runs GolfSim (course, ball physics, enemies, scoring) through
+ * game/HeadlessRunner.h with no SDL or GL, then prints the scorecard,
+ * throughput and the run checksum.
+ *
+ *   quat_golf_headless [--rounds N] [--dt S] [--seed N] [--script FILE]
+ *                      [--course FILE] [--tiles FILE] [--max-strokes N] [--expect HEX]
+ *                      [--record FILE | --replay FILE] [--trace FILE]
+ *                      [--max-step-allocs N]
+ *   quat_golf_headless --import-heightmap DEM.pgm|DEM.raw --out FILE.qgt
+ *                      [--mask FILE] [--raw-size WxH] [--source-spacing M]
+ *                      [--cell-size M] [--height-scale M] [--tile-size N]
+ *
+ * --expect compares the checksum and exits 1 on a mismatch, so a build
+ * server can pin the simulation's behaviour. --record writes the run as a
+ * replay (game/Replay.h); --replay plays one back at full speed instead of
+ * running the caddie, which also works for replays recorded by the game.
+ * --tiles plays the course's holes on a tiled terrain (terrain/TileFile.h,
+ * e.g. from --import-heightmap) streamed around the ball, instead of the
+ * course's own heightmap.
+ * --import-heightmap converts an elevation raster (binary PGM, or 16-bit
+ * little-endian RAW with --raw-size) and an optional surface mask into a
+ * tile file for --tiles (terrain/HeightmapImport.h), then exits.
+ * --trace records a CPU profile of the run as a Chrome trace (core/Profiler.h).
+ * --max-step-allocs prints heap allocations per sim step by subsystem and
+ * exits 1 if sim steps after the first round allocated more than N times
+ * (0 = steady-state steps must not allocate).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "core/AllocHooks.h"
+#include "core/Profiler.h"
+#include "course/CourseFile.h"
+#include "game/GolfSim.h"
+#include "game/HeadlessRunner.h"
+#include "game/ShotScript.h"
+#include "terrain/HeightmapImport.h"
+
+int main(int argc, char* argv[]) {
+  qg::game::HeadlessConfig cfg;
+  std::string script_path, course_path, tiles_path, expect, record_path, replay_path, trace_path;
+  long max_step_allocs = -1;  // No check
+  std::string import_path, out_path, mask_path;
+  qg::terrain::ImportParams import;
+  int raw_width = 0, raw_height = 0;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    const char* val = argv[i + 1];
+    if (arg == "--rounds")
+      cfg.rounds = std::atoi(val);
+    else if (arg == "--dt")
+      cfg.dt = static_cast<float>(std::atof(val));
+    else if (arg == "--seed")
+      cfg.seed = static_cast<uint32_t>(std::strtoul(val, nullptr, 10));
+    else if (arg == "--max-strokes")
+      cfg.max_strokes = std::atoi(val);
+    else if (arg == "--script")
+      script_path = val;
+    else if (arg == "--course")
+      course_path = val;
+    else if (arg == "--tiles")
+      tiles_path = val;
+    else if (arg == "--expect")
+      expect = val;
+    else if (arg == "--record")
+      record_path = val;
+    else if (arg == "--replay")
+      replay_path = val;
+    else if (arg == "--trace")
+      trace_path = val;
+    else if (arg == "--max-step-allocs")
+      max_step_allocs = std::atol(val);
+    else if (arg == "--import-heightmap")
+      import_path = val;
+    else if (arg == "--out")
+      out_path = val;
+    else if (arg == "--mask")
+      mask_path = val;
+    else if (arg == "--raw-size")
+      std::sscanf(val, "%dx%d", &raw_width, &raw_height);
+    else if (arg == "--source-spacing")
+      import.source_spacing = static_cast<float>(std::atof(val));
+    else if (arg == "--cell-size")
+      import.cell_size = static_cast<float>(std::atof(val));
+    else if (arg == "--height-scale")
+      import.height_scale = static_cast<float>(std::atof(val));
+    else if (arg == "--tile-size")
+      import.tile_size = std::atoi(val);
+    else {
+      std::cerr << "Unknown option " << arg << "\n";
+      return 2;
+    }
+  }
+  if (!import_path.empty()) {
+    if (out_path.empty() || import.source_spacing <= 0.0f || import.cell_size <= 0.0f) {
+      std::cerr << "--import-heightmap needs --out, and positive spacings\n";
+      return 2;
+    }
+    if (!qg::terrain::HeightmapImport::import_tiles(import_path, mask_path, out_path, import,
+                                                     raw_width, raw_height))
+      return 1;
+    std::cout << "Imported " << import_path << " to " << out_path << "\n";
+    return 0;
+  }
+  if (cfg.rounds < 1 || cfg.dt <= 0.0f || cfg.max_strokes < 1) {
+    std::cerr << "--rounds, --dt and --max-strokes must be positive\n";
+    return 2;
+  }
+
+  qg::game::GolfSim sim;
+  qg::course::CourseFile file;
+  if (!course_path.empty() && file.open(course_path))
+    sim.load(file);
+  else
+    sim.generate();
+  sim.spawn_enemies();
+  qg::terrain::StreamingTerrain tiles;
+  if (!tiles_path.empty()) {
+    if (!tiles.open(tiles_path))
+      return 2;
+    sim.streamed = &tiles;
+  }
+
+  qg::game::ShotScript script;
+  if (!script_path.empty() && !script.load(script_path))
+    return 2;
+  qg::game::ReplayReader replay;
+  if (!replay_path.empty() && !replay.open(replay_path))
+    return 2;
+  qg::game::ReplayWriter recorder;
+
+  qe::core::Profiler::instance().set_thread_name("sim");
+  qe::core::Profiler::set_enabled(!trace_path.empty());
+  qe::core::AllocFrame run_allocs;
+  run_allocs.begin();
+  auto t0 = std::chrono::steady_clock::now();
+  int desyncs = 0;
+  qg::game::HeadlessResult r =
+      replay_path.empty()
+          ? qg::game::run_headless(sim, script, cfg, record_path.empty() ? nullptr : &recorder)
+          : qg::game::replay_headless(sim, replay, &desyncs);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  qe::core::Profiler::set_enabled(false);
+  run_allocs.end();
+
+  const int par = sim.course_par();
+  for (size_t i = 0; i < r.round_strokes.size(); ++i)
+    std::cout << "Round " << i + 1 << ": " << r.round_strokes[i] << " ("
+              << r.round_strokes[i] - par << " to par)\n";
+
+  char sum[17];
+  std::snprintf(sum, sizeof(sum), "%016llx", static_cast<unsigned long long>(r.checksum));
+  const double sim_secs = static_cast<double>(r.sim_steps) * cfg.dt;
+  std::cout << r.rounds << " rounds, " << r.shots << " shots, " << r.penalties << " penalties, "
+            << r.pickups << " pickups, " << r.enemy_points << " enemy points\n"
+            << r.sim_steps << " sim steps + " << r.plan_steps << " caddie steps in " << secs
+            << " s (" << (r.sim_steps + r.plan_steps) / (secs > 0 ? secs : 1e-9)
+            << " steps/s, " << sim_secs / (secs > 0 ? secs : 1e-9) << "x real time)\n"
+            << "checksum " << sum << "\n";
+
+  if (max_step_allocs >= 0) {
+    const double steps = static_cast<double>(std::max<uint64_t>(r.sim_steps, 1));
+    std::printf("Heap allocations during the run (caddie included):\n");
+    for (size_t t = 0; t < qe::core::AllocTracker::kTags; ++t) {
+      const auto tag = static_cast<qe::core::AllocTag>(t);
+      const qe::core::AllocStats& s = run_allocs[tag];
+      if (s.allocs > 0)
+        std::printf("  %-10s %8llu allocs %10llu bytes  (%.4f allocs/step)\n",
+                    qe::core::alloc_tag_name(tag), static_cast<unsigned long long>(s.allocs),
+                    static_cast<unsigned long long>(s.bytes), s.allocs / steps);
+    }
+    std::cout << r.steady_step_allocs << " allocations in sim steps after the first round\n";
+  }
+  if (!trace_path.empty()) {
+    if (!qe::core::Profiler::instance().write_chrome_trace(trace_path))
+      return 2;
+    std::cout << "Wrote CPU profile to " << trace_path << "\n";
+  }
+  if (!record_path.empty()) {
+    if (!recorder.save(record_path))
+      return 2;
+    std::cout << "Recorded " << recorder.ticks() << " ticks in " << recorder.data().size()
+              << " bytes to " << record_path << "\n";
+  }
+  if (max_step_allocs >= 0 && static_cast<long>(r.steady_step_allocs) > max_step_allocs) {
+    std::cerr << "Steady-state sim steps allocated (limit " << max_step_allocs << ")\n";
+    return 1;
+  }
+  if (replay.failed()) {
+    std::cerr << "Replay is corrupt\n";
+    return 1;
+  }
+  if (desyncs > 0) {
+    std::cerr << "Replay desynced on " << desyncs << " shots\n";
+    return 1;
+  }
+  if (!expect.empty() && expect != sum) {
+    std::cerr << "Checksum mismatch: expected " << expect << "\n";
+    return 1;
+  }
+  return 0;
+}
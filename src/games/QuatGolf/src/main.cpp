@@ -4,7 +4,12 @@
  *
  * Thin orchestration layer. All logic lives in:
  *   - terrain/Terrain.h      (heightmap mesh + surface queries)
+ *   - terrain/StreamingTerrain.h (--tiles: paged terrain around the ball and camera)
  *   - course/CourseBuilder.h  (hole layout → terrain stamping)
+ *   - course/CourseFile.h     (baked course files, --course / --bake-course)
+ *   - game/GolfSim.h          (ball, enemies, scoring — shared with headless_main.cpp)
+ *   - game/Replay.h           (--record / --replay input and shot recordings)
+ *   - game/Snapshot.h         (mulligan and rewind)
  *   - physics/BallPhysics.h  (flight, bounce, roll)
  *   - game/Club.h            (club selection, launch parameters)
  *   - shared/input/           (keyboard + gamepad)
@@ -13,19 +18,27 @@
 
 #include <SDL.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
-#include <numeric>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "ai/NavigationSystem.h"
 #include "audio/AudioSystem.h"
+#include "core/AllocHooks.h"
+#include "core/FrameTelemetry.h"
+#include "core/Profiler.h"
 #include "course/CourseBuilder.h"
+#include "course/CourseFile.h"
 #include "course/Hole.h"
 #include "game/Club.h"
-#include "game/EnemyManager.h"
+#include "game/GolfSim.h"
 #include "game/ParticleSystem.h"
+#include "game/Replay.h"
+#include "game/Snapshot.h"
 #include "input/InputManager.h"
 #include "math/Mat4.h"
 #include "math/Quaternion.h"
@@ -33,14 +46,19 @@
 #include "physics/BallPhysics.h"
 #include "renderer/Camera.h"
 #include "renderer/GLLoader.h"
+#include "renderer/GpuProfiler.h"
 #include "renderer/Mesh.h"
+#include "renderer/PerfOverlay.h"
 #include "renderer/Shader.h"
 #include "renderer/Texture.h"
+#include "terrain/StreamingTerrain.h"
 #include "terrain/Surface.h"
 #include "terrain/Terrain.h"
 
 // ── Application State ───────────────────────────────────────────────────────
 
+constexpr float kAimRadiansPerPixel = 0.003f;  // Mouse aim while the ball is at rest
+
 struct App {
   SDL_Window* window = nullptr;
   SDL_GLContext gl_context = nullptr;
@@ -51,11 +69,15 @@ struct App {
   qe::renderer::Camera camera;
   qe::renderer::Shader world_shader;
   qe::renderer::Shader hud_shader;
+  qe::renderer::GpuProfiler gpu_profiler;  // Per-pass GPU times (inert without timer queries)
+  qe::renderer::PerfOverlay overlay;       // F3: frame graph and live counters
 
-  // Course
-  qg::terrain::Terrain terrain;
-  std::vector<qg::course::Hole> holes;
-  int current_hole = 0;
+  // Course, ball, enemies and scoring (no SDL/GL)
+  qg::game::GolfSim sim;
+
+  // --tiles FILE: the ball plays on tiles paged around the ball and camera
+  qg::terrain::StreamingTerrain streaming;
+  qg::terrain::TileMeshCache tile_meshes;
 
   // Meshes (reused)
   qe::renderer::Mesh ball_mesh;
@@ -65,31 +87,58 @@ struct App {
   qe::renderer::Mesh power_bar_fill;
   qe::renderer::Mesh aim_line;
 
-  // Entities
-  // Entities
-  qe::game::EnemyManager enemy_manager;
+  // Effects
   qe::game::ParticleSystem particle_system;
   qe::audio::AudioSystem audio_system;
   qe::ai::NavigationSystem nav_system;
 
-  // Ball state
-  qg::physics::BallPhysics physics;
-  qg::physics::BallState ball;
-
   // Shot control
   int selected_club = 0;  // Index into CLUBS[]
   float aim_yaw = 0.0f;
   float power = 0.0f;
   bool charging = false;
-  bool ball_in_play = false;
-  int stroke_count = 0;
-  int total_score = 0;      // Game score (points)
-  std::vector<int> scores;  // Per-hole stroke count
 
   // Visual
   float time = 0.0f;
   bool free_cam = false;
 
+  // Replay: the live loop fills `tick` and records it; playback feeds it back
+  qg::game::ReplayTick tick;
+  qg::game::ReplayWriter recorder;
+  qg::game::ReplayReader replay;
+  std::string record_path;
+  bool replaying = false;
+  bool replay_max_speed = false;  // One tick per frame, no vsync
+  double replay_lag = 0.0;        // Wall time not yet covered by replayed ticks
+
+  // Rewind (hold Backspace) walks back through per-frame snapshots; a
+  // mulligan (M) restores the world as it was before the last shot
+  qg::game::WorldHistory history;
+  qe::core::ByteWriter mulligan;
+  bool rewinding = false;
+
+  // Fixed-step sim (--sim-hz N, 0 = one variable step per frame); each tick
+  // consumes the input stamped before it ends
+  float sim_hz = 120.0f;
+  float sim_lag = 0.0f;  // Wall time not yet simulated
+
+  // CPU profiler (--profile FILE, or F9 to start/stop); trace written on stop or exit
+  std::string trace_path = "quatgolf_trace.json";
+  qe::core::AllocFrame frame_allocs;  // Heap allocations of the last frame, per subsystem
+
+  // Frame and phase time percentiles, hitch traces (--hitch-ms), export (--telemetry FILE)
+  qe::core::FrameTelemetry telemetry;
+  int phase_events = telemetry.phase("events");
+  int phase_sim = telemetry.phase("sim");
+  int phase_render = telemetry.phase("render");
+  int phase_swap = telemetry.phase("swap");
+  int phase_gpu = telemetry.phase("gpu", qe::core::CounterKind::GpuTime);
+  uint64_t gpu_frames_seen = 0;  // gpu_profiler.frames_measured() already added
+
+  // Render on demand (--idle-tick S, 0 = redraw every frame)
+  float idle_tick = 0.25f;      // Longest wait for input while the world is idle
+  bool camera_settled = false;  // Follow camera has reached its target
+
   // Timing
   Uint64 last_time = 0;
   int frame_count = 0;
@@ -101,29 +150,85 @@ struct App {
 bool init_window(App& app);
 bool init_gl(App& app);
 void init_assets(App& app);
-void init_course(App& app);
+bool bake_course(const std::string& path);
+void init_course(App& app, const std::string& course_path, const std::string& tiles_path);
 void setup_hole(App& app, int hole_idx);
 void handle_events(App& app);
+void toggle_profiling(App& app);
+void apply_input(App& app);
+void run_sim_ticks(App& app, float dt);
+void play_replay(App& app, float dt);
+void take_mulligan(App& app);
+void rewind_frame(App& app, float dt);
 void update(App& app, float dt);
-void render_world(App& app);
+void update_camera(App& app, float dt);
+bool world_idle(const App& app);
+void page_terrain(App& app);
+void render_world(App& app, const qe::input::InputSample& latched);
 void render_hud(App& app);
 void update_title(App& app);
 void cleanup(App& app);
+qe::math::Vec3 resolve_camera_collision(const App& app, const qe::math::Vec3& focus,
+                                        const qe::math::Vec3& desired);
+void pick_aim_target(App& app);
 
 // Helper meshes
 void build_aim_line(App& app);
 void build_power_bar(App& app);
 
 // ── Entry Point ─────────────────────────────────────────────────────────────
-int main(int /*argc*/, char* /*argv*/[]) {
+int main(int argc, char* argv[]) {
+  // --course <file>       load a baked course instead of generating (falls back if invalid)
+  // --bake-course <file>  generate, stamp and write a course file, then exit
+  // --tiles <file>        play on a tiled terrain streamed around the ball and camera
+  // --record <file>       record input and shots to a replay, written on exit
+  // --replay <file>       play a replay back instead of reading input
+  // --replay-speed max    replay as fast as possible (default: real time)
+  // --idle-tick <s>       while idle, wait up to s seconds for input (0 = always redraw)
+  // --sim-hz <n>          fixed simulation rate (0 = one variable step per frame)
+  // --profile <file>      record a CPU profile from startup, written as a Chrome trace
+  // --hitch-ms <ms>       frames over ms are hitches; record the profiler to trace each one
+  // --telemetry <file>    append frame time percentiles every 10 s (.csv or JSON Lines)
+  std::string course_path, tiles_path, replay_path;
   App app;
+  for (int i = 1; i + 1 < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--course")
+      course_path = argv[++i];
+    else if (arg == "--tiles")
+      tiles_path = argv[++i];
+    else if (arg == "--bake-course")
+      return bake_course(argv[i + 1]) ? 0 : 1;
+    else if (arg == "--record")
+      app.record_path = argv[++i];
+    else if (arg == "--replay")
+      replay_path = argv[++i];
+    else if (arg == "--replay-speed")
+      app.replay_max_speed = std::string(argv[++i]) == "max";
+    else if (arg == "--idle-tick")
+      app.idle_tick = static_cast<float>(std::atof(argv[++i]));
+    else if (arg == "--sim-hz")
+      app.sim_hz = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+    else if (arg == "--profile") {
+      app.trace_path = argv[++i];
+      qe::core::Profiler::set_enabled(true);
+    } else if (arg == "--hitch-ms") {
+      app.telemetry.config.hitch_ms = static_cast<float>(std::atof(argv[++i]));
+      qe::core::Profiler::set_enabled(true);
+    } else if (arg == "--telemetry")
+      app.telemetry.config.export_path = argv[++i];
+  }
+  qe::core::Profiler::instance().set_thread_name("main");
+  if (!replay_path.empty() && !app.replay.open(replay_path))
+    return 1;
+  app.replaying = !replay_path.empty();
 
   if (!init_window(app))
     return 1;
   if (!init_gl(app))
     return 1;
   init_assets(app);
-  init_course(app);
+  init_course(app, course_path, tiles_path);
 
   // Camera
   qe::renderer::Camera::Config cc;
@@ -140,8 +245,17 @@ int main(int /*argc*/, char* /*argv*/[]) {
   app.input.init();
   app.input.set_gamepad_look_speed(3.0f);
 
-  // Start on hole 1
-  setup_hole(app, 0);
+  // Start on hole 1, or wherever the replay starts
+  if (app.replaying) {
+    app.sim.max_strokes = app.replay.max_strokes();
+    setup_hole(app, app.replay.start_hole());
+    if (app.replay_max_speed)
+      SDL_GL_SetSwapInterval(0);
+  } else {
+    setup_hole(app, 0);
+    if (!app.record_path.empty())
+      app.recorder.begin(0, app.sim.max_strokes);
+  }
 
   SDL_SetRelativeMouseMode(SDL_TRUE);
   app.last_time = SDL_GetPerformanceCounter();
@@ -151,27 +265,92 @@ int main(int /*argc*/, char* /*argv*/[]) {
             << "  Mouse / R.Stick  Aim\n"
             << "  Space / A    Power (hold + release)\n"
             << "  Tab / Y      Free camera toggle\n"
+            << "  Left click   Aim at terrain (free camera)\n"
             << "  N / B        Next hole\n"
             << "  R / Back     Reset ball\n"
+            << "  M            Mulligan (retake the last shot)\n"
+            << "  Backspace    Rewind (hold)\n"
             << "  F            Wireframe\n"
+            << "  F3           Performance overlay\n"
+            << "  F9           Start / stop CPU profile\n"
             << "  Esc          Quit\n";
 
   while (app.running) {
+    QE_PROFILE_SCOPE("frame");
+    app.frame_allocs.begin();
+    // Render on demand: with nothing moving, sleep until input arrives or
+    // the idle tick elapses instead of redrawing an unchanged frame
+    bool idle = app.idle_tick > 0.0f && !app.replaying && world_idle(app);
+    bool woke = !idle || SDL_WaitEventTimeout(nullptr, static_cast<int>(app.idle_tick * 1000)) == 1;
+
+    app.telemetry.begin_frame();  // After the idle wait, which is not a hitch
+
     Uint64 now = SDL_GetPerformanceCounter();
-    float dt =
+    float elapsed =
         static_cast<float>(now - app.last_time) / static_cast<float>(SDL_GetPerformanceFrequency());
     app.last_time = now;
-    if (dt > 0.1f)
-      dt = 0.1f;
+    float dt = std::min(elapsed, 0.1f);
 
-    handle_events(app);
-    update(app, dt);
-    render_world(app);
-    render_hud(app);
-    SDL_GL_SwapWindow(app.window);
+    if (app.replaying) {
+      qe::core::TelemetryPhase phase(app.telemetry, app.phase_sim);
+      play_replay(app, dt);
+    } else {
+      {
+        qe::core::TelemetryPhase phase(app.telemetry, app.phase_events);
+        handle_events(app);
+      }
+      qe::core::TelemetryPhase phase(app.telemetry, app.phase_sim);
+      if (app.rewinding)
+        rewind_frame(app, dt);
+      else
+        run_sim_ticks(app, dt);
+    }
+    // Replays and rewinds take no live ticks: drop the input they would
+    // otherwise queue for the first live tick, and do not draw it
+    const bool live = !app.replaying && !app.rewinding;
+    if (!live)
+      app.input.drop_pending();
+    const bool draw = woke || !world_idle(app);
+    if (draw) {
+      // Late latch: show mouse motion that arrived during this frame
+      qe::input::InputSample latched = live ? app.input.late_latch() : qe::input::InputSample{};
+      page_terrain(app);
+      {
+        qe::core::TelemetryPhase phase(app.telemetry, app.phase_render);
+        app.gpu_profiler.begin_frame();
+        render_world(app, latched);
+        render_hud(app);
+        app.gpu_profiler.end_frame();
+      }
+      {
+        QE_PROFILE_SCOPE("swap");  // Includes the wait for vsync
+        qe::core::TelemetryPhase phase(app.telemetry, app.phase_swap);
+        SDL_GL_SwapWindow(app.window);
+      }
+      // GPU times arrive frames late; count each measured frame once
+      if (app.gpu_profiler.frames_measured() != app.gpu_frames_seen) {
+        app.gpu_frames_seen = app.gpu_profiler.frames_measured();
+        app.telemetry.add(app.phase_gpu, app.gpu_profiler.frame_ms());
+      }
+      const double latency = app.input.mark_presented();
+      if (latency >= 0.0)
+        QE_PROFILE_COUNTER("input latency ms", latency * 1000.0);
+      app.frame_count++;
+    }
+    app.frame_allocs.end();
+    QE_PROFILE_COUNTER("allocs", static_cast<double>(app.frame_allocs.total().allocs));
+    QE_PROFILE_COUNTER("alloc bytes", static_cast<double>(app.frame_allocs.total().bytes));
+    QE_COUNTER_SET("allocs", app.frame_allocs.total().allocs);
+    // Record telemetry and latch counters for the overlay once per drawn
+    // frame, so idle passes do not show up as fast frames without draws
+    if (draw) {
+      app.telemetry.end_frame();
+      qe::core::Counters::end_frame();
+    } else {
+      app.telemetry.discard_frame();
+    }
 
-    app.frame_count++;
-    app.fps_timer += dt;
+    app.fps_timer += elapsed;
     if (app.fps_timer >= 0.5f) {
       app.current_fps = static_cast<float>(app.frame_count) / app.fps_timer;
       update_title(app);
@@ -180,6 +359,13 @@ int main(int /*argc*/, char* /*argv*/[]) {
     }
   }
 
+  if (!app.record_path.empty() && app.recorder.save(app.record_path))
+    std::cout << "Recorded " << app.recorder.ticks() << " ticks to " << app.record_path << "\n";
+  if (!app.telemetry.config.export_path.empty())
+    app.telemetry.export_interval();
+  app.telemetry.report(std::cout);
+  if (qe::core::Profiler::enabled())
+    toggle_profiling(app);
   cleanup(app);
   return 0;
 }
@@ -216,6 +402,8 @@ bool init_gl(App& app) {
 
   const char* gpu = reinterpret_cast<const char*>(qe::renderer::gl::glGetString(GL_RENDERER));
   std::cout << "GPU: " << (gpu ? gpu : "?") << std::endl;
+  if (!app.gpu_profiler.init())
+    std::cout << "GPU timer queries unavailable: GPU pass times disabled" << std::endl;
 
   using namespace qe::renderer::gl;
   glEnable(GL_DEPTH_TEST);
@@ -237,11 +425,15 @@ bool init_gl(App& app) {
   const char* hud_f = R"(#version 330 core
         in vec3 vColor; out vec4 FragColor;
         void main() { FragColor=vec4(vColor,0.9); })";
-  return app.hud_shader.compile(hud_v, hud_f);
+  if (!app.hud_shader.compile(hud_v, hud_f))
+    return false;
+  app.overlay.init();
+  return true;
 }
 
 // ── Init: Assets ────────────────────────────────────────────────────────────
 void init_assets(App& app) {
+  QE_ALLOC_TAG(Assets);
   // Ball — small white sphere
   app.ball_mesh = qe::renderer::Mesh::create_sphere(3, 0.15f, 1, 1, 1);
 
@@ -305,16 +497,9 @@ void init_assets(App& app) {
   build_aim_line(app);
 
   // Humanoid Enemies
-  app.enemy_manager.init();
+  app.sim.enemies.init();
   app.particle_system.init();
-
-  // Spawn a few sample enemies
-  app.enemy_manager.spawn("grunt", {2.0f, 0.0f, 2.0f});
-  app.enemy_manager.spawn("grunt", {-2.0f, 0.0f, 3.0f});
-  app.enemy_manager.spawn("grunt", {0.0f, 0.0f, 5.0f});
-
-  // If other types exist (need to generate them first!)
-  // app.enemy_manager.spawn("scout", {4.0f, 0.0f, 4.0f});
+  app.sim.spawn_enemies();
 }
 
 void build_power_bar(App& app) {
@@ -402,56 +587,66 @@ void build_aim_line(App& app) {
 }
 
 // ── Course ──────────────────────────────────────────────────────────────────
-void init_course(App& app) {
-  // Generate terrain
-  qg::course::CourseBuilder::generate_base(app.terrain, 256, 256, 1.0f);
+bool bake_course(const std::string& path) {
+  qg::terrain::Terrain terrain;
+  std::vector<qg::course::Hole> holes;
+  qg::game::GolfSim::generate_course(terrain, holes);
+  if (!qg::course::CourseFile::write(path, holes, terrain))
+    return false;
+  std::cout << "Baked " << holes.size() << " holes to " << path << "\n";
+  return true;
+}
 
-  // Build hole layouts
-  app.holes = qg::course::CourseBuilder::default_course();
+void init_course(App& app, const std::string& course_path, const std::string& tiles_path) {
+  QE_ALLOC_TAG(Assets);
+  // Generate unless a course file was asked for, so a stale bake never
+  // silently replaces a newer generator's course
+  qg::course::CourseFile file;
+  if (!course_path.empty() && file.open(course_path)) {
+    app.sim.load(file);
+    if (file.has_mesh())
+      file.upload_mesh(app.sim.terrain);
+    else
+      app.sim.terrain.build_mesh();
+    if (file.has_nav())
+      file.load_nav(app.nav_system);
+    std::cout << "Course: " << course_path << "\n";
+  } else {
+    if (!course_path.empty())
+      std::cerr << "Course: " << course_path << " is missing or invalid, generating\n";
+    app.sim.generate();
+    app.sim.terrain.build_mesh();
+  }
 
-  // Stamp all holes onto terrain
-  for (auto& hole : app.holes) {
-    qg::course::CourseBuilder::stamp_hole(app.terrain, hole);
+  // The course's holes, played on streamed tiles instead of its heightmap
+  if (!tiles_path.empty() && app.streaming.open(tiles_path)) {
+    app.sim.streamed = &app.streaming;
+    std::cout << "Tiles: " << tiles_path << "\n";
   }
 
-  // Build the mesh
-  app.terrain.build_mesh();
+  // Particles collide with the terrain surface (one batch query per update)
+  app.particle_system.set_ground_sampler(
+      [&app](const float* xs, const float* zs, float* out, size_t n) {
+        app.sim.with_ground([&](const auto& ground) { ground.sample_heights(xs, zs, out, n); });
+      });
 }
 
 void setup_hole(App& app, int hole_idx) {
-  if (hole_idx < 0 || hole_idx >= static_cast<int>(app.holes.size()))
+  if (hole_idx < 0 || hole_idx >= static_cast<int>(app.sim.holes.size()))
     return;
-  app.current_hole = hole_idx;
-  auto& hole = app.holes[hole_idx];
-
-  // Place ball on tee
-  app.ball.position = hole.tee.position;
-  app.ball.position.y =
-      app.terrain.height_at_world(hole.tee.position.x, hole.tee.position.z) + 0.15f;
-  app.ball.velocity = {0, 0, 0};
-  app.ball.spin = {0, 0, 0};
-  app.ball.stopped = true;
-  app.ball.in_flight = false;
-  app.ball.rolling = false;
-  app.ball.in_water = false;
-  app.ball_in_play = false;
-  app.stroke_count = 0;
+  app.sim.setup_hole(hole_idx);
+  const auto& hole = app.sim.hole();
   app.power = 0;
   app.charging = false;
 
   // Aim toward green
-  auto aim = hole.green.pin - hole.tee.position;
-  app.aim_yaw = std::atan2(aim.x, -aim.z);
+  app.aim_yaw = app.sim.pin_yaw();
 
   // Camera behind ball, looking toward green
-  app.camera.set_position(app.ball.position + qe::math::Vec3(0, 3, 5));
+  app.camera.set_position(app.sim.ball.position + qe::math::Vec3(0, 3, 5));
 
-  // Auto-select driver for par 4+, putter for short shots
-  if (hole.par <= 3 && hole.yards < 200) {
-    app.selected_club = 2;  // 5 Iron
-  } else {
-    app.selected_club = 0;  // Driver
-  }
+  // Auto-select driver for par 4+, 5 Iron for short par 3s
+  app.selected_club = app.sim.tee_club();
 
   std::cout << "\n=== Hole " << hole.number << " | Par " << hole.par << " | "
             << static_cast<int>(hole.yards) << " yards ===\n";
@@ -459,6 +654,7 @@ void setup_hole(App& app, int hole_idx) {
 
 // ── Events ──────────────────────────────────────────────────────────────────
 void handle_events(App& app) {
+  QE_ALLOC_TAG(Input);
   app.input.begin_frame();
 
   SDL_Event ev;
@@ -481,32 +677,74 @@ void handle_events(App& app) {
         std::cout << "Club: " << qg::game::CLUBS[app.selected_club].name << "\n";
       }
       // Space = start charging / release = shoot
-      if (key == SDLK_SPACE && app.ball.stopped && !app.charging) {
+      if (key == SDLK_SPACE && app.sim.ball.stopped && !app.charging) {
         app.charging = true;
         app.power = 0;
       }
       // Next hole
       if (key == SDLK_n) {
-        int next = (app.current_hole + 1) % static_cast<int>(app.holes.size());
+        int next = (app.sim.current_hole + 1) % static_cast<int>(app.sim.holes.size());
         setup_hole(app, next);
+        app.tick.hole = next;
       }
+      // Snapshots are not part of a recording, so neither is restoring them
+      if (key == SDLK_m)
+        take_mulligan(app);
+      if (key == SDLK_BACKSPACE)
+        app.rewinding = app.record_path.empty();
+      if (key == SDLK_F9)
+        toggle_profiling(app);
+      if (key == SDLK_F3)
+        app.overlay.visible = !app.overlay.visible;
     }
+    if (ev.type == SDL_KEYUP && ev.key.keysym.sym == SDLK_BACKSPACE)
+      app.rewinding = false;
     if (ev.type == SDL_KEYUP && ev.key.keysym.sym == SDLK_SPACE) {
       if (app.charging) {
         // Fire!
         app.charging = false;
         auto& club = qg::game::CLUBS[app.selected_club];
-        qe::math::Vec3 aim(std::sin(app.aim_yaw), 0, -std::cos(app.aim_yaw));
-        app.physics.launch(app.ball, club.launch_velocity(aim, app.power), club.default_spin(aim));
-        app.ball_in_play = true;
-        app.stroke_count++;
-        std::cout << "Shot " << app.stroke_count << " | " << club.name
+        app.tick.shot = qg::game::record_shot(app.sim, app.selected_club, app.aim_yaw, app.power);
+        app.tick.has_shot = true;
+        qg::game::save_world(app.sim, &app.particle_system, app.mulligan);
+        app.sim.shoot(app.selected_club, app.aim_yaw, app.power);
+        std::cout << "Shot " << app.sim.stroke_count << " | " << club.name
                   << " | Power: " << static_cast<int>(app.power * 100) << "%\n";
       }
     }
   }
   app.input.poll();
+  apply_input(app);
+}
+
+/**
+ * Advance the sim over dt seconds of wall time in fixed ticks. Each tick
+ * gets the input stamped before it ends and is recorded on its own; a shot
+ * or hole change taken this frame rides on the first tick (as replay
+ * playback applies it).
+ */
+void run_sim_ticks(App& app, float dt) {
+  const double now = app.input.clock();
+  const float step = app.sim_hz > 0.0f ? 1.0f / app.sim_hz : dt;
+  bool stepped = false;
+  app.sim_lag += dt;
+  while (app.running && step > 0.0f && app.sim_lag >= step) {
+    app.sim_lag -= step;
+    app.tick.dt = step;
+    app.tick.input = app.input.tick_frame(now - app.sim_lag, step);
+    app.input.set_frame(app.tick.input);
+    update(app, step);
+    if (!app.record_path.empty())
+      app.recorder.write(app.tick);
+    app.tick = qg::game::ReplayTick{};
+    stepped = true;
+  }
+  if (stepped && !world_idle(app))
+    app.history.capture(app.sim, &app.particle_system);
+}
 
+/** Act on the frame's buttons; shared by live input and replay playback. */
+void apply_input(App& app) {
   if (app.input.quit())
     app.running = false;
 
@@ -524,16 +762,84 @@ void handle_events(App& app) {
 
   // Reset ball
   if (app.input.reset()) {
-    setup_hole(app, app.current_hole);
+    setup_hole(app, app.sim.current_hole);
+  }
+}
+
+// ── Replay ──────────────────────────────────────────────────────────────────
+
+/** Advance the replay for one rendered frame of `dt` wall-clock seconds. */
+void play_replay(App& app, float dt) {
+  // Only window events are live; Esc or closing the window stops playback
+  SDL_Event ev;
+  while (SDL_PollEvent(&ev)) {
+    if (ev.type == SDL_QUIT || (ev.type == SDL_KEYDOWN && ev.key.keysym.sym == SDLK_ESCAPE))
+      app.running = false;
+    if (ev.type == SDL_WINDOWEVENT && ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+      qe::renderer::gl::glViewport(0, 0, ev.window.data1, ev.window.data2);
+      app.camera.config.aspect = static_cast<float>(ev.window.data1) / ev.window.data2;
+    }
+  }
+
+  // Real time: run recorded ticks until they cover the elapsed wall time
+  app.replay_lag += dt;
+  while (app.running && (app.replay_max_speed || app.replay_lag > 0.0)) {
+    qg::game::ReplayTick& t = app.tick;
+    if (!app.replay.next(t, static_cast<int>(app.sim.holes.size()))) {
+      std::cout << (app.replay.failed() ? "Replay stopped.\n" : "Replay finished.\n");
+      app.replaying = false;
+      app.replay_lag = 0.0;
+      t = qg::game::ReplayTick{};  // Live ticks start clean
+      return;
+    }
+    if (t.hole >= 0)
+      setup_hole(app, t.hole);
+    if (t.has_shot) {
+      const auto& s = t.shot;
+      if (!qg::game::same_lie(app.sim, s))
+        std::cerr << "Replay desync: shot from a different lie\n";
+      app.selected_club = s.club;
+      app.aim_yaw = s.aim_yaw;
+      app.power = s.power;
+      app.charging = false;
+      app.sim.shoot(s.club, s.aim_yaw, s.power, s.spin);
+    }
+    app.input.set_frame(t.input);
+    apply_input(app);
+    update(app, t.dt);
+    app.replay_lag -= t.dt;
+    if (app.replay_max_speed)
+      break;
   }
 }
 
+// ── Mulligan / Rewind ───────────────────────────────────────────────────────
+
+/** Put the world back as it was just before the last shot. */
+void take_mulligan(App& app) {
+  if (!app.record_path.empty() || app.mulligan.size() == 0)
+    return;
+  if (!qg::game::load_world(app.sim, &app.particle_system, app.mulligan.data()))
+    return;
+  app.charging = false;
+  app.power = 0;
+  app.history.clear();  // The abandoned shot is not rewindable
+  std::cout << "Mulligan! Stroke " << app.sim.stroke_count + 1 << " again.\n";
+}
+
+/** Step the world back one recorded frame; the camera keeps following. */
+void rewind_frame(App& app, float dt) {
+  app.charging = false;
+  app.history.step_back(app.sim, &app.particle_system);
+  update_camera(app, dt);
+}
+
 // ── Update ──────────────────────────────────────────────────────────────────
 void update(App& app, float dt) {
+  QE_PROFILE_SCOPE("update");
   app.time += dt;
-
-  // Update enemies
-  app.enemy_manager.update(dt, app.ball.position);
+  app.audio_system.update();  // Publish sounds loaded in the background
+  app.audio_system.set_listener(app.camera.position(), app.camera.right_dir());
 
   // Power meter
   if (app.charging) {
@@ -577,143 +883,183 @@ void update(App& app, float dt) {
   }
 
   // Aim adjustment (when ball stopped)
-  if (app.ball.stopped && !app.free_cam) {
-    app.aim_yaw += app.input.look_x() * 0.003f;
+  if (app.sim.ball.stopped && !app.free_cam) {
+    app.aim_yaw += app.input.look_x() * kAimRadiansPerPixel;
     // Gamepad aim
     app.aim_yaw += app.input.move_right() * dt * 2.0f;
   }
-
-  // Ball physics
-  app.physics.update(app.ball, app.terrain, dt);
-
-  // Enemy collision
-  if (app.ball.in_flight || app.ball.rolling) {
-    qe::math::Vec3 normal;
-    int points =
-        app.enemy_manager.check_collision(app.ball.position, app.physics.constants.radius, normal);
-    if (points > 0) {
-      // Reflect velocity
-      float v_dot_n = app.ball.velocity.dot(normal);
-      // Only reflect if moving towards enemy
-      if (v_dot_n < 0) {
-        app.ball.velocity = app.ball.velocity - normal * (2.0f * v_dot_n);
-        // Add some energy loss and maybe randomness
-        app.ball.velocity = app.ball.velocity * 0.7f;
-        app.total_score += points;
-        std::cout << "Bonk! Enemy hit. +" << points << " Points (Total: " << app.total_score
-                  << ")\n";
-
-        // Play sound
-        // app.audio_system.play("hit");
-        // Synthetic fallback
-        app.audio_system.play_synthetic(440.0f + (points > 10 ? 220.0f : 0.0f), 0.1f);
-
-        // Spawn particles
-        app.particle_system.spawn(app.ball.position, 20, {1.0f, 0.8f, 0.2f});
-      }
-    }
+  // Aiming or charging (Space is the up axis) keeps the enemies awake; the
+  // frame is part of the replay, so playback wakes on the same ticks
+  app.sim.apply_input(app.input.frame());
+
+  // Enemies, ball physics and rules
+  qg::game::SimEvents ev = app.sim.step(dt);
+  if (ev.enemy_points > 0) {
+    std::cout << "Bonk! Enemy hit. +" << ev.enemy_points
+              << " Points (Total: " << app.sim.total_score << ")\n";
+
+    // Play sound where the hit happened; a burst of hits may be virtualized
+    // app.audio_system.play_at("hit", app.sim.ball.position, 0.5f, qe::audio::Priority::Low);
+    // Synthetic fallback
+    qe::audio::SynthParams bonk;
+    bonk.frequency = 440.0f + (ev.enemy_points > 10 ? 220.0f : 0.0f);
+    bonk.duration = 0.1f;
+    bonk.amplitude = 3000.0f / 32767.0f;
+    app.audio_system.play_synth_at(bonk, app.sim.ball.position, 0.5f, qe::audio::Priority::Low);
+
+    // Spawn particles
+    app.particle_system.spawn(app.sim.ball.position, 20, {1.0f, 0.8f, 0.2f});
   }
 
   // Update Particles
   app.particle_system.update(dt);
 
-  // Check if ball in water — penalty
-  if (app.ball.in_water) {
+  // Water — the sim has already added the penalty and re-teed the ball
+  if (ev.water) {
     std::cout << "Water hazard! 1 stroke penalty.\n";
-    app.stroke_count++;
-    // Reset ball to last position (simplified: back to tee area)
-    setup_hole(app, app.current_hole);
-    app.stroke_count = app.stroke_count;  // Preserve stroke count
+    app.aim_yaw = app.sim.pin_yaw();
   }
 
-  // Check if ball reached green and stopped near pin
-  if (app.ball.stopped && app.ball_in_play) {
-    auto& hole = app.holes[app.current_hole];
-    float dist_to_pin = app.ball.position.distance_to(hole.green.pin);
-
-    if (dist_to_pin < 0.3f) {
-      // Holed out!
-      int score = app.stroke_count;
-      int diff = score - hole.par;
-      std::string result;
-      if (diff <= -2)
-        result = "Eagle!";
-      else if (diff == -1)
-        result = "Birdie!";
-      else if (diff == 0)
-        result = "Par";
-      else if (diff == 1)
-        result = "Bogey";
-      else if (diff == 2)
-        result = "Double Bogey";
-      else
-        result = std::to_string(diff) + " over par";
-
-      std::cout << "HOLED! " << result << " (" << score << " strokes)\n";
-      app.scores.push_back(score);
-
-      // Move to next hole
-      int next = app.current_hole + 1;
-      if (next < static_cast<int>(app.holes.size())) {
-        setup_hole(app, next);
-      } else {
-        // Round complete
-        int total = std::accumulate(app.scores.begin(), app.scores.end(), 0);
-        int total_par = std::accumulate(app.holes.begin(), app.holes.end(), 0,
-                                        [](int sum, const auto& h) { return sum + h.par; });
-        std::cout << "\n=== Round Complete! ===\n"
-                  << "Total: " << total << " (" << total - total_par << " to par)\n";
-        setup_hole(app, 0);
-        app.scores.clear();
-      }
+  // Holed out — the sim has recorded the score and moved to the next hole
+  if (ev.holed >= 0) {
+    const auto& hole = app.sim.holes[ev.holed];
+    int score = ev.hole_strokes;
+    int diff = score - hole.par;
+    std::string result;
+    if (diff <= -2)
+      result = "Eagle!";
+    else if (diff == -1)
+      result = "Birdie!";
+    else if (diff == 0)
+      result = "Par";
+    else if (diff == 1)
+      result = "Bogey";
+    else if (diff == 2)
+      result = "Double Bogey";
+    else
+      result = std::to_string(diff) + " over par";
+
+    std::cout << "HOLED! " << result << " (" << score << " strokes)\n";
+    if (ev.round_complete) {
+      std::cout << "\n=== Round Complete! ===\n"
+                << "Total: " << ev.round_strokes << " ("
+                << ev.round_strokes - app.sim.course_par() << " to par)\n";
     }
-    app.ball_in_play = !app.ball.stopped || !app.ball_in_play;
+    setup_hole(app, app.sim.current_hole);
   }
 
-  // Camera follows ball
+  update_camera(app, dt);
+}
+
+/** Follow the ball (or fly the free camera) and advance camera smoothing. */
+void update_camera(App& app, float dt) {
   if (!app.free_cam) {
-    if (app.ball.in_flight || app.ball.rolling) {
+    if (app.sim.ball.in_flight || app.sim.ball.rolling) {
       // Track shot — behind and above ball
-      qe::math::Vec3 behind = app.ball.velocity.normalized() * -1.0f;
+      qe::math::Vec3 behind = app.sim.ball.velocity.normalized() * -1.0f;
       if (behind.length() < 0.5f)
         behind = {0, 0, 1};
       behind.y = 0;
       behind = behind.normalized();
-      qe::math::Vec3 target = app.ball.position + behind * 8 + qe::math::Vec3(0, 4, 0);
+      qe::math::Vec3 target = app.sim.ball.position + behind * 8 + qe::math::Vec3(0, 4, 0);
+      target = resolve_camera_collision(app, app.sim.ball.position, target);
       app.camera.set_position(app.camera.position().lerp(target, dt * 3));
+      app.camera_settled = false;
       // Look at ball
-      auto dir = (app.ball.position - app.camera.position()).normalized();
+      auto dir = (app.sim.ball.position - app.camera.position()).normalized();
       float pitch = -std::asin(dir.y);
       float yaw_angle = std::atan2(dir.x, -dir.z);
       app.camera.set_angles(yaw_angle, pitch);
     } else {
       // Behind ball, looking toward aim direction
       qe::math::Vec3 aim(std::sin(app.aim_yaw), 0, -std::cos(app.aim_yaw));
-      qe::math::Vec3 target = app.ball.position - aim * 6 + qe::math::Vec3(0, 3, 0);
+      qe::math::Vec3 target = app.sim.ball.position - aim * 6 + qe::math::Vec3(0, 3, 0);
+      target = resolve_camera_collision(app, app.sim.ball.position, target);
       app.camera.set_position(app.camera.position().lerp(target, dt * 5));
-      auto dir = (app.ball.position - app.camera.position()).normalized();
+      app.camera_settled = (target - app.camera.position()).length_squared() < 1e-6f;
+      auto dir = (app.sim.ball.position - app.camera.position()).normalized();
       float pitch = -std::asin(dir.y);
       float yaw_angle = std::atan2(dir.x, -dir.z);
       app.camera.set_angles(yaw_angle, pitch);
     }
   } else {
-    // Free camera
+    // Free camera — click to aim at the terrain under the crosshair
+    if (app.input.shoot_pressed())
+      pick_aim_target(app);
     app.camera.process_mouse(app.input.look_x(), app.input.look_y());
     app.camera.process_movement(app.input.move_forward(), app.input.move_right(),
                                 app.input.move_up(), app.input.sprint(), dt);
+    app.camera_settled = true;  // Camera::at_rest() covers free-flight smoothing
   }
   app.camera.update(dt);
 }
 
+/** True when a frame would look like the last one: nothing moves or animates. */
+bool world_idle(const App& app) {
+  return app.sim.asleep() && !app.charging && !app.rewinding &&
+         app.particle_system.particles.empty() && app.camera_settled && app.camera.at_rest();
+}
+
+// ── Camera Collision / Picking ──────────────────────────────────────────────
+
+/** Pull the follow camera in front of any terrain between it and the ball. */
+qe::math::Vec3 resolve_camera_collision(const App& app, const qe::math::Vec3& focus,
+                                        const qe::math::Vec3& desired) {
+  constexpr float kClearance = 0.5f;
+  qe::math::Vec3 from = focus + qe::math::Vec3(0, kClearance, 0);
+  qe::math::Vec3 result = desired;
+
+  app.sim.with_ground([&](const auto& terrain) {
+    qg::terrain::TerrainHit hit;
+    if (terrain.segment_cast(from, desired, hit)) {
+      result = from.lerp(desired, std::max(0.0f, hit.t - 0.05f));
+    }
+    float ground = terrain.height_at_world(result.x, result.z) + kClearance;
+    if (result.y < ground)
+      result.y = ground;
+  });
+  return result;
+}
+
+/** Aim the shot at the terrain point under the screen centre. */
+void pick_aim_target(App& app) {
+  qg::terrain::TerrainHit hit;
+  if (!app.sim.with_ground([&](const auto& terrain) {
+        return terrain.raycast(app.camera.position(), app.camera.forward(),
+                               app.camera.config.far_z, hit);
+      }))
+    return;
+  auto to_target = hit.point - app.sim.ball.position;
+  app.aim_yaw = std::atan2(to_target.x, -to_target.z);
+  std::cout << "Aim: " << static_cast<int>(to_target.length()) << "m ("
+            << qg::terrain::get_surface(hit.surface).name() << ")\n";
+}
+
 // ── Render: World ───────────────────────────────────────────────────────────
-void render_world(App& app) {
+/** With --tiles: page tiles around the ball and camera, upload meshes near the camera. */
+void page_terrain(App& app) {
+  if (!app.sim.streamed)
+    return;
+  QE_PROFILE_SCOPE("page terrain");
+  const qe::math::Vec3 focus[] = {app.sim.ball.position, app.camera.position()};
+  app.streaming.update(focus, 2);
+  app.tile_meshes.update(app.streaming, app.camera.position());
+}
+
+void render_world(App& app, const qe::input::InputSample& latched) {
+  QE_PROFILE_SCOPE("render_world");
+  QE_ALLOC_TAG(Render);
   using namespace qe::renderer::gl;
   using namespace qe::math;
 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   app.world_shader.use();
 
-  Mat4 vp = app.camera.vp_matrix();
+  // Mouse motion the sim has not consumed yet turns the view (free camera)
+  // or the aim line, so the picture answers the hand before the next tick
+  const bool aiming = app.sim.ball.stopped && !app.free_cam;
+  Mat4 vp = app.free_cam ? app.camera.vp_matrix_latched(latched.dx, latched.dy)
+                         : app.camera.vp_matrix();
   app.world_shader.set_mat4("uViewProjection", vp);
   app.world_shader.set_vec3("uLightDir", Vec3(0.4f, 0.8f, 0.3f).normalized());
   app.world_shader.set_vec3("uLightColor", Vec3(1.0f, 0.98f, 0.92f));
@@ -722,33 +1068,44 @@ void render_world(App& app) {
   app.world_shader.set_int("uUseTexture", 0);
 
   // Enemies
-  app.enemy_manager.draw(app.world_shader);
+  {
+    QE_GPU_SCOPE(app.gpu_profiler, "enemies");
+    app.sim.enemies.draw(app.world_shader);
+  }
 
   // Particles
-  app.particle_system.draw(view_proj);
+  {
+    QE_GPU_SCOPE(app.gpu_profiler, "particles");
+    app.particle_system.draw(vp);
+  }
 
   // Terrain
-  app.world_shader.set_mat4("uModel", Mat4::identity());
-  glDisable(GL_CULL_FACE);
-  app.terrain.draw();
-  glEnable(GL_CULL_FACE);
+  {
+    QE_GPU_SCOPE(app.gpu_profiler, "terrain");
+    app.world_shader.set_mat4("uModel", Mat4::identity());
+    glDisable(GL_CULL_FACE);
+    if (app.sim.streamed)
+      app.tile_meshes.for_each([](const qe::renderer::Mesh& m) { m.draw(); });
+    else
+      app.sim.terrain.draw();
+    glEnable(GL_CULL_FACE);
+  }
 
   // Ball
   app.world_shader.set_mat4("uModel",
-                            Mat4::trs(app.ball.position, Quaternion::identity(), Vec3::one()));
+                            Mat4::trs(app.sim.ball.position, Quaternion::identity(), Vec3::one()));
   app.ball_mesh.draw();
 
   // Flag pins for all holes
-  for (const auto& hole : app.holes) {
+  for (const auto& hole : app.sim.holes) {
     auto pin = hole.green.pin;
-    pin.y = app.terrain.height_at_world(pin.x, pin.z);
+    pin.y = app.sim.with_ground(
+        [&](const auto& terrain) { return terrain.height_at_world(pin.x, pin.z); });
 
     // Pole
     app.world_shader.set_mat4("uModel", Mat4::trs(pin, Quaternion::identity(), Vec3::one()));
     glLineWidth(2.0f);
-    glBindVertexArray(app.flag_pole.vao);
-    glDrawElements(GL_LINES, 2, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    app.flag_pole.draw_lines();
     glLineWidth(1.0f);
 
     // Flag triangle (waving)
@@ -761,63 +1118,109 @@ void render_world(App& app) {
   }
 
   // Aim line (when ball stopped)
-  if (app.ball.stopped) {
-    auto aim_rot = Quaternion::from_axis_angle(Vec3::up(), app.aim_yaw);
-    app.world_shader.set_mat4("uModel", Mat4::trs(app.ball.position, aim_rot, Vec3::one()));
+  if (app.sim.ball.stopped) {
+    float yaw = app.aim_yaw + (aiming ? latched.dx * kAimRadiansPerPixel : 0.0f);
+    auto aim_rot = Quaternion::from_axis_angle(Vec3::up(), yaw);
+    app.world_shader.set_mat4("uModel", Mat4::trs(app.sim.ball.position, aim_rot, Vec3::one()));
     glLineWidth(2.0f);
-    glBindVertexArray(app.aim_line.vao);
-    glDrawElements(GL_LINES, 2, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    app.aim_line.draw_lines();
     glLineWidth(1.0f);
   }
 }
 
 // ── Render: HUD ─────────────────────────────────────────────────────────────
 void render_hud(App& app) {
+  QE_PROFILE_SCOPE("render_hud");
+  QE_ALLOC_TAG(Render);
+  QE_GPU_SCOPE(app.gpu_profiler, "hud");
   using namespace qe::renderer::gl;
 
   glDisable(GL_DEPTH_TEST);
   app.hud_shader.use();
 
   // Power bar (always visible when ball stopped)
-  if (app.ball.stopped || app.charging) {
+  if (app.sim.ball.stopped || app.charging) {
     app.power_bar_bg.draw();
     if (app.charging) {
       app.power_bar_fill.draw();
     }
   }
 
+  // Performance overlay: every quad in one draw with the HUD shader
+  if (app.overlay.visible) {
+    int w = 0, h = 0;
+    SDL_GL_GetDrawableSize(app.window, &w, &h);
+    app.overlay.update(w, h);
+    app.overlay.draw();
+  }
+
   glEnable(GL_DEPTH_TEST);
 }
 
+// ── Profiling ───────────────────────────────────────────────────────────────
+/** Start recording a CPU profile, or stop and write it as a Chrome trace. */
+void toggle_profiling(App& app) {
+  auto& profiler = qe::core::Profiler::instance();
+  if (!qe::core::Profiler::enabled()) {
+    profiler.clear();
+    qe::core::Profiler::set_enabled(true);
+    std::cout << "Profiling...\n";
+    return;
+  }
+  qe::core::Profiler::set_enabled(false);
+  if (profiler.write_chrome_trace(app.trace_path))
+    std::cout << "Wrote CPU profile to " << app.trace_path << "\n";
+  else
+    std::cerr << "Could not write " << app.trace_path << "\n";
+}
+
 // ── Title ───────────────────────────────────────────────────────────────────
 void update_title(App& app) {
-  if (app.current_hole >= static_cast<int>(app.holes.size()))
+  if (app.sim.current_hole >= static_cast<int>(app.sim.holes.size()))
     return;
-  auto& hole = app.holes[app.current_hole];
-  auto surface_type = app.terrain.surface_at_world(app.ball.position.x, app.ball.position.z);
+  auto& hole = app.sim.hole();
+  const auto& ball = app.sim.ball;
+  auto surface_type = app.sim.with_ground([&](const auto& terrain) {
+    return terrain.surface_at_world(ball.position.x, ball.position.z);
+  });
   auto surface = qg::terrain::get_surface(surface_type);
 
-  float dist_to_pin = app.ball.position.distance_to(hole.green.pin);
+  float dist_to_pin = app.sim.distance_to_pin();
 
   std::ostringstream t;
   t << "QuatGolf | " << static_cast<int>(app.current_fps) << " FPS"
-    << " | Hole " << hole.number << " Par " << hole.par << " | Score: " << app.total_score << " | "
-    << qg::game::CLUBS[app.selected_club].name << " | Strokes: " << app.stroke_count << " | "
+    << " | Hole " << hole.number << " Par " << hole.par << " | Score: " << app.sim.total_score
+    << " | "
+    << qg::game::CLUBS[app.selected_club].name << " | Strokes: " << app.sim.stroke_count << " | "
     << static_cast<int>(dist_to_pin) << "m to pin"
     << " | " << surface.name();
-  if (app.ball.in_flight)
+  if (app.sim.ball.in_flight)
     t << " | IN FLIGHT";
-  if (app.ball.rolling)
+  if (app.sim.ball.rolling)
     t << " | ROLLING";
   if (app.input.gamepad_connected())
     t << " | Gamepad: " << app.input.gamepad().name();
+  if (app.input.latency().frames > 0)
+    t << " | Input " << std::fixed << std::setprecision(1) << app.input.latency().avg_ms << " ms";
+  if (app.gpu_profiler.available())
+    t << " | GPU " << std::fixed << std::setprecision(1) << app.gpu_profiler.frame_ms() << " ms";
+  // Last frame's heap allocations and the subsystem that made most of them
+  const auto& allocs = app.frame_allocs;
+  auto worst = qe::core::AllocTag::Other;
+  for (size_t i = 0; i < qe::core::AllocTracker::kTags; ++i)
+    if (allocs[static_cast<qe::core::AllocTag>(i)].allocs > allocs[worst].allocs)
+      worst = static_cast<qe::core::AllocTag>(i);
+  t << " | Allocs " << allocs.total().allocs;
+  if (allocs[worst].allocs > 0)
+    t << " (" << qe::core::alloc_tag_name(worst) << " " << allocs[worst].allocs << ")";
   SDL_SetWindowTitle(app.window, t.str().c_str());
 }
 
 // ── Cleanup ─────────────────────────────────────────────────────────────────
 void cleanup(App& app) {
-  app.terrain.destroy();
+  app.sim.terrain.destroy();
+  app.tile_meshes.clear();
+  app.streaming.close();
   app.ball_mesh.destroy();
   app.flag_pole.destroy();
   app.flag_mesh.destroy();
@@ -826,6 +1229,8 @@ void cleanup(App& app) {
   app.aim_line.destroy();
   app.world_shader.destroy();
   app.hud_shader.destroy();
+  app.gpu_profiler.destroy();
+  app.overlay.destroy();
   if (app.gl_context)
     SDL_GL_DeleteContext(app.gl_context);
   if (app.window)
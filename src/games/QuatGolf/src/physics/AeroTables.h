@@ -0,0 +1,151 @@
+#pragma once
+/**
+ * @file AeroTables.h
+ * @brief Drag and lift coefficients tabulated over ball speed and spin rate.
+ *
+ * A dimpled ball's Cd and Cl depend on the Reynolds number Re = v d / nu and
+ * on the spin ratio S = r omega / v. AeroModel is a small empirical fit:
+ *
+ *   - Drag crisis: Cd drops from cd_subcritical to the supercritical value
+ *     through a logistic step centred on re_critical
+ *   - Supercritical drag: Cd = cd_base + cd_spin * S
+ *   - Lift: Cl = cl_scale * S^cl_exponent, capped at cl_max
+ *
+ * The fit needs exp() and pow(), so it is only evaluated when building an
+ * AeroTable: a (speed, spin rate) grid of {Cd, Cl} pairs. Speed nodes are
+ * uniform; spin nodes are spaced quadratically (denser near zero, where
+ * S^0.4 is steepest), so a lookup is one sqrt and a clamped bilinear blend
+ * with no transcendental calls. BallPhysics does one per flight step.
+ * AeroTable::standard() builds the default model once and shares it.
+ *
+ * Design by Contract:
+ *   - Precondition: max_speed, max_spin > 0; at least one cell per axis
+ *   - Postcondition: lookup() equals the model exactly at grid nodes and is
+ *     continuous between them; inputs outside the grid are clamped
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "core/Contracts.h"
+
+namespace qg {
+namespace physics {
+
+struct AeroCoeffs {
+  float cd = 0.0f;  // Drag coefficient
+  float cl = 0.0f;  // Lift (Magnus) coefficient
+};
+
+/** Empirical Cd/Cl fit for a golf ball; tune the fields, then build a table. */
+struct AeroModel {
+  float diameter = 0.0427f;             // m
+  float kinematic_viscosity = 1.48e-5f;  // m²/s (air at 15 °C)
+
+  float cd_subcritical = 0.50f;  // Below the drag crisis
+  float re_critical = 6.0e4f;    // Centre of the drag crisis
+  float re_width = 1.0e4f;       // Logistic width of the transition
+  float cd_base = 0.24f;         // Supercritical Cd without spin
+  float cd_spin = 0.18f;         // Added Cd per unit spin ratio
+
+  float cl_scale = 0.54f;
+  float cl_exponent = 0.4f;
+  float cl_max = 0.35f;
+
+  float reynolds(float speed) const {
+    return speed * diameter / kinematic_viscosity;
+  }
+
+  /** r omega / v; a ball spinning at (almost) zero speed saturates lift. */
+  float spin_ratio(float speed, float spin_rate) const {
+    return 0.5f * diameter * spin_rate / std::max(speed, 1e-3f);
+  }
+
+  AeroCoeffs eval(float speed, float spin_rate) const {
+    float s = spin_ratio(speed, spin_rate);
+    float crisis = 1.0f / (1.0f + std::exp(-(reynolds(speed) - re_critical) / re_width));
+    float cd_super = cd_base + cd_spin * std::min(s, 1.0f);
+    AeroCoeffs c;
+    c.cd = cd_subcritical + (cd_super - cd_subcritical) * crisis;
+    c.cl = s > 0.0f ? std::min(cl_scale * std::pow(s, cl_exponent), cl_max) : 0.0f;
+    return c;
+  }
+};
+
+class AeroTable {
+ public:
+  /**
+   * Sample `model` on (speed_cells + 1) x (spin_cells + 1) nodes spanning
+   * [0, max_speed] m/s and [0, max_spin] rad/s; spin node j sits at
+   * max_spin * (j / spin_cells)^2.
+   */
+  explicit AeroTable(const AeroModel& model = {}, float max_speed = 100.0f, int speed_cells = 64,
+                     float max_spin = 600.0f, int spin_cells = 32)
+      : model_(model), speed_cells_(speed_cells), spin_cells_(spin_cells) {
+    QE_REQUIRE(max_speed > 0.0f && max_spin > 0.0f && speed_cells > 0 && spin_cells > 0,
+               "AeroTable: empty grid");
+    speed_step_ = max_speed / speed_cells;
+    inv_speed_step_ = 1.0f / speed_step_;
+    max_spin_ = max_spin;
+    inv_max_spin_ = 1.0f / max_spin;
+    nodes_.resize(static_cast<size_t>(speed_cells + 1) * (spin_cells + 1));
+    for (int i = 0; i <= speed_cells; ++i) {
+      for (int j = 0; j <= spin_cells; ++j) {
+        float f = static_cast<float>(j) / spin_cells;
+        nodes_[index(i, j)] = model.eval(i * speed_step_, max_spin * f * f);
+      }
+    }
+  }
+
+  /** Bilinear Cd/Cl at a speed (m/s) and spin rate (rad/s). */
+  AeroCoeffs lookup(float speed, float spin_rate) const {
+    float fu = std::clamp(speed * inv_speed_step_, 0.0f, static_cast<float>(speed_cells_));
+    float fv = std::sqrt(std::clamp(spin_rate * inv_max_spin_, 0.0f, 1.0f)) * spin_cells_;
+    int i = std::min(static_cast<int>(fu), speed_cells_ - 1);
+    int j = std::min(static_cast<int>(fv), spin_cells_ - 1);
+    float tu = fu - i, tv = fv - j;
+
+    const AeroCoeffs& a = nodes_[index(i, j)];
+    const AeroCoeffs& b = nodes_[index(i, j + 1)];
+    const AeroCoeffs& c = nodes_[index(i + 1, j)];
+    const AeroCoeffs& d = nodes_[index(i + 1, j + 1)];
+    AeroCoeffs r;
+    float cd0 = a.cd + (b.cd - a.cd) * tv, cd1 = c.cd + (d.cd - c.cd) * tv;
+    float cl0 = a.cl + (b.cl - a.cl) * tv, cl1 = c.cl + (d.cl - c.cl) * tv;
+    r.cd = cd0 + (cd1 - cd0) * tu;
+    r.cl = cl0 + (cl1 - cl0) * tu;
+    return r;
+  }
+
+  const AeroModel& model() const noexcept {
+    return model_;
+  }
+  float max_speed() const noexcept {
+    return speed_step_ * speed_cells_;
+  }
+  float max_spin() const noexcept {
+    return max_spin_;
+  }
+
+  /** Table for the default model, built on first use and shared. */
+  static std::shared_ptr<const AeroTable> standard() {
+    static const std::shared_ptr<const AeroTable> table = std::make_shared<const AeroTable>();
+    return table;
+  }
+
+ private:
+  AeroModel model_;
+  int speed_cells_, spin_cells_;
+  float speed_step_ = 0.0f, inv_speed_step_ = 0.0f;
+  float max_spin_ = 0.0f, inv_max_spin_ = 0.0f;
+  std::vector<AeroCoeffs> nodes_;  // Speed-major: spin varies fastest
+
+  size_t index(int i, int j) const noexcept {
+    return static_cast<size_t>(i) * (spin_cells_ + 1) + j;
+  }
+};
+
+}  // namespace physics
+}  // namespace qg
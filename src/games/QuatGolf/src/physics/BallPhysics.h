@@ -4,10 +4,15 @@
  * @brief Golf ball flight and terrain interaction physics.
  *
  * Physics model:
- *   - Flight: gravity + aerodynamic drag + lift (Magnus from spin)
- *   - Terrain contact: bounce (restitution * surface), rolling friction
+ *   - Flight: gravity + aerodynamic drag + lift (Magnus from spin), with
+ *     Cd and Cl looked up by speed and spin rate (AeroTables.h)
+ *   - Terrain contact: swept segment vs. heightfield (no tunnelling through
+ *     ridges on fast, low shots), bounce (restitution * surface)
  *   - Rolling: deceleration from surface friction, terrain slope
  *
+ * The ground is a terrain::Terrain or a terrain::StreamingTerrain: any type
+ * with Terrain's segment_cast(), sample() and height_at_world().
+ *
  * Design by Contract:
  *   - Invariant: ball position always has a valid terrain height below it
  *   - Postcondition: after update(), speed >= 0
@@ -18,9 +23,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include "../terrain/Surface.h"
 #include "../terrain/Terrain.h"
+#include "AeroTables.h"
 #include "math/Vec3.h"
 
 namespace qg {
@@ -46,8 +53,8 @@ struct BallConstants {
   float mass = 0.04593f;       // kg (regulation golf ball)
   float radius = 0.02135f;     // metres
   float area = 0.001432f;      // m² (cross-section)
-  float drag_coeff = 0.25f;    // Cd (dimpled ball)
-  float lift_coeff = 0.18f;    // Cl (Magnus effect)
+  float drag_coeff = 0.25f;    // Cd (dimpled ball) when BallPhysics::aero is null
+  float lift_coeff = 0.18f;    // Cl (Magnus effect) when BallPhysics::aero is null
   float air_density = 1.225f;  // kg/m³
 
   float gravity = 9.81f;      // m/s²
@@ -62,14 +69,29 @@ class BallPhysics {
  public:
   BallConstants constants;
 
+  /** Cd/Cl by speed and spin; shared by copies. Null = constant coefficients. */
+  std::shared_ptr<const AeroTable> aero = AeroTable::standard();
+
+  /** Drag and lift coefficients at an airspeed (m/s) and spin rate (rad/s). */
+  AeroCoeffs coefficients(float speed, float spin_rate) const {
+    if (aero)
+      return aero->lookup(speed, spin_rate);
+    AeroCoeffs c;
+    c.cd = constants.drag_coeff;
+    c.cl = constants.lift_coeff;
+    return c;
+  }
+
   /** Update ball state for one timestep. */
-  void update(BallState& ball, const terrain::Terrain& terrain, float dt) {
+  template <typename Ground>
+  void update(BallState& ball, const Ground& terrain, float dt) {
     if (ball.stopped || ball.in_water)
       return;
 
     if (ball.in_flight) {
+      qe::math::Vec3 prev = ball.position;
       update_flight(ball, dt);
-      check_terrain_contact(ball, terrain);
+      check_terrain_contact(ball, terrain, prev);
     } else if (ball.rolling) {
       update_rolling(ball, terrain, dt);
     }
@@ -97,18 +119,18 @@ class BallPhysics {
       return;
 
     Vec3 drag_dir = rel_vel.normalized() * -1.0f;
+    float spin_rate = ball.spin.length();
+    AeroCoeffs coeff = coefficients(speed, spin_rate);
 
     // Drag: F = 0.5 * rho * Cd * A * v²
-    float drag_force =
-        0.5f * constants.air_density * constants.drag_coeff * constants.area * speed * speed;
+    float drag_force = 0.5f * constants.air_density * coeff.cd * constants.area * speed * speed;
     Vec3 drag_accel = drag_dir * (drag_force / constants.mass);
 
     // Magnus lift: F perpendicular to velocity, proportional to spin
     Vec3 lift_accel;
-    if (ball.spin.length() > 0.01f) {
+    if (spin_rate > 0.01f) {
       Vec3 lift_dir = ball.spin.cross(rel_vel).normalized();
-      float lift_force =
-          0.5f * constants.air_density * constants.lift_coeff * constants.area * speed * speed;
+      float lift_force = 0.5f * constants.air_density * coeff.cl * constants.area * speed * speed;
       lift_accel = lift_dir * (lift_force / constants.mass);
     }
 
@@ -124,64 +146,78 @@ class BallPhysics {
     ball.spin = ball.spin * 0.999f;
   }
 
-  /** Check if ball has hit the terrain. */
-  void check_terrain_contact(BallState& ball, const terrain::Terrain& terrain) {
-    float ground_y = terrain.height_at_world(ball.position.x, ball.position.z);
+  /**
+   * Check if ball has hit the terrain during the last step.
+   * Sweeps the bottom of the ball from its previous to its new position so
+   * ridges between the two samples are not skipped; falls back to the
+   * end-of-step height test when the sweep finds nothing (e.g. the ball
+   * started the step below the surface or left the grid).
+   */
+  template <typename Ground>
+  void check_terrain_contact(BallState& ball, const Ground& terrain, const qe::math::Vec3& prev) {
+    const qe::math::Vec3 lift(0, constants.radius, 0);
+    terrain::SurfaceType surface_type;
+    qe::math::Vec3 normal;
+
+    terrain::TerrainHit hit;
+    if (terrain.segment_cast(prev - lift, ball.position - lift, hit)) {
+      ball.position = hit.point + lift;
+      surface_type = hit.surface;
+      normal = hit.normal;
+    } else {
+      auto ground = terrain.sample(ball.position.x, ball.position.z);
+      if (ball.position.y > ground.height + constants.radius)
+        return;
+      ball.position.y = ground.height + constants.radius;
+      surface_type = ground.surface;
+      normal = ground.normal;
+    }
 
-    if (ball.position.y <= ground_y + constants.radius) {
-      ball.position.y = ground_y + constants.radius;
+    // Water hazard — ball stops immediately
+    if (surface_type == terrain::SurfaceType::Water) {
+      ball.in_water = true;
+      ball.in_flight = false;
+      ball.velocity = {0, 0, 0};
+      return;
+    }
 
-      // Get surface properties
-      auto surface_type = terrain.surface_at_world(ball.position.x, ball.position.z);
+    const auto& surface = terrain::surface_props(surface_type);
 
-      // Water hazard — ball stops immediately
-      if (surface_type == terrain::SurfaceType::Water) {
-        ball.in_water = true;
-        ball.in_flight = false;
-        ball.velocity = {0, 0, 0};
-        return;
-      }
+    // Bounce
+    float v_dot_n = ball.velocity.dot(normal);
+    if (v_dot_n < 0) {
+      // Reflect velocity off terrain normal
+      ball.velocity = ball.velocity - normal * (2.0f * v_dot_n);
 
-      auto surface = terrain::get_surface(surface_type);
-      auto normal = terrain.normal_at_world(ball.position.x, ball.position.z);
-
-      // Bounce
-      float v_dot_n = ball.velocity.dot(normal);
-      if (v_dot_n < 0) {
-        // Reflect velocity off terrain normal
-        ball.velocity = ball.velocity - normal * (2.0f * v_dot_n);
-
-        // Apply restitution (energy loss)
-        float restitution = surface.bounce * (1.0f - constants.bounce_loss);
-        ball.velocity = ball.velocity * restitution;
-
-        // If bounce is too weak, transition to rolling
-        if (ball.velocity.y < 0.5f) {
-          ball.in_flight = false;
-          ball.rolling = true;
-          ball.velocity.y = 0;  // Cancel vertical
-        }
+      // Apply restitution (energy loss)
+      float restitution = surface.bounce * (1.0f - constants.bounce_loss);
+      ball.velocity = ball.velocity * restitution;
+
+      // If bounce is too weak, transition to rolling
+      if (ball.velocity.y < 0.5f) {
+        ball.in_flight = false;
+        ball.rolling = true;
+        ball.velocity.y = 0;  // Cancel vertical
       }
     }
   }
 
   /** Rolling physics: friction + slope. */
-  void update_rolling(BallState& ball, const terrain::Terrain& terrain, float dt) {
-    float ground_y = terrain.height_at_world(ball.position.x, ball.position.z);
-    ball.position.y = ground_y + constants.radius;
-
-    auto surface_type = terrain.surface_at_world(ball.position.x, ball.position.z);
+  template <typename Ground>
+  void update_rolling(BallState& ball, const Ground& terrain, float dt) {
+    auto ground = terrain.sample(ball.position.x, ball.position.z);
+    ball.position.y = ground.height + constants.radius;
 
     // Water check
-    if (surface_type == terrain::SurfaceType::Water) {
+    if (ground.surface == terrain::SurfaceType::Water) {
       ball.in_water = true;
       ball.rolling = false;
       ball.velocity = {0, 0, 0};
       return;
     }
 
-    auto surface = terrain::get_surface(surface_type);
-    auto normal = terrain.normal_at_world(ball.position.x, ball.position.z);
+    const auto& surface = *ground.props;
+    const auto& normal = ground.normal;
 
     // Slope acceleration (gravity component along terrain)
     qe::math::Vec3 gravity_vec(0, -constants.gravity, 0);
@@ -192,7 +228,7 @@ class BallPhysics {
     float speed = ball.velocity.length();
     qe::math::Vec3 friction_accel;
     if (speed > 0.001f) {
-      friction_accel = ball.velocity.normalized() * -1.0f * surface.friction * constants.gravity;
+      friction_accel = ball.velocity * (-surface.friction * constants.gravity / speed);
     }
 
     // Speed multiplier from surface
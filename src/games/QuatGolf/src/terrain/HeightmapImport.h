@@ -0,0 +1,286 @@
+#pragma once
+/**
+ * @file HeightmapImport.h
+ * @brief Import 16-bit RAW / PGM elevation rasters and surface masks.
+ *
+ * Raster is a read-only view of an 8- or 16-bit grayscale image through a
+ * memory-mapped file: binary PGM ("P5", maxval up to 65535, big-endian
+ * when 16-bit) or headerless RAW with caller-supplied size and byte order.
+ * Samples are decoded straight from the mapping, so an 8k x 8k DEM costs
+ * address space, not heap; the OS pages rows in as the import sweeps them.
+ *
+ * HeightmapImport resamples a raster onto the terrain grid:
+ *   - output spacing cell_size, source spacing source_spacing (metres)
+ *   - downsampling (cell_size >= 2 * source_spacing) box-filters the
+ *     source footprint of each vertex; otherwise bilinear interpolation
+ *   - height = height_offset + sample * height_scale
+ *   - the optional surface mask is sampled nearest-neighbour; its pixel
+ *     value is a SurfaceType index (0 = Tee, 1 = Fairway, ...) and may have
+ *     a different resolution than the elevation raster
+ *
+ * import_tiles() is the whole file-to-file job behind
+ * `quat_golf_headless --import-heightmap`: open the rasters by extension,
+ * then to_tiles().
+ *
+ * to_tiles() writes a TileFile band by band (rows resampled in parallel,
+ * normals and per-tile height bounds computed on the way), so memory stays
+ * bounded by one band of tiles whatever the input size. to_terrain() fills
+ * an in-memory Terrain for maps that fit.
+ *
+ * Design by Contract:
+ *   - Precondition: rasters are at least 2 x 2
+ *   - Postcondition: open_*() == true  ⇒  every sample lies inside the file
+ *   - Errors are reported to std::cerr and returned as false
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Surface.h"
+#include "Terrain.h"
+#include "TileFile.h"
+#include "core/MappedFile.h"
+#include "core/Parallel.h"
+
+namespace qg {
+namespace terrain {
+
+class Raster {
+ public:
+  /** Open a binary PGM (P5), 8- or 16-bit. */
+  bool open_pgm(const std::string& path) {
+    if (!file_.open(path))
+      return fail(path, "cannot open");
+    const uint8_t* p = file_.data();
+    const size_t n = file_.size();
+    if (n < 2 || p[0] != 'P' || p[1] != '5')
+      return fail(path, "not a binary PGM");
+
+    size_t at = 2;
+    long fields[3] = {0, 0, 0};
+    for (long& field : fields) {
+      // Whitespace and '#' comments may separate header fields
+      while (at < n && (std::isspace(p[at]) || p[at] == '#')) {
+        if (p[at] == '#')
+          while (at < n && p[at] != '\n')
+            ++at;
+        else
+          ++at;
+      }
+      if (at >= n || !std::isdigit(p[at]))
+        return fail(path, "malformed header");
+      while (at < n && std::isdigit(p[at]))
+        field = field * 10 + (p[at++] - '0');
+    }
+    ++at;  // Single whitespace before the pixel data
+    if (fields[2] <= 0 || fields[2] > 65535)
+      return fail(path, "bad maxval");
+    return init(path, static_cast<int>(fields[0]), static_cast<int>(fields[1]),
+                fields[2] > 255 ? 2 : 1, true, at);
+  }
+
+  /**
+   * Open by extension: ".raw" is a headerless little-endian 16-bit raster
+   * of raw_width x raw_height samples, anything else a binary PGM.
+   */
+  bool open(const std::string& path, int raw_width = 0, int raw_height = 0) {
+    const bool raw = path.size() >= 4 && path.compare(path.size() - 4, 4, ".raw") == 0;
+    if (!raw)
+      return open_pgm(path);
+    if (raw_width < 2 || raw_height < 2)
+      return fail(path, "RAW needs its size (width x height)");
+    return open_raw(path, raw_width, raw_height);
+  }
+
+  /** Open a headerless raster of width x height samples. */
+  bool open_raw(const std::string& path, int width, int height, int bytes_per_sample = 2,
+                bool big_endian = false) {
+    if (!file_.open(path))
+      return fail(path, "cannot open");
+    return init(path, width, height, bytes_per_sample, big_endian, 0);
+  }
+
+  int width() const noexcept {
+    return width_;
+  }
+  int height() const noexcept {
+    return height_;
+  }
+
+  /** Raw sample value (coordinates clamped to the image). */
+  uint32_t sample(int x, int y) const {
+    x = std::clamp(x, 0, width_ - 1);
+    y = std::clamp(y, 0, height_ - 1);
+    const uint8_t* s = pixels_ + (static_cast<size_t>(y) * width_ + x) * bytes_;
+    if (bytes_ == 1)
+      return s[0];
+    return big_endian_ ? (static_cast<uint32_t>(s[0]) << 8) | s[1]
+                       : (static_cast<uint32_t>(s[1]) << 8) | s[0];
+  }
+
+  float bilinear(float x, float y) const {
+    x = std::clamp(x, 0.0f, static_cast<float>(width_ - 1));
+    y = std::clamp(y, 0.0f, static_cast<float>(height_ - 1));
+    int x0 = std::min(static_cast<int>(x), width_ - 2);
+    int y0 = std::min(static_cast<int>(y), height_ - 2);
+    float fx = x - x0, fy = y - y0;
+    float s0 = sample(x0, y0) + (static_cast<float>(sample(x0 + 1, y0)) - sample(x0, y0)) * fx;
+    float s1 = sample(x0, y0 + 1) +
+               (static_cast<float>(sample(x0 + 1, y0 + 1)) - sample(x0, y0 + 1)) * fx;
+    return s0 + (s1 - s0) * fy;
+  }
+
+  /** Mean of the samples in [x0, x1] x [y0, y1] (clamped, inclusive). */
+  float box_mean(int x0, int y0, int x1, int y1) const {
+    x0 = std::clamp(x0, 0, width_ - 1);
+    x1 = std::clamp(x1, x0, width_ - 1);
+    y0 = std::clamp(y0, 0, height_ - 1);
+    y1 = std::clamp(y1, y0, height_ - 1);
+    uint64_t sum = 0;
+    for (int y = y0; y <= y1; ++y)
+      for (int x = x0; x <= x1; ++x)
+        sum += sample(x, y);
+    return static_cast<float>(sum) / (static_cast<float>(x1 - x0 + 1) * (y1 - y0 + 1));
+  }
+
+ private:
+  qe::core::MappedFile file_;
+  const uint8_t* pixels_ = nullptr;
+  int width_ = 0, height_ = 0;
+  int bytes_ = 2;
+  bool big_endian_ = false;
+
+  bool init(const std::string& path, int w, int h, int bytes, bool big_endian, size_t offset) {
+    if (w < 2 || h < 2 || (bytes != 1 && bytes != 2))
+      return fail(path, "unsupported raster size");
+    if (offset + static_cast<size_t>(w) * h * bytes > file_.size())
+      return fail(path, "truncated pixel data");
+    pixels_ = file_.data() + offset;
+    width_ = w;
+    height_ = h;
+    bytes_ = bytes;
+    big_endian_ = big_endian;
+    return true;
+  }
+
+  bool fail(const std::string& path, const std::string& why) {
+    std::cerr << "Raster: " << path << ": " << why << std::endl;
+    file_.close();
+    pixels_ = nullptr;
+    width_ = height_ = 0;
+    return false;
+  }
+};
+
+struct ImportParams {
+  float source_spacing = 1.0f;  // Metres between elevation samples
+  float cell_size = 1.0f;       // Output grid spacing (metres)
+  float height_scale = 0.01f;   // Metres per sample unit
+  float height_offset = 0.0f;
+  int tile_size = 128;          // to_tiles() only
+  int coarse_step = 16;         // to_tiles() only
+};
+
+class HeightmapImport {
+ public:
+  /** Output vertices across/along the grid for a raster. */
+  static int grid_width(const Raster& heights, const ImportParams& p) {
+    return static_cast<int>((heights.width() - 1) * p.source_spacing / p.cell_size) + 1;
+  }
+  static int grid_depth(const Raster& heights, const ImportParams& p) {
+    return static_cast<int>((heights.height() - 1) * p.source_spacing / p.cell_size) + 1;
+  }
+
+  /** Resampled height of output vertex (gx, gz). Thread-safe. */
+  static float height(const Raster& heights, const ImportParams& p, int gx, int gz) {
+    const float ratio = p.cell_size / p.source_spacing;  // Source pixels per cell
+    float sx = gx * ratio, sy = gz * ratio;
+    float v;
+    if (ratio >= 2.0f) {
+      int r = static_cast<int>(ratio * 0.5f);
+      int cx = static_cast<int>(sx + 0.5f), cy = static_cast<int>(sy + 0.5f);
+      v = heights.box_mean(cx - r, cy - r, cx + r, cy + r);
+    } else {
+      v = heights.bilinear(sx, sy);
+    }
+    return p.height_offset + v * p.height_scale;
+  }
+
+  /** Nearest mask value at output vertex (gx, gz); Rough without a mask. */
+  static SurfaceType surface(const Raster* mask, const Raster& heights, const ImportParams& p,
+                             int gx, int gz) {
+    if (!mask)
+      return SurfaceType::Rough;
+    const float sx = gx * p.cell_size / p.source_spacing * (mask->width() - 1) /
+                     static_cast<float>(heights.width() - 1);
+    const float sy = gz * p.cell_size / p.source_spacing * (mask->height() - 1) /
+                     static_cast<float>(heights.height() - 1);
+    uint32_t v = mask->sample(static_cast<int>(sx + 0.5f), static_cast<int>(sy + 0.5f));
+    return static_cast<SurfaceType>(
+        std::min<uint32_t>(v, static_cast<uint32_t>(SurfaceType::OutOfBounds)));
+  }
+
+  /**
+   * Stream a raster into a tile file. The tiled grid is rounded up to whole
+   * tiles; vertices past the raster edge repeat the edge sample.
+   */
+  static bool to_tiles(const std::string& path, const Raster& heights, const Raster* mask,
+                       const ImportParams& p) {
+    const int w = grid_width(heights, p), d = grid_depth(heights, p);
+    TileLayout layout;
+    layout.tile_size = p.tile_size;
+    layout.tiles_x = (w - 1 + p.tile_size - 1) / p.tile_size;
+    layout.tiles_z = (d - 1 + p.tile_size - 1) / p.tile_size;
+    layout.cell_size = p.cell_size;
+    layout.coarse_step = p.coarse_step;
+    return TileFile::write(
+        path, layout,
+        [&](int gx, int gz) {
+          return height(heights, p, std::min(gx, w - 1), std::min(gz, d - 1));
+        },
+        [&](int gx, int gz) {
+          return surface(mask, heights, p, std::min(gx, w - 1), std::min(gz, d - 1));
+        });
+  }
+
+  /**
+   * Open an elevation raster and an optional mask (empty path = none; a
+   * RAW mask has the raster's size) with Raster::open() and stream them
+   * into a tile file.
+   */
+  static bool import_tiles(const std::string& heights_path, const std::string& mask_path,
+                           const std::string& out_path, const ImportParams& p,
+                           int raw_width = 0, int raw_height = 0) {
+    Raster heights, mask;
+    if (!heights.open(heights_path, raw_width, raw_height))
+      return false;
+    if (!mask_path.empty() && !mask.open(mask_path, raw_width, raw_height))
+      return false;
+    return to_tiles(out_path, heights, mask_path.empty() ? nullptr : &mask, p);
+  }
+
+  /** Resample a raster into an in-memory terrain (rows in parallel). */
+  static void to_terrain(Terrain& t, const Raster& heights, const Raster* mask,
+                         const ImportParams& p) {
+    const int w = grid_width(heights, p), d = grid_depth(heights, p);
+    std::vector<float> hs(static_cast<size_t>(w) * d);
+    std::vector<SurfaceType> ss(hs.size());
+    qe::core::parallel_for(0, d, [&](int lo, int hi) {
+      for (int gz = lo; gz < hi; ++gz)
+        for (int gx = 0; gx < w; ++gx) {
+          size_t i = static_cast<size_t>(gz) * w + gx;
+          hs[i] = height(heights, p, gx, gz);
+          ss[i] = surface(mask, heights, p, gx, gz);
+        }
+    }, 16);
+    t.set_data(w, d, p.cell_size, std::move(hs), std::move(ss));
+  }
+};
+
+}  // namespace terrain
+}  // namespace qg
@@ -0,0 +1,260 @@
+#pragma once
+/**
+ * @file MinMaxPyramid.h
+ * @brief Min/max height mip pyramid for hierarchical heightfield ray casts.
+ *
+ * Level 0 stores the height range of each 2x2 block of terrain cells; every
+ * further level halves the resolution until a single root node covers the
+ * whole grid. Individual cells are not stored (the exact per-cell test is
+ * cheap), so the pyramid costs ~2.7 bytes per cell.
+ *
+ * traverse() walks the quadtree front-to-back along a ray, rejecting whole
+ * nodes whose bounding box the ray misses, and hands surviving cells to a
+ * caller-supplied exact intersection test. update() refreshes only the
+ * nodes above an edited rectangle.
+ *
+ * Design by Contract:
+ *   - Precondition: build() is given a width x depth grid with width, depth >= 2
+ *   - Invariant: each node's [min, max] bounds every vertex of its cells
+ *   - Postcondition: traverse() reports the nearest cell hit within [0, t_max]
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace qg {
+namespace terrain {
+
+class MinMaxPyramid {
+ public:
+  struct Range {
+    float min = 0.0f;
+    float max = 0.0f;
+  };
+
+  /**
+   * Rebuild from a row-major vertex height accessor.
+   * @param height_fn  float(int x, int z), called once per vertex
+   */
+  template <typename HeightFn>
+  void build(int width, int depth, HeightFn&& height_fn) {
+    levels_.clear();
+    width_ = width;
+    depth_ = depth;
+    if (width < 2 || depth < 2)
+      return;
+
+    // Level 0: 2x2 cells = up to 3x3 vertices per node
+    Level base;
+    base.nx = width / 2;  // == ceil((width - 1) / 2)
+    base.nz = depth / 2;
+    base.ranges.resize(static_cast<size_t>(base.nx) * base.nz);
+    levels_.push_back(std::move(base));
+    while (levels_.back().nx > 1 || levels_.back().nz > 1) {
+      const Level& fine = levels_.back();
+      Level coarse;
+      coarse.nx = (fine.nx + 1) / 2;
+      coarse.nz = (fine.nz + 1) / 2;
+      coarse.ranges.resize(static_cast<size_t>(coarse.nx) * coarse.nz);
+      levels_.push_back(std::move(coarse));
+    }
+    refresh(0, 0, levels_[0].nx - 1, levels_[0].nz - 1, height_fn);
+  }
+
+  /**
+   * Refresh the nodes covering an edited vertex rectangle (inclusive) and
+   * their ancestors; cost is proportional to the rectangle, not the grid.
+   */
+  template <typename HeightFn>
+  void update(int vx0, int vz0, int vx1, int vz1, HeightFn&& height_fn) {
+    if (levels_.empty())
+      return;
+    // A vertex on an even line is shared by the nodes on both sides
+    const Level& base = levels_[0];
+    int i0 = std::clamp((vx0 - 1) / 2, 0, base.nx - 1);
+    int j0 = std::clamp((vz0 - 1) / 2, 0, base.nz - 1);
+    int i1 = std::clamp(vx1 / 2, 0, base.nx - 1);
+    int j1 = std::clamp(vz1 / 2, 0, base.nz - 1);
+    refresh(i0, j0, i1, j1, height_fn);
+  }
+
+  bool empty() const noexcept {
+    return levels_.empty();
+  }
+  int level_count() const noexcept {
+    return static_cast<int>(levels_.size());
+  }
+
+  /** Height range of node (i, j) at a level (clamped to the level's grid). */
+  Range range(int level, int i, int j) const {
+    const Level& l = levels_[std::clamp(level, 0, level_count() - 1)];
+    i = std::clamp(i, 0, l.nx - 1);
+    j = std::clamp(j, 0, l.nz - 1);
+    return l.ranges[j * l.nx + i];
+  }
+
+  /** Height range of the whole grid. */
+  Range root() const {
+    return levels_.empty() ? Range{} : levels_.back().ranges.front();
+  }
+
+  /**
+   * Walk cells along a grid-space ray, nearest first.
+   *
+   * The ray is p(t) = o + d * t in grid space (x, z in vertex units, y in
+   * world height), t in [0, t_max]. `cell_fn(cx, cz, t_enter, t_exit, t_best)`
+   * is called for every cell whose bounding box the ray overlaps before the
+   * best hit so far; it returns true and lowers t_best when it finds a closer
+   * intersection.
+   *
+   * @return true if any cell reported a hit; t_best holds its parameter.
+   */
+  template <typename CellFn>
+  bool traverse(const float o[3], const float d[3], float t_max, CellFn&& cell_fn,
+                float& t_best) const {
+    t_best = t_max;
+    if (levels_.empty())
+      return false;
+
+    struct Item {
+      int level;
+      int i, j;
+    };
+    // Each pop pushes at most 4 children, so depth * 3 + 4 slots suffice.
+    std::array<Item, 32 * 3 + 4> stack;
+    int top = 0;
+    stack[top++] = {level_count() - 1, 0, 0};
+
+    // Visit near children last on the stack so they pop first
+    const bool flip_x = d[0] < 0.0f;
+    const bool flip_z = d[2] < 0.0f;
+    bool hit = false;
+
+    while (top > 0) {
+      Item it = stack[--top];
+      int span = 1 << (it.level + 1);  // cells per node edge
+      int cx0 = it.i * span;
+      int cz0 = it.j * span;
+      int cx1 = std::min(cx0 + span, width_ - 1);
+      int cz1 = std::min(cz0 + span, depth_ - 1);
+
+      const Level& lvl = levels_[it.level];
+      const Range& r = lvl.ranges[it.j * lvl.nx + it.i];
+      float lo[3] = {static_cast<float>(cx0), r.min, static_cast<float>(cz0)};
+      float hi[3] = {static_cast<float>(cx1), r.max, static_cast<float>(cz1)};
+      float tn = 0.0f, tf = t_best;
+      if (!clip_box(o, d, lo, hi, tn, tf))
+        continue;
+
+      if (it.level == 0) {
+        // Leaf block: exact test on each overlapped cell, nearest first
+        for (int k = 0; k < 4; ++k) {
+          int cx = cx0 + ((k & 1) ^ (flip_x ? 1 : 0));
+          int cz = cz0 + (((k >> 1) & 1) ^ (flip_z ? 1 : 0));
+          if (cx >= cx1 || cz >= cz1)
+            continue;
+          float clo[3] = {static_cast<float>(cx), r.min, static_cast<float>(cz)};
+          float chi[3] = {static_cast<float>(cx + 1), r.max, static_cast<float>(cz + 1)};
+          float cn = 0.0f, cf = t_best;
+          if (clip_box(o, d, clo, chi, cn, cf) && cell_fn(cx, cz, cn, cf, t_best))
+            hit = true;
+        }
+        continue;
+      }
+
+      const Level& child = levels_[it.level - 1];
+      for (int k = 3; k >= 0; --k) {
+        int ci = it.i * 2 + ((k & 1) ^ (flip_x ? 1 : 0));
+        int cj = it.j * 2 + (((k >> 1) & 1) ^ (flip_z ? 1 : 0));
+        if (ci < child.nx && cj < child.nz)
+          stack[top++] = {it.level - 1, ci, cj};
+      }
+    }
+    return hit;
+  }
+
+  /**
+   * Clip a ray against an axis-aligned box; narrows [tn, tf].
+   * Zero direction components are handled without dividing.
+   */
+  static bool clip_box(const float o[3], const float d[3], const float lo[3], const float hi[3],
+                       float& tn, float& tf) {
+    for (int a = 0; a < 3; ++a) {
+      if (std::abs(d[a]) < 1e-12f) {
+        if (o[a] < lo[a] || o[a] > hi[a])
+          return false;
+        continue;
+      }
+      float inv = 1.0f / d[a];
+      float t0 = (lo[a] - o[a]) * inv;
+      float t1 = (hi[a] - o[a]) * inv;
+      if (t0 > t1)
+        std::swap(t0, t1);
+      tn = std::max(tn, t0);
+      tf = std::min(tf, t1);
+      if (tn > tf)
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  struct Level {
+    int nx = 0, nz = 0;
+    std::vector<Range> ranges;
+  };
+
+  /** Recompute level-0 nodes [i0..i1] x [j0..j1] and reduce them upwards. */
+  template <typename HeightFn>
+  void refresh(int i0, int j0, int i1, int j1, HeightFn&& height_fn) {
+    Level& base = levels_[0];
+    for (int j = j0; j <= j1; ++j) {
+      for (int i = i0; i <= i1; ++i) {
+        int x0 = i * 2, z0 = j * 2;
+        int x1 = std::min(x0 + 2, width_ - 1);
+        int z1 = std::min(z0 + 2, depth_ - 1);
+        Range r{height_fn(x0, z0), height_fn(x0, z0)};
+        for (int z = z0; z <= z1; ++z) {
+          for (int x = x0; x <= x1; ++x) {
+            float h = height_fn(x, z);
+            r.min = std::min(r.min, h);
+            r.max = std::max(r.max, h);
+          }
+        }
+        base.ranges[j * base.nx + i] = r;
+      }
+    }
+
+    // Coarser levels: reduce 2x2 children
+    for (size_t l = 1; l < levels_.size(); ++l) {
+      const Level& fine = levels_[l - 1];
+      Level& coarse = levels_[l];
+      i0 /= 2;
+      j0 /= 2;
+      i1 /= 2;
+      j1 /= 2;
+      for (int j = j0; j <= j1; ++j) {
+        for (int i = i0; i <= i1; ++i) {
+          Range r = fine.ranges[(j * 2) * fine.nx + i * 2];
+          for (int cj = j * 2; cj < std::min(j * 2 + 2, fine.nz); ++cj) {
+            for (int ci = i * 2; ci < std::min(i * 2 + 2, fine.nx); ++ci) {
+              const Range& c = fine.ranges[cj * fine.nx + ci];
+              r.min = std::min(r.min, c.min);
+              r.max = std::max(r.max, c.max);
+            }
+          }
+          coarse.ranges[j * coarse.nx + i] = r;
+        }
+      }
+    }
+  }
+
+  std::vector<Level> levels_;
+  int width_ = 0;
+  int depth_ = 0;
+};
+
+}  // namespace terrain
+}  // namespace qg
@@ -0,0 +1,660 @@
+#pragma once
+/**
+ * @file StreamingTerrain.h
+ * @brief Tile-paged terrain for courses larger than memory.
+ *
+ * StreamingTerrain reads a TileFile (see TileFile.h). update() is called
+ * once per frame with the points of interest (ball, camera): tiles within
+ * load_radius of any of them are queued nearest-first for a background
+ * loader thread, finished tiles are adopted, and least-recently-wanted
+ * tiles are dropped once resident data exceeds memory_budget.
+ *
+ * Height, normal, surface and ray queries work anywhere on the grid and
+ * never wait for I/O: a cell whose tile is not resident is answered from
+ * the coarse overview that stays in memory, and has_detail() tells the
+ * caller which one it got. Tiles share their edge vertices, so results
+ * are continuous across tile boundaries. The query set matches Terrain's
+ * (sample(), raycast(), segment_cast(), ...), so ball physics runs on
+ * either; rays skip whole tiles by their stored height bounds.
+ *
+ * page_in() is update() followed by waiting for the loads it queued: the
+ * headless runner uses it so which tiles are resident, and therefore every
+ * query result, depends only on the ball's path.
+ *
+ * TileMeshCache mirrors the same idea on the GPU: one mesh per resident
+ * tile near the camera, a bounded number of uploads per frame and an LRU
+ * cap on live meshes.
+ *
+ * World mapping matches Terrain: gx = wx / cell_size + width / 2.
+ *
+ * Design by Contract:
+ *   - Precondition: update(), the queries and TileMeshCache::update() run
+ *     on one thread (the frame thread); only file reads happen off it
+ *   - Invariant: resident bytes <= memory_budget after update(), unless the
+ *     tiles wanted this frame alone exceed it
+ *   - Postcondition: queries return without taking a lock
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "MinMaxPyramid.h"
+#include "Surface.h"
+#include "Terrain.h"
+#include "TerrainStorage.h"
+#include "TileFile.h"
+#include "math/Vec3.h"
+#include "renderer/Mesh.h"
+
+namespace qg {
+namespace terrain {
+
+struct StreamingConfig {
+  float load_radius = 256.0f;        // World distance from a focus point to page a tile in
+  size_t memory_budget = 64u << 20;  // Bytes of resident tile data
+};
+
+class StreamingTerrain {
+ public:
+  explicit StreamingTerrain(const StreamingConfig& cfg = {}) : cfg_(cfg) {}
+  ~StreamingTerrain() {
+    close();
+  }
+
+  StreamingTerrain(const StreamingTerrain&) = delete;
+  StreamingTerrain& operator=(const StreamingTerrain&) = delete;
+
+  /** Open a tile file and start the loader thread. */
+  bool open(const std::string& path) {
+    close();
+    if (!file_.open(path))
+      return false;
+    const TileLayout& l = file_.layout();
+    slots_.clear();
+    slots_.resize(static_cast<size_t>(l.tile_count()));
+    width_ = l.width();
+    depth_ = l.depth();
+    stop_ = false;
+    worker_ = std::thread([this] { worker_loop(); });
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+      queue_.clear();
+    }
+    wake_.notify_all();
+    if (worker_.joinable())
+      worker_.join();
+    completed_.clear();
+    slots_.clear();
+    resident_bytes_ = 0;
+    resident_count_ = 0;
+    file_.close();
+  }
+
+  bool is_open() const noexcept {
+    return file_.is_open();
+  }
+  const TileLayout& layout() const noexcept {
+    return file_.layout();
+  }
+  void set_config(const StreamingConfig& cfg) {
+    cfg_ = cfg;
+  }
+
+  /**
+   * Per-frame paging step: adopt finished tiles, queue the missing tiles
+   * around the focus points (nearest first) and evict down to the budget.
+   */
+  void update(const qe::math::Vec3* focus, size_t count) {
+    if (slots_.empty())
+      return;
+    ++frame_;
+
+    std::vector<std::unique_ptr<TileData>> done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done.swap(completed_);
+    }
+    for (auto& t : done) {
+      Slot& s = slots_[tile_id(t->tx, t->tz)];
+      if (s.data)
+        continue;  // Duplicate load of a tile that was re-requested
+      resident_bytes_ += t->memory_bytes();
+      ++resident_count_;
+      s.data = std::move(t);
+      s.last_used = frame_;
+    }
+
+    // Wanted tiles: distance from the focus point to the tile's rectangle
+    const TileLayout& l = file_.layout();
+    const float tile_world = l.tile_size * l.cell_size;
+    std::vector<std::pair<float, int>> missing;
+    for (size_t i = 0; i < count; ++i) {
+      const float gx = to_grid_x(focus[i].x), gz = to_grid_z(focus[i].z);
+      const float r = cfg_.load_radius / l.cell_size;
+      const float fx = gx * l.cell_size, fz = gz * l.cell_size;  // Relative to grid origin
+      int tx0 = std::max(static_cast<int>(std::floor((gx - r) / l.tile_size)), 0);
+      int tz0 = std::max(static_cast<int>(std::floor((gz - r) / l.tile_size)), 0);
+      int tx1 = std::min(static_cast<int>(std::floor((gx + r) / l.tile_size)), l.tiles_x - 1);
+      int tz1 = std::min(static_cast<int>(std::floor((gz + r) / l.tile_size)), l.tiles_z - 1);
+      for (int tz = tz0; tz <= tz1; ++tz) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+          float dx = std::max({tx * tile_world - fx, fx - (tx + 1) * tile_world, 0.0f});
+          float dz = std::max({tz * tile_world - fz, fz - (tz + 1) * tile_world, 0.0f});
+          float dist = std::sqrt(dx * dx + dz * dz);
+          if (dist > cfg_.load_radius)
+            continue;
+          Slot& s = slots_[tile_id(tx, tz)];
+          s.last_used = frame_;
+          if (!s.data)
+            missing.emplace_back(dist, tile_id(tx, tz));
+        }
+      }
+    }
+    std::sort(missing.begin(), missing.end());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.clear();  // Stale requests from earlier frames are dropped
+      for (const auto& m : missing)
+        if (m.second != in_flight_ &&
+            std::find(queue_.begin(), queue_.end(), m.second) == queue_.end())
+          queue_.push_back(m.second);
+    }
+    if (!missing.empty())
+      wake_.notify_one();
+
+    evict();
+  }
+
+  /** update(), then wait for the tiles it queued and adopt them. */
+  void page_in(const qe::math::Vec3* focus, size_t count) {
+    update(focus, count);
+    if (pending() == 0)
+      return;
+    wait_idle();
+    update(focus, count);
+  }
+
+  /** Bilinear height; detailed where the tile is resident, coarse elsewhere. */
+  float height_at_world(float wx, float wz) const {
+    float gx = clamp_x(to_grid_x(wx)), gz = clamp_z(to_grid_z(wz));
+    const TileLayout& l = file_.layout();
+    int cx = std::min(static_cast<int>(gx), width_ - 2);
+    int cz = std::min(static_cast<int>(gz), depth_ - 2);
+    int tx = std::min(cx / l.tile_size, l.tiles_x - 1);
+    int tz = std::min(cz / l.tile_size, l.tiles_z - 1);
+    if (const TileData* t = tile(tx, tz)) {
+      const int tv = l.tile_vertices();
+      int lx = cx - tx * l.tile_size, lz = cz - tz * l.tile_size;
+      const float* h = t->heights.data() + static_cast<size_t>(lz) * tv + lx;
+      return bilerp(h[0], h[1], h[tv], h[tv + 1], gx - cx, gz - cz);
+    }
+    return coarse_height(gx, gz);
+  }
+
+  /** Normal of the nearest vertex (coarse central difference if not resident). */
+  qe::math::Vec3 normal_at_world(float wx, float wz) const {
+    int vx, vz, tx, tz;
+    nearest_vertex(wx, wz, vx, vz, tx, tz);
+    if (const TileData* t = tile(tx, tz))
+      return unpack_normal(t->normals[local_index(vx, vz, tx, tz)]);
+
+    const TileLayout& l = file_.layout();
+    int cx = coarse_index(vx, l.coarse_width()), cz = coarse_index(vz, l.coarse_depth());
+    auto ch = [&](int x, int z) {
+      return file_.coarse_height(std::clamp(x, 0, l.coarse_width() - 1),
+                                 std::clamp(z, 0, l.coarse_depth() - 1));
+    };
+    float nx = ch(cx - 1, cz) - ch(cx + 1, cz);
+    float ny = 2.0f * l.coarse_step * l.cell_size;
+    float nz = ch(cx, cz - 1) - ch(cx, cz + 1);
+    float inv = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+    return {nx * inv, ny * inv, nz * inv};
+  }
+
+  /** Surface of the nearest vertex (nearest coarse sample if not resident). */
+  SurfaceType surface_at_world(float wx, float wz) const {
+    int vx, vz, tx, tz;
+    nearest_vertex(wx, wz, vx, vz, tx, tz);
+    if (const TileData* t = tile(tx, tz))
+      return static_cast<SurfaceType>(t->surfaces[local_index(vx, vz, tx, tz)]);
+    const TileLayout& l = file_.layout();
+    return file_.coarse_surface(coarse_index(vx, l.coarse_width()),
+                                coarse_index(vz, l.coarse_depth()));
+  }
+
+  /** Height, normal and surface at one world position (see Terrain::sample). */
+  TerrainSample sample(float wx, float wz) const {
+    TerrainSample s;
+    s.height = height_at_world(wx, wz);
+    s.normal = normal_at_world(wx, wz);
+    s.surface = surface_at_world(wx, wz);
+    s.props = &surface_props(s.surface);
+    return s;
+  }
+
+  /** out[i] = height_at_world(wx[i], wz[i]) */
+  void sample_heights(const float* wx, const float* wz, float* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = height_at_world(wx[i], wz[i]);
+  }
+
+  /** Cast a ray against the streamed surface; same contract as Terrain::raycast(). */
+  bool raycast(const qe::math::Vec3& origin, const qe::math::Vec3& dir, float max_dist,
+               TerrainHit& hit) const {
+    float len = dir.length();
+    if (len < 1e-8f)
+      return false;
+    return intersect(origin, dir * (1.0f / len), max_dist, hit);
+  }
+
+  /** Sweep the segment a → b; hit.t is the fraction along the segment. */
+  bool segment_cast(const qe::math::Vec3& a, const qe::math::Vec3& b, TerrainHit& hit) const {
+    return intersect(a, b - a, 1.0f, hit);
+  }
+
+  /** True when queries at (wx, wz) are answered at full resolution. */
+  bool has_detail(float wx, float wz) const {
+    int vx, vz, tx, tz;
+    nearest_vertex(wx, wz, vx, vz, tx, tz);
+    return tile(tx, tz) != nullptr;
+  }
+
+  /** Resident tile or nullptr. */
+  const TileData* tile(int tx, int tz) const {
+    if (slots_.empty())
+      return nullptr;
+    return slots_[tile_id(tx, tz)].data.get();
+  }
+
+  template <typename Fn>
+  void for_each_resident(Fn&& fn) const {
+    for (const auto& s : slots_)
+      if (s.data)
+        fn(*s.data);
+  }
+
+  /** Height range of any tile, resident or not. */
+  void tile_bounds(int tx, int tz, float& lo, float& hi) const {
+    file_.tile_bounds(tx, tz, lo, hi);
+  }
+
+  /** World position of a tile's first vertex. */
+  qe::math::Vec3 tile_origin(int tx, int tz) const {
+    const TileLayout& l = file_.layout();
+    return {(tx * l.tile_size - width_ / 2.0f) * l.cell_size, 0.0f,
+            (tz * l.tile_size - depth_ / 2.0f) * l.cell_size};
+  }
+
+  size_t resident_tiles() const noexcept {
+    return resident_count_;
+  }
+  /** Resident tile data plus the always-loaded coarse overview. */
+  size_t memory_bytes() const noexcept {
+    return resident_bytes_ + file_.coarse_bytes();
+  }
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + (in_flight_ >= 0 ? 1 : 0);
+  }
+
+  /** Block until the loader has drained its queue (tools and tests). */
+  void wait_idle() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [&] { return stop_ || (queue_.empty() && in_flight_ < 0); });
+  }
+
+ private:
+  struct Slot {
+    std::unique_ptr<TileData> data;
+    uint64_t last_used = 0;
+  };
+
+  StreamingConfig cfg_;
+  TileFile file_;
+  int width_ = 0, depth_ = 0;
+  std::vector<Slot> slots_;  // Frame thread only
+  uint64_t frame_ = 0;
+  size_t resident_bytes_ = 0;
+  size_t resident_count_ = 0;
+
+  // Loader thread hand-off
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  mutable std::condition_variable idle_;
+  std::deque<int> queue_;
+  std::vector<std::unique_ptr<TileData>> completed_;
+  int in_flight_ = -1;
+  bool stop_ = true;
+  std::thread worker_;
+
+  void worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      if (stop_)
+        break;
+      in_flight_ = queue_.front();
+      queue_.pop_front();
+      const int tiles_x = file_.layout().tiles_x;
+      const int id = in_flight_;
+      lock.unlock();
+      auto t = std::make_unique<TileData>();
+      file_.read_tile(id % tiles_x, id / tiles_x, *t);
+      lock.lock();
+      completed_.push_back(std::move(t));
+      in_flight_ = -1;
+      idle_.notify_all();
+    }
+    idle_.notify_all();
+  }
+
+  /**
+   * Ray vs. the bilinear surface, nearest crossing from above. Tiles are
+   * walked in the order the ray crosses them and skipped when it misses
+   * their height bounds; cells of a tile are walked the same way and
+   * tested exactly, with coarse heights where the tile is not resident.
+   */
+  bool intersect(const qe::math::Vec3& origin, const qe::math::Vec3& dir, float t_max,
+                 TerrainHit& hit) const {
+    if (slots_.empty())
+      return false;
+    const TileLayout& l = file_.layout();
+    const int T = l.tile_size;
+    const float inv_cs = 1.0f / l.cell_size;
+    const float o[3] = {origin.x * inv_cs + width_ / 2.0f, origin.y,
+                        origin.z * inv_cs + depth_ / 2.0f};
+    const float d[3] = {dir.x * inv_cs, dir.y, dir.z * inv_cs};
+
+    const float big = std::numeric_limits<float>::max();
+    const float grid_lo[3] = {0.0f, -big, 0.0f};
+    const float grid_hi[3] = {static_cast<float>(width_ - 1), big,
+                              static_cast<float>(depth_ - 1)};
+    float tn = 0.0f, tf = t_max;
+    if (!MinMaxPyramid::clip_box(o, d, grid_lo, grid_hi, tn, tf))
+      return false;
+
+    float t_best = t_max, u = 0.0f, v = 0.0f;
+    float h[4] = {};
+    bool found = false;
+    walk(o, d, tn, tf, static_cast<float>(T), l.tiles_x, l.tiles_z,
+         [&](int tx, int tz, float t0, float t1) {
+           float lo[3] = {static_cast<float>(tx * T), 0.0f, static_cast<float>(tz * T)};
+           float hi[3] = {static_cast<float>((tx + 1) * T), 0.0f,
+                          static_cast<float>((tz + 1) * T)};
+           file_.tile_bounds(tx, tz, lo[1], hi[1]);
+           float cn = t0, cf = t1;
+           if (!MinMaxPyramid::clip_box(o, d, lo, hi, cn, cf))
+             return false;
+           const TileData* t = tile(tx, tz);
+           auto height = [&](int vx, int vz) {
+             return t ? t->heights[local_index(vx, vz, tx, tz)]
+                      : coarse_height(static_cast<float>(vx), static_cast<float>(vz));
+           };
+           // Cells of this tile, in grid units relative to the tile's corner
+           const float to[3] = {o[0] - tx * T, o[1], o[2] - tz * T};
+           return walk(to, d, cn, cf, 1.0f, T, T, [&](int lx, int lz, float c0, float c1) {
+             const int cx = tx * T + lx, cz = tz * T + lz;
+             float c[4] = {height(cx, cz), height(cx + 1, cz), height(cx, cz + 1),
+                           height(cx + 1, cz + 1)};
+             if (!intersect_cell(o, d, cx, cz, c[0], c[1], c[2], c[3], c0, c1, t_max, t_best, u,
+                                 v))
+               return false;
+             std::copy(c, c + 4, h);
+             found = true;
+             return true;
+           });
+         });
+    if (!found)
+      return false;
+    bilinear_hit(origin, dir, t_best, h[0], h[1], h[2], h[3], u, v, inv_cs, hit);
+    hit.surface = surface_at_world(hit.point.x, hit.point.z);
+    return true;
+  }
+
+  /**
+   * Visit the cells [0, nx) x [0, nz) of edge `size` that the grid-space
+   * ray crosses between tn and tf, in order, as fn(x, z, t_enter, t_exit).
+   * Stops and returns true as soon as fn does.
+   */
+  template <typename Fn>
+  static bool walk(const float o[3], const float d[3], float tn, float tf, float size, int nx,
+                   int nz, Fn&& fn) {
+    const float inf = std::numeric_limits<float>::infinity();
+    int x = std::clamp(static_cast<int>(std::floor((o[0] + d[0] * tn) / size)), 0, nx - 1);
+    int z = std::clamp(static_cast<int>(std::floor((o[2] + d[2] * tn) / size)), 0, nz - 1);
+    const int sx = d[0] > 0.0f ? 1 : -1, sz = d[2] > 0.0f ? 1 : -1;
+    float next_x = d[0] != 0.0f ? ((x + (sx > 0 ? 1 : 0)) * size - o[0]) / d[0] : inf;
+    float next_z = d[2] != 0.0f ? ((z + (sz > 0 ? 1 : 0)) * size - o[2]) / d[2] : inf;
+    const float step_x = d[0] != 0.0f ? size / std::abs(d[0]) : inf;
+    const float step_z = d[2] != 0.0f ? size / std::abs(d[2]) : inf;
+    for (float t = tn;;) {
+      const float t_exit = std::min({next_x, next_z, tf});
+      if (fn(x, z, t, std::max(t, t_exit)))
+        return true;
+      if (t_exit >= tf)
+        return false;
+      t = t_exit;
+      if (next_x <= next_z) {
+        x += sx;
+        next_x += step_x;
+      } else {
+        z += sz;
+        next_z += step_z;
+      }
+      if (x < 0 || x >= nx || z < 0 || z >= nz)
+        return false;
+    }
+  }
+
+  /** Drop least-recently-wanted tiles until within budget. */
+  void evict() {
+    while (resident_bytes_ > cfg_.memory_budget) {
+      Slot* victim = nullptr;
+      for (auto& s : slots_)
+        if (s.data && s.last_used < frame_ && (!victim || s.last_used < victim->last_used))
+          victim = &s;
+      if (!victim)
+        break;  // Everything resident is wanted this frame
+      resident_bytes_ -= victim->data->memory_bytes();
+      --resident_count_;
+      victim->data.reset();
+    }
+  }
+
+  int tile_id(int tx, int tz) const {
+    return tz * file_.layout().tiles_x + tx;
+  }
+
+  float to_grid_x(float wx) const {
+    return wx / file_.layout().cell_size + width_ / 2.0f;
+  }
+  float to_grid_z(float wz) const {
+    return wz / file_.layout().cell_size + depth_ / 2.0f;
+  }
+  float clamp_x(float gx) const {
+    return std::min(std::max(gx, 0.0f), static_cast<float>(width_ - 1));
+  }
+  float clamp_z(float gz) const {
+    return std::min(std::max(gz, 0.0f), static_cast<float>(depth_ - 1));
+  }
+
+  static float bilerp(float h00, float h10, float h01, float h11, float fx, float fz) {
+    float h0 = h00 + (h10 - h00) * fx;
+    float h1 = h01 + (h11 - h01) * fx;
+    return h0 + (h1 - h0) * fz;
+  }
+
+  float coarse_height(float gx, float gz) const {
+    const TileLayout& l = file_.layout();
+    float cx = gx / l.coarse_step, cz = gz / l.coarse_step;
+    int x0 = std::min(static_cast<int>(cx), l.coarse_width() - 2);
+    int z0 = std::min(static_cast<int>(cz), l.coarse_depth() - 2);
+    return bilerp(file_.coarse_height(x0, z0), file_.coarse_height(x0 + 1, z0),
+                  file_.coarse_height(x0, z0 + 1), file_.coarse_height(x0 + 1, z0 + 1), cx - x0,
+                  cz - z0);
+  }
+
+  int coarse_index(int v, int coarse_extent) const {
+    int step = file_.layout().coarse_step;
+    return std::min((v + step / 2) / step, coarse_extent - 1);
+  }
+
+  void nearest_vertex(float wx, float wz, int& vx, int& vz, int& tx, int& tz) const {
+    const TileLayout& l = file_.layout();
+    vx = static_cast<int>(clamp_x(to_grid_x(wx)) + 0.5f);
+    vz = static_cast<int>(clamp_z(to_grid_z(wz)) + 0.5f);
+    tx = std::min(vx / l.tile_size, l.tiles_x - 1);
+    tz = std::min(vz / l.tile_size, l.tiles_z - 1);
+  }
+
+  size_t local_index(int vx, int vz, int tx, int tz) const {
+    const TileLayout& l = file_.layout();
+    return static_cast<size_t>(vz - tz * l.tile_size) * l.tile_vertices() +
+           (vx - tx * l.tile_size);
+  }
+};
+
+struct TileMeshConfig {
+  size_t max_meshes = 64;     // Live GPU meshes (LRU beyond this)
+  int uploads_per_frame = 2;  // Bounds the per-frame upload cost
+  float draw_radius = 400.0f;
+};
+
+/** GPU meshes for resident tiles around the camera (needs a GL context). */
+class TileMeshCache {
+ public:
+  explicit TileMeshCache(const TileMeshConfig& cfg = {}) : cfg_(cfg) {}
+
+  void update(const StreamingTerrain& terrain, const qe::math::Vec3& camera) {
+    ++frame_;
+    // Meshes whose tile was paged out go with it
+    for (auto it = meshes_.begin(); it != meshes_.end();) {
+      const TileLayout& l = terrain.layout();
+      if (!terrain.tile(it->first % l.tiles_x, it->first / l.tiles_x))
+        it = meshes_.erase(it);
+      else
+        ++it;
+    }
+
+    const TileLayout& l = terrain.layout();
+    const float half = 0.5f * l.tile_size * l.cell_size;
+    std::vector<std::pair<float, const TileData*>> near;
+    terrain.for_each_resident([&](const TileData& t) {
+      qe::math::Vec3 c = terrain.tile_origin(t.tx, t.tz);
+      float dx = c.x + half - camera.x, dz = c.z + half - camera.z;
+      float dist = std::sqrt(dx * dx + dz * dz) - half * 1.4142f;
+      if (dist <= cfg_.draw_radius)
+        near.emplace_back(dist, &t);
+    });
+    std::sort(near.begin(), near.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    int uploads = 0;
+    for (const auto& n : near) {
+      int id = n.second->tz * l.tiles_x + n.second->tx;
+      auto it = meshes_.find(id);
+      if (it != meshes_.end()) {
+        it->second.last_used = frame_;
+      } else if (uploads < cfg_.uploads_per_frame) {
+        build_geometry(terrain, *n.second, verts_, indices_);
+        Entry e;
+        e.mesh.upload(verts_, indices_);
+        e.last_used = frame_;
+        meshes_.emplace(id, std::move(e));
+        ++uploads;
+      }
+    }
+
+    while (meshes_.size() > cfg_.max_meshes) {
+      auto victim = std::min_element(meshes_.begin(), meshes_.end(), [](const auto& a,
+                                                                        const auto& b) {
+        return a.second.last_used < b.second.last_used;
+      });
+      meshes_.erase(victim);
+    }
+  }
+
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    for (const auto& m : meshes_)
+      fn(m.second.mesh);
+  }
+
+  size_t size() const noexcept {
+    return meshes_.size();
+  }
+
+  /** Release every mesh (while the GL context is still current). */
+  void clear() {
+    meshes_.clear();
+  }
+
+  /** Vertices and indices of one tile in world space (same look as Terrain's mesh). */
+  static void build_geometry(const StreamingTerrain& terrain, const TileData& t,
+                             std::vector<qe::renderer::Vertex>& verts,
+                             std::vector<uint16_t>& indices) {
+    const TileLayout& l = terrain.layout();
+    const int tv = l.tile_vertices();
+    const qe::math::Vec3 origin = terrain.tile_origin(t.tx, t.tz);
+    verts.resize(static_cast<size_t>(tv) * tv);
+    for (int z = 0; z < tv; ++z) {
+      for (int x = 0; x < tv; ++x) {
+        size_t i = static_cast<size_t>(z) * tv + x;
+        qe::renderer::Vertex& v = verts[i];
+        v.position[0] = origin.x + x * l.cell_size;
+        v.position[1] = t.heights[i];
+        v.position[2] = origin.z + z * l.cell_size;
+        auto n = unpack_normal(t.normals[i]);
+        v.normal[0] = n.x;
+        v.normal[1] = n.y;
+        v.normal[2] = n.z;
+        const auto& surf = surface_props(static_cast<SurfaceType>(t.surfaces[i]));
+        v.color[0] = surf.r;
+        v.color[1] = surf.g;
+        v.color[2] = surf.b;
+        v.uv[0] = static_cast<float>(t.tx * l.tile_size + x) / (l.width() - 1);
+        v.uv[1] = static_cast<float>(t.tz * l.tile_size + z) / (l.depth() - 1);
+      }
+    }
+    indices.clear();
+    indices.reserve(static_cast<size_t>(tv - 1) * (tv - 1) * 6);
+    for (int z = 0; z < tv - 1; ++z) {
+      for (int x = 0; x < tv - 1; ++x) {
+        auto tl = static_cast<uint16_t>(z * tv + x), tr = static_cast<uint16_t>(tl + 1);
+        auto bl = static_cast<uint16_t>((z + 1) * tv + x), br = static_cast<uint16_t>(bl + 1);
+        indices.insert(indices.end(), {tl, bl, tr, tr, bl, br});
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    qe::renderer::Mesh mesh;
+    uint64_t last_used = 0;
+  };
+
+  TileMeshConfig cfg_;
+  std::unordered_map<int, Entry> meshes_;
+  uint64_t frame_ = 0;
+  std::vector<qe::renderer::Vertex> verts_;  // Scratch, reused across uploads
+  std::vector<uint16_t> indices_;
+};
+
+}  // namespace terrain
+}  // namespace qg
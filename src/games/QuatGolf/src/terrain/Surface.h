@@ -10,6 +10,7 @@
  * Design by Contract:
  *   - Invariant: friction in [0, 1], bounce in [0, 1]
  *   - Postcondition: from_height() always returns a valid surface
+ *   - Invariant: kSurfaceTable[i].type == SurfaceType(i)
  */
 
 #include <string>
@@ -60,27 +61,31 @@ struct SurfaceProps {
   }
 };
 
+/**
+ * Physical properties for every surface type, indexed by SurfaceType.
+ * Lookups are a single indexed load instead of a switch per query.
+ */
+inline constexpr SurfaceProps kSurfaceTable[static_cast<int>(SurfaceType::Count)] = {
+    {SurfaceType::Tee, 0.08f, 0.5f, 1.0f, 0.35f, 0.75f, 0.30f},
+    {SurfaceType::Fairway, 0.10f, 0.45f, 1.0f, 0.28f, 0.65f, 0.22f},
+    {SurfaceType::Rough, 0.30f, 0.35f, 0.7f, 0.22f, 0.48f, 0.16f},
+    {SurfaceType::DeepRough, 0.50f, 0.25f, 0.4f, 0.16f, 0.36f, 0.12f},
+    {SurfaceType::Sand, 0.60f, 0.15f, 0.5f, 0.90f, 0.82f, 0.60f},
+    {SurfaceType::Green, 0.04f, 0.40f, 1.0f, 0.22f, 0.78f, 0.30f},
+    {SurfaceType::Water, 1.00f, 0.00f, 0.0f, 0.15f, 0.35f, 0.70f},
+    {SurfaceType::OutOfBounds, 0.50f, 0.30f, 0.5f, 0.40f, 0.35f, 0.30f},
+};
+
+/** Table entry for a surface type; out-of-range values map to OutOfBounds. */
+inline const SurfaceProps& surface_props(SurfaceType type) {
+  auto i = static_cast<unsigned>(type);
+  constexpr auto kLast = static_cast<unsigned>(SurfaceType::OutOfBounds);
+  return kSurfaceTable[i < kLast ? i : kLast];
+}
+
 /** Get physical properties for a surface type. */
 inline SurfaceProps get_surface(SurfaceType type) {
-  switch (type) {
-    case SurfaceType::Tee:
-      return {type, 0.08f, 0.5f, 1.0f, 0.35f, 0.75f, 0.30f};
-    case SurfaceType::Fairway:
-      return {type, 0.10f, 0.45f, 1.0f, 0.28f, 0.65f, 0.22f};
-    case SurfaceType::Rough:
-      return {type, 0.30f, 0.35f, 0.7f, 0.22f, 0.48f, 0.16f};
-    case SurfaceType::DeepRough:
-      return {type, 0.50f, 0.25f, 0.4f, 0.16f, 0.36f, 0.12f};
-    case SurfaceType::Sand:
-      return {type, 0.60f, 0.15f, 0.5f, 0.90f, 0.82f, 0.60f};
-    case SurfaceType::Green:
-      return {type, 0.04f, 0.40f, 1.0f, 0.22f, 0.78f, 0.30f};
-    case SurfaceType::Water:
-      return {type, 1.00f, 0.00f, 0.0f, 0.15f, 0.35f, 0.70f};
-    case SurfaceType::OutOfBounds:
-    default:
-      return {type, 0.50f, 0.30f, 0.5f, 0.40f, 0.35f, 0.30f};
-  }
+  return surface_props(type);
 }
 
 }  // namespace terrain
@@ -8,156 +8,315 @@
  *   - Surface type (fairway, rough, sand, etc.)
  *   - Normal (computed from neighbours for smooth shading)
  *
- * The heightmap is procedurally generated for now. Future: load from image.
+ * Per-vertex normals are precomputed whenever the heights change, and
+ * surface properties come from a lookup table, so point and batch queries
+ * are a handful of loads with no branches or throwing normalizes.
+ *
+ * A min/max height pyramid is kept alongside the heightmap so rays and
+ * swept segments can be intersected with the bilinear surface exactly
+ * (ball sweeps, camera collision, picking).
+ *
+ * Storage is either full precision (float heights, one enum per vertex) or
+ * quantized (16-bit heights with per-tile scale/offset, 4-bit surfaces,
+ * snorm8 normals; see TerrainStorage.h). Every query decodes through the
+ * same private accessors, so callers never see the difference beyond the
+ * quantization error of at most half a code step per tile.
+ *
+ * edit() hands out exclusive, region-locked edit handles. Committing one
+ * refreshes only the normals and pyramid nodes around the region and
+ * grows the dirty rectangle, so the next build_mesh() re-uploads just
+ * those vertices.
+ *
+ * The mesh is one vertex buffer for the whole grid plus a single 16-bit
+ * index pattern covering band_rows() quad rows; draw() replays it once per
+ * band with that band's first vertex as base vertex. Vertices are built
+ * in parallel row bands from the precomputed normals.
+ *
+ * Heights come from CourseBuilder::generate_base() or HeightmapImport.
  *
  * Design by Contract:
  *   - Precondition: width, depth >= 2
- *   - Invariant: heights_ and surfaces_ are width * depth
+ *   - Invariant: the active storage holds width * depth heights, surfaces
+ *     and normals; the inactive storage is empty
+ *   - Invariant: held edit regions are pairwise disjoint
  *   - Postcondition: mesh vertices match heightmap dimensions
  */
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "MinMaxPyramid.h"
 #include "Surface.h"
+#include "TerrainEdit.h"
+#include "TerrainStorage.h"
+#include "core/Parallel.h"
 #include "math/Vec3.h"
 #include "renderer/Mesh.h"
 
 namespace qg {
 namespace terrain {
 
+/** Result of a ray or segment query against the terrain surface. */
+struct TerrainHit {
+  qe::math::Vec3 point;   // World-space intersection point
+  qe::math::Vec3 normal;  // Exact normal of the bilinear patch at the hit
+  SurfaceType surface = SurfaceType::Rough;
+  float t = 0.0f;  // Ray: distance along dir; segment: fraction [0, 1]
+};
+
+/** Combined point query result (see Terrain::sample). */
+struct TerrainSample {
+  float height = 0.0f;
+  qe::math::Vec3 normal{0, 1, 0};
+  SurfaceType surface = SurfaceType::Rough;
+  const SurfaceProps* props = nullptr;
+};
+
+/**
+ * Nearest downward crossing of the grid-space ray p(t) = o + d * t with
+ * the bilinear patch over cell (cx, cz) whose corner heights are h00..h11,
+ * for t in [t0, t1] (with a little slack) and below t_best. On a hit,
+ * t_best becomes the crossing (clamped to [0, t_max]) and (u, v) its
+ * position in the cell. Shared by Terrain and StreamingTerrain.
+ */
+inline bool intersect_cell(const float o[3], const float d[3], int cx, int cz, float h00,
+                           float h10, float h01, float h11, float t0, float t1, float t_max,
+                           float& t_best, float& u, float& v) {
+  float a = h10 - h00, b = h01 - h00, c = h00 - h10 - h01 + h11;
+
+  // f(t) = ray_y(t) - h(u(t), v(t)) = A t² + B t + C
+  float u0 = o[0] - cx, v0 = o[2] - cz;
+  float A = -c * d[0] * d[2];
+  float B = d[1] - (a * d[0] + b * d[2] + c * (u0 * d[2] + v0 * d[0]));
+  float C = o[1] - (h00 + a * u0 + b * v0 + c * u0 * v0);
+
+  float roots[2];
+  int n = 0;
+  if (std::abs(A) < 1e-9f) {
+    if (std::abs(B) > 1e-12f)
+      roots[n++] = -C / B;
+  } else {
+    float disc = B * B - 4.0f * A * C;
+    if (disc < 0.0f)
+      return false;
+    // Numerically stable quadratic roots
+    float q = -0.5f * (B + std::copysign(std::sqrt(disc), B));
+    float r0 = q / A;
+    float r1 = std::abs(q) > 1e-12f ? C / q : r0;
+    roots[n++] = std::min(r0, r1);
+    roots[n++] = std::max(r0, r1);
+  }
+
+  const float slack = 1e-5f;
+  for (int k = 0; k < n; ++k) {
+    float t = roots[k];
+    if (t < t0 - slack || t > t1 + slack || t >= t_best)
+      continue;
+    if (2.0f * A * t + B >= 0.0f)  // Leaving the surface, not entering
+      continue;
+    t_best = std::clamp(t, 0.0f, t_max);
+    u = std::clamp(u0 + d[0] * t, 0.0f, 1.0f);
+    v = std::clamp(v0 + d[2] * t, 0.0f, 1.0f);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Fill hit from a crossing found by intersect_cell(): exact patch height
+ * and normal at (u, v). The surface is left to the caller.
+ */
+inline void bilinear_hit(const qe::math::Vec3& origin, const qe::math::Vec3& dir, float t,
+                         float h00, float h10, float h01, float h11, float u, float v,
+                         float inv_cs, TerrainHit& hit) {
+  float c = h00 - h10 - h01 + h11;
+  float dh_du = (h10 - h00) + c * v;
+  float dh_dv = (h01 - h00) + c * u;
+  hit.t = t;
+  hit.point = origin + dir * t;
+  hit.point.y = h00 + (h10 - h00) * u + (h01 - h00) * v + c * u * v;
+  hit.normal = qe::math::Vec3(-dh_du * inv_cs, 1.0f, -dh_dv * inv_cs).normalized();
+}
+
+/** How Terrain keeps its per-vertex data in memory. */
+enum class StorageMode {
+  Float,      // 4-byte heights, int-sized surfaces, 12-byte normals
+  Quantized,  // 2-byte heights, 4-bit surfaces, 4-byte normals
+};
+
 class Terrain {
  public:
   int width = 0;           // Grid cells in X
   int depth = 0;           // Grid cells in Z
   float cell_size = 1.0f;  // World units per cell
 
-  /** Build terrain mesh from internal heightmap + surface data. */
+  /**
+   * Build terrain mesh from internal heightmap + surface data.
+   *
+   * Uploads everything the first time (and after set_data); afterwards only
+   * the vertices inside dirty_rect() are rewritten with glBufferSubData.
+   */
   void build_mesh() {
     if (width < 2 || depth < 2)
       return;
+    const size_t vertex_count = static_cast<size_t>(width) * depth;
+    const GridRect full{0, 0, width - 1, depth - 1};
+    const GridRect dirty = take_dirty();
+
+    if (mesh.vao != 0 && mesh.vertex_count == vertex_count && !(dirty == full)) {
+      update_mesh(dirty);
+      return;
+    }
 
     std::vector<qe::renderer::Vertex> verts;
-    std::vector<unsigned> indices;
-    verts.reserve(width * depth);
-    indices.reserve((width - 1) * (depth - 1) * 6);
-
-    // Vertices
-    for (int z = 0; z < depth; ++z) {
-      for (int x = 0; x < width; ++x) {
-        qe::renderer::Vertex v;
-        float wx = (x - width / 2.0f) * cell_size;
-        float wz = (z - depth / 2.0f) * cell_size;
-        float wy = height_at(x, z);
-
-        v.position[0] = wx;
-        v.position[1] = wy;
-        v.position[2] = wz;
-
-        // Normal from finite differences
-        auto n = normal_at(x, z);
-        v.normal[0] = n.x;
-        v.normal[1] = n.y;
-        v.normal[2] = n.z;
-
-        // Color from surface type
-        auto surf = get_surface(surface_at(x, z));
-        v.color[0] = surf.r;
-        v.color[1] = surf.g;
-        v.color[2] = surf.b;
-
-        // UV for potential texture
-        v.uv[0] = static_cast<float>(x) / (width - 1);
-        v.uv[1] = static_cast<float>(z) / (depth - 1);
-
-        verts.push_back(v);
+    std::vector<uint16_t> indices;
+    build_geometry(verts, indices);
+    mesh.upload(verts, indices, GL_DYNAMIC_DRAW);
+  }
+
+  /**
+   * Quad rows per draw band: the most rows whose vertices fit a 16-bit
+   * index. Every band shares one index pattern and is drawn with its
+   * first vertex as base vertex.
+   */
+  int band_rows() const {
+    return std::max(1, std::min(depth - 1, 65536 / std::max(width, 1) - 1));
+  }
+
+  /**
+   * CPU-side mesh data exactly as build_mesh() would upload it: all
+   * vertices (built in parallel by row bands) and the 16-bit index
+   * pattern of one band.
+   * @pre width <= 32768 (two rows must fit a 16-bit index)
+   */
+  void build_geometry(std::vector<qe::renderer::Vertex>& verts,
+                      std::vector<uint16_t>& indices) const {
+    verts.clear();
+    indices.clear();
+    if (width < 2 || depth < 2)
+      return;
+    QE_REQUIRE(width <= 32768, "Terrain::build_geometry: grid too wide for 16-bit bands");
+    build_vertices(verts);
+    build_band_indices(indices);
+  }
+
+  /** Vertices of the whole grid, row bands built concurrently. */
+  void build_vertices(std::vector<qe::renderer::Vertex>& verts) const {
+    verts.resize(static_cast<size_t>(width) * depth);
+    qe::core::parallel_for(0, depth, [&](int z0, int z1) {
+      for (int z = z0; z < z1; ++z) {
+        qe::renderer::Vertex* row = verts.data() + static_cast<size_t>(z) * width;
+        for (int x = 0; x < width; ++x)
+          row[x] = make_vertex(x, z);
       }
-    }
+    }, 32);
+  }
 
-    // Indices (two triangles per quad)
-    for (int z = 0; z < depth - 1; ++z) {
+  /** Two triangles per quad for band_rows() rows, indices local to the band. */
+  void build_band_indices(std::vector<uint16_t>& indices) const {
+    const int rows = band_rows();
+    indices.clear();
+    indices.reserve(static_cast<size_t>(width - 1) * rows * 6);
+    for (int z = 0; z < rows; ++z) {
       for (int x = 0; x < width - 1; ++x) {
-        unsigned tl = z * width + x;
-        unsigned tr = tl + 1;
-        unsigned bl = (z + 1) * width + x;
-        unsigned br = bl + 1;
-
-        indices.push_back(tl);
-        indices.push_back(bl);
-        indices.push_back(tr);
-
-        indices.push_back(tr);
-        indices.push_back(bl);
-        indices.push_back(br);
+        auto tl = static_cast<uint16_t>(z * width + x);
+        auto tr = static_cast<uint16_t>(tl + 1);
+        auto bl = static_cast<uint16_t>((z + 1) * width + x);
+        auto br = static_cast<uint16_t>(bl + 1);
+        indices.insert(indices.end(), {tl, bl, tr, tr, bl, br});
       }
     }
+  }
 
-    mesh.upload(verts, indices);
+  /**
+   * Upload previously built vertices (e.g. baked into a course file)
+   * instead of rebuilding them; marks the mesh in sync with the heightmap.
+   * @pre vertex_count == width * depth
+   */
+  void upload_mesh(const qe::renderer::Vertex* verts, size_t vertex_count) {
+    QE_REQUIRE(vertex_count == static_cast<size_t>(width) * depth,
+               "Terrain::upload_mesh: vertex count does not match the grid");
+    std::vector<uint16_t> indices;
+    build_band_indices(indices);
+    mesh.upload(verts, vertex_count, indices.data(), indices.size(), GL_DYNAMIC_DRAW);
+    dirty_ = GridRect{};
   }
 
   /** Get height at grid coordinates (clamped). */
   float height_at(int x, int z) const {
     x = std::clamp(x, 0, width - 1);
     z = std::clamp(z, 0, depth - 1);
-    return heights_[z * width + x];
+    return vertex_height(x, z);
   }
 
   /** Get height at world coordinates (bilinear interpolation). */
   float height_at_world(float wx, float wz) const {
-    float gx = wx / cell_size + width / 2.0f;
-    float gz = wz / cell_size + depth / 2.0f;
-
-    int x0 = static_cast<int>(std::floor(gx));
-    int z0 = static_cast<int>(std::floor(gz));
-    float fx = gx - x0;
-    float fz = gz - z0;
-
-    float h00 = height_at(x0, z0);
-    float h10 = height_at(x0 + 1, z0);
-    float h01 = height_at(x0, z0 + 1);
-    float h11 = height_at(x0 + 1, z0 + 1);
-
-    float h0 = h00 + (h10 - h00) * fx;
-    float h1 = h01 + (h11 - h01) * fx;
-    return h0 + (h1 - h0) * fz;
+    return sample_height_grid(to_grid_x(wx), to_grid_z(wz));
   }
 
-  /** Get surface normal at world position. */
+  /** Get surface normal at world position (nearest precomputed normal). */
   qe::math::Vec3 normal_at_world(float wx, float wz) const {
-    float gx = wx / cell_size + width / 2.0f;
-    float gz = wz / cell_size + depth / 2.0f;
-    int x = static_cast<int>(std::round(gx));
-    int z = static_cast<int>(std::round(gz));
-    return normal_at(x, z);
+    return vertex_normal(nearest_index(to_grid_x(wx), to_grid_z(wz)));
   }
 
   /** Get surface type at world coordinates. */
   SurfaceType surface_at_world(float wx, float wz) const {
-    float gx = wx / cell_size + width / 2.0f;
-    float gz = wz / cell_size + depth / 2.0f;
-    int x = static_cast<int>(std::round(gx));
-    int z = static_cast<int>(std::round(gz));
-    return surface_at(x, z);
+    return vertex_surface(nearest_index(to_grid_x(wx), to_grid_z(wz)));
   }
 
   /** Get surface type at grid coordinates (clamped). */
   SurfaceType surface_at(int x, int z) const {
     x = std::clamp(x, 0, width - 1);
     z = std::clamp(z, 0, depth - 1);
-    return surfaces_[z * width + x];
+    return vertex_surface(static_cast<size_t>(z) * width + x);
   }
 
-  /** Compute normal from height differences. */
+  /** Precomputed normal at grid coordinates (clamped). */
   qe::math::Vec3 normal_at(int x, int z) const {
-    float hL = height_at(x - 1, z);
-    float hR = height_at(x + 1, z);
-    float hD = height_at(x, z - 1);
-    float hU = height_at(x, z + 1);
-    return qe::math::Vec3(hL - hR, 2.0f * cell_size, hD - hU).normalized();
+    x = std::clamp(x, 0, width - 1);
+    z = std::clamp(z, 0, depth - 1);
+    return vertex_normal(static_cast<size_t>(z) * width + x);
+  }
+
+  /**
+   * Everything physics needs at one world position, from a single
+   * coordinate transform: bilinear height, nearest normal and surface.
+   */
+  TerrainSample sample(float wx, float wz) const {
+    float gx = to_grid_x(wx), gz = to_grid_z(wz);
+    size_t i = nearest_index(gx, gz);
+    TerrainSample s;
+    s.height = sample_height_grid(gx, gz);
+    s.normal = vertex_normal(i);
+    s.surface = vertex_surface(i);
+    s.props = &surface_props(s.surface);
+    return s;
   }
 
-  /** Set heightmap data directly. */
+  // --- Batch queries (structure-of-arrays, n positions at once) ---
+
+  /** out[i] = height_at_world(wx[i], wz[i]) */
+  void sample_heights(const float* wx, const float* wz, float* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = sample_height_grid(to_grid_x(wx[i]), to_grid_z(wz[i]));
+  }
+
+  /** out[i] = normal_at_world(wx[i], wz[i]) */
+  void sample_normals(const float* wx, const float* wz, qe::math::Vec3* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = vertex_normal(nearest_index(to_grid_x(wx[i]), to_grid_z(wz[i])));
+  }
+
+  /** out[i] = surface_at_world(wx[i], wz[i]) */
+  void sample_surfaces(const float* wx, const float* wz, SurfaceType* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = vertex_surface(nearest_index(to_grid_x(wx[i]), to_grid_z(wz[i])));
+  }
+
+  /** Set heightmap data directly (stored in the current storage mode). */
   void set_data(int w, int d, float cs, std::vector<float> heights,
                 std::vector<SurfaceType> surfaces) {
     width = w;
@@ -165,10 +324,203 @@ class Terrain {
     cell_size = cs;
     heights_ = std::move(heights);
     surfaces_ = std::move(surfaces);
+    if (mode_ == StorageMode::Quantized)
+      encode_quantized();
+    compute_normals();
+    pyramid_.build(width, depth, [this](int x, int z) { return vertex_height(x, z); });
+    dirty_ = GridRect{0, 0, width - 1, depth - 1};
   }
 
+  /**
+   * Exclusive in-place edit of a vertex rectangle (RAII).
+   *
+   * Reads and writes go to a scratch copy of the region; commit() (or the
+   * destructor) writes it back, refreshes normals and pyramid nodes within
+   * one vertex of the region and marks it dirty for build_mesh().
+   *
+   * Edits of disjoint regions may be held on different threads at once;
+   * an overlapping edit() blocks until the earlier one commits. Queries
+   * and set_data()/set_storage() must not run while edits are open.
+   */
+  class Edit {
+   public:
+    Edit(const Edit&) = delete;
+    Edit& operator=(const Edit&) = delete;
+    Edit& operator=(Edit&&) = delete;
+
+    Edit(Edit&& other) noexcept
+        : terrain_(other.terrain_),
+          rect_(other.rect_),
+          locked_(other.locked_),
+          heights_(std::move(other.heights_)),
+          surfaces_(std::move(other.surfaces_)) {
+      other.terrain_ = nullptr;
+    }
+
+    ~Edit() {
+      commit();
+    }
+
+    /** Requested region, clamped to the grid. */
+    const GridRect& rect() const noexcept {
+      return rect_;
+    }
+
+    /** @pre rect().contains(x, z) */
+    float height(int x, int z) const {
+      return heights_[index(x, z)];
+    }
+    void set_height(int x, int z, float h) {
+      heights_[index(x, z)] = h;
+    }
+    SurfaceType surface(int x, int z) const {
+      return surfaces_[index(x, z)];
+    }
+    void set_surface(int x, int z, SurfaceType s) {
+      surfaces_[index(x, z)] = s;
+    }
+
+    /** Apply the edit and release the region (idempotent). */
+    void commit() {
+      if (!terrain_)
+        return;
+      terrain_->apply_edit(*this);
+      terrain_ = nullptr;
+    }
+
+   private:
+    friend class Terrain;
+
+    Edit(Terrain& t, const GridRect& rect, const GridRect& locked)
+        : terrain_(&t), rect_(rect), locked_(locked) {
+      heights_.resize(static_cast<size_t>(locked.cols()) * locked.rows());
+      surfaces_.resize(heights_.size());
+      std::lock_guard<std::mutex> lock(t.locks_->data_mutex());
+      for (int z = locked.z0; z <= locked.z1; ++z)
+        for (int x = locked.x0; x <= locked.x1; ++x) {
+          heights_[index(x, z)] = t.vertex_height(x, z);
+          surfaces_[index(x, z)] = t.vertex_surface(static_cast<size_t>(z) * t.width + x);
+        }
+    }
+
+    size_t index(int x, int z) const {
+      return static_cast<size_t>(z - locked_.z0) * locked_.cols() + (x - locked_.x0);
+    }
+
+    Terrain* terrain_ = nullptr;
+    GridRect rect_;    // What the caller asked for
+    GridRect locked_;  // rect_ grown to whole storage tiles in quantized mode
+    std::vector<float> heights_;
+    std::vector<SurfaceType> surfaces_;
+  };
+
+  /**
+   * Open an edit over a vertex rectangle (clamped to the grid).
+   * @pre region overlaps the grid
+   */
+  Edit edit(const GridRect& region) {
+    GridRect rect = region.clamped(width, depth);
+    QE_REQUIRE(!rect.empty(), "Terrain::edit: region lies outside the grid");
+    GridRect locked = rect;
+    if (mode_ == StorageMode::Quantized) {
+      // Tiles are re-encoded as a whole, so they must not be shared
+      constexpr int kMask = QuantizedHeights::kTileSize - 1;
+      locked = GridRect{rect.x0 & ~kMask, rect.z0 & ~kMask, rect.x1 | kMask, rect.z1 | kMask}
+                   .clamped(width, depth);
+    }
+    locks_->acquire(locked);
+    return Edit(*this, rect, locked);
+  }
+
+  /** Vertices changed since the last build_mesh() (empty when in sync). */
+  const GridRect& dirty_rect() const noexcept {
+    return dirty_;
+  }
+
+  /** Return and clear the dirty rectangle (for consumers other than the mesh). */
+  GridRect take_dirty() noexcept {
+    GridRect r = dirty_;
+    dirty_ = GridRect{};
+    return r;
+  }
+
+  /**
+   * Switch storage mode, converting any existing data. Going from
+   * Quantized back to Float keeps the quantized values (precision lost
+   * on the way in is not recovered).
+   */
+  void set_storage(StorageMode mode) {
+    if (mode == mode_)
+      return;
+    if (heights_.empty() && qheights_.empty()) {
+      mode_ = mode;
+      return;
+    }
+    if (mode == StorageMode::Quantized) {
+      mode_ = mode;
+      encode_quantized();
+    } else {
+      size_t n = static_cast<size_t>(width) * depth;
+      heights_.resize(n);
+      surfaces_.resize(n);
+      for (int z = 0; z < depth; ++z)
+        for (int x = 0; x < width; ++x)
+          heights_[z * width + x] = qheights_.decode(x, z);
+      for (size_t i = 0; i < n; ++i)
+        surfaces_[i] = psurfaces_.get(i);
+      qheights_.clear();
+      psurfaces_.clear();
+      pnormals_.clear();
+      pnormals_.shrink_to_fit();
+      mode_ = mode;
+    }
+    compute_normals();
+    pyramid_.build(width, depth, [this](int x, int z) { return vertex_height(x, z); });
+    dirty_ = GridRect{0, 0, width - 1, depth - 1};
+  }
+
+  StorageMode storage() const noexcept {
+    return mode_;
+  }
+
+  /** Bytes held by per-vertex heights, surfaces and normals. */
+  size_t memory_bytes() const noexcept {
+    return heights_.size() * sizeof(float) + surfaces_.size() * sizeof(SurfaceType) +
+           normals_.size() * sizeof(qe::math::Vec3) + qheights_.memory_bytes() +
+           psurfaces_.memory_bytes() + pnormals_.size() * sizeof(uint32_t);
+  }
+
+  /**
+   * Cast a ray against the terrain surface.
+   * @param dir  Direction (need not be normalized; hit.t is in units of |dir|
+   *             after normalization, i.e. world distance)
+   * @return true on the nearest downward crossing within max_dist.
+   */
+  bool raycast(const qe::math::Vec3& origin, const qe::math::Vec3& dir, float max_dist,
+               TerrainHit& hit) const {
+    float len = dir.length();
+    if (len < 1e-8f)
+      return false;
+    return intersect(origin, dir * (1.0f / len), max_dist, hit);
+  }
+
+  /** Sweep the segment a → b; hit.t is the fraction along the segment. */
+  bool segment_cast(const qe::math::Vec3& a, const qe::math::Vec3& b, TerrainHit& hit) const {
+    return intersect(a, b - a, 1.0f, hit);
+  }
+
+  const MinMaxPyramid& pyramid() const noexcept {
+    return pyramid_;
+  }
+
+  /** One base-vertex draw per band of band_rows() quad rows. */
   void draw() const {
-    mesh.draw();
+    const int rows = band_rows();
+    const GLsizei per_row = (width - 1) * 6;
+    for (int z = 0; z < depth - 1; z += rows) {
+      int n = std::min(rows, depth - 1 - z);
+      mesh.draw_base_vertex(per_row * n, z * width);
+    }
   }
   void destroy() {
     mesh.destroy();
@@ -179,6 +531,224 @@ class Terrain {
  private:
   std::vector<float> heights_;
   std::vector<SurfaceType> surfaces_;
+  std::vector<qe::math::Vec3> normals_;  // Per-vertex, rebuilt with the heights
+  QuantizedHeights qheights_;            // Quantized mode counterparts
+  PackedSurfaces psurfaces_;
+  std::vector<uint32_t> pnormals_;
+  StorageMode mode_ = StorageMode::Float;
+  MinMaxPyramid pyramid_;
+  GridRect dirty_;
+  std::unique_ptr<RegionLocks> locks_ = std::make_unique<RegionLocks>();
+
+  // --- Storage-agnostic vertex accessors (unclamped) ---
+
+  float vertex_height(int x, int z) const {
+    return mode_ == StorageMode::Quantized ? qheights_.decode(x, z) : heights_[z * width + x];
+  }
+  SurfaceType vertex_surface(size_t i) const {
+    return mode_ == StorageMode::Quantized ? psurfaces_.get(i) : surfaces_[i];
+  }
+  qe::math::Vec3 vertex_normal(size_t i) const {
+    return mode_ == StorageMode::Quantized ? unpack_normal(pnormals_[i]) : normals_[i];
+  }
+
+  /** Move heights_/surfaces_ into the quantized containers. */
+  void encode_quantized() {
+    qheights_.encode(width, depth, heights_.data());
+    psurfaces_.resize(surfaces_.size());
+    for (size_t i = 0; i < surfaces_.size(); ++i)
+      psurfaces_.set(i, surfaces_[i]);
+    heights_.clear();
+    heights_.shrink_to_fit();
+    surfaces_.clear();
+    surfaces_.shrink_to_fit();
+    normals_.clear();
+    normals_.shrink_to_fit();
+  }
+
+  float to_grid_x(float wx) const {
+    return wx / cell_size + width / 2.0f;
+  }
+  float to_grid_z(float wz) const {
+    return wz / cell_size + depth / 2.0f;
+  }
+
+  /**
+   * Branch-free bilinear height at grid coordinates. Clamping the
+   * coordinate (min/max, not per-corner index clamps) reproduces the
+   * edge-extended lookup of height_at() for points outside the grid.
+   */
+  float sample_height_grid(float gx, float gz) const {
+    gx = std::min(std::max(gx, 0.0f), static_cast<float>(width - 1));
+    gz = std::min(std::max(gz, 0.0f), static_cast<float>(depth - 1));
+    int x0 = std::min(static_cast<int>(gx), width - 2);
+    int z0 = std::min(static_cast<int>(gz), depth - 2);
+    float fx = gx - x0;
+    float fz = gz - z0;
+
+    float h00 = vertex_height(x0, z0), h10 = vertex_height(x0 + 1, z0);
+    float h01 = vertex_height(x0, z0 + 1), h11 = vertex_height(x0 + 1, z0 + 1);
+    float h0 = h00 + (h10 - h00) * fx;
+    float h1 = h01 + (h11 - h01) * fx;
+    return h0 + (h1 - h0) * fz;
+  }
+
+  /** Row-major index of the grid vertex nearest (gx, gz), clamped. */
+  size_t nearest_index(float gx, float gz) const {
+    gx = std::min(std::max(gx, 0.0f), static_cast<float>(width - 1));
+    gz = std::min(std::max(gz, 0.0f), static_cast<float>(depth - 1));
+    return static_cast<size_t>(static_cast<int>(gz + 0.5f)) * width +
+           static_cast<size_t>(gx + 0.5f);
+  }
+
+  /** Central-difference normal per vertex (never zero-length: y = 2 * cell_size). */
+  void compute_normals() {
+    const size_t n = static_cast<size_t>(width) * depth;
+    if (mode_ == StorageMode::Quantized)
+      pnormals_.resize(n);
+    else
+      normals_.resize(n);
+    compute_normals(GridRect{0, 0, width - 1, depth - 1});
+  }
+
+  /** Recompute the normals inside r (already sized storage). */
+  void compute_normals(const GridRect& r) {
+    const bool packed = mode_ == StorageMode::Quantized;
+    for (int z = r.z0; z <= r.z1; ++z) {
+      for (int x = r.x0; x <= r.x1; ++x) {
+        float hL = height_at(x - 1, z);
+        float hR = height_at(x + 1, z);
+        float hD = height_at(x, z - 1);
+        float hU = height_at(x, z + 1);
+        float nx = hL - hR, ny = 2.0f * cell_size, nz = hD - hU;
+        float inv = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+        qe::math::Vec3 nrm(nx * inv, ny * inv, nz * inv);
+        if (packed)
+          pnormals_[z * width + x] = pack_normal(nrm);
+        else
+          normals_[z * width + x] = nrm;
+      }
+    }
+  }
+
+  /** Write back a committed edit and refresh everything derived from it. */
+  void apply_edit(const Edit& e) {
+    const GridRect& r = e.locked_;
+    {
+      std::lock_guard<std::mutex> lock(locks_->data_mutex());
+      if (mode_ == StorageMode::Quantized) {
+        constexpr int kShift = QuantizedHeights::kTileShift;
+        for (int tz = r.z0 >> kShift; tz <= r.z1 >> kShift; ++tz)
+          for (int tx = r.x0 >> kShift; tx <= r.x1 >> kShift; ++tx)
+            qheights_.encode_tile(tx, tz, [&](int x, int z) { return e.heights_[e.index(x, z)]; });
+      }
+      for (int z = r.z0; z <= r.z1; ++z) {
+        for (int x = r.x0; x <= r.x1; ++x) {
+          size_t i = static_cast<size_t>(z) * width + x;
+          if (mode_ == StorageMode::Quantized) {
+            psurfaces_.set(i, e.surfaces_[e.index(x, z)]);
+          } else {
+            heights_[i] = e.heights_[e.index(x, z)];
+            surfaces_[i] = e.surfaces_[e.index(x, z)];
+          }
+        }
+      }
+
+      // Normals use central differences, so the ring around r changes too
+      GridRect touched = r.expanded(1).clamped(width, depth);
+      compute_normals(touched);
+      pyramid_.update(r.x0, r.z0, r.x1, r.z1,
+                      [this](int x, int z) { return vertex_height(x, z); });
+      dirty_ = dirty_.united(touched);
+    }
+    locks_->release(r);
+  }
+
+  /** Vertex (x, z) as uploaded to the GPU. */
+  qe::renderer::Vertex make_vertex(int x, int z) const {
+    qe::renderer::Vertex v;
+    v.position[0] = (x - width / 2.0f) * cell_size;
+    v.position[1] = vertex_height(x, z);
+    v.position[2] = (z - depth / 2.0f) * cell_size;
+
+    size_t i = static_cast<size_t>(z) * width + x;
+    auto n = vertex_normal(i);
+    v.normal[0] = n.x;
+    v.normal[1] = n.y;
+    v.normal[2] = n.z;
+
+    // Color from surface type
+    const auto& surf = surface_props(vertex_surface(i));
+    v.color[0] = surf.r;
+    v.color[1] = surf.g;
+    v.color[2] = surf.b;
+
+    // UV for potential texture
+    v.uv[0] = static_cast<float>(x) / (width - 1);
+    v.uv[1] = static_cast<float>(z) / (depth - 1);
+    return v;
+  }
+
+  /** Re-upload the vertices of r in an existing mesh. */
+  void update_mesh(const GridRect& r) {
+    if (r.empty())
+      return;
+    std::vector<qe::renderer::Vertex> verts;
+    verts.reserve(static_cast<size_t>(r.cols()) * r.rows());
+    for (int z = r.z0; z <= r.z1; ++z)
+      for (int x = r.x0; x <= r.x1; ++x)
+        verts.push_back(make_vertex(x, z));
+
+    size_t first = static_cast<size_t>(r.z0) * width + r.x0;
+    if (r.cols() == width) {
+      // Full-width band is contiguous in the vertex buffer
+      mesh.update_vertices(first, verts.data(), verts.size());
+    } else {
+      for (int row = 0; row < r.rows(); ++row)
+        mesh.update_vertices(first + static_cast<size_t>(row) * width,
+                             &verts[static_cast<size_t>(row) * r.cols()], r.cols());
+    }
+  }
+
+  /**
+   * Hierarchical ray vs. bilinear heightfield intersection.
+   * Only crossings from above to below the surface count, so rays that
+   * start under the terrain (or resting on it) do not report a hit.
+   */
+  bool intersect(const qe::math::Vec3& origin, const qe::math::Vec3& dir, float t_max,
+                 TerrainHit& hit) const {
+    if (pyramid_.empty())
+      return false;
+
+    // Grid space: x/z in vertex units, y unchanged
+    const float inv_cs = 1.0f / cell_size;
+    const float o[3] = {origin.x * inv_cs + width / 2.0f, origin.y,
+                        origin.z * inv_cs + depth / 2.0f};
+    const float d[3] = {dir.x * inv_cs, dir.y, dir.z * inv_cs};
+
+    float best_u = 0.0f, best_v = 0.0f;
+    int best_cx = 0, best_cz = 0;
+
+    auto cell_test = [&](int cx, int cz, float t0, float t1, float& t_best) {
+      if (!intersect_cell(o, d, cx, cz, vertex_height(cx, cz), vertex_height(cx + 1, cz),
+                          vertex_height(cx, cz + 1), vertex_height(cx + 1, cz + 1), t0, t1,
+                          t_max, t_best, best_u, best_v))
+        return false;
+      best_cx = cx;
+      best_cz = cz;
+      return true;
+    };
+
+    float t_hit;
+    if (!pyramid_.traverse(o, d, t_max, cell_test, t_hit))
+      return false;
+
+    bilinear_hit(origin, dir, t_hit, vertex_height(best_cx, best_cz),
+                 vertex_height(best_cx + 1, best_cz), vertex_height(best_cx, best_cz + 1),
+                 vertex_height(best_cx + 1, best_cz + 1), best_u, best_v, inv_cs, hit);
+    hit.surface = surface_at_world(hit.point.x, hit.point.z);
+    return true;
+  }
 };
 
 }  // namespace terrain
@@ -0,0 +1,109 @@
+#pragma once
+/**
+ * @file TerrainEdit.h
+ * @brief Grid rectangles and region locks for in-place terrain editing.
+ *
+ * GridRect is an inclusive rectangle of heightmap vertices, used both for
+ * edit regions and for the dirty area the mesh still has to re-upload.
+ * RegionLocks lets several editors (e.g. course stamps on worker threads)
+ * hold disjoint rectangles at once; an overlapping request blocks until
+ * the conflicting region is released.
+ *
+ * Design by Contract:
+ *   - Invariant: rectangles held in RegionLocks are pairwise disjoint
+ *   - Postcondition: acquire() returns only once the rectangle is exclusive
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace qg {
+namespace terrain {
+
+/** Inclusive vertex rectangle [x0, x1] x [z0, z1]; empty when x1 < x0. */
+struct GridRect {
+  int x0 = 0, z0 = 0;
+  int x1 = -1, z1 = -1;
+
+  bool empty() const noexcept {
+    return x1 < x0 || z1 < z0;
+  }
+  int cols() const noexcept {
+    return empty() ? 0 : x1 - x0 + 1;
+  }
+  int rows() const noexcept {
+    return empty() ? 0 : z1 - z0 + 1;
+  }
+  bool contains(int x, int z) const noexcept {
+    return x >= x0 && x <= x1 && z >= z0 && z <= z1;
+  }
+  bool overlaps(const GridRect& o) const noexcept {
+    return !empty() && !o.empty() && x0 <= o.x1 && o.x0 <= x1 && z0 <= o.z1 && o.z0 <= z1;
+  }
+  bool operator==(const GridRect& o) const noexcept {
+    return x0 == o.x0 && z0 == o.z0 && x1 == o.x1 && z1 == o.z1;
+  }
+
+  /** Smallest rectangle covering both (either may be empty). */
+  GridRect united(const GridRect& o) const noexcept {
+    if (empty())
+      return o;
+    if (o.empty())
+      return *this;
+    return {std::min(x0, o.x0), std::min(z0, o.z0), std::max(x1, o.x1), std::max(z1, o.z1)};
+  }
+
+  GridRect expanded(int n) const noexcept {
+    return empty() ? *this : GridRect{x0 - n, z0 - n, x1 + n, z1 + n};
+  }
+
+  /** Intersection with a width x depth grid. */
+  GridRect clamped(int width, int depth) const noexcept {
+    GridRect r{std::max(x0, 0), std::max(z0, 0), std::min(x1, width - 1), std::min(z1, depth - 1)};
+    return r.empty() ? GridRect{} : r;
+  }
+};
+
+class RegionLocks {
+ public:
+  /** Block until no held rectangle overlaps r, then hold it. */
+  void acquire(const GridRect& r) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_.wait(lock, [&] {
+      return std::none_of(held_.begin(), held_.end(),
+                          [&](const GridRect& h) { return h.overlaps(r); });
+    });
+    held_.push_back(r);
+  }
+
+  void release(const GridRect& r) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = std::find(held_.begin(), held_.end(), r);
+      if (it != held_.end())
+        held_.erase(it);
+    }
+    released_.notify_all();
+  }
+
+  size_t held() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return held_.size();
+  }
+
+  /** Serializes reads/writes of shared terrain data (storage, normals, pyramid). */
+  std::mutex& data_mutex() noexcept {
+    return data_mutex_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  std::vector<GridRect> held_;
+  std::mutex data_mutex_;
+};
+
+}  // namespace terrain
+}  // namespace qg
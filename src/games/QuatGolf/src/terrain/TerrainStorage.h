@@ -0,0 +1,163 @@
+#pragma once
+/**
+ * @file TerrainStorage.h
+ * @brief Compact encodings for terrain heights, surfaces and normals.
+ *
+ * Used by Terrain's quantized storage mode:
+ *   - QuantizedHeights: 16-bit heights with a per-tile offset and scale
+ *     (16x16 vertex tiles, max error = tile range / 131070)
+ *   - PackedSurfaces:   4 bits per cell, two cells per byte
+ *   - pack_normal():    unit normal as three signed 8-bit components
+ *
+ * Per-vertex cost drops from 4 + 4 + 12 bytes (float height, int-sized
+ * enum, float normal) to 2 + 0.5 + 4 bytes.
+ *
+ * Design by Contract:
+ *   - Precondition: encode() is given width * depth values
+ *   - Invariant: |decode(x, z) - source(x, z)| <= tile scale / 2
+ *   - Invariant: SurfaceType values fit in 4 bits (Count <= 16)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Surface.h"
+#include "math/Vec3.h"
+
+namespace qg {
+namespace terrain {
+
+static_assert(static_cast<int>(SurfaceType::Count) <= 16, "SurfaceType must fit in 4 bits");
+
+class QuantizedHeights {
+ public:
+  static constexpr int kTileShift = 4;  // 16x16 vertices per tile
+  static constexpr int kTileSize = 1 << kTileShift;
+
+  struct Tile {
+    float offset = 0.0f;  // Height of code 0
+    float scale = 0.0f;   // Metres per code step
+  };
+
+  void encode(int width, int depth, const float* heights) {
+    width_ = width;
+    depth_ = depth;
+    tiles_x_ = (width + kTileSize - 1) >> kTileShift;
+    tiles_z_ = (depth + kTileSize - 1) >> kTileShift;
+    codes_.assign(static_cast<size_t>(width) * depth, 0);
+    tiles_.assign(static_cast<size_t>(tiles_x_) * tiles_z_, Tile{});
+    for (int tz = 0; tz < tiles_z_; ++tz)
+      for (int tx = 0; tx < tiles_x_; ++tx)
+        encode_tile(tx, tz, [&](int x, int z) { return heights[z * width + x]; });
+  }
+
+  /**
+   * Re-encode one tile from a height accessor (used after edits).
+   * @param height_fn  float(int x, int z) for vertices inside the tile
+   */
+  template <typename HeightFn>
+  void encode_tile(int tx, int tz, HeightFn&& height_fn) {
+    int x0 = tx << kTileShift, z0 = tz << kTileShift;
+    int x1 = std::min(x0 + kTileSize, width_), z1 = std::min(z0 + kTileSize, depth_);
+
+    float lo = height_fn(x0, z0), hi = lo;
+    for (int z = z0; z < z1; ++z)
+      for (int x = x0; x < x1; ++x) {
+        float h = height_fn(x, z);
+        lo = std::min(lo, h);
+        hi = std::max(hi, h);
+      }
+
+    Tile& t = tiles_[tz * tiles_x_ + tx];
+    t.offset = lo;
+    t.scale = (hi - lo) / 65535.0f;
+    float inv = t.scale > 0.0f ? 1.0f / t.scale : 0.0f;
+    for (int z = z0; z < z1; ++z)
+      for (int x = x0; x < x1; ++x) {
+        float q = std::round((height_fn(x, z) - lo) * inv);
+        codes_[z * width_ + x] = static_cast<uint16_t>(std::clamp(q, 0.0f, 65535.0f));
+      }
+  }
+
+  float decode(int x, int z) const {
+    const Tile& t = tiles_[(z >> kTileShift) * tiles_x_ + (x >> kTileShift)];
+    return t.offset + t.scale * codes_[z * width_ + x];
+  }
+
+  int tiles_x() const noexcept {
+    return tiles_x_;
+  }
+  int tiles_z() const noexcept {
+    return tiles_z_;
+  }
+  bool empty() const noexcept {
+    return codes_.empty();
+  }
+  void clear() {
+    codes_.clear();
+    codes_.shrink_to_fit();
+    tiles_.clear();
+    tiles_.shrink_to_fit();
+  }
+  size_t memory_bytes() const noexcept {
+    return codes_.size() * sizeof(uint16_t) + tiles_.size() * sizeof(Tile);
+  }
+
+ private:
+  int width_ = 0, depth_ = 0;
+  int tiles_x_ = 0, tiles_z_ = 0;
+  std::vector<uint16_t> codes_;
+  std::vector<Tile> tiles_;
+};
+
+class PackedSurfaces {
+ public:
+  void resize(size_t count) {
+    nibbles_.assign((count + 1) / 2, 0);
+  }
+
+  SurfaceType get(size_t i) const {
+    return static_cast<SurfaceType>((nibbles_[i >> 1] >> ((i & 1) * 4)) & 0xF);
+  }
+
+  void set(size_t i, SurfaceType s) {
+    uint8_t& byte = nibbles_[i >> 1];
+    int shift = static_cast<int>(i & 1) * 4;
+    byte = static_cast<uint8_t>((byte & ~(0xF << shift)) | (static_cast<int>(s) << shift));
+  }
+
+  bool empty() const noexcept {
+    return nibbles_.empty();
+  }
+  void clear() {
+    nibbles_.clear();
+    nibbles_.shrink_to_fit();
+  }
+  size_t memory_bytes() const noexcept {
+    return nibbles_.size();
+  }
+
+ private:
+  std::vector<uint8_t> nibbles_;
+};
+
+/** Pack a unit normal into three snorm8 components (x | y << 8 | z << 16). */
+inline uint32_t pack_normal(const qe::math::Vec3& n) {
+  auto q = [](float v) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(
+        static_cast<int8_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f))));
+  };
+  return q(n.x) | (q(n.y) << 8) | (q(n.z) << 16);
+}
+
+/** Inverse of pack_normal (length within ~1% of 1). */
+inline qe::math::Vec3 unpack_normal(uint32_t p) {
+  constexpr float kInv = 1.0f / 127.0f;
+  return {static_cast<int8_t>(p & 0xFF) * kInv, static_cast<int8_t>((p >> 8) & 0xFF) * kInv,
+          static_cast<int8_t>((p >> 16) & 0xFF) * kInv};
+}
+
+}  // namespace terrain
+}  // namespace qg
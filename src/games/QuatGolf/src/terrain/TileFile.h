@@ -0,0 +1,335 @@
+#pragma once
+/**
+ * @file TileFile.h
+ * @brief On-disk tiled heightmap for terrain larger than memory.
+ *
+ * The grid is cut into square tiles of tile_size cells. Each tile stores
+ * (tile_size + 1)^2 vertices — neighbouring tiles duplicate their shared
+ * edge — so any bilinear cell and any nearest-vertex lookup is answered by
+ * a single tile. Per vertex: float height, packed normal, surface byte.
+ *
+ * A coarse overview (every coarse_step-th vertex) and the min/max height
+ * of every tile are stored up front and kept in memory by the reader; they
+ * answer queries for tiles that have not been paged in yet.
+ *
+ * Layout (little-endian, 16-byte aligned blocks):
+ *   Header | coarse heights | coarse surfaces | tile bounds | tile 0 | ...
+ * Tiles are row-major (tz * tiles_x + tx) with a fixed stride.
+ *
+ * Design by Contract:
+ *   - Precondition: tile_size % coarse_step == 0
+ *   - Invariant: vertex (gx, gz) of the full grid maps to tile
+ *     (min(gx / T, tiles_x - 1), ...) at local (gx - tx * T, ...)
+ *   - read_tile() is const and thread-safe (reads the mapping only)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Surface.h"
+#include "TerrainStorage.h"
+#include "core/MappedFile.h"
+#include "core/Parallel.h"
+#include "math/Vec3.h"
+
+namespace qg {
+namespace terrain {
+
+struct TileLayout {
+  int tile_size = 128;  // Cells per tile edge (<= 255: tile meshes use 16-bit indices)
+  int tiles_x = 1;
+  int tiles_z = 1;
+  float cell_size = 1.0f;
+  int coarse_step = 16;  // Vertices between coarse samples
+
+  /** Vertices across the full grid. */
+  int width() const noexcept {
+    return tiles_x * tile_size + 1;
+  }
+  int depth() const noexcept {
+    return tiles_z * tile_size + 1;
+  }
+  int tile_vertices() const noexcept {
+    return tile_size + 1;
+  }
+  int coarse_width() const noexcept {
+    return tiles_x * tile_size / coarse_step + 1;
+  }
+  int coarse_depth() const noexcept {
+    return tiles_z * tile_size / coarse_step + 1;
+  }
+  int tile_count() const noexcept {
+    return tiles_x * tiles_z;
+  }
+  bool valid() const noexcept {
+    return tile_size >= 2 && tile_size <= 255 && tiles_x >= 1 && tiles_z >= 1 && cell_size > 0.0f &&
+           coarse_step >= 1 && tile_size % coarse_step == 0;
+  }
+};
+
+/** One paged-in tile: (tile_size + 1)^2 vertices, row-major. */
+struct TileData {
+  int tx = 0, tz = 0;
+  std::vector<float> heights;
+  std::vector<uint32_t> normals;  // pack_normal()
+  std::vector<uint8_t> surfaces;
+
+  size_t memory_bytes() const noexcept {
+    return heights.size() * sizeof(float) + normals.size() * sizeof(uint32_t) + surfaces.size();
+  }
+};
+
+class TileFile {
+ public:
+  static constexpr uint32_t kVersion = 1;
+
+  /**
+   * Write a tiled heightmap one row of tiles at a time: each band of
+   * tile_size + 3 rows (one apron row either side for normals) is sampled
+   * in parallel, cut into tiles and written out, so memory stays at one
+   * band regardless of the grid size.
+   * @param height  float(int gx, int gz) for 0 <= gx < width(), 0 <= gz < depth();
+   *                called concurrently, must be thread-safe
+   * @param surface SurfaceType(int gx, int gz), same domain and contract
+   */
+  template <typename HeightFn, typename SurfaceFn>
+  static bool write(const std::string& path, const TileLayout& layout, HeightFn&& height,
+                    SurfaceFn&& surface) {
+    if (!layout.valid()) {
+      std::cerr << "TileFile: invalid layout" << std::endl;
+      return false;
+    }
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) {
+      std::cerr << "TileFile: cannot write " << path << std::endl;
+      return false;
+    }
+
+    const int w = layout.width(), d = layout.depth();
+    Header hdr;
+    hdr.tile_size = layout.tile_size;
+    hdr.tiles_x = layout.tiles_x;
+    hdr.tiles_z = layout.tiles_z;
+    hdr.cell_size = layout.cell_size;
+    hdr.coarse_step = layout.coarse_step;
+    std::vector<uint8_t> block;
+    append(block, &hdr, sizeof(hdr));
+
+    // Coarse overview
+    const int cw = layout.coarse_width(), cd = layout.coarse_depth();
+    std::vector<float> ch(static_cast<size_t>(cw) * cd);
+    std::vector<uint8_t> cs(ch.size());
+    qe::core::parallel_for(0, cd, [&](int lo, int hi) {
+      for (int z = lo; z < hi; ++z)
+        for (int x = 0; x < cw; ++x) {
+          int gx = x * layout.coarse_step, gz = z * layout.coarse_step;
+          ch[static_cast<size_t>(z) * cw + x] = static_cast<float>(height(gx, gz));
+          cs[static_cast<size_t>(z) * cw + x] = static_cast<uint8_t>(surface(gx, gz));
+        }
+    });
+    append(block, ch.data(), ch.size() * sizeof(float));
+    append(block, cs.data(), cs.size());
+    const std::streamoff bounds_at = static_cast<std::streamoff>(block.size());
+    std::vector<float> bounds(static_cast<size_t>(layout.tile_count()) * 2);
+    append(block, bounds.data(), bounds.size() * sizeof(float));  // Patched at the end
+    if (!f.write(reinterpret_cast<const char*>(block.data()),
+                 static_cast<std::streamsize>(block.size())))
+      return false;
+
+    // Tiles, one band of rows at a time
+    const int T = layout.tile_size, tv = layout.tile_vertices();
+    const int bw = w + 2;  // Band columns -1 .. w
+    const float two_cs = 2.0f * layout.cell_size;
+    std::vector<float> band(static_cast<size_t>(T + 3) * bw);
+    std::vector<uint8_t> sband(static_cast<size_t>(tv) * w);
+    TileData tile;
+    tile.heights.resize(static_cast<size_t>(tv) * tv);
+    tile.normals.resize(tile.heights.size());
+    tile.surfaces.resize(tile.heights.size());
+    for (int tz = 0; tz < layout.tiles_z; ++tz) {
+      const int gz0 = tz * T;
+      qe::core::parallel_for(0, T + 3, [&](int lo, int hi) {
+        for (int r = lo; r < hi; ++r) {
+          int gz = std::clamp(gz0 - 1 + r, 0, d - 1);
+          float* row = band.data() + static_cast<size_t>(r) * bw;
+          for (int c = 0; c < bw; ++c)
+            row[c] = static_cast<float>(height(std::clamp(c - 1, 0, w - 1), gz));
+          if (r >= 1 && r <= tv)
+            for (int gx = 0; gx < w; ++gx)
+              sband[static_cast<size_t>(r - 1) * w + gx] =
+                  static_cast<uint8_t>(surface(gx, gz0 + r - 1));
+        }
+      }, 4);
+
+      for (int tx = 0; tx < layout.tiles_x; ++tx) {
+        float lo = band[static_cast<size_t>(bw) + tx * T + 1], hi = lo;
+        for (int lz = 0; lz < tv; ++lz) {
+          // Band row lz + 1 is grid row gz0 + lz; column c + 1 is grid column c
+          const float* row = band.data() + static_cast<size_t>(lz + 1) * bw + tx * T + 1;
+          for (int lx = 0; lx < tv; ++lx) {
+            size_t i = static_cast<size_t>(lz) * tv + lx;
+            float hc = row[lx];
+            tile.heights[i] = hc;
+            lo = std::min(lo, hc);
+            hi = std::max(hi, hc);
+            tile.surfaces[i] = sband[static_cast<size_t>(lz) * w + tx * T + lx];
+            // Same central difference as Terrain::compute_normals()
+            float nx = row[lx - 1] - row[lx + 1];
+            float nz = row[lx - bw] - row[lx + bw];
+            float inv = 1.0f / std::sqrt(nx * nx + two_cs * two_cs + nz * nz);
+            tile.normals[i] = pack_normal({nx * inv, two_cs * inv, nz * inv});
+          }
+        }
+        bounds[(static_cast<size_t>(tz) * layout.tiles_x + tx) * 2] = lo;
+        bounds[(static_cast<size_t>(tz) * layout.tiles_x + tx) * 2 + 1] = hi;
+        block.clear();
+        append(block, tile.heights.data(), tile.heights.size() * sizeof(float));
+        append(block, tile.normals.data(), tile.normals.size() * sizeof(uint32_t));
+        append(block, tile.surfaces.data(), tile.surfaces.size());
+        if (!f.write(reinterpret_cast<const char*>(block.data()),
+                     static_cast<std::streamsize>(block.size())))
+          return false;
+      }
+    }
+
+    f.seekp(bounds_at);
+    f.write(reinterpret_cast<const char*>(bounds.data()),
+            static_cast<std::streamsize>(bounds.size() * sizeof(float)));
+    return static_cast<bool>(f);
+  }
+
+  /** Map and validate a tile file; the coarse overview is copied into memory. */
+  bool open(const std::string& path) {
+    file_.close();
+    if (!file_.open(path))
+      return false;
+    if (file_.size() < sizeof(Header))
+      return fail(path, "truncated header");
+    Header hdr;
+    std::memcpy(&hdr, file_.data(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, "QGTT", 4) != 0 || hdr.version != kVersion)
+      return fail(path, "not a version " + std::to_string(kVersion) + " tile file");
+    layout_.tile_size = hdr.tile_size;
+    layout_.tiles_x = hdr.tiles_x;
+    layout_.tiles_z = hdr.tiles_z;
+    layout_.cell_size = hdr.cell_size;
+    layout_.coarse_step = hdr.coarse_step;
+    if (!layout_.valid())
+      return fail(path, "bad layout");
+    if (tiles_offset() + tile_stride() * layout_.tile_count() > file_.size())
+      return fail(path, "truncated tile data");
+
+    const size_t cn = static_cast<size_t>(layout_.coarse_width()) * layout_.coarse_depth();
+    const uint8_t* p = file_.data() + sizeof(Header);
+    coarse_heights_.resize(cn);
+    std::memcpy(coarse_heights_.data(), p, cn * sizeof(float));
+    p += align(cn * sizeof(float));
+    coarse_surfaces_.assign(p, p + cn);
+    p += align(cn);
+    bounds_.resize(static_cast<size_t>(layout_.tile_count()) * 2);
+    std::memcpy(bounds_.data(), p, bounds_.size() * sizeof(float));
+    return true;
+  }
+
+  /** Unmap the file; is_open() is false afterwards. */
+  void close() {
+    file_.close();
+  }
+
+  bool is_open() const noexcept {
+    return file_.is_open();
+  }
+  const TileLayout& layout() const noexcept {
+    return layout_;
+  }
+  float coarse_height(int cx, int cz) const {
+    return coarse_heights_[static_cast<size_t>(cz) * layout_.coarse_width() + cx];
+  }
+  SurfaceType coarse_surface(int cx, int cz) const {
+    return static_cast<SurfaceType>(
+        coarse_surfaces_[static_cast<size_t>(cz) * layout_.coarse_width() + cx]);
+  }
+  /** Lowest and highest height inside a tile (available without paging it in). */
+  void tile_bounds(int tx, int tz, float& lo, float& hi) const {
+    size_t i = (static_cast<size_t>(tz) * layout_.tiles_x + tx) * 2;
+    lo = bounds_[i];
+    hi = bounds_[i + 1];
+  }
+  size_t coarse_bytes() const noexcept {
+    return (coarse_heights_.size() + bounds_.size()) * sizeof(float) + coarse_surfaces_.size();
+  }
+
+  /** Copy one tile out of the mapping (page faults land on the caller's thread). */
+  void read_tile(int tx, int tz, TileData& out) const {
+    const size_t n = static_cast<size_t>(layout_.tile_vertices()) * layout_.tile_vertices();
+    const uint8_t* p = file_.data() + tiles_offset() +
+                       tile_stride() * (static_cast<size_t>(tz) * layout_.tiles_x + tx);
+    out.tx = tx;
+    out.tz = tz;
+    out.heights.resize(n);
+    out.normals.resize(n);
+    std::memcpy(out.heights.data(), p, n * sizeof(float));
+    p += align(n * sizeof(float));
+    std::memcpy(out.normals.data(), p, n * sizeof(uint32_t));
+    p += align(n * sizeof(uint32_t));
+    out.surfaces.assign(p, p + n);
+  }
+
+ private:
+  static constexpr size_t kAlign = 16;
+
+  struct Header {
+    char magic[4] = {'Q', 'G', 'T', 'T'};
+    uint32_t version = kVersion;
+    int32_t tile_size = 0;
+    int32_t tiles_x = 0;
+    int32_t tiles_z = 0;
+    float cell_size = 1.0f;
+    int32_t coarse_step = 1;
+    uint32_t reserved = 0;
+  };
+  static_assert(sizeof(Header) == 32, "TileFile header layout");
+
+  qe::core::MappedFile file_;
+  TileLayout layout_;
+  std::vector<float> coarse_heights_;
+  std::vector<uint8_t> coarse_surfaces_;
+  std::vector<float> bounds_;  // min, max per tile
+
+  static size_t align(size_t v) {
+    return (v + kAlign - 1) & ~(kAlign - 1);
+  }
+
+  /** Append bytes and pad to the block alignment. */
+  static void append(std::vector<uint8_t>& out, const void* data, size_t n) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + n);
+    out.resize(align(out.size()), 0);
+  }
+
+  size_t tiles_offset() const {
+    const size_t cn = static_cast<size_t>(layout_.coarse_width()) * layout_.coarse_depth();
+    return sizeof(Header) + align(cn * sizeof(float)) + align(cn) +
+           align(static_cast<size_t>(layout_.tile_count()) * 2 * sizeof(float));
+  }
+
+  size_t tile_stride() const {
+    const size_t n = static_cast<size_t>(layout_.tile_vertices()) * layout_.tile_vertices();
+    return align(n * sizeof(float)) + align(n * sizeof(uint32_t)) + align(n);
+  }
+
+  bool fail(const std::string& path, const std::string& why) {
+    std::cerr << "TileFile: " << path << ": " << why << std::endl;
+    file_.close();
+    return false;
+  }
+};
+
+}  // namespace terrain
+}  // namespace qg
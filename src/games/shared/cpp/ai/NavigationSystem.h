@@ -5,6 +5,7 @@
 #include <queue>
 #include <vector>
 
+#include "core/AllocTracker.h"
 #include "math/Vec3.h"
 
 namespace qe {
@@ -90,6 +91,7 @@ class NavigationSystem {
   }
 
   std::vector<math::Vec3> find_path(const math::Vec3 &start, const math::Vec3 &end) {
+    QE_ALLOC_TAG(Ai);
     current_search_id++;
     Node *start_node = get_node(start.x, start.z);
     Node *end_node = get_node(end.x, end.z);
@@ -0,0 +1,180 @@
+#pragma once
+/**
+ * @file AudioStream.h
+ * @brief Streamed WAV playback: a decoder thread keeps a PCM ring full ahead of the mixer.
+ *
+ * Long assets (music, ambience) are never fully resident. open() parses
+ * the header and decodes the first buffer_seconds of audio on the calling
+ * thread, then a background thread reads, converts (audio/Resampler.h) and
+ * writes further chunks into a core::SpscBuffer whenever there is room for
+ * one. The mixer's audio callback only copies frames out of that ring, so
+ * it never touches the disk; memory stays at one ring plus one chunk of
+ * scratch regardless of the file's length.
+ *
+ * A looping stream rewinds the file at the end and keeps the resampler's
+ * phase, so the loop point is seamless. A one-shot stream reports
+ * finished() once its last frame has been read.
+ *
+ * Design by Contract:
+ *   - Precondition: out_channels is 1 or 2; out_rate > 0
+ *   - Precondition: open() once, before any voice plays the stream; only
+ *     the mixer (one thread) calls read()
+ *   - Postcondition: the stream must outlive any voice playing it;
+ *     close() and the destructor stop the decoder thread
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Mixer.h"
+#include "Resampler.h"
+#include "WavReader.h"
+#include "core/SpscRing.h"
+
+namespace qe {
+namespace audio {
+
+class AudioStream : public StreamSource {
+ public:
+  /**
+   * @param out_channels  1 or 2; the file is mapped to this
+   * @param buffer_seconds  Ring capacity: how far ahead the decoder runs
+   */
+  explicit AudioStream(int out_channels = 2, int out_rate = 44100, float buffer_seconds = 0.5f)
+      : channels_(out_channels == 1 ? 1 : 2),
+        rate_(std::max(out_rate, 1)),
+        ring_(static_cast<size_t>(std::max(buffer_seconds, 0.05f) * rate_) * channels_) {}
+
+  ~AudioStream() override {
+    close();
+  }
+
+  AudioStream(const AudioStream&) = delete;
+  AudioStream& operator=(const AudioStream&) = delete;
+
+  /** Open `path`, pre-fill the ring and start the decoder thread. */
+  bool open(const std::string& path, bool loop = false) {
+    close();
+    if (!reader_.open(path))
+      return false;
+    if (reader_.frames() == 0) {
+      std::cerr << "AudioStream: " << path << ": no samples\n";
+      return false;
+    }
+    loop_ = loop;
+    resampler_.configure(channels_, reader_.format().rate, rate_);
+    raw_.resize(kChunk * reader_.format().frame_bytes());
+    decoded_.resize(kChunk * channels_);
+    resampled_.reserve(resampler_.max_output(kChunk) * channels_);
+    pending_.reserve(resampled_.capacity());
+    pending_.clear();
+    pending_at_ = 0;
+    draining_ = false;
+    eof_.store(false, std::memory_order_relaxed);
+    while (fill_once()) {
+    }
+    running_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread([this] { decode_loop(); });
+    return true;
+  }
+
+  /** Stop the decoder thread; the ring keeps whatever was decoded. */
+  void close() {
+    running_.store(false, std::memory_order_relaxed);
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  int channels() const override {
+    return channels_;
+  }
+
+  size_t read(int16_t* out, size_t frames) override {
+    return ring_.read(out, frames * channels_) / channels_;
+  }
+
+  bool finished() const override {
+    return eof_.load(std::memory_order_acquire) && ring_.readable() == 0;
+  }
+
+  /** Seconds of audio decoded and waiting in the ring. */
+  float buffered_seconds() const {
+    return static_cast<float>(ring_.readable() / channels_) / rate_;
+  }
+
+ private:
+  static constexpr size_t kChunk = 2048;  // Input frames decoded per step
+
+  int channels_, rate_;
+  bool loop_ = false;
+  WavReader reader_;
+  LinearResampler resampler_;
+  core::SpscBuffer<int16_t> ring_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> eof_{false};
+
+  // Decoder-side scratch, sized once in open()
+  std::vector<uint8_t> raw_;
+  std::vector<float> decoded_, resampled_;
+  std::vector<int16_t> pending_;  // Converted frames not yet in the ring
+  size_t pending_at_ = 0;
+  bool draining_ = false;  // File read to the end; pending_ holds the tail
+
+  /**
+   * Move pending PCM into the ring, decoding another chunk once it is all
+   * in. Returns false when there is nothing to do right now: the ring is
+   * full or the file is finished.
+   */
+  bool fill_once() {
+    if (eof_.load(std::memory_order_relaxed))
+      return false;
+    if (pending_at_ < pending_.size()) {
+      pending_at_ += ring_.write(pending_.data() + pending_at_, pending_.size() - pending_at_);
+      if (pending_at_ < pending_.size())
+        return false;
+    }
+    if (draining_) {
+      // The tail is in the ring, so finished() cannot skip it
+      eof_.store(true, std::memory_order_release);
+      return false;
+    }
+
+    size_t n = reader_.read(raw_.data(), kChunk);
+    if (n == 0 && loop_ && reader_.rewind())
+      n = reader_.read(raw_.data(), kChunk);
+    resampled_.clear();
+    if (n > 0) {
+      decode_pcm(raw_.data(), n, reader_.format(), channels_, decoded_.data());
+      resampler_.process(decoded_.data(), n, resampled_);
+    } else {
+      resampler_.flush(resampled_);
+      draining_ = true;
+    }
+    pending_.resize(resampled_.size());
+    mixer_detail::to_s16(resampled_.data(), pending_.data(), pending_.size());
+    pending_at_ = 0;
+    return true;
+  }
+
+  void decode_loop() {
+    while (running_.load(std::memory_order_relaxed)) {
+      if (!fill_once()) {
+        if (eof_.load(std::memory_order_relaxed))
+          return;
+        // Ring full: sleep for a fraction of its length
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+  }
+};
+
+}  // namespace audio
+}  // namespace qe
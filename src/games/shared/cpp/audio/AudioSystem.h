@@ -2,63 +2,63 @@
 #include <SDL.h>
 #include <SDL_audio.h>
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "AudioStream.h"
+#include "Mixer.h"
+#include "Resampler.h"
+#include "core/AllocTracker.h"
+#include "core/Counters.h"
+#include "core/Profiler.h"
+#include "math/Vec3.h"
+
 namespace qe {
 namespace audio {
 
-// Simple WAV loader and mixer using SDL2 Audio
+// WAV loading, streaming and mixing on top of an SDL2 audio device
 class AudioSystem {
  public:
-  struct SoundData {
-    Uint8* buffer;
-    Uint32 length;
-    SDL_AudioSpec spec;
-  };
+  using SoundData = SoundClip;
 
   SDL_AudioDeviceID deviceId = 0;
+  // Clips are converted to the device rate when loaded and never replaced,
+  // so voices can read them without locks
   std::map<std::string, SoundData> sounds;
+  // Long assets decoded on their own threads (see open_stream())
+  std::map<std::string, std::unique_ptr<AudioStream>> streams;
 
-  // Simple mixing: keep track of playing sounds if needed,
-  // but for now let's use SDL_QueueAudio which is fire-and-forget for simple effects.
-  // NOTE: SDL_QueueAudio queues data. If we want overlapping sounds, we need a mixer callback.
-  // Let's implement a very simple mixer callback.
-
-  struct PlayingSound {
-    Uint8* position;
-    Uint32 remaining;
-    bool active = false;
-  };
-  std::vector<PlayingSound> playing_sounds;
+  // Voices are mixed on the audio thread; play() only queues a command.
+  // Up to 64 play at once but only the 16 most important are mixed; the
+  // rest run virtually (see Mixer.h)
+  Mixer mixer{64, 2048, 16};
   SDL_AudioSpec deviceSpec;
 
+  // Positional sounds: full gain within ref_distance, silent (virtual)
+  // beyond max_distance
+  float ref_distance = 4.0f;
+  float max_distance = 80.0f;
+
   static void AudioCallback(void* userdata, Uint8* stream, int len) {
     AudioSystem* sys = static_cast<AudioSystem*>(userdata);
-    SDL_memset(stream, 0, len);  // Silence
-
-    if (!sys)
+    if (!sys) {
+      SDL_memset(stream, 0, len);
       return;
-
-    for (auto& s : sys->playing_sounds) {
-      if (!s.active)
-        continue;
-
-      Uint32 mix_len = (len > static_cast<int>(s.remaining)) ? s.remaining : len;
-      SDL_MixAudioFormat(stream, s.position, sys->deviceSpec.format, mix_len,
-                         SDL_MIX_MAXVOLUME / 2);
-
-      s.position += mix_len;
-      s.remaining -= mix_len;
-
-      if (s.remaining == 0) {
-        s.active = false;
-      }
     }
-
-    // Cleanup inactive (optional, might need lock)
+    QE_PROFILE_TRACK_SCOPE("audio mix", sys->profile_track_);
+    QE_ALLOC_TAG(Audio);
+    // The device is opened as S16 stereo: 4 bytes per frame
+    sys->mixer.mix(reinterpret_cast<int16_t*>(stream), static_cast<size_t>(len) / 4);
+    core::Counters::set(sys->voices_counter_, static_cast<double>(sys->mixer.active_voices()));
+    core::Counters::set(sys->virtual_counter_, static_cast<double>(sys->mixer.virtual_voices()));
+    core::Counters::set(sys->limit_counter_, static_cast<double>(sys->mixer.max_voices()));
   }
 
   bool init() {
@@ -75,6 +75,13 @@ class AudioSystem {
     want.samples = 1024;
     want.callback = AudioCallback;
     want.userdata = this;
+    // Register the callback's trace track and counters before the device
+    // starts: a thread's first event or counter lookup locks and allocates
+    if (!profile_track_)
+      profile_track_ = core::Profiler::instance().add_track("audio");
+    voices_counter_ = core::Counters::id("voices", core::CounterKind::Gauge);
+    virtual_counter_ = core::Counters::id("virtual voices", core::CounterKind::Gauge);
+    limit_counter_ = core::Counters::id("voice limit", core::CounterKind::Gauge);
 
     deviceId = SDL_OpenAudioDevice(NULL, 0, &want, &deviceSpec,
                                    0);  // 0 = allow changes? No, force same format
@@ -83,88 +90,182 @@ class AudioSystem {
       return false;
     }
 
-    // Pre-allocate slots
-    playing_sounds.resize(16);
+    mixer.set_sample_rate(deviceSpec.freq);
     SDL_PauseAudioDevice(deviceId, 0);
     return true;
   }
 
+  /** Load and convert a WAV now (blocks on disk I/O and conversion). */
   bool load_wav(const std::string& name, const std::string& path) {
+    QE_ALLOC_TAG(Assets);
+    if (sounds.count(name)) {
+      std::cerr << "Sound " << name << " is already loaded" << std::endl;
+      return false;
+    }
     SoundData sound;
-    if (SDL_LoadWAV(path.c_str(), &sound.spec, &sound.buffer, &sound.length) == NULL) {
-      std::cerr << "Failed to load WAV " << path << ": " << SDL_GetError() << std::endl;
+    if (!load_clip(path, mixer.sample_rate(), sound))
       return false;
+    sounds.emplace(name, std::move(sound));
+    return true;
+  }
+
+  /**
+   * Load and convert a WAV on a worker thread; it becomes playable at the
+   * first update() after it finishes. Call after init() so the device rate
+   * is known.
+   */
+  void load_wav_async(const std::string& name, const std::string& path) {
+    QE_ALLOC_TAG(Assets);
+    const int rate = mixer.sample_rate();
+    pending_loads_.emplace_back(name, std::async(std::launch::async, [path, rate] {
+                                  QE_ALLOC_TAG(Assets);
+                                  SoundData sound;
+                                  if (!load_clip(path, rate, sound))
+                                    sound.samples.clear();
+                                  return sound;
+                                }));
+  }
+
+  /** Publish finished background loads (call once per frame). */
+  void update() {
+    QE_ALLOC_TAG(Assets);
+    for (size_t i = 0; i < pending_loads_.size();) {
+      auto& load = pending_loads_[i];
+      if (load.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++i;
+        continue;
+      }
+      SoundData sound = load.second.get();
+      if (!sound.samples.empty() && !sounds.count(load.first))
+        sounds.emplace(load.first, std::move(sound));
+      pending_loads_.erase(pending_loads_.begin() + static_cast<std::ptrdiff_t>(i));
     }
+  }
 
-    // Convert if needed?
-    // For this simple example, assume WAVs match the device spec or rely on luck/pre-conversion.
-    // In robust engine, we'd use SDL_AudioCVT.
-    // Let's assume input assets are 44.1k stereo S16 for now.
+  /** Background loads not yet published by update(). */
+  size_t loads_pending() const {
+    return pending_loads_.size();
+  }
 
-    sounds[name] = sound;
+  /**
+   * Open a long WAV for streaming (music, ambience): only ~0.5 s of it is
+   * held in memory at a time. Each name can be opened once.
+   */
+  bool open_stream(const std::string& name, const std::string& path, bool loop = false) {
+    QE_ALLOC_TAG(Assets);
+    if (streams.count(name)) {
+      std::cerr << "Stream " << name << " is already open" << std::endl;
+      return false;
+    }
+    auto stream = std::make_unique<AudioStream>(2, mixer.sample_rate());
+    if (!stream->open(path, loop))
+      return false;
+    streams.emplace(name, std::move(stream));
     return true;
   }
 
-  void play(const std::string& name) {
-    if (sounds.find(name) == sounds.end())
-      return;
+  /** Start an opened stream; it plays once from where its decoder is. */
+  VoiceId play_stream(const std::string& name, float gain = 0.5f, float pan = 0.0f,
+                      Priority priority = Priority::High) {
+    auto it = streams.find(name);
+    return it == streams.end() ? 0 : mixer.play_stream(it->second.get(), gain, pan, priority);
+  }
 
-    SoundData& sd = sounds[name];
+  /** Start a loaded sound; returns its voice id (0 if unknown or dropped). */
+  VoiceId play(const std::string& name, float gain = 0.5f, float pan = 0.0f, bool loop = false,
+               Priority priority = Priority::Normal) {
+    auto it = sounds.find(name);
+    if (it == sounds.end())
+      return 0;
+    const SoundData& sd = it->second;
+    return mixer.play(sd.samples.data(), sd.frames(), sd.channels, gain, pan, loop, priority);
+  }
 
-    // Find free slot
-    SDL_LockAudioDevice(deviceId);
-    for (auto& s : playing_sounds) {
-      if (!s.active) {
-        s.position = sd.buffer;
-        s.remaining = sd.length;
-        s.active = true;
-        break;
-      }
-    }
-    SDL_UnlockAudioDevice(deviceId);
+  /** Where positional sounds are heard from; `right` is the listener's unit right axis. */
+  void set_listener(const math::Vec3& position, const math::Vec3& right) {
+    listener_pos_ = position;
+    listener_right_ = right;
   }
 
-  // Synthesize a simple beep/boop if no file
-  void play_synthetic(float freq, float duration) {
-    // Generate a square wave buffer
-    static std::vector<Uint8> synth_buffer;
-    int samples = static_cast<int>(duration * deviceSpec.freq);
-    int bytes = samples * deviceSpec.channels * 2;  // 16bit = 2 bytes
-    if (synth_buffer.size() < bytes)
-      synth_buffer.resize(bytes);
+  /** play() from a point in the world: attenuated by distance and panned. */
+  VoiceId play_at(const std::string& name, const math::Vec3& position, float gain = 0.5f,
+                  Priority priority = Priority::Normal) {
+    float g, pan;
+    spatialize(position, gain, g, pan);
+    return play(name, g, pan, false, priority);
+  }
 
-    auto* raw = reinterpret_cast<Sint16*>(synth_buffer.data());
-    int period = static_cast<int>(deviceSpec.freq / freq);
+  /** Re-aim a positional voice at a moving source (gain as passed to play_at()). */
+  void set_position(VoiceId id, const math::Vec3& position, float gain = 0.5f) {
+    float g, pan;
+    spatialize(position, gain, g, pan);
+    mixer.set_gain(id, g);
+    mixer.set_pan(id, pan);
+  }
 
-    for (int i = 0; i < samples; ++i) {
-      Sint16 val = ((i / (period / 2)) % 2) ? 3000 : -3000;
-      for (int c = 0; c < deviceSpec.channels; ++c) {
-        *raw++ = val;
-      }
-    }
+  void stop(VoiceId id) {
+    mixer.stop(id);
+  }
+  void set_gain(VoiceId id, float gain) {
+    mixer.set_gain(id, gain);
+  }
+  void set_pan(VoiceId id, float pan) {
+    mixer.set_pan(id, pan);
+  }
 
-    SDL_LockAudioDevice(deviceId);
-    for (auto& s : playing_sounds) {
-      if (!s.active) {
-        s.position = synth_buffer.data();
-        s.remaining = bytes;
-        s.active = true;
-        break;
-      }
-    }
-    SDL_UnlockAudioDevice(deviceId);
+  // Synthesize a simple beep/boop if no file: rendered on the audio thread,
+  // so overlapping beeps never share a buffer
+  VoiceId play_synthetic(float freq, float duration, Waveform wave = Waveform::Square) {
+    SynthParams p;
+    p.wave = wave;
+    p.frequency = freq;
+    p.duration = duration;
+    p.amplitude = 3000.0f / 32767.0f;
+    return mixer.play_synth(p, 0.5f);
+  }
+
+  VoiceId play_synth(const SynthParams& params, float gain = 0.5f, float pan = 0.0f,
+                     Priority priority = Priority::Normal) {
+    return mixer.play_synth(params, gain, pan, priority);
+  }
+
+  VoiceId play_synth_at(const SynthParams& params, const math::Vec3& position,
+                        float gain = 0.5f, Priority priority = Priority::Normal) {
+    float g, pan;
+    spatialize(position, gain, g, pan);
+    return mixer.play_synth(params, g, pan, priority);
   }
 
   void cleanup() {
+    mixer.stop_all();
     if (deviceId) {
       SDL_CloseAudioDevice(deviceId);
       deviceId = 0;
     }
-    for (auto& pair : sounds) {
-      SDL_FreeWAV(pair.second.buffer);
-    }
+    // The callback has stopped: nothing reads the clips or streams any more
+    for (auto& load : pending_loads_)
+      load.second.wait();
+    pending_loads_.clear();
+    streams.clear();
     sounds.clear();
   }
+
+ private:
+  std::vector<std::pair<std::string, std::future<SoundData>>> pending_loads_;
+  core::Profiler::Ring* profile_track_ = nullptr;  // Made by init() before the device starts
+  int voices_counter_ = -1;  // Counter ids, looked up by init()
+  int virtual_counter_ = -1;
+  int limit_counter_ = -1;
+  math::Vec3 listener_pos_{0.0f, 0.0f, 0.0f};
+  math::Vec3 listener_right_{1.0f, 0.0f, 0.0f};
+
+  void spatialize(const math::Vec3& position, float gain, float& out_gain, float& out_pan) const {
+    const math::Vec3 to = position - listener_pos_;
+    const float d = to.length();
+    out_gain = gain * distance_gain(d, ref_distance, max_distance);
+    // Sources close to the listener stay centred
+    out_pan = d > 1e-3f ? std::clamp(to.dot(listener_right_) / d, -1.0f, 1.0f) : 0.0f;
+  }
 };
 
 }  // namespace audio
@@ -0,0 +1,545 @@
+#pragma once
+/**
+ * @file Mixer.h
+ * @brief Lock-free voice mixer: game thread sends commands, audio thread mixes.
+ *
+ * The game thread never touches voice state. play(), stop(), set_gain()
+ * and set_pan() push a small command into a core::SpscRing; mix(), called
+ * from the audio callback, drains the ring, mixes every active voice into a
+ * float accumulator and converts the sum to clipped S16 stereo.
+ *
+ * A sample voice reads 16-bit mono or interleaved stereo frames from memory
+ * the caller keeps alive until the voice ends (sounds are loaded for the
+ * life of the device). A synth voice carries only its SynthParams and is
+ * rendered by an Oscillator into a per-block scratch buffer on the audio
+ * thread (audio/Oscillator.h). A stream voice pulls frames from a
+ * StreamSource that another thread keeps filled (audio/AudioStream.h); if
+ * the source runs dry the voice plays silence and counts an underrun.
+ *
+ * Gain and balance pan (-1 = left, 0 = both channels at full gain, +1 =
+ * right) fold into one left/right multiplier pair, applied four stereo
+ * frames at a time by an SSE2 kernel when available. The accumulator stays
+ * in S16 units, so the final conversion saturates to [-32768, 32767] with
+ * no extra scaling.
+ *
+ * Voice ids are handed out by the game thread and never reused, so a stop
+ * for a voice that already finished is simply ignored.
+ *
+ * Voice management: more voices can play than are mixed. At each mix()
+ * call the playing voices are ranked by priority, then audibility (their
+ * gain, which distance attenuation feeds via AudioSystem::play_at()), then
+ * age; the top max_mixed audible ones are mixed and the rest are virtual.
+ * A virtual voice costs a position update per block: samples advance,
+ * synth notes skip() and streams are drained, so a voice that becomes
+ * audible again resumes where it would have been. When every voice is
+ * playing, a new play steals the lowest-ranked voice if it outranks it and
+ * is dropped otherwise.
+ *
+ * Design by Contract:
+ *   - Precondition: one game thread calls the command functions; one audio
+ *     thread calls mix()
+ *   - Postcondition: mix() never blocks, locks or allocates
+ *   - Postcondition: SIMD and scalar paths produce identical samples
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Oscillator.h"
+#include "core/SpscRing.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QE_AUDIO_SSE2 1
+#endif
+
+namespace qe {
+namespace audio {
+
+using VoiceId = uint32_t;  // 0 = no voice
+
+/** Which sounds survive when voices run out; equal priorities compare by gain. */
+enum class Priority : uint8_t { Low, Normal, High, Critical };
+
+/**
+ * Inverse-distance gain (the usual clamped rolloff): 1 inside ref_distance,
+ * ref / d beyond it and 0 past max_distance, where the voice goes virtual.
+ */
+inline float distance_gain(float distance, float ref_distance, float max_distance) {
+  if (distance >= max_distance)
+    return 0.0f;
+  return distance <= ref_distance ? 1.0f : ref_distance / distance;
+}
+
+/** PCM produced ahead of time by another thread; read() runs on the audio thread. */
+class StreamSource {
+ public:
+  virtual ~StreamSource() = default;
+  /** 1 or 2 interleaved channels, fixed for the source's lifetime. */
+  virtual int channels() const = 0;
+  /** Copy up to `frames` S16 frames to out; returns the frames copied. */
+  virtual size_t read(int16_t* out, size_t frames) = 0;
+  /** True once every frame has been read and no more will arrive. */
+  virtual bool finished() const = 0;
+};
+
+namespace mixer_detail {
+
+/** acc[2i], acc[2i + 1] += src frame i (stereo) times (left, right). */
+inline void mix_stereo(const int16_t* src, float* acc, size_t frames, float left, float right) {
+  size_t i = 0;
+#ifdef QE_AUDIO_SSE2
+  const __m128 lr = _mm_setr_ps(left, right, left, right);
+  for (; i + 4 <= frames; i += 4) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+    __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+    __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+    float* a = acc + 2 * i;
+    _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(lo, lr)));
+    _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(hi, lr)));
+  }
+#endif
+  for (; i < frames; ++i) {
+    acc[2 * i] += src[2 * i] * left;
+    acc[2 * i + 1] += src[2 * i + 1] * right;
+  }
+}
+
+/** acc[2i], acc[2i + 1] += src sample i times (left, right). */
+inline void mix_mono(const int16_t* src, float* acc, size_t frames, float left, float right) {
+  size_t i = 0;
+#ifdef QE_AUDIO_SSE2
+  const __m128 lr = _mm_setr_ps(left, right, left, right);
+  for (; i + 4 <= frames; i += 4) {
+    __m128i s = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+    __m128 m = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+    float* a = acc + 2 * i;
+    _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(_mm_unpacklo_ps(m, m), lr)));
+    _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(_mm_unpackhi_ps(m, m), lr)));
+  }
+#endif
+  for (; i < frames; ++i) {
+    acc[2 * i] += src[i] * left;
+    acc[2 * i + 1] += src[i] * right;
+  }
+}
+
+/** acc[2i], acc[2i + 1] += float sample i times (left, right). */
+inline void mix_mono_f32(const float* src, float* acc, size_t frames, float left, float right) {
+  size_t i = 0;
+#ifdef QE_AUDIO_SSE2
+  const __m128 lr = _mm_setr_ps(left, right, left, right);
+  for (; i + 4 <= frames; i += 4) {
+    __m128 m = _mm_loadu_ps(src + i);
+    float* a = acc + 2 * i;
+    _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(_mm_unpacklo_ps(m, m), lr)));
+    _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(_mm_unpackhi_ps(m, m), lr)));
+  }
+#endif
+  for (; i < frames; ++i) {
+    acc[2 * i] += src[i] * left;
+    acc[2 * i + 1] += src[i] * right;
+  }
+}
+
+/** Round to nearest (even on ties) and saturate to S16. */
+inline void to_s16(const float* acc, int16_t* out, size_t samples) {
+  size_t i = 0;
+#ifdef QE_AUDIO_SSE2
+  const __m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+  for (; i + 8 <= samples; i += 8) {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i), lo), hi);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i + 4), lo), hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+#endif
+  for (; i < samples; ++i)
+    out[i] = static_cast<int16_t>(std::nearbyint(std::clamp(acc[i], -32768.0f, 32767.0f)));
+}
+
+}  // namespace mixer_detail
+
+class Mixer {
+ public:
+  /**
+   * @param max_voices  Voices playing at once, mixed or virtual
+   * @param block_frames  Accumulator size; larger mix() requests are split
+   * @param max_mixed  Voices actually mixed per block; 0 = all of them
+   */
+  explicit Mixer(int max_voices = 64, int block_frames = 2048, int max_mixed = 0)
+      : voices_(static_cast<size_t>(std::max(max_voices, 1))),
+        max_mixed_(max_mixed > 0 ? std::min(max_mixed, std::max(max_voices, 1))
+                                 : std::max(max_voices, 1)),
+        order_(voices_.size()),
+        acc_(2 * static_cast<size_t>(std::max(block_frames, 1))),
+        synth_(static_cast<size_t>(std::max(block_frames, 1))),
+        stream_(2 * static_cast<size_t>(std::max(block_frames, 1))) {}
+
+  /** Output rate used for synth voices; set before the audio thread starts. */
+  void set_sample_rate(int hz) noexcept {
+    sample_rate_ = std::max(hz, 1);
+  }
+  int sample_rate() const noexcept {
+    return sample_rate_;
+  }
+
+  // --- Game thread ---
+
+  /**
+   * Start a voice over `frames` 16-bit frames of 1 or 2 interleaved
+   * channels. Returns its id, or 0 when the command queue is full.
+   */
+  VoiceId play(const int16_t* data, uint32_t frames, int channels, float gain = 1.0f,
+               float pan = 0.0f, bool loop = false, Priority priority = Priority::Normal) {
+    Command c;
+    c.priority = priority;
+    c.op = Op::Play;
+    c.voice = next_id_;
+    c.data = data;
+    c.frames = frames;
+    c.channels = static_cast<uint8_t>(channels == 1 ? 1 : 2);
+    c.loop = loop;
+    c.gain = gain;
+    c.pan = pan;
+    if (!data || frames == 0)
+      c.voice = 0;
+    return start(c);
+  }
+
+  /** Start a synth note; returns its id, or 0 when the queue is full. */
+  VoiceId play_synth(const SynthParams& params, float gain = 1.0f, float pan = 0.0f,
+                     Priority priority = Priority::Normal) {
+    Command c;
+    c.priority = priority;
+    c.op = Op::PlaySynth;
+    c.voice = next_id_;
+    c.synth = params;
+    c.gain = gain;
+    c.pan = pan;
+    return start(c);
+  }
+
+  /**
+   * Start pulling frames from `source`, which must outlive the voice (keep
+   * it until the device is closed). Returns the id, or 0 if the queue is full.
+   */
+  VoiceId play_stream(StreamSource* source, float gain = 1.0f, float pan = 0.0f,
+                      Priority priority = Priority::High) {
+    Command c;
+    c.priority = priority;
+    c.op = Op::PlayStream;
+    c.voice = source ? next_id_ : 0;
+    c.stream = source;
+    c.gain = gain;
+    c.pan = pan;
+    return start(c);
+  }
+
+  bool stop(VoiceId id) {
+    return send(Op::Stop, id);
+  }
+  bool stop_all() {
+    return send(Op::StopAll, 0);
+  }
+  bool set_gain(VoiceId id, float gain) {
+    return send(Op::SetGain, id, gain);
+  }
+  bool set_pan(VoiceId id, float pan) {
+    return send(Op::SetPan, id, pan);
+  }
+
+  /** Voices playing (mixed or virtual) at the end of the last mix() call. */
+  int active_voices() const noexcept {
+    return active_.load(std::memory_order_relaxed);
+  }
+
+  /** Of active_voices(), those tracked but not mixed in the last block. */
+  int virtual_voices() const noexcept {
+    return virtual_.load(std::memory_order_relaxed);
+  }
+
+  /** Plays lost to a full queue or to voices that all outranked them. */
+  uint32_t dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /** Voices ended early to make room for a more important play. */
+  uint32_t stolen() const noexcept {
+    return stolen_.load(std::memory_order_relaxed);
+  }
+
+  /** Blocks in which a stream voice had fewer frames ready than needed. */
+  uint32_t underruns() const noexcept {
+    return underruns_.load(std::memory_order_relaxed);
+  }
+
+  int max_voices() const noexcept {
+    return static_cast<int>(voices_.size());
+  }
+
+  int max_mixed() const noexcept {
+    return max_mixed_;
+  }
+
+  static constexpr bool simd() noexcept {
+#ifdef QE_AUDIO_SSE2
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // --- Audio thread ---
+
+  /** Apply pending commands and write `frames` S16 stereo frames to out. */
+  void mix(int16_t* out, size_t frames) {
+    apply_commands();
+    const size_t block = acc_.size() / 2;
+    for (size_t done = 0; done < frames; done += block) {
+      size_t n = std::min(block, frames - done);
+      choose_mixed();
+      std::fill(acc_.begin(), acc_.begin() + static_cast<std::ptrdiff_t>(2 * n), 0.0f);
+      for (Voice& v : voices_)
+        if (v.id)
+          mix_voice(v, n);
+      mixer_detail::to_s16(acc_.data(), out + 2 * done, 2 * n);
+    }
+    int active = 0, virtuals = 0;
+    for (const Voice& v : voices_) {
+      active += v.id != 0;
+      virtuals += v.id != 0 && !v.mixed;
+    }
+    active_.store(active, std::memory_order_relaxed);
+    virtual_.store(virtuals, std::memory_order_relaxed);
+  }
+
+ private:
+  enum class Op : uint8_t { Play, PlaySynth, PlayStream, Stop, StopAll, SetGain, SetPan };
+
+  struct Command {
+    Op op = Op::Stop;
+    Priority priority = Priority::Normal;
+    uint8_t channels = 2;
+    bool loop = false;
+    VoiceId voice = 0;
+    const int16_t* data = nullptr;
+    uint32_t frames = 0;
+    float gain = 1.0f;
+    float pan = 0.0f;
+    StreamSource* stream = nullptr;
+    SynthParams synth;
+  };
+
+  struct Voice {
+    VoiceId id = 0;  // 0 = free
+    const int16_t* data = nullptr;  // Null for synth and stream voices
+    StreamSource* stream = nullptr;
+    uint32_t frames = 0, pos = 0;
+    uint8_t channels = 2;
+    bool loop = false;
+    bool mixed = true;  // False while virtual
+    Priority priority = Priority::Normal;
+    float gain = 1.0f, pan = 0.0f;
+    Oscillator osc;
+  };
+
+  // Audible below this gain (about -80 dB); quieter voices stay virtual
+  static constexpr float kInaudible = 1e-4f;
+
+  core::SpscRing<Command, 256> commands_;
+  VoiceId next_id_ = 1;  // Game thread only
+  std::atomic<int> active_{0};
+  std::atomic<int> virtual_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> stolen_{0};
+  std::atomic<uint32_t> underruns_{0};
+
+  std::vector<Voice> voices_;  // Audio thread only
+  int max_mixed_;
+  std::vector<Voice*> order_;  // Ranking scratch for choose_mixed()
+  std::vector<float> acc_;     // Interleaved stereo, S16 units
+  std::vector<float> synth_;   // One synth voice's block, mono
+  std::vector<int16_t> stream_;  // One stream voice's block
+  int sample_rate_ = 44100;
+
+  VoiceId start(const Command& c) {
+    if (c.voice == 0 || !commands_.push(c)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+    }
+    if (++next_id_ == 0)
+      next_id_ = 1;
+    return c.voice;
+  }
+
+  bool send(Op op, VoiceId id, float value = 0.0f) {
+    Command c;
+    c.op = op;
+    c.voice = id;
+    c.gain = c.pan = value;
+    return commands_.push(c);
+  }
+
+  Voice* find(VoiceId id) {
+    for (Voice& v : voices_)
+      if (v.id == id)
+        return &v;
+    return nullptr;
+  }
+
+  /** True if (priority, gain, id) a ranks above b: older voices win ties. */
+  static bool outranks(Priority pa, float ga, VoiceId ia, Priority pb, float gb, VoiceId ib) {
+    if (pa != pb)
+      return pa > pb;
+    if (ga != gb)
+      return ga > gb;
+    return ia - ib > 0x80000000u;  // ia is older, allowing for id wrap-around
+  }
+  static bool outranks(const Voice* a, const Voice* b) {
+    return outranks(a->priority, std::fabs(a->gain), a->id, b->priority, std::fabs(b->gain), b->id);
+  }
+
+  /** A slot for a new voice: a free one, or the lowest-ranked one it outranks. */
+  Voice* claim(const Command& c) {
+    if (Voice* v = find(0))
+      return v;
+    Voice* victim = &voices_[0];
+    for (Voice& v : voices_)
+      if (outranks(victim, &v))
+        victim = &v;
+    // New voices lose ties against playing ones
+    if (!outranks(c.priority, std::fabs(c.gain), 0, victim->priority, std::fabs(victim->gain),
+                  0)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    stolen_.fetch_add(1, std::memory_order_relaxed);
+    return victim;
+  }
+
+  /** Mark the max_mixed_ top-ranked audible voices as mixed and the rest virtual. */
+  void choose_mixed() {
+    size_t count = 0;
+    for (Voice& v : voices_) {
+      v.mixed = v.id && std::fabs(v.gain) >= kInaudible;
+      if (v.mixed)
+        order_[count++] = &v;
+    }
+    const size_t keep = static_cast<size_t>(max_mixed_);
+    if (count > keep) {
+      auto first = order_.begin(), cut = first + static_cast<std::ptrdiff_t>(keep);
+      std::nth_element(first, cut, first + static_cast<std::ptrdiff_t>(count),
+                       [](const Voice* a, const Voice* b) { return outranks(a, b); });
+      for (size_t i = keep; i < count; ++i)
+        order_[i]->mixed = false;
+    }
+  }
+
+  void apply_commands() {
+    Command c;
+    while (commands_.pop(c)) {
+      if (c.op == Op::StopAll) {
+        for (Voice& v : voices_)
+          v.id = 0;
+        continue;
+      }
+      const bool starts = c.op == Op::Play || c.op == Op::PlaySynth || c.op == Op::PlayStream;
+      Voice* v = starts ? claim(c) : find(c.voice);
+      if (!v)
+        continue;
+      switch (c.op) {
+        case Op::Play:
+        case Op::PlaySynth:
+        case Op::PlayStream:
+          v->id = c.voice;
+          v->data = c.data;
+          v->stream = c.stream;
+          v->frames = c.frames;
+          v->pos = 0;
+          v->channels = c.channels;
+          v->loop = c.loop;
+          v->priority = c.priority;
+          v->gain = c.gain;
+          v->pan = c.pan;
+          if (c.op == Op::PlaySynth)
+            v->osc.start(c.synth, sample_rate_);
+          break;
+        case Op::Stop:
+          v->id = 0;
+          break;
+        case Op::SetGain:
+          v->gain = c.gain;
+          break;
+        case Op::SetPan:
+          v->pan = c.pan;
+          break;
+        case Op::StopAll:
+          break;
+      }
+    }
+  }
+
+  /**
+   * Add up to n frames of v to the accumulator, or only advance it when
+   * virtual; frees v when it ends.
+   */
+  void mix_voice(Voice& v, size_t n) {
+    const float pan = std::clamp(v.pan, -1.0f, 1.0f);
+    const float left = v.gain * std::min(1.0f, 1.0f - pan);
+    const float right = v.gain * std::min(1.0f, 1.0f + pan);
+    float* acc = acc_.data();
+    if (v.stream) {
+      const int ch = v.stream->channels() == 1 ? 1 : 2;
+      size_t got = v.stream->read(stream_.data(), n);  // Virtual streams are drained too
+      if (v.mixed && ch == 2)
+        mixer_detail::mix_stereo(stream_.data(), acc, got, left, right);
+      else if (v.mixed)
+        mixer_detail::mix_mono(stream_.data(), acc, got, left, right);
+      if (got < n) {
+        if (v.stream->finished())
+          v.id = 0;
+        else
+          underruns_.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+    if (!v.data) {
+      if (!v.mixed) {
+        if (v.osc.skip(n) < n)
+          v.id = 0;
+        return;
+      }
+      size_t made = v.osc.render(synth_.data(), n);
+      mixer_detail::mix_mono_f32(synth_.data(), acc, made, left, right);
+      if (made < n)
+        v.id = 0;
+      return;
+    }
+    while (n > 0) {
+      size_t run = std::min<size_t>(n, v.frames - v.pos);
+      const int16_t* src = v.data + static_cast<size_t>(v.pos) * v.channels;
+      if (v.mixed && v.channels == 2)
+        mixer_detail::mix_stereo(src, acc, run, left, right);
+      else if (v.mixed)
+        mixer_detail::mix_mono(src, acc, run, left, right);
+      acc += 2 * run;
+      n -= run;
+      v.pos += static_cast<uint32_t>(run);
+      if (v.pos == v.frames) {
+        if (!v.loop) {
+          v.id = 0;
+          return;
+        }
+        v.pos = 0;
+      }
+    }
+  }
+};
+
+}  // namespace audio
+}  // namespace qe
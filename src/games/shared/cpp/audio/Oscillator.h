@@ -0,0 +1,234 @@
+#pragma once
+/**
+ * @file Oscillator.h
+ * @brief Parametric synth voices (square, sine, saw, noise) with an ADSR envelope.
+ *
+ * A SynthParams block (a few floats) fully describes a note, so the game
+ * thread only sends that; the Mixer renders samples on the audio thread
+ * straight into its scratch buffer. Nothing is allocated or shared between
+ * notes.
+ *
+ *   - Square and saw are band-limited with polyBLEP corrections at each
+ *     discontinuity, so high notes do not alias into harsh noise
+ *   - Sine uses the two-term recurrence y[n] = 2 cos(w) y[n-1] - y[n-2]
+ *     in double precision: one multiply-add per sample, no sin() calls
+ *   - Noise is a seeded xorshift32, so a note sounds the same every time
+ *
+ * The envelope rises linearly over attack, falls to sustain over decay,
+ * holds until `duration` seconds after note-on, then falls to silence
+ * over release; the note ends there.
+ *
+ * skip() advances a note without producing samples (a virtual voice in the
+ * Mixer); rendering afterwards continues exactly where an unbroken render
+ * would have been.
+ *
+ * Design by Contract:
+ *   - Precondition: start() before render(); sample_rate > 0
+ *   - Postcondition: render() output lies within +/- amplitude * 32767
+ *     (plus a small polyBLEP overshoot for square and saw)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace qe {
+namespace audio {
+
+enum class Waveform : uint8_t { Square, Sine, Saw, Noise };
+
+struct Envelope {
+  float attack = 0.005f;  // s, 0 -> 1
+  float decay = 0.0f;     // s, 1 -> sustain
+  float sustain = 1.0f;   // Level while the note is held
+  float release = 0.02f;  // s, -> 0 once the note is released
+};
+
+struct SynthParams {
+  Waveform wave = Waveform::Square;
+  float frequency = 440.0f;  // Hz
+  float duration = 0.1f;     // s from note-on to release
+  float amplitude = 0.25f;   // Peak level, 1 = S16 full scale
+  Envelope env;
+  uint32_t seed = 1;  // Noise generator state (0 is replaced by 1)
+};
+
+class Oscillator {
+ public:
+  void start(const SynthParams& p, int sample_rate) {
+    const double sr = std::max(sample_rate, 1);
+    wave_ = p.wave;
+    scale_ = p.amplitude * 32767.0f;
+    const double cycles = std::clamp(p.frequency / sr, 0.0, 0.5);  // Per sample, below Nyquist
+    inc_ = static_cast<float>(cycles);
+    phase_ = 0.0f;
+    w_ = 2.0 * 3.14159265358979323846 * cycles;
+    k_ = 2.0 * std::cos(w_);
+    seek_sine(0);
+    noise_ = p.seed ? p.seed : 1u;
+
+    const Envelope& e = p.env;
+    sustain_ = std::clamp(e.sustain, 0.0f, 1.0f);
+    attack_step_ = e.attack > 0.0f ? static_cast<float>(1.0 / (e.attack * sr)) : 1.0f;
+    decay_step_ = e.decay > 0.0f ? static_cast<float>((1.0 - sustain_) / (e.decay * sr)) : 1.0f;
+    release_samples_ = std::max(e.release * sr, 1.0);
+    held_ = static_cast<uint32_t>(std::max(p.duration, 0.0f) * sr);
+    level_ = 0.0f;
+    stage_ = Stage::Attack;
+    if (held_ == 0)
+      begin_release();
+  }
+
+  /**
+   * Write up to n samples (S16 units) to out. Returns how many were
+   * written; fewer than n means the note ended.
+   */
+  size_t render(float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      if (stage_ == Stage::Done)
+        return i;
+      out[i] = scale_ * envelope() * sample();
+    }
+    return n;
+  }
+
+  /**
+   * Advance up to n samples without rendering them. Returns how many were
+   * skipped; fewer than n means the note ended. Costs one envelope step
+   * per sample.
+   */
+  size_t skip(size_t n) {
+    size_t i = 0;
+    for (; i < n && stage_ != Stage::Done; ++i)
+      envelope();
+    switch (wave_) {
+      case Waveform::Square:
+      case Waveform::Saw:
+        phase_ = static_cast<float>(std::fmod(phase_ + static_cast<double>(inc_) * i, 1.0));
+        break;
+      case Waveform::Sine:
+        seek_sine(t_ + i);
+        break;
+      case Waveform::Noise:
+        for (size_t k = 0; k < i; ++k)
+          next_noise();
+        break;
+    }
+    return i;
+  }
+
+  bool finished() const noexcept {
+    return stage_ == Stage::Done;
+  }
+
+ private:
+  enum class Stage : uint8_t { Attack, Decay, Sustain, Release, Done };
+
+  Waveform wave_ = Waveform::Square;
+  float scale_ = 0.0f;
+  float phase_ = 0.0f, inc_ = 0.0f;  // Cycles
+  double w_ = 0.0, k_ = 0.0, y1_ = 0.0, y2_ = 0.0;  // Sine: radians per sample, recurrence
+  uint64_t t_ = 0;                                 // Sine: index of the next sample
+  uint32_t noise_ = 1;
+
+  Stage stage_ = Stage::Done;
+  float level_ = 0.0f, sustain_ = 1.0f;
+  float attack_step_ = 1.0f, decay_step_ = 1.0f, release_step_ = 1.0f;
+  double release_samples_ = 1.0;
+  uint32_t held_ = 0;  // Samples left before release
+
+  /** Residual that smooths a unit step at phase 0 (t, dt in cycles). */
+  static float poly_blep(float t, float dt) {
+    if (t < dt) {
+      t /= dt;
+      return t + t - t * t - 1.0f;
+    }
+    if (t > 1.0f - dt) {
+      t = (t - 1.0f) / dt;
+      return t * t + t + t + 1.0f;
+    }
+    return 0.0f;
+  }
+
+  /** Restart the sine recurrence so the next sample is sin(w * t). */
+  void seek_sine(uint64_t t) {
+    t_ = t;
+    y1_ = std::sin(w_ * (static_cast<double>(t) - 1.0));
+    y2_ = std::sin(w_ * (static_cast<double>(t) - 2.0));
+  }
+
+  uint32_t next_noise() {
+    noise_ ^= noise_ << 13;
+    noise_ ^= noise_ >> 17;
+    noise_ ^= noise_ << 5;
+    return noise_;
+  }
+
+  float sample() {
+    float v = 0.0f;
+    switch (wave_) {
+      case Waveform::Square: {
+        float half = phase_ + 0.5f;
+        half -= half >= 1.0f ? 1.0f : 0.0f;
+        v = (phase_ < 0.5f ? 1.0f : -1.0f) + poly_blep(phase_, inc_) - poly_blep(half, inc_);
+        break;
+      }
+      case Waveform::Saw:
+        v = 2.0f * phase_ - 1.0f - poly_blep(phase_, inc_);
+        break;
+      case Waveform::Sine: {
+        double y = k_ * y1_ - y2_;
+        y2_ = y1_;
+        y1_ = y;
+        ++t_;
+        return static_cast<float>(y);
+      }
+      case Waveform::Noise:
+        return static_cast<float>(static_cast<int32_t>(next_noise())) * (1.0f / 2147483648.0f);
+    }
+    phase_ += inc_;
+    phase_ -= phase_ >= 1.0f ? 1.0f : 0.0f;
+    return v;
+  }
+
+  void begin_release() {
+    stage_ = level_ > 0.0f ? Stage::Release : Stage::Done;
+    release_step_ = static_cast<float>(level_ / release_samples_);
+  }
+
+  float envelope() {
+    if (held_ > 0 && --held_ == 0)
+      begin_release();
+    switch (stage_) {
+      case Stage::Attack:
+        level_ += attack_step_;
+        if (level_ >= 1.0f) {
+          level_ = 1.0f;
+          stage_ = sustain_ < 1.0f ? Stage::Decay : Stage::Sustain;
+        }
+        break;
+      case Stage::Decay:
+        level_ -= decay_step_;
+        if (level_ <= sustain_) {
+          level_ = sustain_;
+          stage_ = Stage::Sustain;
+        }
+        break;
+      case Stage::Release:
+        level_ -= release_step_;
+        if (level_ <= 0.0f) {
+          level_ = 0.0f;
+          stage_ = Stage::Done;
+        }
+        break;
+      case Stage::Sustain:
+      case Stage::Done:
+        break;
+    }
+    return level_;
+  }
+};
+
+}  // namespace audio
+}  // namespace qe
@@ -0,0 +1,214 @@
+#pragma once
+/**
+ * @file Resampler.h
+ * @brief PCM decoding, channel mapping and sample-rate conversion to the mixer format.
+ *
+ * Assets arrive in whatever format they were authored in; the mixer wants
+ * 16-bit mono or stereo at the device rate. Conversion runs in three steps:
+ *
+ *   1. decode_pcm():       raw U8/S16/S24/S32/F32 frames -> float frames in
+ *                          S16 units, mapped to 1 or 2 output channels
+ *                          (mono is duplicated, stereo averaged to mono,
+ *                          extra channels beyond left/right dropped)
+ *   2. LinearResampler:    linear interpolation between input frames; keeps
+ *                          its phase and last frame across calls, so a
+ *                          stream can be converted chunk by chunk with no
+ *                          seams. Equal rates copy straight through.
+ *   3. mixer_detail::to_s16(): round and saturate
+ *
+ * convert_pcm() chains them for a whole clip and load_clip() does the same
+ * for a WAV file at load time (safe to run on a worker thread). Linear
+ * interpolation is cheap and transparent for effects authored near the
+ * device rate; heavy downsampling can alias, so ship assets at 44.1 kHz
+ * where it matters.
+ *
+ * Design by Contract:
+ *   - Precondition: out_channels is 1 or 2; rates are positive
+ *   - Postcondition: converting n input frames yields about
+ *     n * out_rate / in_rate frames (exactly n at equal rates)
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Mixer.h"
+#include "WavReader.h"
+
+namespace qe {
+namespace audio {
+
+namespace pcm_detail {
+inline uint32_t le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+}  // namespace pcm_detail
+
+/** Read one sample of `f` at p as a float in S16 units. */
+inline float decode_sample(const uint8_t* p, SampleFormat f) {
+  switch (f) {
+    case SampleFormat::U8:
+      return (static_cast<int>(p[0]) - 128) * 256.0f;
+    case SampleFormat::S16:
+      return static_cast<float>(static_cast<int16_t>(p[0] | p[1] << 8));
+    case SampleFormat::S24: {
+      // Place the 24 bits at the top of an int32 to sign-extend them
+      uint32_t bits = static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+                      static_cast<uint32_t>(p[2]) << 24;
+      return static_cast<float>(static_cast<int32_t>(bits)) * (1.0f / 65536.0f);
+    }
+    case SampleFormat::S32:
+      return static_cast<float>(static_cast<int32_t>(pcm_detail::le32(p))) * (1.0f / 65536.0f);
+    case SampleFormat::F32: {
+      uint32_t bits = pcm_detail::le32(p);
+      float v;
+      std::memcpy(&v, &bits, 4);
+      return v * 32768.0f;
+    }
+  }
+  return 0.0f;
+}
+
+/** Decode `frames` raw frames into out (frames * out_channels floats). */
+inline void decode_pcm(const uint8_t* src, size_t frames, const PcmFormat& in, int out_channels,
+                       float* out) {
+  const int bytes = sample_bytes(in.sample), stride = in.frame_bytes();
+  for (size_t i = 0; i < frames; ++i, src += stride) {
+    float l = decode_sample(src, in.sample);
+    float r = in.channels > 1 ? decode_sample(src + bytes, in.sample) : l;
+    if (out_channels == 1) {
+      *out++ = in.channels > 1 ? 0.5f * (l + r) : l;
+    } else {
+      *out++ = l;
+      *out++ = r;
+    }
+  }
+}
+
+class LinearResampler {
+ public:
+  LinearResampler(int channels = 2, int in_rate = 44100, int out_rate = 44100) {
+    configure(channels, in_rate, out_rate);
+  }
+
+  void configure(int channels, int in_rate, int out_rate) {
+    channels_ = channels == 1 ? 1 : 2;
+    passthrough_ = in_rate == out_rate;
+    step_ = static_cast<double>(in_rate) / out_rate;
+    reset();
+  }
+
+  /** Forget stream history (next input starts a new signal). */
+  void reset() {
+    pos_ = 1.0;
+    prev_[0] = prev_[1] = 0.0f;
+  }
+
+  /** Append the output for in_frames frames to out. */
+  void process(const float* in, size_t in_frames, std::vector<float>& out) {
+    if (passthrough_) {
+      out.insert(out.end(), in, in + in_frames * channels_);
+      return;
+    }
+    // pos_ indexes the input with the previous chunk's last frame at 0
+    const double end = static_cast<double>(in_frames);
+    for (; pos_ < end; pos_ += step_) {
+      const size_t i = static_cast<size_t>(pos_);
+      const float t = static_cast<float>(pos_ - i);
+      for (int c = 0; c < channels_; ++c) {
+        float a = i == 0 ? prev_[c] : in[(i - 1) * channels_ + c];
+        float b = in[i * channels_ + c];
+        out.push_back(a + (b - a) * t);
+      }
+    }
+    if (in_frames > 0) {
+      pos_ -= end;
+      for (int c = 0; c < channels_; ++c)
+        prev_[c] = in[(in_frames - 1) * channels_ + c];
+    }
+  }
+
+  /** Emit what is left between the last input frame and the end of the signal. */
+  void flush(std::vector<float>& out) {
+    if (passthrough_)
+      return;
+    for (; pos_ < 1.0; pos_ += step_)
+      for (int c = 0; c < channels_; ++c)
+        out.push_back(prev_[c]);
+  }
+
+  /** Upper bound on the output frames for in_frames more input frames. */
+  size_t max_output(size_t in_frames) const {
+    return passthrough_ ? in_frames : static_cast<size_t>(in_frames / step_) + 2;
+  }
+
+  int channels() const noexcept {
+    return channels_;
+  }
+
+ private:
+  int channels_ = 2;
+  bool passthrough_ = true;
+  double step_ = 1.0;  // Input frames per output frame
+  double pos_ = 1.0;
+  float prev_[2] = {0.0f, 0.0f};
+};
+
+/**
+ * Convert a whole clip to S16 with out_channels at out_rate (interleaved).
+ * Work is done in chunks so the float scratch stays small.
+ */
+inline std::vector<int16_t> convert_pcm(const uint8_t* src, size_t frames, const PcmFormat& in,
+                                        int out_channels, int out_rate) {
+  constexpr size_t kChunk = 4096;
+  LinearResampler rs(out_channels, in.rate, out_rate);
+  std::vector<float> decoded(kChunk * rs.channels()), resampled;
+  resampled.reserve(rs.max_output(frames) * rs.channels());
+  for (size_t done = 0; done < frames; done += kChunk) {
+    size_t n = std::min(kChunk, frames - done);
+    decode_pcm(src + done * in.frame_bytes(), n, in, rs.channels(), decoded.data());
+    rs.process(decoded.data(), n, resampled);
+  }
+  rs.flush(resampled);
+  std::vector<int16_t> out(resampled.size());
+  mixer_detail::to_s16(resampled.data(), out.data(), out.size());
+  return out;
+}
+
+/** A fully converted, mixer-ready sound. */
+struct SoundClip {
+  std::vector<int16_t> samples;  // Interleaved S16
+  int channels = 2;
+
+  uint32_t frames() const {
+    return static_cast<uint32_t>(samples.size() / channels);
+  }
+};
+
+/**
+ * Read a whole WAV file and convert it for the mixer at out_rate. Mono
+ * stays mono (the mixer pans it); anything wider becomes stereo.
+ */
+inline bool load_clip(const std::string& path, int out_rate, SoundClip& out) {
+  WavReader reader;
+  if (!reader.open(path))
+    return false;
+  const PcmFormat& in = reader.format();
+  std::vector<uint8_t> raw(static_cast<size_t>(reader.frames()) * in.frame_bytes());
+  const size_t frames = reader.read(raw.data(), static_cast<size_t>(reader.frames()));
+  if (frames != reader.frames()) {
+    std::cerr << "load_clip: " << path << ": truncated sample data\n";
+    return false;
+  }
+  out.channels = std::min(in.channels, 2);
+  out.samples = convert_pcm(raw.data(), frames, in, out.channels, out_rate);
+  return true;
+}
+
+}  // namespace audio
+}  // namespace qe
@@ -0,0 +1,194 @@
+#pragma once
+/**
+ * @file WavReader.h
+ * @brief Incremental RIFF/WAVE reader for uncompressed PCM and float data.
+ *
+ * open() parses the header chunks and leaves the file positioned at the
+ * first sample frame; read() then pulls raw interleaved frames in whatever
+ * amount the caller asks for. A whole clip can be read at once at load
+ * time, or a long one decoded piecewise by a streaming thread without ever
+ * holding the file in memory (audio/AudioStream.h).
+ *
+ * Supported: integer PCM at 8 (unsigned), 16, 24 and 32 bits and 32-bit
+ * IEEE float, any channel count and rate, including WAVE_FORMAT_EXTENSIBLE
+ * headers. Compressed formats (ADPCM, mu-law, ...) are rejected.
+ *
+ * Design by Contract:
+ *   - Postcondition: after a successful open(), frames() * format().frame_bytes()
+ *     bytes of sample data are readable
+ *   - Errors are reported to std::cerr and returned as false
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace qe {
+namespace audio {
+
+enum class SampleFormat : uint8_t { U8, S16, S24, S32, F32 };
+
+inline int sample_bytes(SampleFormat f) {
+  switch (f) {
+    case SampleFormat::U8:
+      return 1;
+    case SampleFormat::S16:
+      return 2;
+    case SampleFormat::S24:
+      return 3;
+    case SampleFormat::S32:
+    case SampleFormat::F32:
+      return 4;
+  }
+  return 0;
+}
+
+struct PcmFormat {
+  SampleFormat sample = SampleFormat::S16;
+  int channels = 2;
+  int rate = 44100;
+
+  int frame_bytes() const {
+    return sample_bytes(sample) * channels;
+  }
+};
+
+class WavReader {
+ public:
+  bool open(const std::string& path) {
+    path_ = path;
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary);
+    if (!file_)
+      return fail("cannot open");
+
+    uint8_t riff[12];
+    if (!read_bytes(riff, 12) || !tag_is(riff, "RIFF") || !tag_is(riff + 8, "WAVE"))
+      return fail("not a RIFF/WAVE file");
+
+    bool have_fmt = false;
+    uint8_t chunk[8];
+    while (read_bytes(chunk, 8)) {
+      const uint32_t size = le32(chunk + 4);
+      if (tag_is(chunk, "fmt ")) {
+        if (size < 16 || size > 64)
+          return fail("bad fmt chunk");
+        uint8_t fmt[64];
+        if (!read_bytes(fmt, size + (size & 1)))
+          return fail("truncated fmt chunk");
+        if (!parse_fmt(fmt, size))
+          return false;
+        have_fmt = true;
+      } else if (tag_is(chunk, "data")) {
+        if (!have_fmt)
+          return fail("data before fmt");
+        data_start_ = file_.tellg();
+        file_.seekg(0, std::ios::end);
+        const uint64_t avail = static_cast<uint64_t>(file_.tellg() - data_start_);
+        file_.seekg(data_start_);
+        // Streamed writers may leave the size at 0xFFFFFFFF: trust the file
+        frames_ = std::min<uint64_t>(size, avail) / format_.frame_bytes();
+        pos_ = 0;
+        return true;
+      } else {
+        file_.seekg(size + (size & 1), std::ios::cur);
+      }
+    }
+    return fail("no data chunk");
+  }
+
+  const PcmFormat& format() const noexcept {
+    return format_;
+  }
+
+  /** Sample frames in the data chunk. */
+  uint64_t frames() const noexcept {
+    return frames_;
+  }
+
+  /** Frames not yet read. */
+  uint64_t remaining() const noexcept {
+    return frames_ - pos_;
+  }
+
+  /** Copy up to n raw frames into dst; returns the frames read (0 at the end). */
+  size_t read(uint8_t* dst, size_t n) {
+    n = static_cast<size_t>(std::min<uint64_t>(n, remaining()));
+    const size_t bytes = n * format_.frame_bytes();
+    if (n == 0 || !read_bytes(dst, bytes))
+      return 0;
+    pos_ += n;
+    return n;
+  }
+
+  /** Go back to the first frame (looping streams). */
+  bool rewind() {
+    file_.clear();
+    file_.seekg(data_start_);
+    pos_ = 0;
+    return static_cast<bool>(file_);
+  }
+
+ private:
+  std::ifstream file_;
+  std::string path_;
+  PcmFormat format_;
+  std::streampos data_start_ = 0;
+  uint64_t frames_ = 0, pos_ = 0;
+
+  static uint16_t le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+  }
+  static uint32_t le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+  }
+  static bool tag_is(const uint8_t* p, const char* tag) {
+    return std::equal(p, p + 4, reinterpret_cast<const uint8_t*>(tag));
+  }
+
+  bool read_bytes(uint8_t* dst, size_t n) {
+    file_.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(n));
+    return static_cast<size_t>(file_.gcount()) == n;
+  }
+
+  bool fail(const char* why) {
+    std::cerr << "WavReader: " << path_ << ": " << why << "\n";
+    frames_ = pos_ = 0;
+    return false;
+  }
+
+  bool parse_fmt(const uint8_t* fmt, uint32_t size) {
+    constexpr uint16_t kPcm = 1, kFloat = 3, kExtensible = 0xFFFE;
+    uint16_t tag = le16(fmt);
+    const int channels = le16(fmt + 2);
+    const uint32_t rate = le32(fmt + 4);
+    const int bits = le16(fmt + 14);
+    if (tag == kExtensible && size >= 26)
+      tag = le16(fmt + 24);  // First two bytes of the sub-format GUID
+
+    if (tag == kPcm && bits == 8)
+      format_.sample = SampleFormat::U8;
+    else if (tag == kPcm && bits == 16)
+      format_.sample = SampleFormat::S16;
+    else if (tag == kPcm && bits == 24)
+      format_.sample = SampleFormat::S24;
+    else if (tag == kPcm && bits == 32)
+      format_.sample = SampleFormat::S32;
+    else if (tag == kFloat && bits == 32)
+      format_.sample = SampleFormat::F32;
+    else
+      return fail("unsupported sample format (need 8/16/24/32-bit PCM or 32-bit float)");
+    if (channels < 1 || rate == 0 || rate > 768000)
+      return fail("bad channel count or sample rate");
+    format_.channels = channels;
+    format_.rate = static_cast<int>(rate);
+    return true;
+  }
+};
+
+}  // namespace audio
+}  // namespace qe
@@ -0,0 +1,143 @@
+#pragma once
+/**
+ * @file AllocHooks.h
+ * @brief Global operator new/delete replacements that feed AllocTracker.
+ *
+ * Include in exactly ONE translation unit of a program (the one with
+ * main()): the replacements are ordinary, non-inline definitions. Every
+ * allocation then goes through malloc as before, plus one thread-local and
+ * two relaxed atomic increments.
+ *
+ * Design by Contract:
+ *   - Precondition: included once per program
+ *   - Postcondition: AllocTracker::installed() is true once static
+ *     initialization reaches this translation unit
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocTracker.h"
+
+// GCC sees malloc'd memory reach operator delete through the inlined
+// replacements and flags a new/free mismatch; here that pairing is intended
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace qe {
+namespace core {
+namespace detail {
+
+inline void* tracked_alloc(std::size_t n) {
+  AllocTracker::on_alloc(n);
+  return std::malloc(n ? n : 1);
+}
+
+inline void* tracked_aligned_alloc(std::size_t n, std::align_val_t al) {
+  AllocTracker::on_alloc(n);
+  const std::size_t a = static_cast<std::size_t>(al);
+#ifdef _WIN32
+  return _aligned_malloc(n ? n : 1, a);
+#else
+  // aligned_alloc wants a size that is a multiple of the alignment
+  return std::aligned_alloc(a, n ? (n + a - 1) / a * a : a);
+#endif
+}
+
+inline void tracked_free(void* p) noexcept {
+  if (!p)
+    return;
+  AllocTracker::on_free();
+  std::free(p);
+}
+
+inline void tracked_aligned_free(void* p) noexcept {
+  if (!p)
+    return;
+  AllocTracker::on_free();
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+static const bool hooks_installed = (AllocTracker::mark_installed(), true);
+
+}  // namespace detail
+}  // namespace core
+}  // namespace qe
+
+// ── Replacements ────────────────────────────────────────────────────────────
+
+void* operator new(std::size_t n) {
+  if (void* p = qe::core::detail::tracked_alloc(n))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+  return operator new(n);
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  return qe::core::detail::tracked_alloc(n);
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+  return qe::core::detail::tracked_alloc(n);
+}
+void* operator new(std::size_t n, std::align_val_t al) {
+  if (void* p = qe::core::detail::tracked_aligned_alloc(n, al))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t al) {
+  return operator new(n, al);
+}
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return qe::core::detail::tracked_aligned_alloc(n, al);
+}
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return qe::core::detail::tracked_aligned_alloc(n, al);
+}
+
+void operator delete(void* p) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete[](void* p) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  qe::core::detail::tracked_free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+  qe::core::detail::tracked_aligned_free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+/**
+ * @file AllocTracker.h
+ * @brief Heap allocation counts and bytes per subsystem, per frame.
+ *
+ *   void ParticleSystem::update(float dt) {
+ *     QE_ALLOC_TAG(Particles);  // Allocations below count as Particles
+ *     ...
+ *   }
+ *
+ *   AllocFrame frame;
+ *   frame.begin();
+ *   run_frame();
+ *   frame.end();  // frame[AllocTag::Particles].allocs, .bytes, frame.total()
+ *
+ * Counting happens in the global operator new/delete replacements of
+ * core/AllocHooks.h, which one translation unit per program includes;
+ * without them every count stays zero (installed() is false). Each thread
+ * carries a current tag, set by QE_ALLOC_TAG for the enclosing block, and
+ * TaggedAllocator charges a container's storage to a fixed tag wherever it
+ * grows. Counters are relaxed atomics, so any thread may allocate.
+ *
+ * thread_allocs() counts only the calling thread, for checks such as "this
+ * sim step did not allocate" that other threads must not disturb.
+ *
+ * Design by Contract:
+ *   - Postcondition: counting never allocates and never blocks
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace qe {
+namespace core {
+
+enum class AllocTag : uint8_t {
+  Other,
+  Sim,
+  Physics,
+  Enemies,
+  Particles,
+  Ai,
+  Input,
+  Render,
+  Audio,
+  Assets,
+  Count
+};
+
+inline const char* alloc_tag_name(AllocTag tag) {
+  static constexpr const char* kNames[] = {"other",     "sim", "physics", "enemies",
+                                           "particles", "ai",  "input",   "render",
+                                           "audio",     "assets"};
+  return tag < AllocTag::Count ? kNames[static_cast<size_t>(tag)] : "?";
+}
+
+/** Allocation counters; also used for the difference between two readings. */
+struct AllocStats {
+  uint64_t allocs = 0;
+  uint64_t bytes = 0;  // Requested by allocations (frees are not sized)
+  uint64_t frees = 0;
+
+  AllocStats operator-(const AllocStats& o) const {
+    return {allocs - o.allocs, bytes - o.bytes, frees - o.frees};
+  }
+  AllocStats& operator+=(const AllocStats& o) {
+    allocs += o.allocs;
+    bytes += o.bytes;
+    frees += o.frees;
+    return *this;
+  }
+};
+
+namespace detail {
+struct AllocCounters {
+  std::atomic<uint64_t> allocs{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> frees{0};
+};
+}  // namespace detail
+
+class AllocTracker {
+ public:
+  static constexpr size_t kTags = static_cast<size_t>(AllocTag::Count);
+
+  /** Called by the operator new replacements. */
+  static void on_alloc(size_t bytes) noexcept {
+    detail::AllocCounters& c = counters_[static_cast<size_t>(tag())];
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    ++thread_counter();
+  }
+  /** Called by the operator delete replacements (not for null). */
+  static void on_free() noexcept {
+    counters_[static_cast<size_t>(tag())].frees.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Everything charged to tag since startup. */
+  static AllocStats stats(AllocTag tag) noexcept {
+    const detail::AllocCounters& c = counters_[static_cast<size_t>(tag)];
+    return {c.allocs.load(std::memory_order_relaxed), c.bytes.load(std::memory_order_relaxed),
+            c.frees.load(std::memory_order_relaxed)};
+  }
+  static AllocStats total() noexcept {
+    AllocStats sum;
+    for (size_t t = 0; t < kTags; ++t)
+      sum += stats(static_cast<AllocTag>(t));
+    return sum;
+  }
+
+  /** Allocations made by the calling thread since it started. */
+  static uint64_t thread_allocs() noexcept {
+    return thread_counter();
+  }
+
+  /** The calling thread's current tag. */
+  static AllocTag& tag() noexcept {
+    thread_local AllocTag current = AllocTag::Other;
+    return current;
+  }
+
+  /** Whether core/AllocHooks.h is linked in, i.e. whether counts mean anything. */
+  static bool installed() noexcept {
+    return installed_.load(std::memory_order_relaxed);
+  }
+  static void mark_installed() noexcept {
+    installed_.store(true, std::memory_order_relaxed);
+  }
+
+ private:
+  static inline std::array<detail::AllocCounters, kTags> counters_{};
+  static inline std::atomic<bool> installed_{false};
+
+  static uint64_t& thread_counter() noexcept {
+    thread_local uint64_t n = 0;
+    return n;
+  }
+};
+
+/** Charges the calling thread's allocations to a tag until destroyed. */
+class AllocTagScope {
+ public:
+  explicit AllocTagScope(AllocTag tag) noexcept : saved_(AllocTracker::tag()) {
+    AllocTracker::tag() = tag;
+  }
+  ~AllocTagScope() {
+    AllocTracker::tag() = saved_;
+  }
+
+  AllocTagScope(const AllocTagScope&) = delete;
+  AllocTagScope& operator=(const AllocTagScope&) = delete;
+
+ private:
+  AllocTag saved_;
+};
+
+/** Per-tag allocations between begin() and end(), all threads. */
+class AllocFrame {
+ public:
+  void begin() noexcept {
+    for (size_t t = 0; t < AllocTracker::kTags; ++t)
+      start_[t] = AllocTracker::stats(static_cast<AllocTag>(t));
+  }
+  void end() noexcept {
+    total_ = AllocStats{};
+    for (size_t t = 0; t < AllocTracker::kTags; ++t) {
+      delta_[t] = AllocTracker::stats(static_cast<AllocTag>(t)) - start_[t];
+      total_ += delta_[t];
+    }
+  }
+
+  const AllocStats& operator[](AllocTag tag) const noexcept {
+    return delta_[static_cast<size_t>(tag)];
+  }
+  const AllocStats& total() const noexcept {
+    return total_;
+  }
+
+ private:
+  std::array<AllocStats, AllocTracker::kTags> start_{};
+  std::array<AllocStats, AllocTracker::kTags> delta_{};
+  AllocStats total_;
+};
+
+/** STL allocator that charges its storage to Tag wherever the container grows. */
+template <typename T, AllocTag Tag>
+struct TaggedAllocator {
+  using value_type = T;
+  template <typename U>
+  struct rebind {
+    using other = TaggedAllocator<U, Tag>;
+  };
+
+  TaggedAllocator() noexcept = default;
+  template <typename U>
+  TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept {}
+
+  T* allocate(size_t n) {
+    AllocTagScope scope(Tag);
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) noexcept {
+    AllocTagScope scope(Tag);
+    ::operator delete(p);
+  }
+
+  template <typename U>
+  bool operator==(const TaggedAllocator<U, Tag>&) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const TaggedAllocator<U, Tag>&) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace core
+}  // namespace qe
+
+#define QE_ALLOC_CONCAT_(a, b) a##b
+#define QE_ALLOC_CONCAT(a, b) QE_ALLOC_CONCAT_(a, b)
+
+/** Charge the enclosing block's allocations to AllocTag::tag. */
+#define QE_ALLOC_TAG(tag) \
+  ::qe::core::AllocTagScope QE_ALLOC_CONCAT(qe_alloc_tag_, __LINE__)(::qe::core::AllocTag::tag)
@@ -0,0 +1,176 @@
+#pragma once
+/**
+ * @file ByteStream.h
+ * @brief Growable byte writer and bounds-checked reader with varints.
+ *
+ * Integers are LEB128 varints (7 bits per byte, low groups first), so small
+ * values cost one byte. Signed values go through zigzag first (0, -1, 1,
+ * -2, ... -> 0, 1, 2, 3, ...) so small negatives stay small too. Floats are
+ * stored as their raw little-endian IEEE bits; delta coders can diff those
+ * bits with put_svarint() when neighbouring values are close.
+ *
+ * Design by Contract:
+ *   - Invariant: ByteReader never reads past its buffer
+ *   - Postcondition: a read past the end returns 0 and clears ok()
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace qe {
+namespace core {
+
+inline uint64_t zigzag_encode(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline uint32_t float_bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float bits_float(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+class ByteWriter {
+ public:
+  void put_u8(uint8_t v) {
+    buf_.push_back(v);
+  }
+
+  void put_u32(uint32_t v) {
+    for (int i = 0; i < 4; ++i)
+      buf_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+  }
+
+  void put_varint(uint64_t v) {
+    while (v >= 0x80) {
+      buf_.push_back(static_cast<uint8_t>(v | 0x80));
+      v >>= 7;
+    }
+    buf_.push_back(static_cast<uint8_t>(v));
+  }
+
+  void put_svarint(int64_t v) {
+    put_varint(zigzag_encode(v));
+  }
+
+  void put_f32(float f) {
+    put_u32(float_bits(f));
+  }
+
+  void put_bytes(const void* data, size_t n) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    buf_.insert(buf_.end(), p, p + n);
+  }
+
+  const std::vector<uint8_t>& data() const noexcept {
+    return buf_;
+  }
+  size_t size() const noexcept {
+    return buf_.size();
+  }
+  void clear() noexcept {
+    buf_.clear();
+  }
+  /** Preallocate so writes up to n bytes do not reallocate; clear() keeps it. */
+  void reserve(size_t n) {
+    buf_.reserve(n);
+  }
+
+ private:
+  std::vector<uint8_t> buf_;
+};
+
+class ByteReader {
+ public:
+  ByteReader() = default;
+  ByteReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+  explicit ByteReader(const std::vector<uint8_t>& v) : ByteReader(v.data(), v.size()) {}
+
+  uint8_t get_u8() {
+    if (p_ >= end_)
+      return overrun();
+    return *p_++;
+  }
+
+  uint32_t get_u32() {
+    if (end_ - p_ < 4)
+      return overrun();
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i)
+      v |= static_cast<uint32_t>(*p_++) << (8 * i);
+    return v;
+  }
+
+  uint64_t get_varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (p_ >= end_)
+        return overrun();
+      uint8_t b = *p_++;
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    return overrun();  // More than 10 bytes: corrupt
+  }
+
+  int64_t get_svarint() {
+    return zigzag_decode(get_varint());
+  }
+
+  float get_f32() {
+    return bits_float(get_u32());
+  }
+
+  bool get_bytes(void* out, size_t n) {
+    if (static_cast<size_t>(end_ - p_) < n)
+      return overrun() != 0;
+    std::memcpy(out, p_, n);
+    p_ += n;
+    return true;
+  }
+
+  /** Step over n bytes; false (and no longer ok()) if fewer remain. */
+  bool skip(size_t n) {
+    if (static_cast<size_t>(end_ - p_) < n)
+      return overrun() != 0;
+    p_ += n;
+    return true;
+  }
+
+  bool ok() const noexcept {
+    return ok_;
+  }
+  bool at_end() const noexcept {
+    return p_ >= end_;
+  }
+  size_t remaining() const noexcept {
+    return static_cast<size_t>(end_ - p_);
+  }
+
+ private:
+  const uint8_t* p_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  bool ok_ = true;
+
+  uint8_t overrun() {
+    ok_ = false;
+    p_ = end_;
+    return 0;
+  }
+};
+
+}  // namespace core
+}  // namespace qe
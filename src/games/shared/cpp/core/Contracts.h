@@ -0,0 +1,20 @@
+#pragma once
+/**
+ * @file Contracts.h
+ * @brief Design-by-Contract precondition check shared by every module.
+ *
+ *   QE_REQUIRE(count > 0, "Mesh: empty index buffer");
+ *
+ * A failed check throws std::invalid_argument with the message. Kept free
+ * of other engine headers so physics, simulation and tools can validate
+ * their inputs without pulling in the renderer.
+ */
+
+#include <stdexcept>
+
+// DbC macro — throws std::invalid_argument on validation failure
+#define QE_REQUIRE(cond, msg)           \
+  do {                                  \
+    if (!(cond))                        \
+      throw std::invalid_argument(msg); \
+  } while (0)
@@ -0,0 +1,146 @@
+#pragma once
+/**
+ * @file Counters.h
+ * @brief Named per-frame counters and gauges that subsystems publish to.
+ *
+ *   void Mesh::draw() const {
+ *     QE_COUNTER_ADD("draw calls", 1);  // Summed over the frame
+ *     ...
+ *   }
+ *   QE_COUNTER_SET("particles", particles.size());  // Level, kept until set again
+ *
+ *   Counters::end_frame();  // Once per frame, after the last publish
+ *   for (int i = 0; i < Counters::count(); ++i)
+ *     show(Counters::name(i), Counters::last(i));
+ *
+ * One fixed table of kMaxCounters slots for the whole program. The macros
+ * look their counter up once (a function-local static) and then cost one
+ * relaxed atomic store or add, from any thread. Code that must never
+ * block (the audio callback) looks its ids up with id() beforehand and
+ * calls set() or add() directly.
+ * end_frame() latches every value for readers and zeroes the per-frame
+ * counters, so readers see complete frames while the next one fills.
+ *
+ * A counter is identified by name and kind: the "enemies" gauge (how many)
+ * and the "enemies" GPU time (how long to draw them) are different slots.
+ *
+ * Design by Contract:
+ *   - Precondition: names are string literals (only the pointer is kept)
+ *   - Precondition: end_frame() and the readers run on one thread
+ *   - Postcondition: publishing never allocates, and blocks only the first
+ *     time a counter is registered
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+namespace qe {
+namespace core {
+
+enum class CounterKind : uint8_t {
+  PerFrame,  // Summed over a frame, zeroed by end_frame()
+  Gauge,     // Current level
+  CpuTime,   // Milliseconds of a CPU phase in the last frame
+  GpuTime,   // Milliseconds of a GPU pass in the newest measured frame
+};
+
+namespace detail {
+struct CounterSlot {
+  const char* name = "";
+  CounterKind kind = CounterKind::PerFrame;
+  std::atomic<double> value{0.0};
+  double last = 0.0;  // Latched by Counters::end_frame()
+};
+}  // namespace detail
+
+class Counters {
+ public:
+  static constexpr int kMaxCounters = 64;
+
+  using Kind = CounterKind;
+
+  /** Slot of the named counter, registered on first use (-1 when the table is full). */
+  static int id(const char* name, Kind kind) {
+    if (int found = find(name, kind); found >= 0)
+      return found;
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    if (int found = find(name, kind); found >= 0)
+      return found;  // Registered while we waited
+    const int n = count_.load(std::memory_order_relaxed);
+    if (n == kMaxCounters)
+      return -1;
+    slots_[n].name = name;
+    slots_[n].kind = kind;
+    count_.store(n + 1, std::memory_order_release);
+    return n;
+  }
+
+  /** Registered slot of the named counter, or -1. */
+  static int find(const char* name, Kind kind) noexcept {
+    const int n = count_.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i)
+      if (slots_[i].kind == kind && std::strcmp(slots_[i].name, name) == 0)
+        return i;
+    return -1;
+  }
+
+  static void add(int id, double v) noexcept {
+    if (id < 0)
+      return;
+    std::atomic<double>& value = slots_[id].value;
+    double cur = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {
+    }
+  }
+  static void set(int id, double v) noexcept {
+    if (id >= 0)
+      slots_[id].value.store(v, std::memory_order_relaxed);
+  }
+
+  /** Latch every counter for readers and start a new frame. */
+  static void end_frame() noexcept {
+    const int n = count_.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) {
+      detail::CounterSlot& s = slots_[i];
+      s.last = s.kind == Kind::PerFrame ? s.value.exchange(0.0, std::memory_order_relaxed)
+                                        : s.value.load(std::memory_order_relaxed);
+    }
+  }
+
+  static int count() noexcept {
+    return count_.load(std::memory_order_acquire);
+  }
+  static const char* name(int id) noexcept {
+    return slots_[id].name;
+  }
+  static Kind kind(int id) noexcept {
+    return slots_[id].kind;
+  }
+  /** Value latched by the last end_frame() (0 for id -1). */
+  static double last(int id) noexcept {
+    return id >= 0 ? slots_[id].last : 0.0;
+  }
+
+ private:
+  static inline std::array<detail::CounterSlot, kMaxCounters> slots_{};
+  static inline std::atomic<int> count_{0};
+  static inline std::mutex register_mutex_;
+};
+
+}  // namespace core
+}  // namespace qe
+
+#define QE_COUNTER_PUBLISH_(op, kind, name, v)                                \
+  do {                                                                        \
+    static const int qe_counter_id_ =                                         \
+        ::qe::core::Counters::id((name), ::qe::core::Counters::Kind::kind);   \
+    ::qe::core::Counters::op(qe_counter_id_, static_cast<double>(v));         \
+  } while (0)
+
+/** Add v to this frame's total of counter `name` (a string literal). */
+#define QE_COUNTER_ADD(name, v) QE_COUNTER_PUBLISH_(add, PerFrame, name, v)
+/** Set gauge `name` (a string literal) to v. */
+#define QE_COUNTER_SET(name, v) QE_COUNTER_PUBLISH_(set, Gauge, name, v)
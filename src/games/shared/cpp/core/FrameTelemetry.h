@@ -0,0 +1,401 @@
+#pragma once
+/**
+ * @file FrameTelemetry.h
+ * @brief Always-on frame and phase time percentiles, hitch capture, export.
+ *
+ *   const int render = telemetry.phase("render");
+ *   telemetry.begin_frame();
+ *   { TelemetryPhase t(telemetry, render); draw(); }
+ *   telemetry.end_frame();
+ *   telemetry.stats(render).p99_ms;
+ *
+ * Every frame's time, and the time of each phase that ran in it (summed if
+ * it ran more than once), goes into a LogHistogram: HDR-style buckets, 32
+ * linear sub-buckets per power of two of microseconds, so any percentile
+ * is within ~3% with a fixed 4 KB per histogram and no allocation per
+ * frame. Averages hide stutter; p99 and p99.9 show it. A loop pass that
+ * presents nothing ends with discard_frame() rather than end_frame(), so
+ * idle wake-ups do not count as fast frames.
+ *
+ * A frame longer than config.hitch_ms is a hitch. It is logged with its
+ * slowest phase, and if the CPU profiler (core/Profiler.h) is recording,
+ * the trace from capture_before_ms before the hitch to a few frames after
+ * it is written to <capture_prefix>_<n>.json — a long session keeps the
+ * context of its shader compiles and asset loads without a full trace.
+ *
+ * With config.export_path set, each export_interval_s the interval's
+ * percentiles per phase are appended to it, as CSV when the path ends in
+ * ".csv" and JSON Lines otherwise, and the interval histograms restart.
+ * stats() and report() cover the whole session. Each phase's time in the
+ * last frame it ran is also published as a time counter (core/Counters.h)
+ * for live displays.
+ *
+ * Design by Contract:
+ *   - Precondition: used from one thread (the one running the frame loop)
+ *   - Precondition: phase names are string literals (only the pointer is kept)
+ *   - Postcondition: recording a frame never allocates
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Counters.h"
+#include "Profiler.h"
+
+namespace qe {
+namespace core {
+
+/** Log-bucketed histogram of non-negative integers (microseconds here). */
+class LogHistogram {
+ public:
+  static constexpr int kSubBits = 5;
+  static constexpr uint64_t kSub = uint64_t{1} << kSubBits;  // Sub-buckets per power of two
+  static constexpr int kMaxBits = 36;                         // Larger values are clamped
+  static constexpr size_t kBuckets = kSub + (kMaxBits - kSubBits) * kSub;
+
+  void record(uint64_t v) noexcept {
+    v = std::min(v, (uint64_t{1} << kMaxBits) - 1);
+    ++counts_[index(v)];
+    ++count_;
+    sum_ += v;
+    max_ = std::max(max_, v);
+  }
+  void record_ms(float ms) noexcept {
+    record(static_cast<uint64_t>(std::llround(std::max(ms, 0.0f) * 1000.0)));
+  }
+
+  /**
+   * Smallest value v such that at least p percent of the samples are <= v,
+   * to bucket precision (the bucket's highest value, capped at max()).
+   */
+  uint64_t percentile(double p) const noexcept {
+    if (count_ == 0)
+      return 0;
+    // The epsilon keeps 99.9% of 1000 samples at rank 999 despite rounding
+    const double want =
+        std::ceil(std::clamp(p, 0.0, 100.0) * static_cast<double>(count_) / 100.0 - 1e-9);
+    const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(want), 1);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      seen += counts_[b];
+      if (seen >= rank)
+        return std::min(highest(b), max_);
+    }
+    return max_;
+  }
+
+  uint64_t count() const noexcept {
+    return count_;
+  }
+  uint64_t max() const noexcept {
+    return max_;
+  }
+  double mean() const noexcept {
+    return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+  }
+
+  void clear() noexcept {
+    counts_.fill(0);
+    count_ = sum_ = max_ = 0;
+  }
+
+  static size_t index(uint64_t v) noexcept {
+    if (v < kSub)
+      return static_cast<size_t>(v);
+    const int shift = msb(v) - kSubBits;
+    return static_cast<size_t>((shift + 1) * kSub + ((v >> shift) - kSub));
+  }
+  /** Highest value that lands in bucket b. */
+  static uint64_t highest(size_t b) noexcept {
+    if (b < kSub)
+      return b;
+    const int shift = static_cast<int>(b / kSub) - 1;
+    return ((kSub + b % kSub + 1) << shift) - 1;
+  }
+
+ private:
+  std::array<uint32_t, kBuckets> counts_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+
+  static int msb(uint64_t v) noexcept {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    while (v >>= 1)
+      ++n;
+    return n;
+#endif
+  }
+};
+
+/** Percentiles of one phase, in milliseconds. */
+struct PhaseStats {
+  const char* name = "";
+  uint64_t frames = 0;  // Frames in which the phase ran
+  float p50_ms = 0.0f;
+  float p99_ms = 0.0f;
+  float p999_ms = 0.0f;
+  float max_ms = 0.0f;
+  float mean_ms = 0.0f;
+};
+
+class FrameTelemetry {
+ public:
+  static constexpr int kMaxPhases = 16;
+  static constexpr int kFrame = 0;  // The whole frame, always phase 0
+
+  struct Config {
+    float hitch_ms = 50.0f;                // Longer frames are hitches (0 = never)
+    float capture_before_ms = 250.0f;      // Trace kept from before a hitch
+    int capture_after_frames = 5;          // Frames traced after it before writing
+    int max_captures = 16;                 // Hitch traces per session
+    std::string capture_prefix = "hitch";  // Traces go to <prefix>_<n>.json
+    std::string export_path;               // Periodic .csv or JSON Lines ("" = off)
+    float export_interval_s = 10.0f;
+  };
+  Config config;
+
+  FrameTelemetry() {
+    phases_.reserve(kMaxPhases);
+    phase("frame");
+    session_start_ns_ = last_export_ns_ = Profiler::now_ns();
+  }
+
+  /**
+   * Index of the named phase, registered on first use (-1 when kMaxPhases
+   * are in use). `published_as` is the kind of its live counter; a phase
+   * fed from GPU timings is published as GpuTime.
+   */
+  int phase(const char* name, CounterKind published_as = CounterKind::CpuTime) {
+    for (size_t i = 0; i < phases_.size(); ++i)
+      if (std::strcmp(phases_[i].name, name) == 0)
+        return static_cast<int>(i);
+    if (phases_.size() == kMaxPhases)
+      return -1;
+    phases_.emplace_back();
+    phases_.back().name = name;
+    phases_.back().counter = Counters::id(name, published_as);
+    return static_cast<int>(phases_.size() - 1);
+  }
+
+  /** Add time to a phase of the current frame. */
+  void add(int phase, float ms) noexcept {
+    if (phase < 0 || phase >= static_cast<int>(phases_.size()))
+      return;
+    phases_[phase].frame_ms += ms;
+    phases_[phase].ran = true;
+  }
+
+  void begin_frame() noexcept {
+    frame_start_ns_ = Profiler::now_ns();
+  }
+  /** Close the frame begun by begin_frame(). */
+  void end_frame() {
+    record_frame(static_cast<float>(Profiler::now_ns() - frame_start_ns_) * 1e-6f);
+  }
+
+  /**
+   * Drop the frame begun by begin_frame() and the phase time added to it,
+   * for a loop pass that presented nothing (an idle wake-up).
+   */
+  void discard_frame() noexcept {
+    for (Phase& p : phases_) {
+      p.frame_ms = 0.0f;
+      p.ran = false;
+    }
+  }
+
+  /** Close the current frame with an externally measured frame time. */
+  void record_frame(float frame_ms) {
+    const int64_t now = Profiler::now_ns();
+    add(kFrame, frame_ms);
+    int slowest = -1;
+    for (size_t i = 0; i < phases_.size(); ++i) {
+      Phase& p = phases_[i];
+      if (!p.ran)
+        continue;
+      p.session.record_ms(p.frame_ms);
+      p.interval.record_ms(p.frame_ms);
+      Counters::set(p.counter, p.frame_ms);
+      if (i != kFrame && (slowest < 0 || p.frame_ms > phases_[slowest].frame_ms))
+        slowest = static_cast<int>(i);
+    }
+    ++frames_;
+
+    if (config.hitch_ms > 0.0f && frame_ms > config.hitch_ms)
+      on_hitch(now, frame_ms, slowest);
+    if (capture_due_ > 0 && --capture_due_ == 0)
+      capture(now);
+    if (!config.export_path.empty() &&
+        now - last_export_ns_ >= static_cast<int64_t>(config.export_interval_s * 1e9))
+      export_interval();
+
+    discard_frame();
+  }
+
+  /** Whole-session percentiles of a phase. */
+  PhaseStats stats(int phase) const {
+    return phase >= 0 && phase < static_cast<int>(phases_.size())
+               ? make_stats(phases_[phase].name, phases_[phase].session)
+               : PhaseStats{};
+  }
+
+  int phases() const noexcept {
+    return static_cast<int>(phases_.size());
+  }
+  uint64_t frames() const noexcept {
+    return frames_;
+  }
+  uint64_t hitches() const noexcept {
+    return hitches_;
+  }
+  int captures() const noexcept {
+    return captures_;
+  }
+
+  /**
+   * Append the current interval's percentiles to config.export_path and
+   * start a new interval. False if the file could not be written.
+   */
+  bool export_interval() {
+    last_export_ns_ = Profiler::now_ns();
+    const bool csv = ends_with(config.export_path, ".csv");
+    std::FILE* f = std::fopen(config.export_path.c_str(), exported_ ? "a" : "w");
+    if (!f)
+      return false;
+    if (!exported_ && csv)
+      std::fputs("time_s,phase,frames,p50_ms,p99_ms,p999_ms,max_ms,mean_ms,hitches\n", f);
+    exported_ = true;
+    const double t = static_cast<double>(last_export_ns_ - session_start_ns_) * 1e-9;
+    for (size_t i = 0; i < phases_.size(); ++i) {
+      Phase& p = phases_[i];
+      if (p.interval.count() == 0)
+        continue;
+      const PhaseStats s = make_stats(p.name, p.interval);
+      const unsigned long long hitches = i == kFrame ? interval_hitches_ : 0;
+      const auto frames = static_cast<unsigned long long>(s.frames);
+      if (csv)
+        std::fprintf(f, "%.3f,%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%llu\n", t, s.name, frames,
+                     s.p50_ms, s.p99_ms, s.p999_ms, s.max_ms, s.mean_ms, hitches);
+      else
+        std::fprintf(f,
+                     "{\"time_s\":%.3f,\"phase\":\"%s\",\"frames\":%llu,\"p50_ms\":%.3f,"
+                     "\"p99_ms\":%.3f,\"p999_ms\":%.3f,\"max_ms\":%.3f,\"mean_ms\":%.3f,"
+                     "\"hitches\":%llu}\n",
+                     t, s.name, frames, s.p50_ms, s.p99_ms, s.p999_ms, s.max_ms, s.mean_ms,
+                     hitches);
+      p.interval.clear();
+    }
+    interval_hitches_ = 0;
+    return std::fclose(f) == 0;
+  }
+
+  /** Session table: one line per phase. */
+  void report(std::ostream& out) const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-12s %8s %8s %8s %8s %8s %8s\n", "phase (ms)", "frames",
+                  "p50", "p99", "p99.9", "max", "mean");
+    out << line;
+    for (size_t i = 0; i < phases_.size(); ++i) {
+      const PhaseStats s = stats(static_cast<int>(i));
+      std::snprintf(line, sizeof(line), "%-12s %8llu %8.2f %8.2f %8.2f %8.2f %8.2f\n", s.name,
+                    static_cast<unsigned long long>(s.frames), s.p50_ms, s.p99_ms, s.p999_ms,
+                    s.max_ms, s.mean_ms);
+      out << line;
+    }
+    out << hitches_ << " hitches over " << config.hitch_ms << " ms in " << frames_ << " frames\n";
+  }
+
+ private:
+  struct Phase {
+    const char* name = "";
+    LogHistogram session;
+    LogHistogram interval;  // Since the last export
+    float frame_ms = 0.0f;  // This frame so far
+    bool ran = false;
+    int counter = -1;  // Live counter (core/Counters.h)
+  };
+
+  std::vector<Phase> phases_;
+  uint64_t frames_ = 0;
+  uint64_t hitches_ = 0;
+  uint64_t interval_hitches_ = 0;
+  int captures_ = 0;
+  int capture_due_ = 0;  // Frames left before writing the pending capture
+  int64_t capture_from_ns_ = 0;
+  int64_t frame_start_ns_ = 0;
+  int64_t session_start_ns_ = 0;
+  int64_t last_export_ns_ = 0;
+  bool exported_ = false;
+
+  void on_hitch(int64_t now, float frame_ms, int slowest) {
+    ++hitches_;
+    ++interval_hitches_;
+    std::fprintf(stderr, "Hitch: %.1f ms frame", frame_ms);
+    if (slowest >= 0)
+      std::fprintf(stderr, " (%s %.1f ms)", phases_[slowest].name, phases_[slowest].frame_ms);
+    std::fputc('\n', stderr);
+
+    // A hitch during a pending capture just lands in the same trace
+    if (capture_due_ > 0 || captures_ >= config.max_captures || !Profiler::enabled())
+      return;
+    capture_from_ns_ =
+        now - static_cast<int64_t>((frame_ms + config.capture_before_ms) * 1e6f);
+    capture_due_ = std::max(config.capture_after_frames, 0) + 1;
+  }
+
+  void capture(int64_t now) {
+    const std::string path = config.capture_prefix + "_" + std::to_string(captures_) + ".json";
+    ++captures_;
+    if (Profiler::instance().write_chrome_trace(path, capture_from_ns_, now))
+      std::fprintf(stderr, "Hitch trace written to %s\n", path.c_str());
+  }
+
+  static PhaseStats make_stats(const char* name, const LogHistogram& h) {
+    PhaseStats s;
+    s.name = name;
+    s.frames = h.count();
+    s.p50_ms = static_cast<float>(h.percentile(50.0)) * 1e-3f;
+    s.p99_ms = static_cast<float>(h.percentile(99.0)) * 1e-3f;
+    s.p999_ms = static_cast<float>(h.percentile(99.9)) * 1e-3f;
+    s.max_ms = static_cast<float>(h.max()) * 1e-3f;
+    s.mean_ms = static_cast<float>(h.mean()) * 1e-3f;
+    return s;
+  }
+
+  static bool ends_with(const std::string& s, const char* suffix) {
+    const size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+  }
+};
+
+/** Adds the enclosing block's wall time to a telemetry phase. */
+class TelemetryPhase {
+ public:
+  TelemetryPhase(FrameTelemetry& telemetry, int phase) noexcept
+      : telemetry_(telemetry), phase_(phase), start_ns_(Profiler::now_ns()) {}
+  ~TelemetryPhase() {
+    telemetry_.add(phase_, static_cast<float>(Profiler::now_ns() - start_ns_) * 1e-6f);
+  }
+
+  TelemetryPhase(const TelemetryPhase&) = delete;
+  TelemetryPhase& operator=(const TelemetryPhase&) = delete;
+
+ private:
+  FrameTelemetry& telemetry_;
+  int phase_;
+  int64_t start_ns_;
+};
+
+}  // namespace core
+}  // namespace qe
@@ -0,0 +1,201 @@
+#pragma once
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory-mapped file (POSIX mmap / Win32 file mapping).
+ *
+ * The OS pages data in on first touch, so opening a large file is O(1)
+ * and sections that are never read are never loaded. Falls back to
+ * reading the whole file into a heap buffer where mapping is unavailable.
+ *
+ * Design by Contract:
+ *   - Postcondition: open() == true  ⇒  data() is valid for size() bytes
+ *   - Invariant: move-only; the mapping is released exactly once
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define QE_HAS_MMAP 1
+#endif
+
+namespace qe {
+namespace core {
+
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path) {
+    open(path);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept {
+    take(other);
+  }
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      close();
+      take(other);
+    }
+    return *this;
+  }
+
+  ~MappedFile() {
+    close();
+  }
+
+  /** Map a file read-only; returns false if it cannot be opened. */
+  bool open(const std::string& path) {
+    close();
+#if defined(QE_HAS_MMAP)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        size_ = 0;
+        return read_fallback(path);
+      }
+      data_ = static_cast<const uint8_t*>(p);
+      mapped_ = true;
+    }
+    ::close(fd);  // The mapping keeps its own reference
+    open_ = true;
+    return true;
+#elif defined(_WIN32)
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER sz;
+    GetFileSizeEx(file_, &sz);
+    size_ = static_cast<size_t>(sz.QuadPart);
+    if (size_ > 0) {
+      mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      void* p = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+      if (!p) {
+        close();
+        return read_fallback(path);
+      }
+      data_ = static_cast<const uint8_t*>(p);
+      mapped_ = true;
+    }
+    open_ = true;
+    return true;
+#else
+    return read_fallback(path);
+#endif
+  }
+
+  void close() {
+#if defined(QE_HAS_MMAP)
+    if (mapped_)
+      ::munmap(const_cast<uint8_t*>(data_), size_);
+#elif defined(_WIN32)
+    if (mapped_)
+      UnmapViewOfFile(data_);
+    if (mapping_)
+      CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE)
+      CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+#endif
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    open_ = false;
+  }
+
+  bool is_open() const noexcept {
+    return open_;
+  }
+  /** True when backed by an OS mapping rather than the read fallback. */
+  bool is_mapped() const noexcept {
+    return mapped_;
+  }
+  const uint8_t* data() const noexcept {
+    return data_;
+  }
+  size_t size() const noexcept {
+    return size_;
+  }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  bool open_ = false;
+  std::vector<uint8_t> buffer_;  // Read fallback storage
+#if defined(_WIN32)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#endif
+
+  bool read_fallback(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+      return false;
+    buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    auto bytes = static_cast<std::streamsize>(buffer_.size());
+    if (bytes > 0 && !in.read(reinterpret_cast<char*>(buffer_.data()), bytes)) {
+      buffer_.clear();
+      return false;
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    open_ = true;
+    return true;
+  }
+
+  void take(MappedFile& other) {
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    open_ = other.open_;
+    buffer_ = std::move(other.buffer_);
+#if defined(_WIN32)
+    file_ = other.file_;
+    mapping_ = other.mapping_;
+    other.file_ = INVALID_HANDLE_VALUE;
+    other.mapping_ = nullptr;
+#endif
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+    other.open_ = false;
+  }
+};
+
+}  // namespace core
+}  // namespace qe
@@ -0,0 +1,77 @@
+#pragma once
+/**
+ * @file Parallel.h
+ * @brief Minimal fork-join helper for splitting index ranges across threads.
+ *
+ * parallel_for() cuts [begin, end) into one contiguous chunk per worker,
+ * runs the chunks on std::threads (the calling thread takes the first one)
+ * and joins before returning. Intended for coarse one-shot jobs such as
+ * terrain generation or mesh building, not for per-frame micro tasks: each
+ * call spawns its threads afresh.
+ *
+ * Design by Contract:
+ *   - Precondition: fn(lo, hi) is safe to run concurrently on disjoint ranges
+ *   - Postcondition: every index in [begin, end) is covered exactly once
+ *   - Postcondition: an exception thrown by any chunk is rethrown after join
+ */
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qe {
+namespace core {
+
+/** Hardware threads available (at least 1). */
+inline int worker_count() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : static_cast<int>(n);
+}
+
+/**
+ * Run fn(lo, hi) over contiguous chunks covering [begin, end).
+ * @param min_chunk  Smallest range worth a thread of its own
+ * @param max_workers  Upper bound on threads (0 = worker_count())
+ */
+template <typename Fn>
+void parallel_for(int begin, int end, Fn&& fn, int min_chunk = 1, int max_workers = 0) {
+  const int count = end - begin;
+  if (count <= 0)
+    return;
+  int workers = max_workers > 0 ? max_workers : worker_count();
+  workers = std::clamp(count / std::max(min_chunk, 1), 1, workers);
+  if (workers == 1) {
+    fn(begin, end);
+    return;
+  }
+
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto run = [&](int lo, int hi) {
+    try {
+      fn(lo, hi);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (int w = 1; w < workers; ++w) {
+    int lo = begin + static_cast<int>(static_cast<long long>(count) * w / workers);
+    int hi = begin + static_cast<int>(static_cast<long long>(count) * (w + 1) / workers);
+    threads.emplace_back(run, lo, hi);
+  }
+  run(begin, begin + count / workers);
+  for (auto& t : threads)
+    t.join();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+}  // namespace core
+}  // namespace qe
@@ -0,0 +1,360 @@
+#pragma once
+/**
+ * @file Profiler.h
+ * @brief Scoped CPU timing into per-thread rings, exported as a Chrome trace.
+ *
+ *   void update(float dt) {
+ *     QE_PROFILE_SCOPE("update");
+ *     ...
+ *   }
+ *
+ * Each thread that records gets its own ring of TraceEvents (begin, end,
+ * nesting depth), written only by that thread: a scope costs two
+ * steady_clock reads and one slot store, with no locks or allocation
+ * after the thread's first event. When recording is off a scope is one
+ * relaxed atomic load; building with QE_NO_PROFILE removes the macros
+ * entirely.
+ *
+ * write_chrome_trace() copies every ring and writes Chrome trace event
+ * JSON (chrome://tracing, ui.perfetto.dev): one complete ("X") event per
+ * scope, counters as "C" events, thread names as metadata. Nesting shows
+ * as a flame chart since child scopes lie inside their parents.
+ *
+ * A track (add_track) is a ring that belongs to no thread, for timelines
+ * measured elsewhere, such as GPU timer queries converted to this clock,
+ * or for a thread whose first event must not lock or allocate:
+ * QE_PROFILE_TRACK_SCOPE records onto a track made ahead of time.
+ *
+ * Rings keep the newest kRingEvents events per thread. A snapshot taken
+ * while a thread records drops any slot that thread may have overwritten
+ * during the copy.
+ *
+ * Design by Contract:
+ *   - Precondition: scope and counter names are string literals (only the
+ *     pointer is stored)
+ *   - Postcondition: recording never blocks the recording thread
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace qe {
+namespace core {
+
+struct TraceEvent {
+  enum Kind : uint8_t { Scope, Counter };
+
+  const char* name = "";
+  int64_t start_ns = 0;
+  int64_t end_ns = 0;   // Scope only
+  double value = 0.0;   // Counter only
+  uint16_t depth = 0;   // Enclosing scopes on the same thread
+  uint16_t thread = 0;  // Index into Profiler::thread_names() (set by snapshot())
+  Kind kind = Scope;
+};
+
+class Profiler {
+ public:
+  static constexpr size_t kRingEvents = size_t{1} << 15;  // Per thread, ~1 MB
+
+  /** One thread's events, or a track's; only its one writer pushes. */
+  struct Ring {
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(kRingEvents);
+    std::atomic<size_t> written{0};  // Total pushed; only the owner stores
+    std::atomic<bool> owned{true};
+    const char* name = nullptr;
+
+    void push(const TraceEvent& e) noexcept {
+      const size_t w = written.load(std::memory_order_relaxed);
+      events[w & (kRingEvents - 1)] = e;
+      written.store(w + 1, std::memory_order_release);
+    }
+  };
+
+  static Profiler& instance() {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  /** Start or stop recording on every thread; stopping keeps what was recorded. */
+  static void set_enabled(bool on) noexcept {
+    enabled_.store(on, std::memory_order_relaxed);
+  }
+  static bool enabled() noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static int64_t now_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /** Name the calling thread in exported traces. */
+  void set_thread_name(const char* name) {
+    Ring& r = local();
+    std::lock_guard<std::mutex> lock(mutex_);
+    r.name = name;
+  }
+
+  /**
+   * A timeline of its own, shown next to the threads; events are pushed
+   * with record_on() by one thread at a time. Tracks live as long as the
+   * profiler.
+   */
+  Ring* add_track(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.push_back(std::make_unique<Ring>());
+    rings_.back()->name = name;
+    return rings_.back().get();
+  }
+
+  /** Add an event (times on now_ns()'s clock) to a track if recording. */
+  static void record_on(Ring* track, const TraceEvent& e) noexcept {
+    if (enabled())
+      track->push(e);
+  }
+
+  /** Record a sampled value (shown as a graph track). */
+  void counter(const char* name, double value) {
+    if (!enabled())
+      return;
+    TraceEvent e;
+    e.name = name;
+    e.start_ns = now_ns();
+    e.value = value;
+    e.kind = TraceEvent::Counter;
+    local().push(e);
+  }
+
+  /**
+   * Copy every thread's recorded events into out, oldest first per
+   * thread, with TraceEvent::thread set.
+   */
+  void snapshot(std::vector<TraceEvent>& out) const {
+    out.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t t = 0; t < rings_.size(); ++t) {
+      const Ring& r = *rings_[t];
+      const size_t end = r.written.load(std::memory_order_acquire);
+      const size_t begin = end > kRingEvents ? end - kRingEvents : 0;
+      const size_t first = out.size();
+      for (size_t i = begin; i < end; ++i)
+        out.push_back(r.events[i & (kRingEvents - 1)]);
+      // Drop slots the owner reused during the copy, or may be writing now
+      const size_t now = r.written.load(std::memory_order_acquire) + 1;
+      const size_t valid = now > kRingEvents ? now - kRingEvents : 0;
+      if (valid > begin) {
+        const size_t lost = std::min(valid - begin, end - begin);
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(first),
+                  out.begin() + static_cast<std::ptrdiff_t>(first + lost));
+      }
+      for (size_t i = first; i < out.size(); ++i)
+        out[i].thread = static_cast<uint16_t>(t);
+    }
+  }
+
+  /** Names of recording threads, indexed by TraceEvent::thread. */
+  std::vector<std::string> thread_names() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (size_t t = 0; t < rings_.size(); ++t)
+      names.push_back(rings_[t]->name ? rings_[t]->name : "thread " + std::to_string(t));
+    return names;
+  }
+
+  /**
+   * Write what was recorded as Chrome trace JSON: everything, or only the
+   * events overlapping [from_ns, to_ns] (times on now_ns()'s clock).
+   */
+  bool write_chrome_trace(const std::string& path, int64_t from_ns = INT64_MIN,
+                          int64_t to_ns = INT64_MAX) const {
+    std::vector<TraceEvent> events;
+    snapshot(events);
+    events.erase(std::remove_if(events.begin(), events.end(),
+                                [&](const TraceEvent& e) {
+                                  const int64_t end =
+                                      e.kind == TraceEvent::Scope ? e.end_ns : e.start_ns;
+                                  return end < from_ns || e.start_ns > to_ns;
+                                }),
+                 events.end());
+    const std::vector<std::string> names = thread_names();
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f)
+      return false;
+    int64_t origin = events.empty() ? 0 : events.front().start_ns;
+    for (const TraceEvent& e : events)
+      origin = std::min(origin, e.start_ns);
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    bool first = true;
+    auto sep = [&] {
+      std::fputs(first ? "" : ",\n", f);
+      first = false;
+    };
+    for (size_t t = 0; t < names.size(); ++t) {
+      sep();
+      std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,", t);
+      std::fprintf(f, "\"args\":{\"name\":\"%s\"}}", escape(names[t]).c_str());
+    }
+    for (const TraceEvent& e : events) {
+      sep();
+      const double ts = (e.start_ns - origin) * 1e-3;  // Microseconds
+      if (e.kind == TraceEvent::Counter)
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+                        "\"args\":{\"value\":%g}}",
+                     escape(e.name).c_str(), ts, unsigned{e.thread}, e.value);
+      else
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                        "\"tid\":%u}",
+                     escape(e.name).c_str(), ts, (e.end_ns - e.start_ns) * 1e-3,
+                     unsigned{e.thread});
+    }
+    std::fputs("\n]}\n", f);
+    return std::fclose(f) == 0;
+  }
+
+  /** Forget recorded events; only call while no other thread is recording. */
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& r : rings_)
+      r->written.store(0, std::memory_order_release);
+  }
+
+  // --- Used by ProfileScope ---
+
+  void record(const char* name, int64_t start_ns, int64_t end_ns, uint16_t depth) {
+    TraceEvent e;
+    e.name = name;
+    e.start_ns = start_ns;
+    e.end_ns = end_ns;
+    e.depth = depth;
+    local().push(e);
+  }
+
+  /** The calling thread's current scope depth. */
+  static uint16_t& depth() noexcept {
+    thread_local uint16_t d = 0;
+    return d;
+  }
+
+ private:
+  /** Releases the thread's ring for reuse when the thread exits. */
+  struct Owner {
+    Ring* ring = nullptr;
+    ~Owner() {
+      if (ring)
+        ring->owned.store(false, std::memory_order_release);
+    }
+  };
+
+  static inline std::atomic<bool> enabled_{false};
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+
+  Profiler() = default;
+
+  /** The calling thread's ring: registered on first use, recycled from exited threads. */
+  Ring& local() {
+    thread_local Owner owner;
+    if (!owner.ring) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& r : rings_)
+        if (!r->owned.load(std::memory_order_acquire)) {
+          r->written.store(0, std::memory_order_relaxed);
+          r->name = nullptr;
+          r->owned.store(true, std::memory_order_relaxed);
+          owner.ring = r.get();
+          break;
+        }
+      if (!owner.ring) {
+        rings_.push_back(std::make_unique<Ring>());
+        owner.ring = rings_.back().get();
+      }
+    }
+    return *owner.ring;
+  }
+
+  static std::string escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+      if (c == '"' || c == '\\')
+        out += '\\';
+      out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+    return out;
+  }
+};
+
+/** RAII timer behind QE_PROFILE_SCOPE. */
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name) noexcept : name_(name) {
+    if (Profiler::enabled()) {
+      depth_ = Profiler::depth()++;
+      start_ns_ = Profiler::now_ns();
+    }
+  }
+
+  /**
+   * Time onto a track from add_track() instead of the thread's ring, for
+   * threads that must never take the profiler's lock (the audio callback).
+   */
+  ProfileScope(const char* name, Profiler::Ring* track) noexcept : name_(name), track_(track) {
+    if (Profiler::enabled())
+      start_ns_ = Profiler::now_ns();
+  }
+
+  ~ProfileScope() {
+    if (start_ns_ == 0)
+      return;
+    const int64_t end = Profiler::now_ns();
+    if (track_) {
+      TraceEvent e;
+      e.name = name_;
+      e.start_ns = start_ns_;
+      e.end_ns = end;
+      Profiler::record_on(track_, e);
+      return;
+    }
+    --Profiler::depth();
+    Profiler::instance().record(name_, start_ns_, end, depth_);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  const char* name_;
+  Profiler::Ring* track_ = nullptr;
+  int64_t start_ns_ = 0;
+  uint16_t depth_ = 0;
+};
+
+}  // namespace core
+}  // namespace qe
+
+#define QE_PROFILE_CONCAT_(a, b) a##b
+#define QE_PROFILE_CONCAT(a, b) QE_PROFILE_CONCAT_(a, b)
+
+#ifdef QE_NO_PROFILE
+#define QE_PROFILE_SCOPE(name) ((void)0)
+#define QE_PROFILE_TRACK_SCOPE(name, track) ((void)0)
+#define QE_PROFILE_COUNTER(name, value) ((void)0)
+#else
+/** Time the enclosing block under `name` (a string literal). */
+#define QE_PROFILE_SCOPE(name) \
+  ::qe::core::ProfileScope QE_PROFILE_CONCAT(qe_profile_scope_, __LINE__)(name)
+/** Time the enclosing block under `name` on `track` (a Profiler::add_track() ring). */
+#define QE_PROFILE_TRACK_SCOPE(name, track) \
+  ::qe::core::ProfileScope QE_PROFILE_CONCAT(qe_profile_scope_, __LINE__)(name, track)
+/** Record a sampled value under `name` (a string literal). */
+#define QE_PROFILE_COUNTER(name, value) ::qe::core::Profiler::instance().counter(name, value)
+#endif
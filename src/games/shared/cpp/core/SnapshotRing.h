@@ -0,0 +1,211 @@
+#pragma once
+/**
+ * @file SnapshotRing.h
+ * @brief Fixed-budget history of byte snapshots stored as XOR + RLE deltas.
+ *
+ * The newest snapshot is kept whole. Each older one is kept only as its
+ * difference to the next newer one: the two byte strings are XORed, so
+ * unchanged bytes become zero, and the result is run-length coded as
+ *
+ *   varint older_size, then (varint zero_run, varint n, n bytes)*
+ *
+ * Stepping back applies those reverse deltas newest-first. History can
+ * therefore be dropped from the old end without re-encoding anything:
+ * deltas live in one arena allocated up front, and when it (or the entry
+ * table) is full the oldest deltas are discarded.
+ *
+ * Deltas are small when snapshots have a fixed layout (raw floats at stable
+ * offsets) and most bytes do not change between pushes. Snapshots may
+ * change size; the shorter side is treated as zero-padded.
+ *
+ * Design by Contract:
+ *   - Invariant: stored deltas are contiguous in age, oldest first
+ *   - Postcondition: restore(k) reproduces the k-th snapshot before the
+ *     newest byte for byte, for every k < size()
+ *   - No allocation after warm-up unless a snapshot outgrows earlier ones
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ByteStream.h"
+
+namespace qe {
+namespace core {
+
+/** Append the delta that turns `newer` back into `older`. */
+inline void xor_rle_encode(const uint8_t* older, size_t older_n, const uint8_t* newer,
+                           size_t newer_n, ByteWriter& out) {
+  auto x = [&](size_t i) -> uint8_t {
+    return static_cast<uint8_t>((i < older_n ? older[i] : 0) ^ (i < newer_n ? newer[i] : 0));
+  };
+  const size_t n = std::max(older_n, newer_n);
+  out.put_varint(older_n);
+  size_t i = 0;
+  while (i < n) {
+    size_t zeros = 0;
+    while (i < n && x(i) == 0) {
+      ++i;
+      ++zeros;
+    }
+    // A literal run ends at two zero bytes; a lone zero costs less inline
+    size_t lit_end = i;
+    while (lit_end < n && (x(lit_end) != 0 || (lit_end + 1 < n && x(lit_end + 1) != 0)))
+      ++lit_end;
+    out.put_varint(zeros);
+    out.put_varint(lit_end - i);
+    for (; i < lit_end; ++i)
+      out.put_u8(x(i));
+  }
+}
+
+/**
+ * Rebuild the older snapshot from `newer` and one delta into `out`.
+ * Returns false (out unspecified) when the delta is corrupt.
+ */
+inline bool xor_rle_apply(const uint8_t* newer, size_t newer_n, ByteReader& delta,
+                          std::vector<uint8_t>& out) {
+  const size_t older_n = static_cast<size_t>(delta.get_varint());
+  const size_t n = std::max(older_n, newer_n);
+  out.assign(newer, newer + newer_n);
+  out.resize(n, 0);
+  size_t i = 0;
+  while (i < n && delta.ok()) {
+    size_t zeros = static_cast<size_t>(delta.get_varint());
+    size_t lit = static_cast<size_t>(delta.get_varint());
+    if (zeros > n - i || lit > n - i - zeros)
+      return false;
+    i += zeros;
+    for (size_t end = i + lit; i < end; ++i)
+      out[i] ^= delta.get_u8();
+  }
+  out.resize(older_n);
+  return delta.ok();
+}
+
+class SnapshotRing {
+ public:
+  /** arena_bytes bounds the delta storage; max_snapshots bounds the count. */
+  explicit SnapshotRing(size_t arena_bytes = size_t{1} << 20, size_t max_snapshots = 1024)
+      : arena_(arena_bytes), entries_(std::max<size_t>(max_snapshots, 2) - 1) {}
+
+  /** Make `data` the newest snapshot; the previous newest becomes a delta. */
+  void push(const uint8_t* data, size_t n) {
+    if (has_head_) {
+      scratch_.clear();
+      xor_rle_encode(head_.data(), head_.size(), data, n, scratch_);
+      store(scratch_.data().data(), scratch_.size());
+    }
+    head_.assign(data, data + n);
+    has_head_ = true;
+  }
+  void push(const std::vector<uint8_t>& v) {
+    push(v.data(), v.size());
+  }
+
+  /** Snapshots available, the newest included. */
+  size_t size() const noexcept {
+    return has_head_ ? count_ + 1 : 0;
+  }
+
+  /** The newest snapshot (empty when size() == 0). */
+  const std::vector<uint8_t>& newest() const noexcept {
+    return head_;
+  }
+
+  /** Copy the snapshot `back` pushes before the newest into out. */
+  bool restore(size_t back, std::vector<uint8_t>& out) {
+    if (back >= size())
+      return false;
+    out = head_;
+    for (size_t k = 0; k < back; ++k) {
+      const Entry& e = entries_[slot(count_ - 1 - k)];
+      ByteReader delta(arena_.data() + e.offset, e.size);
+      work_.swap(out);
+      if (!xor_rle_apply(work_.data(), work_.size(), delta, out))
+        return false;
+    }
+    return true;
+  }
+
+  /** Drop the newest `back` snapshots so the one before them is newest. */
+  bool rewind(size_t back) {
+    if (back == 0)
+      return size() > 0;
+    if (!restore(back, rewound_))
+      return false;
+    head_.swap(rewound_);
+    count_ -= back;
+    write_ = count_ ? entries_[slot(count_ - 1)].offset + entries_[slot(count_ - 1)].size : 0;
+    if (!count_)
+      first_ = 0;
+    return true;
+  }
+
+  void clear() noexcept {
+    head_.clear();
+    has_head_ = false;
+    first_ = count_ = write_ = 0;
+  }
+
+  /** Arena bytes held by deltas (excluding the newest snapshot). */
+  size_t delta_bytes() const noexcept {
+    size_t total = 0;
+    for (size_t k = 0; k < count_; ++k)
+      total += entries_[slot(k)].size;
+    return total;
+  }
+
+ private:
+  struct Entry {
+    size_t offset = 0;
+    size_t size = 0;
+  };
+
+  std::vector<uint8_t> arena_;
+  std::vector<Entry> entries_;  // Ring of deltas, oldest at first_
+  size_t first_ = 0, count_ = 0;
+  size_t write_ = 0;  // Arena offset just past the newest delta
+  std::vector<uint8_t> head_;
+  bool has_head_ = false;
+  ByteWriter scratch_;
+  std::vector<uint8_t> work_, rewound_;
+
+  size_t slot(size_t age_index) const noexcept {
+    return (first_ + age_index) % entries_.size();
+  }
+
+  void drop_oldest() noexcept {
+    first_ = (first_ + 1) % entries_.size();
+    if (--count_ == 0)
+      first_ = write_ = 0;
+  }
+
+  void store(const uint8_t* bytes, size_t n) {
+    if (n > arena_.size()) {  // Cannot be kept: the history ends here
+      first_ = count_ = write_ = 0;
+      return;
+    }
+    if (count_ == entries_.size())
+      drop_oldest();
+    size_t off = write_;
+    if (off + n > arena_.size()) {
+      // Wrap; deltas still past write_ are the oldest ones
+      while (count_ && entries_[first_].offset >= write_)
+        drop_oldest();
+      off = 0;
+    }
+    while (count_ && entries_[first_].offset < off + n &&
+           off < entries_[first_].offset + entries_[first_].size)
+      drop_oldest();
+    std::copy(bytes, bytes + n, arena_.begin() + static_cast<std::ptrdiff_t>(off));
+    entries_[slot(count_)] = {off, n};
+    ++count_;
+    write_ = off + n;
+  }
+};
+
+}  // namespace core
+}  // namespace qe
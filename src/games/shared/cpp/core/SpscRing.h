@@ -0,0 +1,140 @@
+#pragma once
+/**
+ * @file SpscRing.h
+ * @brief Bounded lock-free queues for exactly one producer and one consumer.
+ *
+ *   - SpscRing<T, N>: fixed-capacity queue of items (commands, events)
+ *   - SpscBuffer<T>:  runtime-sized stream of values moved in bulk (PCM)
+ *
+ * Slots live in a power-of-two array (SpscBuffer allocates it once, up
+ * front). The producer owns tail_, the consumer owns head_; each publishes
+ * its index with a release store and reads the other's with an acquire
+ * load, so a slot's contents are visible before its index is. Neither side
+ * ever blocks or allocates, which makes both safe to use from a real-time
+ * thread such as the audio callback.
+ *
+ * Design by Contract:
+ *   - Precondition: push()/write() are only called from one thread,
+ *     pop()/read() from one (possibly different) thread
+ *   - Postcondition: items are popped in push order; push() on a full ring
+ *     and pop() on an empty one return false and change nothing
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace qe {
+namespace core {
+
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing: capacity must be a power of two");
+
+ public:
+  /** Producer side. False when the ring is full. */
+  bool push(const T& item) noexcept {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity)
+      return false;
+    slots_[tail & (Capacity - 1)] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Consumer side. False when the ring is empty. */
+  bool pop(T& item) noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    item = slots_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Items queued; exact only when neither side is running concurrently. */
+  size_t size() const noexcept {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  static constexpr size_t capacity() noexcept {
+    return Capacity;
+  }
+
+ private:
+  // Separate cache lines: each index is written by one thread only
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::array<T, Capacity> slots_{};
+};
+
+template <typename T>
+class SpscBuffer {
+ public:
+  /** Holds at least min_capacity values (rounded up to a power of two). */
+  explicit SpscBuffer(size_t min_capacity = 4096) {
+    size_t cap = 2;
+    while (cap < min_capacity)
+      cap <<= 1;
+    slots_.resize(cap);
+  }
+
+  /** Producer side. Copies up to n values; returns how many fit. */
+  size_t write(const T* src, size_t n) noexcept {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    n = std::min(n, slots_.size() - (tail - head_.load(std::memory_order_acquire)));
+    copy_in(tail, src, n);
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /** Consumer side. Copies up to n values; returns how many were queued. */
+  size_t read(T* dst, size_t n) noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    n = std::min(n, tail_.load(std::memory_order_acquire) - head);
+    copy_out(head, dst, n);
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /** Values queued; the consumer sees a lower bound while the producer runs. */
+  size_t readable() const noexcept {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  /** Free slots; the producer sees a lower bound while the consumer runs. */
+  size_t writable() const noexcept {
+    return slots_.size() - readable();
+  }
+
+  size_t capacity() const noexcept {
+    return slots_.size();
+  }
+
+ private:
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::vector<T> slots_;
+
+  void copy_in(size_t at, const T* src, size_t n) noexcept {
+    const size_t i = at & (slots_.size() - 1), first = std::min(n, slots_.size() - i);
+    std::copy(src, src + first, slots_.data() + i);
+    std::copy(src + first, src + n, slots_.data());
+  }
+
+  void copy_out(size_t at, T* dst, size_t n) const noexcept {
+    const size_t i = at & (slots_.size() - 1), first = std::min(n, slots_.size() - i);
+    std::copy(slots_.data() + i, slots_.data() + i + first, dst);
+    std::copy(slots_.data(), slots_.data() + (n - first), dst + first);
+  }
+};
+
+}  // namespace core
+}  // namespace qe
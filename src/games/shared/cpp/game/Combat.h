@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "../core/AABB.h"
+#include "../core/Counters.h"
 #include "../core/Entity.h"
 #include "../core/Projectile.h"
 #include "../math/Vec3.h"
@@ -90,6 +91,7 @@ inline void update_projectiles(std::vector<core::Projectile>& projectiles, float
   projectiles.erase(std::remove_if(projectiles.begin(), projectiles.end(),
                                    [](const core::Projectile& p) { return !p.is_alive(); }),
                     projectiles.end());
+  QE_COUNTER_SET("projectiles", projectiles.size());
 }
 
 /** Check projectile-entity AABB collisions. */
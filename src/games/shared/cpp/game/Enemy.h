@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../core/ByteStream.h"
 #include "../loader/HumanoidEnemy.h"
 #include "../math/Vec3.h"
 #include "../renderer/Shader.h"
@@ -17,31 +18,34 @@ enum class EnemyState {
 class Enemy {
  public:
   EnemyState state = EnemyState::Idle;
-  loader::HumanoidEnemy humanoid;
+  HumanoidEnemy humanoid;
   math::Vec3 velocity = {0, 0, 0};
   float speed = 2.0f;
   float state_timer = 0.0f;
+  bool sleeping = false;  // Frozen: update() is a no-op until woken
 
   Enemy(std::shared_ptr<loader::HumanoidRig> rig) {
     humanoid.set_rig(rig);
   }
 
   void update(float dt, const math::Vec3& player_pos) {
+    if (sleeping)
+      return;
     state_timer += dt;
 
-    loader::HumanoidEnemy::AnimState anim = loader::HumanoidEnemy::AnimState::Idle;
+    HumanoidEnemy::AnimState anim = HumanoidEnemy::AnimState::Idle;
 
     // Simple state machine
     switch (state) {
       case EnemyState::Idle:
-        anim = loader::HumanoidEnemy::AnimState::Idle;
+        anim = HumanoidEnemy::AnimState::Idle;
         if (state_timer > 3.0f) {
           state = EnemyState::Watch;
           state_timer = 0;
         }
         break;
       case EnemyState::Watch: {
-        anim = loader::HumanoidEnemy::AnimState::Idle;  // Or Walk if moving?
+        anim = HumanoidEnemy::AnimState::Idle;  // Or Walk if moving?
         // Look at player/ball
         auto dir = (player_pos - humanoid.transform.position()).normalized();
         float target_yaw = std::atan2(dir.x, -dir.z);
@@ -56,10 +60,10 @@ class Enemy {
         break;
       }
       case EnemyState::Panic:
-        anim = loader::HumanoidEnemy::AnimState::Panic;
+        anim = HumanoidEnemy::AnimState::Panic;
         break;
       case EnemyState::Celebrate:
-        anim = loader::HumanoidEnemy::AnimState::Panic;  // Celebrate looks like Panic for now
+        anim = HumanoidEnemy::AnimState::Panic;  // Celebrate looks like Panic for now
         break;
     }
 
@@ -70,6 +74,37 @@ class Enemy {
     humanoid.draw(shader);
   }
 
+  /** Bytes save_state() appends. */
+  static constexpr size_t kStateBytes = 4 + 1 + 16 * 4;
+
+  /** Append the simulation state (fixed size: 1 u32, 1 u8, 16 raw floats). */
+  void save_state(core::ByteWriter& out) const {
+    const auto& t = humanoid.transform;
+    out.put_u32(static_cast<uint32_t>(state));
+    out.put_u8(sleeping ? 1 : 0);
+    for (float v : {velocity.x, velocity.y, velocity.z, speed, state_timer, t.position().x,
+                    t.position().y, t.position().z, t.rotation().w, t.rotation().x,
+                    t.rotation().y, t.rotation().z, t.scale().x, t.scale().y, t.scale().z,
+                    humanoid.anim_time()})
+      out.put_f32(v);
+  }
+
+  /** Inverse of save_state(); the pose refreshes on the next update(). */
+  void restore_state(core::ByteReader& in) {
+    state = static_cast<EnemyState>(in.get_u32());
+    sleeping = in.get_u8() != 0;
+    velocity = {in.get_f32(), in.get_f32(), in.get_f32()};
+    speed = in.get_f32();
+    state_timer = in.get_f32();
+    math::Vec3 pos{in.get_f32(), in.get_f32(), in.get_f32()};
+    math::Quaternion rot{in.get_f32(), in.get_f32(), in.get_f32(), in.get_f32()};
+    math::Vec3 scl{in.get_f32(), in.get_f32(), in.get_f32()};
+    humanoid.transform.set_position(pos);
+    humanoid.transform.set_rotation(rot);
+    humanoid.transform.set_scale(scl);
+    humanoid.set_anim_time(in.get_f32());
+  }
+
   bool check_collision(const math::Vec3& sphere_pos, float sphere_radius, math::Vec3& out_normal,
                        float& out_depth) {
     // Simple Cylinder vs Sphere
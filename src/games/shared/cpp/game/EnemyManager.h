@@ -3,9 +3,14 @@
 #include <cmath>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "../core/AllocTracker.h"
+#include "../core/ByteStream.h"
+#include "../core/Counters.h"
+#include "../core/Profiler.h"
 #include "Enemy.h"
 
 namespace qe {
@@ -48,11 +53,31 @@ class EnemyManager {
     std::cout << "Spawned " << type << " at " << pos.x << "," << pos.z << "\n";
   }
 
+  /** Spawn a collision-only enemy with no rig (headless simulation). */
+  void spawn_proxy(const math::Vec3& pos) {
+    auto enemy = std::make_unique<Enemy>(nullptr);
+    enemy->humanoid.transform.set_position(pos);
+    enemies.push_back(std::move(enemy));
+  }
+
   void update(float dt, const math::Vec3& player_pos) {
+    QE_PROFILE_SCOPE("enemies");
+    QE_ALLOC_TAG(Enemies);
     for (auto& e : enemies) {
       // Update AI state
       e->update(dt, player_pos);
     }
+    QE_COUNTER_SET("enemies", enemies.size());
+  }
+
+  /** Freeze every enemy (AI and animation) until wake_all(). */
+  void sleep_all() {
+    for (auto& e : enemies)
+      e->sleeping = true;
+  }
+  void wake_all() {
+    for (auto& e : enemies)
+      e->sleeping = false;
   }
 
   void draw(renderer::Shader& shader) {
@@ -61,6 +86,33 @@ class EnemyManager {
     }
   }
 
+  /** Append every enemy's state (count first). */
+  void save_state(core::ByteWriter& out) const {
+    out.put_u32(static_cast<uint32_t>(enemies.size()));
+    for (const auto& e : enemies)
+      e->save_state(out);
+  }
+
+  /** Step over a save_state() record; false if it is truncated or for another enemy count. */
+  bool skip_state(core::ByteReader& in) const {
+    return in.get_u32() == enemies.size() && in.ok() &&
+           in.skip(enemies.size() * Enemy::kStateBytes);
+  }
+
+  /**
+   * Inverse of save_state(); false, touching nothing, if the enemy count
+   * differs or the record is truncated.
+   */
+  bool restore_state(core::ByteReader& in) {
+    core::ByteReader probe = in;
+    if (!skip_state(probe))
+      return false;
+    in.get_u32();
+    for (auto& e : enemies)
+      e->restore_state(in);
+    return in.ok();
+  }
+
   int check_collision(const math::Vec3& pos, float r, math::Vec3& normal) {
     float depth;
     for (auto& e : enemies) {
@@ -5,12 +5,26 @@
  *
  * Uses instanced rendering to draw thousands of particles efficiently.
  * Each particle is a small cube mesh drawn via glDrawElementsInstanced.
+ *
+ * Ground collision uses y = 0 unless a batch ground sampler is installed
+ * (e.g. terrain heights), which is queried once per update for all particles.
+ *
+ * Spawn jitter comes from a seeded xorshift generator whose state is saved
+ * with the particles (save_state / restore_state), so effects rewind and
+ * replay along with the rest of the world.
  */
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <random>
 #include <vector>
 
+#include "../core/AllocTracker.h"
+#include "../core/ByteStream.h"
+#include "../core/Counters.h"
+#include "../core/Profiler.h"
 #include "../math/Mat4.h"
 #include "../math/Vec3.h"
 #include "../renderer/Mesh.h"
@@ -30,6 +44,10 @@ struct Particle {
 
 class ParticleSystem {
  public:
+  /** Batch ground query: out[i] = ground height at (xs[i], zs[i]). */
+  using GroundSampler =
+      std::function<void(const float *xs, const float *zs, float *out, size_t n)>;
+
   std::vector<Particle> particles;
   std::shared_ptr<renderer::Mesh> particle_mesh;
 
@@ -42,33 +60,51 @@ class ParticleSystem {
                                      "shaders/particle_instanced.frag");
   }
 
+  /** Reseed the spawn jitter generator (0 is mapped to 1). */
+  void seed(uint32_t s) {
+    rng_ = s ? s : 1;
+  }
+
   void spawn(const math::Vec3 &pos, int count, const math::Vec3 &color) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    QE_ALLOC_TAG(Particles);
+    auto dis = [this] {  // Uniform in [-1, 1)
+      rng_ ^= rng_ << 13;
+      rng_ ^= rng_ >> 17;
+      rng_ ^= rng_ << 5;
+      return static_cast<float>(rng_ >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    };
 
     for (int i = 0; i < count; ++i) {
       Particle p;
       p.position = pos;
-      float vx = dis(gen), vy = dis(gen) + 2.0f, vz = dis(gen);
+      float vx = dis(), vy = dis() + 2.0f, vz = dis();
       float len = std::sqrt(vx * vx + vy * vy + vz * vz);
       if (len > 1e-6f) {
         vx /= len;
         vy /= len;
         vz /= len;
       }
-      float speed = dis(gen) + 2.0f;
+      float speed = dis() + 2.0f;
       p.velocity = math::Vec3(vx * speed, vy * speed, vz * speed);
       p.color = color;
-      p.life = 1.0f + dis(gen) * 0.5f;
+      p.life = 1.0f + dis() * 0.5f;
       p.max_life = p.life;
-      p.scale = 0.05f + dis(gen) * 0.02f;
+      p.scale = 0.05f + dis() * 0.02f;
       particles.push_back(p);
     }
   }
 
+  /** Install a batch ground sampler (empty function = flat ground at y = 0). */
+  void set_ground_sampler(GroundSampler sampler) {
+    ground_sampler_ = std::move(sampler);
+  }
+
   void update(float dt) {
-    for (auto it = particles.begin(); it != particles.end();) {
+    QE_PROFILE_SCOPE("particles");
+    QE_ALLOC_TAG(Particles);
+    sample_ground();
+    size_t i = 0;
+    for (auto it = particles.begin(); it != particles.end(); ++i) {
       it->life -= dt;
       if (it->life <= 0) {
         it = particles.erase(it);
@@ -76,8 +112,9 @@ class ParticleSystem {
         it->velocity.y -= 9.8f * dt;
         it->position = it->position + it->velocity * dt;
 
-        if (it->position.y < 0) {
-          it->position.y = 0;
+        float ground = ground_y_.empty() ? 0.0f : ground_y_[i];
+        if (it->position.y < ground) {
+          it->position.y = ground;
           it->velocity.y *= -0.5f;
           it->velocity.x *= 0.8f;
           it->velocity.z *= 0.8f;
@@ -85,6 +122,41 @@ class ParticleSystem {
         ++it;
       }
     }
+    QE_COUNTER_SET("particles", particles.size());
+  }
+
+  /** Append the generator state and every particle (12 raw floats each). */
+  void save_state(core::ByteWriter &out) const {
+    out.put_u32(rng_);
+    out.put_u32(static_cast<uint32_t>(particles.size()));
+    for (const auto &p : particles) {
+      for (float v : {p.position.x, p.position.y, p.position.z, p.velocity.x, p.velocity.y,
+                      p.velocity.z, p.color.x, p.color.y, p.color.z, p.life, p.max_life, p.scale})
+        out.put_f32(v);
+    }
+  }
+
+  /** Step over a save_state() record; false if it is truncated. */
+  bool skip_state(core::ByteReader &in) const {
+    in.get_u32();
+    const uint32_t n = in.get_u32();
+    return in.ok() && in.skip(n * 12 * sizeof(float));
+  }
+
+  /** Inverse of save_state(); false, touching nothing, if the stream ends early. */
+  bool restore_state(core::ByteReader &in) {
+    core::ByteReader probe = in;
+    if (!skip_state(probe))
+      return false;
+    rng_ = in.get_u32();
+    particles.resize(in.get_u32());
+    for (auto &p : particles) {
+      for (float *v : {&p.position.x, &p.position.y, &p.position.z, &p.velocity.x, &p.velocity.y,
+                       &p.velocity.z, &p.color.x, &p.color.y, &p.color.z, &p.life, &p.max_life,
+                       &p.scale})
+        *v = in.get_f32();
+    }
+    return in.ok();
   }
 
   void draw(const math::Mat4 &view_proj) {
@@ -128,6 +200,8 @@ class ParticleSystem {
   // Mat4 column stride for instanced vertex attributes (4 floats per column)
   static constexpr size_t kMat4ColStride = sizeof(float) * 4;
 
+  uint32_t rng_ = 0x9E3779B9u;  // xorshift32 state for spawn jitter
+
   GLuint instance_vbo_model_ = 0;
   GLuint instance_vbo_color_ = 0;
   bool instancing_initialized_ = false;
@@ -136,6 +210,25 @@ class ParticleSystem {
   std::vector<math::Mat4> draw_models_;
   std::vector<math::Vec3> draw_colors_;
 
+  // Ground heights under each particle (sampled at the start of update)
+  GroundSampler ground_sampler_;
+  std::vector<float> ground_xs_, ground_zs_, ground_y_;
+
+  void sample_ground() {
+    ground_y_.clear();
+    if (!ground_sampler_ || particles.empty())
+      return;
+    size_t n = particles.size();
+    ground_xs_.resize(n);
+    ground_zs_.resize(n);
+    ground_y_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      ground_xs_[i] = particles[i].position.x;
+      ground_zs_[i] = particles[i].position.z;
+    }
+    ground_sampler_(ground_xs_.data(), ground_zs_.data(), ground_y_.data(), n);
+  }
+
   void setup_instancing() {
     if (instancing_initialized_ || !particle_mesh)
       return;
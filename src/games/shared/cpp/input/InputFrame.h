@@ -0,0 +1,75 @@
+#pragma once
+/**
+ * @file InputFrame.h
+ * @brief One frame of resolved input — axes and button edges, no SDL.
+ *
+ * InputManager::poll() folds keyboard, mouse and gamepad into an
+ * InputFrame; every query reads from it. Because the frame is plain data it
+ * can be recorded, compared and fed back in for replays.
+ *
+ * Design by Contract:
+ *   - Invariant: move axes in [-1, 1]; look/zoom are unbounded deltas
+ *   - Invariant: *Pressed bits are set for exactly one frame per press
+ */
+
+#include <cstdint>
+
+namespace qe {
+namespace input {
+
+/** Digital inputs as bits of InputFrame::buttons. */
+enum InputButton : uint32_t {
+  kSprint = 1u << 0,
+  kShootHeld = 1u << 1,
+  kShootPressed = 1u << 2,
+  kToggleCamera = 1u << 3,
+  kToggleWireframe = 1u << 4,
+  kReset = 1u << 5,
+  kSlerpOff = 1u << 6,
+  kSlerpOn = 1u << 7,
+  kQuit = 1u << 8,
+};
+
+/** Buttons that are one-frame edges rather than held state. */
+constexpr uint32_t kEdgeButtons = kShootPressed | kToggleCamera | kToggleWireframe | kReset |
+                                  kSlerpOff | kSlerpOn | kQuit;
+
+struct InputFrame {
+  static constexpr int kAxes = 6;
+
+  // move_forward, move_right, move_up, look_x, look_y, zoom
+  float axes[kAxes] = {0, 0, 0, 0, 0, 0};
+  uint32_t buttons = 0;
+
+  float move_forward() const {
+    return axes[0];
+  }
+  float move_right() const {
+    return axes[1];
+  }
+  float move_up() const {
+    return axes[2];
+  }
+  float look_x() const {
+    return axes[3];
+  }
+  float look_y() const {
+    return axes[4];
+  }
+  float zoom() const {
+    return axes[5];
+  }
+  bool has(InputButton b) const {
+    return (buttons & b) != 0;
+  }
+  /** True if any axis is off zero or any button is set. */
+  bool any() const {
+    for (float a : axes)
+      if (a != 0.0f)
+        return true;
+    return buttons != 0;
+  }
+};
+
+}  // namespace input
+}  // namespace qe
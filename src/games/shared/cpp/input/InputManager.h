@@ -3,6 +3,18 @@
  * @file InputManager.h
  * @brief Unified input manager — keyboard, mouse, and gamepad in one interface.
  *
+ * poll() resolves every device into one InputFrame (see InputFrame.h) and
+ * the queries below read from it, so pressed-edges are computed once per
+ * frame however often they are queried. set_frame() substitutes a recorded
+ * frame for replay playback.
+ *
+ * Mouse motion and wheel events also go into an InputTimeline with their
+ * SDL timestamps. A fixed-step sim calls tick_frame() once per tick to get
+ * only the motion stamped before that tick ends, with each poll's button
+ * edges delivered to exactly one tick; late_latch() pulls motion that
+ * arrived during the frame just before rendering, and mark_presented()
+ * after the swap records input-to-present latency.
+ *
  * Design by Contract:
  *   - Precondition: SDL must be initialized before construction
  *   - Invariant: movement axes always normalized to [-1, 1]
@@ -21,6 +33,8 @@
 #include <SDL.h>
 
 #include "Gamepad.h"
+#include "InputFrame.h"
+#include "InputTimeline.h"
 
 namespace qe {
 namespace input {
@@ -33,6 +47,13 @@ class InputManager {
   void init() {
     SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER);
     gamepad_.open();
+    // Put the performance counter on the event timestamp timebase
+    clock_offset_ = SDL_GetTicks() * 1e-3 - counter_seconds();
+  }
+
+  /** Seconds on the event timestamp clock, at performance-counter resolution. */
+  double clock() const {
+    return counter_seconds() + clock_offset_;
   }
 
   /** Reset per-frame state. Call at start of each frame. */
@@ -50,17 +71,30 @@ class InputManager {
     if (gamepad_.handle_event(event))
       return true;
 
+    InputSample s;
+    s.time = event.common.timestamp * 1e-3;
     switch (event.type) {
       case SDL_MOUSEMOTION:
         mouse_dx_ += static_cast<float>(event.motion.xrel);
         mouse_dy_ += static_cast<float>(event.motion.yrel);
+        s.dx = static_cast<float>(event.motion.xrel);
+        s.dy = static_cast<float>(event.motion.yrel);
+        timeline_.push(s);
         return true;
 
       case SDL_MOUSEWHEEL:
         scroll_ += static_cast<float>(event.wheel.y);
+        s.wheel = static_cast<float>(event.wheel.y);
+        timeline_.push(s);
         return true;
 
+      case SDL_KEYDOWN:
+        if (!event.key.repeat)
+          timeline_.push(s);  // No delta, but its latency counts
+        return false;
+
       case SDL_MOUSEBUTTONDOWN:
+        timeline_.push(s);
         if (event.button.button == SDL_BUTTON_LEFT) {
           shoot_held_ = true;
           shoot_pressed_ = true;
@@ -79,101 +113,158 @@ class InputManager {
     }
   }
 
-  /** Poll keyboard and gamepad state. Call after processing events. */
+  /** Poll keyboard and gamepad state and resolve the frame. Call after events. */
   void poll() {
     keys_ = SDL_GetKeyboardState(nullptr);
     gamepad_.poll();
+    frame_ = resolve();
+    pending_edges_ |= frame_.buttons & kEdgeButtons;
+  }
+
+  /**
+   * Input for one sim tick of dt seconds ending at tick_end (clock()
+   * time): held state from the last poll(), motion stamped up to tick_end,
+   * stick look scaled to the tick's length and any button edges not yet
+   * given to a tick. Returns the frame without installing it.
+   */
+  InputFrame tick_frame(double tick_end, float dt) {
+    InputFrame f = frame_;
+    const InputSample s = timeline_.take_until(tick_end);
+    const float rate = dt * kStickReferenceHz;
+    f.axes[3] = s.dx + stick_look_[0] * rate;
+    f.axes[4] = s.dy + stick_look_[1] * rate;
+    f.axes[5] = s.wheel + dpad_zoom_ * rate;
+    f.buttons = (frame_.buttons & ~kEdgeButtons) | pending_edges_;
+    pending_edges_ = 0;
+    return f;
+  }
+
+  /**
+   * Pull mouse motion that arrived since the events were handled and
+   * return all motion no tick has consumed yet, for the renderer to apply
+   * to the view it is about to draw. The sim still gets it next frame.
+   */
+  InputSample late_latch() {
+    SDL_PumpEvents();
+    SDL_Event events[64];
+    int n;
+    while ((n = SDL_PeepEvents(events, 64, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION)) > 0)
+      for (int i = 0; i < n; ++i) {
+        InputSample s;
+        s.time = events[i].common.timestamp * 1e-3;
+        s.dx = static_cast<float>(events[i].motion.xrel);
+        s.dy = static_cast<float>(events[i].motion.yrel);
+        timeline_.push(s);
+      }
+    return timeline_.pending();
+  }
+
+  /**
+   * Drop queued motion and button edges that no tick will consume, e.g.
+   * while a replay or a rewind drives the sim, so the first live tick
+   * afterwards does not get the whole backlog.
+   */
+  void drop_pending() {
+    timeline_.clear();
+    pending_edges_ = 0;
+  }
+
+  /**
+   * Call right after presenting a frame; feeds latency(). Returns that
+   * frame's latency in seconds, or a negative value if it showed no new input.
+   */
+  double mark_presented() {
+    return timeline_.present(clock());
+  }
+
+  /** Age of the oldest input each presented frame showed for the first time. */
+  const LatencyStats& latency() const noexcept {
+    return timeline_.latency();
+  }
+
+  /** This frame's resolved input (what a replay records). */
+  const InputFrame& frame() const noexcept {
+    return frame_;
+  }
+
+  /** Replace this frame's input, e.g. from a replay. The next poll() overwrites it. */
+  void set_frame(const InputFrame& f) noexcept {
+    frame_ = f;
   }
 
   // --- Unified Queries (keyboard + gamepad combined) ---
 
   /** Forward/backward axis [-1, 1]. W/S or left stick Y. */
   float move_forward() const {
-    float kb = key_axis(SDL_SCANCODE_W, SDL_SCANCODE_S);
-    float gp = -gamepad_.left_stick().y;  // SDL Y is inverted
-    return clamp_sum(kb, gp);
+    return frame_.move_forward();
   }
 
   /** Right/left strafe axis [-1, 1]. D/A or left stick X. */
   float move_right() const {
-    float kb = key_axis(SDL_SCANCODE_D, SDL_SCANCODE_A);
-    float gp = gamepad_.left_stick().x;
-    return clamp_sum(kb, gp);
+    return frame_.move_right();
   }
 
   /** Up/down axis [-1, 1]. Space/C or bumpers. */
   float move_up() const {
-    float kb = key_axis(SDL_SCANCODE_SPACE, SDL_SCANCODE_C);
-    float gp = 0.0f;
-    if (gamepad_.button_held(Gamepad::Button::LeftBumper))
-      gp -= 1.0f;
-    if (gamepad_.button_held(Gamepad::Button::RightBumper))
-      gp += 1.0f;
-    return clamp_sum(kb, gp);
+    return frame_.move_up();
   }
 
   /** Mouse look delta X (pixels). Combined with right stick X. */
   float look_x() const {
-    return mouse_dx_ + gamepad_.right_stick().x * gamepad_look_speed_;
+    return frame_.look_x();
   }
 
   /** Mouse look delta Y (pixels). Combined with right stick Y. */
   float look_y() const {
-    return mouse_dy_ + gamepad_.right_stick().y * gamepad_look_speed_;
+    return frame_.look_y();
   }
 
   /** Zoom delta (scroll wheel + D-pad up/down). */
   float zoom() const {
-    float gp = 0.0f;
-    if (gamepad_.button_held(Gamepad::Button::DPadUp))
-      gp += 1.0f;
-    if (gamepad_.button_held(Gamepad::Button::DPadDown))
-      gp -= 1.0f;
-    return scroll_ + gp;
+    return frame_.zoom();
   }
 
   /** Sprint: Left Shift or left stick click. */
   bool sprint() const {
-    return key_held(SDL_SCANCODE_LSHIFT) || gamepad_.button_held(Gamepad::Button::LeftStick);
+    return frame_.has(kSprint);
   }
 
   /** Shoot: Left Click or right trigger. */
   bool shoot_held() const {
-    return shoot_held_ || gamepad_.triggers().right > 0.5f;
+    return frame_.has(kShootHeld);
   }
 
   bool shoot_pressed() const {
-    return shoot_pressed_ || gamepad_.button_pressed(Gamepad::Button::A);
+    return frame_.has(kShootPressed);
   }
 
   /** Toggle camera: Tab or Y button. */
   bool toggle_camera() const {
-    return key_pressed(SDL_SCANCODE_TAB) || gamepad_.button_pressed(Gamepad::Button::Y);
+    return frame_.has(kToggleCamera);
   }
 
   /** Wireframe: F or X button. */
   bool toggle_wireframe() const {
-    return key_pressed(SDL_SCANCODE_F) || gamepad_.button_pressed(Gamepad::Button::X);
+    return frame_.has(kToggleWireframe);
   }
 
   /** Reset: R or Back button. */
   bool reset() const {
-    return key_pressed(SDL_SCANCODE_R) || gamepad_.button_pressed(Gamepad::Button::Back);
+    return frame_.has(kReset);
   }
 
   /** SLERP off: 1 key, SLERP on: 2 key (or D-pad left/right). */
   bool slerp_off() const {
-    return key_pressed(SDL_SCANCODE_1) || gamepad_.button_pressed(Gamepad::Button::DPadLeft);
+    return frame_.has(kSlerpOff);
   }
 
   bool slerp_on() const {
-    return key_pressed(SDL_SCANCODE_2) || gamepad_.button_pressed(Gamepad::Button::DPadRight);
+    return frame_.has(kSlerpOn);
   }
 
   /** Quit: Escape or Start + Back. */
   bool quit() const {
-    return key_pressed(SDL_SCANCODE_ESCAPE) || (gamepad_.button_held(Gamepad::Button::Start) &&
-                                                gamepad_.button_held(Gamepad::Button::Back));
+    return frame_.has(kQuit);
   }
 
   // --- Direct Access ---
@@ -200,19 +291,78 @@ class InputManager {
   bool shoot_released_ = false;
 
   float gamepad_look_speed_ = 5.0f;
+  InputFrame frame_;
+
+  // Per-tick input (tick_frame())
+  static constexpr float kStickReferenceHz = 60.0f;  // Stick speeds are per 1/60 s
+  InputTimeline timeline_;
+  uint32_t pending_edges_ = 0;
+  float stick_look_[2] = {0.0f, 0.0f};
+  float dpad_zoom_ = 0.0f;
+  double clock_offset_ = 0.0;
+
+  static double counter_seconds() {
+    return static_cast<double>(SDL_GetPerformanceCounter()) /
+           static_cast<double>(SDL_GetPerformanceFrequency());
+  }
 
   // Previous-frame key state for edge detection
-  mutable Uint8 prev_keys_[SDL_NUM_SCANCODES] = {};
+  Uint8 prev_keys_[SDL_NUM_SCANCODES] = {};
+
+  InputFrame resolve() {
+    InputFrame f;
+    f.axes[0] = clamp_sum(key_axis(SDL_SCANCODE_W, SDL_SCANCODE_S),
+                          -gamepad_.left_stick().y);  // SDL Y is inverted
+    f.axes[1] = clamp_sum(key_axis(SDL_SCANCODE_D, SDL_SCANCODE_A), gamepad_.left_stick().x);
+    float bumpers = 0.0f;
+    if (gamepad_.button_held(Gamepad::Button::LeftBumper))
+      bumpers -= 1.0f;
+    if (gamepad_.button_held(Gamepad::Button::RightBumper))
+      bumpers += 1.0f;
+    f.axes[2] = clamp_sum(key_axis(SDL_SCANCODE_SPACE, SDL_SCANCODE_C), bumpers);
+    stick_look_[0] = gamepad_.right_stick().x * gamepad_look_speed_;
+    stick_look_[1] = gamepad_.right_stick().y * gamepad_look_speed_;
+    f.axes[3] = mouse_dx_ + stick_look_[0];
+    f.axes[4] = mouse_dy_ + stick_look_[1];
+    dpad_zoom_ = 0.0f;
+    if (gamepad_.button_held(Gamepad::Button::DPadUp))
+      dpad_zoom_ += 1.0f;
+    if (gamepad_.button_held(Gamepad::Button::DPadDown))
+      dpad_zoom_ -= 1.0f;
+    f.axes[5] = scroll_ + dpad_zoom_;
+
+    auto set = [&f](InputButton b, bool on) {
+      if (on)
+        f.buttons |= b;
+    };
+    set(kSprint,
+        key_held(SDL_SCANCODE_LSHIFT) || gamepad_.button_held(Gamepad::Button::LeftStick));
+    set(kShootHeld, shoot_held_ || gamepad_.triggers().right > 0.5f);
+    set(kShootPressed, shoot_pressed_ || gamepad_.button_pressed(Gamepad::Button::A));
+    set(kToggleCamera,
+        key_pressed(SDL_SCANCODE_TAB) || gamepad_.button_pressed(Gamepad::Button::Y));
+    set(kToggleWireframe,
+        key_pressed(SDL_SCANCODE_F) || gamepad_.button_pressed(Gamepad::Button::X));
+    set(kReset, key_pressed(SDL_SCANCODE_R) || gamepad_.button_pressed(Gamepad::Button::Back));
+    set(kSlerpOff,
+        key_pressed(SDL_SCANCODE_1) || gamepad_.button_pressed(Gamepad::Button::DPadLeft));
+    set(kSlerpOn,
+        key_pressed(SDL_SCANCODE_2) || gamepad_.button_pressed(Gamepad::Button::DPadRight));
+    set(kQuit, key_pressed(SDL_SCANCODE_ESCAPE) ||
+                   (gamepad_.button_held(Gamepad::Button::Start) &&
+                    gamepad_.button_held(Gamepad::Button::Back)));
+    return f;
+  }
 
   bool key_held(SDL_Scancode sc) const {
     return keys_ && keys_[sc];
   }
 
-  bool key_pressed(SDL_Scancode sc) const {
+  /** Edge test; called once per scancode per poll(). */
+  bool key_pressed(SDL_Scancode sc) {
     bool current = keys_ && keys_[sc];
     bool prev = prev_keys_[sc];
-    // Update prev (mutable) - slight hack but avoids separate begin_frame
-    const_cast<Uint8*>(prev_keys_)[sc] = current ? 1 : 0;
+    prev_keys_[sc] = current ? 1 : 0;
     return current && !prev;
   }
 
@@ -0,0 +1,149 @@
+#pragma once
+/**
+ * @file InputTimeline.h
+ * @brief Timestamped relative input, consumed per simulation tick — no SDL.
+ *
+ * Mouse motion and wheel events are kept with the time they happened
+ * instead of being summed into one per-frame delta. A fixed-step sim takes
+ * each tick's share with take_until(tick_end), so a frame that runs
+ * several ticks spreads the motion over them the way it arrived; whatever
+ * arrived after the last tick stays queued for the next frame. The
+ * renderer can fold that remainder (pending()) into the view just before
+ * drawing, which is the late latch.
+ *
+ * present() is called once a frame has been submitted: every sample
+ * pushed so far is on screen, and the age of the oldest one that was not
+ * yet is that frame's input latency, kept in LatencyStats.
+ *
+ * Times are seconds on any one monotonic clock (InputManager uses SDL's
+ * event timestamps).
+ *
+ * Design by Contract:
+ *   - Precondition: push() with non-decreasing times (earlier ones are
+ *     treated as arriving at the latest time seen)
+ *   - Postcondition: every pushed delta is returned by exactly one
+ *     take_until(), unless clear() drops it first
+ *   - Postcondition: fewer than kCompactAt taken samples stay stored
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace qe {
+namespace input {
+
+/** Relative input at one instant; also used for sums over an interval. */
+struct InputSample {
+  double time = 0.0;           // Seconds
+  float dx = 0.0f, dy = 0.0f;  // Mouse motion (pixels)
+  float wheel = 0.0f;
+};
+
+/** Input-to-present latency in milliseconds. */
+struct LatencyStats {
+  float last_ms = 0.0f;
+  float avg_ms = 0.0f;  // Exponential moving average
+  float max_ms = 0.0f;
+  uint32_t frames = 0;  // Presented frames that carried new input
+
+  void add(float ms) {
+    last_ms = ms;
+    avg_ms = frames == 0 ? ms : avg_ms + (ms - avg_ms) * 0.1f;
+    max_ms = std::max(max_ms, ms);
+    ++frames;
+  }
+};
+
+class InputTimeline {
+ public:
+  void push(InputSample s) {
+    s.time = std::max(s.time, latest_);
+    latest_ = s.time;
+    samples_.push_back(s);
+    if (unpresented_ < 0.0)
+      unpresented_ = s.time;
+  }
+
+  /** Sum and remove the samples stamped at or before t; the sum is stamped t. */
+  InputSample take_until(double t) {
+    InputSample sum;
+    sum.time = t;
+    size_t i = head_;
+    for (; i < samples_.size() && samples_[i].time <= t; ++i)
+      add(sum, samples_[i]);
+    head_ = i;
+    // Drop what was taken; both keep capacity, so steady state does not
+    // allocate even when a newer sample is always still queued
+    if (head_ == samples_.size()) {
+      samples_.clear();
+      head_ = 0;
+    } else if (head_ >= kCompactAt) {
+      samples_.erase(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(head_));
+      head_ = 0;
+    }
+    return sum;
+  }
+
+  /** Sum of the samples not yet taken (time = the newest one's). */
+  InputSample pending() const {
+    InputSample sum;
+    for (size_t i = head_; i < samples_.size(); ++i)
+      add(sum, samples_[i]);
+    sum.time = latest_;
+    return sum;
+  }
+
+  /**
+   * A frame showing every sample so far was presented at `now`. Returns
+   * the age in seconds of the oldest sample it showed for the first time,
+   * or a negative value when it showed no new input.
+   */
+  double present(double now) {
+    if (unpresented_ < 0.0)
+      return -1.0;
+    const double age = std::max(now - unpresented_, 0.0);
+    unpresented_ = -1.0;
+    latency_.add(static_cast<float>(age * 1000.0));
+    return age;
+  }
+
+  const LatencyStats& latency() const noexcept {
+    return latency_;
+  }
+
+  /** Samples not yet taken. */
+  size_t size() const noexcept {
+    return samples_.size() - head_;
+  }
+
+  /** Samples held, taken ones not yet erased included. */
+  size_t stored() const noexcept {
+    return samples_.size();
+  }
+
+  void clear() {
+    samples_.clear();
+    head_ = 0;
+    unpresented_ = -1.0;
+  }
+
+ private:
+  static constexpr size_t kCompactAt = 256;  // Taken samples kept before erasing them
+
+  std::vector<InputSample> samples_;
+  size_t head_ = 0;            // First sample not yet taken
+  double latest_ = 0.0;        // Newest time pushed
+  double unpresented_ = -1.0;  // Oldest time not yet presented (-1 = none)
+  LatencyStats latency_;
+
+  static void add(InputSample& sum, const InputSample& s) {
+    sum.dx += s.dx;
+    sum.dy += s.dy;
+    sum.wheel += s.wheel;
+  }
+};
+
+}  // namespace input
+}  // namespace qe
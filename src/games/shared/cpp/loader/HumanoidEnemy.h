@@ -6,18 +6,12 @@
 #include <stdexcept>
 #include <vector>
 
+#include "../core/Contracts.h"
 #include "../core/Transform.h"
 #include "../math/Mat4.h"
 #include "../renderer/Shader.h"
 #include "HumanoidRig.h"
 
-// DbC macro — throws std::invalid_argument on validation failure
-#define QE_REQUIRE(cond, msg)           \
-  do {                                  \
-    if (!(cond))                        \
-      throw std::invalid_argument(msg); \
-  } while (0)
-
 namespace qe {
 namespace game {
 
@@ -111,6 +105,14 @@ class HumanoidEnemy {
     return rig_ != nullptr;
   }
 
+  /** Animation clock (seconds); joint poses are recomputed from it by update(). */
+  float anim_time() const noexcept {
+    return anim_time_;
+  }
+  void set_anim_time(float t) noexcept {
+    anim_time_ = t;
+  }
+
  private:
   std::shared_ptr<loader::HumanoidRig> rig_;
   std::vector<NodeState> states_;
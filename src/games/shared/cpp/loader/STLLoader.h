@@ -34,16 +34,10 @@
 #include <utility>
 #include <vector>
 
+#include "../core/Contracts.h"
 #include "../math/Vec3.h"
 #include "../renderer/Mesh.h"
 
-// DbC macro — throws std::invalid_argument on validation failure
-#define QE_REQUIRE(cond, msg)           \
-  do {                                  \
-    if (!(cond))                        \
-      throw std::invalid_argument(msg); \
-  } while (0)
-
 namespace qe {
 namespace loader {
 
@@ -186,6 +186,22 @@ class Camera {
     return projection_matrix() * view_matrix();
   }
 
+  /**
+   * vp_matrix() as if process_mouse(dx, dy) had already run, for a
+   * late-latched render of mouse motion the simulation has not consumed
+   * yet. The camera itself is unchanged. Third-person views ignore it.
+   */
+  math::Mat4 vp_matrix_latched(float dx, float dy) const {
+    if (mode_ != CameraMode::FirstPerson || (dx == 0.0f && dy == 0.0f))
+      return vp_matrix();
+    Camera latched = *this;
+    latched.process_mouse_fps(dx, dy);
+    // Turn the displayed orientation by what the target just turned by
+    math::Quaternion turn = latched.target_orientation_ * target_orientation_.conjugate();
+    latched.current_orientation_ = (turn * current_orientation_).normalized();
+    return latched.vp_matrix();
+  }
+
   // --- Accessors ---
 
   math::Vec3 position() const noexcept {
@@ -236,6 +252,21 @@ class Camera {
     return velocity_.length();
   }
 
+  /**
+   * True when movement has stopped and smoothing has converged, so update()
+   * would leave the view unchanged (render-on-demand loops can skip frames).
+   * eps bounds speed (m/s) and remaining TPS position error (m).
+   */
+  bool at_rest(float eps = 1e-3f) const noexcept {
+    constexpr float kSameOrientation = 0.9999999f;  // |dot| of ~1 mrad apart
+    if (velocity_.length_squared() > eps * eps)
+      return false;
+    if (mode_ == CameraMode::FirstPerson)
+      return std::fabs(current_orientation_.dot(target_orientation_)) >= kSameOrientation;
+    return (tps_current_pos_ - tps_goal_).length_squared() <= eps * eps &&
+           std::fabs(current_orientation_.dot(tps_goal_orientation_)) >= kSameOrientation;
+  }
+
  private:
   CameraMode mode_ = CameraMode::FirstPerson;
 
@@ -255,6 +286,8 @@ class Camera {
   // TPS state
   math::Vec3 tps_target_{0.0f, 1.0f, 0.0f};
   math::Vec3 tps_current_pos_{0.0f, 3.0f, 6.0f};
+  math::Vec3 tps_goal_{0.0f, 3.0f, 6.0f};  // Where smoothing is heading (at_rest)
+  math::Quaternion tps_goal_orientation_ = math::Quaternion::identity();
   float orbit_yaw_ = 0.0f;
   float orbit_pitch_ = 0.3f;  // Slight downward look
 
@@ -326,6 +359,7 @@ class Camera {
     // Smooth camera position (LERP for position)
     float pos_t = 1.0f - std::pow(config.orbit_smoothing, dt * 60.0f);
     tps_current_pos_ = tps_current_pos_.lerp(target_pos, pos_t);
+    tps_goal_ = target_pos;
 
     // Look at target — build orientation quaternion
     math::Vec3 look_dir = (tps_target_ - tps_current_pos_);
@@ -333,6 +367,7 @@ class Camera {
       look_dir = look_dir.normalized();
       math::Quaternion target_orient =
           math::Quaternion::from_two_vectors(math::Vec3::forward(), look_dir);
+      tps_goal_orientation_ = target_orient;
 
       // SLERP the orientation for smooth look transitions
       float orient_t = 1.0f - std::pow(config.orbit_smoothing * 0.5f, dt * 60.0f);
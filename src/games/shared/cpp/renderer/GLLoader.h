@@ -9,6 +9,7 @@
  *   - Buffers (VAO, VBO, EBO)
  *   - Drawing (drawElements, drawArrays)
  *   - State (viewport, clear, enable, blend)
+ *   - Timer queries (optional: null when the driver lacks them)
  *
  * Usage:
  *   // After creating SDL GL context:
@@ -17,6 +18,7 @@
 
 // cstddef is needed for ptrdiff_t (GLsizeiptr) regardless of SDL.
 #include <cstddef>
+#include <cstdint>
 
 // SDL is only needed for the runtime GL loader function.
 // When compiling tests without SDL, define QE_NO_SDL before including this
@@ -35,6 +37,9 @@ using GLenum = unsigned int;
 using GLfloat = float;
 using GLbitfield = unsigned int;
 using GLsizeiptr = ptrdiff_t;
+using GLintptr = ptrdiff_t;
+using GLint64 = int64_t;
+using GLuint64 = uint64_t;
 using GLvoid = void;
 
 // ── OpenGL Constants ────────────────────────────────────────────────────────
@@ -66,6 +71,7 @@ constexpr GLenum GL_LINES = 0x0001;
 // Data types
 constexpr GLenum GL_FLOAT = 0x1406;
 constexpr GLenum GL_UNSIGNED_INT = 0x1405;
+constexpr GLenum GL_UNSIGNED_SHORT = 0x1403;
 constexpr GLenum GL_UNSIGNED_BYTE = 0x1401;
 
 // Shader types
@@ -112,6 +118,12 @@ constexpr GLenum GL_VERSION = 0x1F02;
 constexpr GLenum GL_RENDERER = 0x1F01;
 constexpr GLenum GL_VENDOR = 0x1F00;
 
+// Timer queries
+constexpr GLenum GL_TIMESTAMP = 0x8E28;
+constexpr GLenum GL_QUERY_COUNTER_BITS = 0x8864;
+constexpr GLenum GL_QUERY_RESULT = 0x8866;
+constexpr GLenum GL_QUERY_RESULT_AVAILABLE = 0x8867;
+
 // ── Function Pointer Typedefs ───────────────────────────────────────────────
 // Using C calling convention (APIENTRY on Windows = __stdcall)
 #ifdef _WIN32
@@ -167,6 +179,7 @@ using PFNGLDELETEVERTEXARRAYSPROC = void(QE_APIENTRY *)(GLsizei, const GLuint *)
 using PFNGLGENBUFFERSPROC = void(QE_APIENTRY *)(GLsizei, GLuint *);
 using PFNGLBINDBUFFERPROC = void(QE_APIENTRY *)(GLenum, GLuint);
 using PFNGLBUFFERDATAPROC = void(QE_APIENTRY *)(GLenum, GLsizeiptr, const void *, GLenum);
+using PFNGLBUFFERSUBDATAPROC = void(QE_APIENTRY *)(GLenum, GLintptr, GLsizeiptr, const void *);
 using PFNGLDELETEBUFFERSPROC = void(QE_APIENTRY *)(GLsizei, const GLuint *);
 using PFNGLENABLEVERTEXATTRIBARRAYPROC = void(QE_APIENTRY *)(GLuint);
 using PFNGLVERTEXATTRIBPOINTERPROC = void(QE_APIENTRY *)(GLuint, GLint, GLenum, GLboolean, GLsizei,
@@ -176,6 +189,8 @@ using PFNGLVERTEXATTRIBDIVISORPROC = void(QE_APIENTRY *)(GLuint, GLuint);
 // Instanced drawing
 using PFNGLDRAWELEMENTSINSTANCEDPROC = void(QE_APIENTRY *)(GLenum, GLsizei, GLenum, const void *,
                                                            GLsizei);
+using PFNGLDRAWELEMENTSBASEVERTEXPROC = void(QE_APIENTRY *)(GLenum, GLsizei, GLenum, const void *,
+                                                            GLint);
 
 // Texture functions
 using PFNGLGENTEXTURESPROC = void(QE_APIENTRY *)(GLsizei, GLuint *);
@@ -188,6 +203,15 @@ using PFNGLGENERATEMIPMAPPROC = void(QE_APIENTRY *)(GLenum);
 using PFNGLDELETETEXTURESPROC = void(QE_APIENTRY *)(GLsizei, const GLuint *);
 using PFNGLUNIFORM1IPROC = void(QE_APIENTRY *)(GLint, GLint);
 
+// Timer queries (GL 3.3 / ARB_timer_query)
+using PFNGLGENQUERIESPROC = void(QE_APIENTRY *)(GLsizei, GLuint *);
+using PFNGLDELETEQUERIESPROC = void(QE_APIENTRY *)(GLsizei, const GLuint *);
+using PFNGLQUERYCOUNTERPROC = void(QE_APIENTRY *)(GLuint, GLenum);
+using PFNGLGETQUERYIVPROC = void(QE_APIENTRY *)(GLenum, GLenum, GLint *);
+using PFNGLGETQUERYOBJECTIVPROC = void(QE_APIENTRY *)(GLuint, GLenum, GLint *);
+using PFNGLGETQUERYOBJECTUI64VPROC = void(QE_APIENTRY *)(GLuint, GLenum, GLuint64 *);
+using PFNGLGETINTEGER64VPROC = void(QE_APIENTRY *)(GLenum, GLint64 *);
+
 // ── Global Function Pointers ────────────────────────────────────────────────
 namespace qe {
 namespace renderer {
@@ -240,6 +264,7 @@ inline PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays = nullptr;
 inline PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
 inline PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
 inline PFNGLBUFFERDATAPROC glBufferData = nullptr;
+inline PFNGLBUFFERSUBDATAPROC glBufferSubData = nullptr;
 inline PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
 inline PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray = nullptr;
 inline PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
@@ -247,6 +272,7 @@ inline PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor = nullptr;
 
 // Instanced drawing
 inline PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced = nullptr;
+inline PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertex = nullptr;
 
 // Textures
 inline PFNGLGENTEXTURESPROC glGenTextures = nullptr;
@@ -258,6 +284,25 @@ inline PFNGLGENERATEMIPMAPPROC glGenerateMipmap = nullptr;
 inline PFNGLDELETETEXTURESPROC glDeleteTextures = nullptr;
 inline PFNGLUNIFORM1IPROC glUniform1i = nullptr;
 
+// Timer queries (optional)
+inline PFNGLGENQUERIESPROC glGenQueries = nullptr;
+inline PFNGLDELETEQUERIESPROC glDeleteQueries = nullptr;
+inline PFNGLQUERYCOUNTERPROC glQueryCounter = nullptr;
+inline PFNGLGETQUERYIVPROC glGetQueryiv = nullptr;
+inline PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv = nullptr;
+inline PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = nullptr;
+inline PFNGLGETINTEGER64VPROC glGetInteger64v = nullptr;
+
+/** Whether GPU timestamps can be queried (functions loaded and a non-zero counter width). */
+inline bool has_timer_queries() {
+  if (!glGenQueries || !glDeleteQueries || !glQueryCounter || !glGetQueryiv ||
+      !glGetQueryObjectiv || !glGetQueryObjectui64v || !glGetInteger64v)
+    return false;
+  GLint bits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+  return bits > 0;
+}
+
 // ── Loader Function ─────────────────────────────────────────────────────────
 
 #ifndef QE_NO_SDL
@@ -267,9 +312,11 @@ inline PFNGLUNIFORM1IPROC glUniform1i = nullptr;
  * @return true if all required functions were loaded.
  */
 inline bool load() {
-#define QE_LOAD_GL(name)                                                 \
-  name = reinterpret_cast<decltype(name)>(SDL_GL_GetProcAddress(#name)); \
-  if (!name)                                                             \
+#define QE_LOAD_GL_OPTIONAL(name) \
+  name = reinterpret_cast<decltype(name)>(SDL_GL_GetProcAddress(#name))
+#define QE_LOAD_GL(name)     \
+  QE_LOAD_GL_OPTIONAL(name); \
+  if (!name)                 \
   return false
 
   // Core
@@ -319,6 +366,7 @@ inline bool load() {
   QE_LOAD_GL(glGenBuffers);
   QE_LOAD_GL(glBindBuffer);
   QE_LOAD_GL(glBufferData);
+  QE_LOAD_GL(glBufferSubData);
   QE_LOAD_GL(glDeleteBuffers);
   QE_LOAD_GL(glEnableVertexAttribArray);
   QE_LOAD_GL(glVertexAttribPointer);
@@ -326,6 +374,7 @@ inline bool load() {
 
   // Instanced drawing
   QE_LOAD_GL(glDrawElementsInstanced);
+  QE_LOAD_GL(glDrawElementsBaseVertex);
 
   // Textures
   QE_LOAD_GL(glGenTextures);
@@ -337,7 +386,17 @@ inline bool load() {
   QE_LOAD_GL(glDeleteTextures);
   QE_LOAD_GL(glUniform1i);
 
+  // Timer queries: profiling only, so their absence is not an error
+  QE_LOAD_GL_OPTIONAL(glGenQueries);
+  QE_LOAD_GL_OPTIONAL(glDeleteQueries);
+  QE_LOAD_GL_OPTIONAL(glQueryCounter);
+  QE_LOAD_GL_OPTIONAL(glGetQueryiv);
+  QE_LOAD_GL_OPTIONAL(glGetQueryObjectiv);
+  QE_LOAD_GL_OPTIONAL(glGetQueryObjectui64v);
+  QE_LOAD_GL_OPTIONAL(glGetInteger64v);
+
 #undef QE_LOAD_GL
+#undef QE_LOAD_GL_OPTIONAL
   return true;
 }
 #endif  // QE_NO_SDL
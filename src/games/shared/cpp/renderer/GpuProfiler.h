@@ -0,0 +1,251 @@
+#pragma once
+/**
+ * @file GpuProfiler.h
+ * @brief Per-pass GPU times from timestamp queries, read back frames later.
+ *
+ *   gpu.begin_frame();
+ *   { QE_GPU_SCOPE(gpu, "terrain"); terrain.draw(); }
+ *   gpu.end_frame();
+ *   SDL_GL_SwapWindow(window);
+ *
+ * Each scope brackets its draws with two glQueryCounter(GL_TIMESTAMP)
+ * queries. Results are read only once the GPU reports them available, so
+ * a frame's numbers arrive a few frames later and the CPU never waits: a
+ * ring of kFramesInFlight query sets is cycled, and if the GPU falls so far
+ * behind that the next set is still pending, that frame is not measured
+ * (dropped()) rather than stalling on it.
+ *
+ * Timestamps rather than GL_TIME_ELAPSED queries, because elapsed queries
+ * cannot nest and carry no absolute time. With absolute times the passes
+ * are placed on the CPU profiler's clock (core/Profiler.h) using a
+ * GL_TIMESTAMP / now_ns() pair sampled each frame, and appear as a "GPU"
+ * track in the Chrome trace. Each pass's time is also published as a GPU
+ * time counter (core/Counters.h).
+ *
+ * Without timer queries (old drivers, zero counter bits) init() returns
+ * false and every call is a no-op.
+ *
+ * Design by Contract:
+ *   - Precondition: init() and all other calls on the GL context's thread
+ *   - Precondition: scopes nest and close before end_frame()
+ *   - Postcondition: no call blocks on GPU completion
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "GLLoader.h"
+#include "core/Counters.h"
+#include "core/Profiler.h"
+
+namespace qe {
+namespace renderer {
+
+/** One pass of a measured frame. */
+struct GpuPassTime {
+  const char* name = "";
+  float ms = 0.0f;
+  uint16_t depth = 0;  // Enclosing GPU scopes
+};
+
+class GpuProfiler {
+ public:
+  static constexpr int kFramesInFlight = 4;
+  static constexpr int kMaxPasses = 32;  // Per frame; later scopes are not measured
+
+  /** Create the query ring. Returns false (profiler stays inert) without timer queries. */
+  bool init() {
+    destroy();
+    if (!gl::has_timer_queries())
+      return false;
+    for (Frame& f : frames_) {
+      f.queries.resize(2 + 2 * kMaxPasses);
+      gl::glGenQueries(static_cast<GLsizei>(f.queries.size()), f.queries.data());
+      f.passes.reserve(kMaxPasses);
+    }
+    results_.reserve(kMaxPasses);
+    if (!track_)
+      track_ = core::Profiler::instance().add_track("GPU");
+    available_ = true;
+    return true;
+  }
+
+  void destroy() {
+    if (available_)
+      for (Frame& f : frames_)
+        gl::glDeleteQueries(static_cast<GLsizei>(f.queries.size()), f.queries.data());
+    for (Frame& f : frames_)
+      f = Frame{};
+    results_.clear();
+    available_ = recording_ = false;
+    issued_ = collected_ = 0;
+  }
+
+  bool available() const noexcept {
+    return available_;
+  }
+
+  /** Collect finished frames, then start measuring this one. */
+  void begin_frame() {
+    if (!available_)
+      return;
+    collect();
+    Frame& f = frames_[issued_ % kFramesInFlight];
+    if (f.pending) {
+      ++dropped_;  // The GPU is kFramesInFlight frames behind: skip rather than wait
+      return;
+    }
+    f.passes.clear();
+    depth_ = 0;
+    GLint64 gpu_now = 0;
+    gl::glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+    f.cpu_sync_ns = core::Profiler::now_ns();
+    f.gpu_sync_ns = gpu_now;
+    gl::glQueryCounter(f.queries[0], GL_TIMESTAMP);
+    recording_ = true;
+  }
+
+  /** Start a pass; returns the handle for end() (-1 when not measured). */
+  int begin(const char* name) {
+    if (!recording_)
+      return -1;
+    Frame& f = frames_[issued_ % kFramesInFlight];
+    if (f.passes.size() == static_cast<size_t>(kMaxPasses))
+      return -1;
+    const int i = static_cast<int>(f.passes.size());
+    f.passes.push_back({name, depth_++});
+    gl::glQueryCounter(f.queries[2 + 2 * i], GL_TIMESTAMP);
+    return i;
+  }
+
+  void end(int pass) {
+    if (pass < 0 || !recording_)
+      return;
+    --depth_;
+    gl::glQueryCounter(frames_[issued_ % kFramesInFlight].queries[3 + 2 * pass], GL_TIMESTAMP);
+  }
+
+  /** Close the frame; call after its last draw, before the swap. */
+  void end_frame() {
+    if (!recording_)
+      return;
+    Frame& f = frames_[issued_ % kFramesInFlight];
+    gl::glQueryCounter(f.queries[1], GL_TIMESTAMP);
+    f.pending = true;
+    ++issued_;
+    recording_ = false;
+  }
+
+  /** Passes of the newest measured frame, in begin() order. */
+  const std::vector<GpuPassTime>& results() const noexcept {
+    return results_;
+  }
+  /** GPU time of the newest measured frame, begin_frame() to end_frame(). */
+  float frame_ms() const noexcept {
+    return frame_ms_;
+  }
+  /** Frames read back so far; frame_ms() and results() change when this does. */
+  uint64_t frames_measured() const noexcept {
+    return collected_;
+  }
+  /** Frames not measured because every query set was still in flight. */
+  uint64_t dropped() const noexcept {
+    return dropped_;
+  }
+
+ private:
+  struct Pass {
+    const char* name;
+    uint16_t depth;
+  };
+  struct Frame {
+    std::vector<GLuint> queries;  // Frame begin, frame end, then begin/end per pass
+    std::vector<Pass> passes;
+    int64_t cpu_sync_ns = 0;  // now_ns() and GL_TIMESTAMP read together
+    int64_t gpu_sync_ns = 0;
+    bool pending = false;  // Issued, results not read yet
+  };
+
+  Frame frames_[kFramesInFlight];
+  std::vector<GpuPassTime> results_;
+  core::Profiler::Ring* track_ = nullptr;
+  uint64_t issued_ = 0;     // Frames ended
+  uint64_t collected_ = 0;  // Frames read back
+  uint64_t dropped_ = 0;
+  float frame_ms_ = 0.0f;
+  uint16_t depth_ = 0;
+  bool available_ = false;
+  bool recording_ = false;
+
+  /** Read back every finished frame, oldest first, stopping at the first unfinished one. */
+  void collect() {
+    while (collected_ < issued_) {
+      Frame& f = frames_[collected_ % kFramesInFlight];
+      // The frame's last query; once it is available so are the earlier ones
+      GLint done = 0;
+      gl::glGetQueryObjectiv(f.queries[1], GL_QUERY_RESULT_AVAILABLE, &done);
+      if (!done)
+        return;
+      read(f);
+      f.pending = false;
+      ++collected_;
+    }
+  }
+
+  void read(const Frame& f) {
+    auto stamp = [&](size_t q) {
+      GLuint64 t = 0;
+      gl::glGetQueryObjectui64v(f.queries[q], GL_QUERY_RESULT, &t);
+      return static_cast<int64_t>(t);
+    };
+    // GPU nanoseconds to the CPU profiler's clock
+    auto to_cpu = [&](int64_t gpu_ns) { return gpu_ns - f.gpu_sync_ns + f.cpu_sync_ns; };
+
+    const int64_t frame_begin = stamp(0);
+    const int64_t frame_end = stamp(1);
+    frame_ms_ = static_cast<float>(frame_end - frame_begin) * 1e-6f;
+    results_.clear();
+    core::TraceEvent e;
+    e.name = "gpu frame";
+    e.start_ns = to_cpu(frame_begin);
+    e.end_ns = to_cpu(frame_end);
+    core::Profiler::record_on(track_, e);
+    for (size_t i = 0; i < f.passes.size(); ++i) {
+      const int64_t begin = stamp(2 + 2 * i);
+      const int64_t end = stamp(3 + 2 * i);
+      results_.push_back({f.passes[i].name, static_cast<float>(end - begin) * 1e-6f,
+                          f.passes[i].depth});
+      core::Counters::set(core::Counters::id(f.passes[i].name, core::CounterKind::GpuTime),
+                          results_.back().ms);
+      e.name = f.passes[i].name;
+      e.start_ns = to_cpu(begin);
+      e.end_ns = to_cpu(end);
+      e.depth = static_cast<uint16_t>(f.passes[i].depth + 1);
+      core::Profiler::record_on(track_, e);
+    }
+  }
+};
+
+/** RAII pass behind QE_GPU_SCOPE. */
+class GpuScope {
+ public:
+  GpuScope(GpuProfiler& profiler, const char* name)
+      : profiler_(profiler), pass_(profiler.begin(name)) {}
+  ~GpuScope() {
+    profiler_.end(pass_);
+  }
+
+  GpuScope(const GpuScope&) = delete;
+  GpuScope& operator=(const GpuScope&) = delete;
+
+ private:
+  GpuProfiler& profiler_;
+  int pass_;
+};
+
+}  // namespace renderer
+}  // namespace qe
+
+/** Time the enclosing block's GPU work as pass `name` (a string literal). */
+#define QE_GPU_SCOPE(profiler, name) \
+  ::qe::renderer::GpuScope QE_PROFILE_CONCAT(qe_gpu_scope_, __LINE__)((profiler), (name))
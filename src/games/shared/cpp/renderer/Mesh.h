@@ -9,27 +9,25 @@
  *
  * Resource ownership follows Rule of Five: Mesh owns GPU handles and
  * is move-only (copy is deleted to prevent double-free of GL objects).
+ *
+ * Every draw publishes "draw calls" and "triangles" (core/Counters.h).
  */
 
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <stdexcept>
 #include <utility>
 #include <vector>
 
+#include "../core/Contracts.h"
+#include "../core/Counters.h"
 #include "GLLoader.h"
 
 namespace qe {
 namespace renderer {
 
-// DbC macro — throws std::invalid_argument on validation failure
-#define QE_REQUIRE(cond, msg)           \
-  do {                                  \
-    if (!(cond))                        \
-      throw std::invalid_argument(msg); \
-  } while (0)
-
 static constexpr float kPi = 3.14159265358979323846f;
 
 /** Per-vertex data sent to the GPU. */
@@ -46,6 +44,8 @@ class Mesh {
   GLuint vbo = 0;
   GLuint ebo = 0;
   GLsizei index_count = 0;
+  size_t vertex_count = 0;
+  GLenum index_type = GL_UNSIGNED_INT;  // GL_UNSIGNED_SHORT for 16-bit uploads
 
   Mesh() = default;
 
@@ -55,11 +55,17 @@ class Mesh {
   Mesh &operator=(const Mesh &) = delete;
 
   Mesh(Mesh &&other) noexcept
-      : vao(other.vao), vbo(other.vbo), ebo(other.ebo), index_count(other.index_count) {
+      : vao(other.vao),
+        vbo(other.vbo),
+        ebo(other.ebo),
+        index_count(other.index_count),
+        vertex_count(other.vertex_count),
+        index_type(other.index_type) {
     other.vao = 0;
     other.vbo = 0;
     other.ebo = 0;
     other.index_count = 0;
+    other.vertex_count = 0;
   }
 
   Mesh &operator=(Mesh &&other) noexcept {
@@ -69,10 +75,13 @@ class Mesh {
       vbo = other.vbo;
       ebo = other.ebo;
       index_count = other.index_count;
+      vertex_count = other.vertex_count;
+      index_type = other.index_type;
       other.vao = 0;
       other.vbo = 0;
       other.ebo = 0;
       other.index_count = 0;
+      other.vertex_count = 0;
     }
     return *this;
   }
@@ -85,59 +94,90 @@ class Mesh {
 
   /**
    * Upload vertex + index data to the GPU.
+   * @param usage  GL_STATIC_DRAW, or GL_DYNAMIC_DRAW for meshes that are
+   *               patched with update_vertices()
    * @pre vertices is non-empty
    * @pre indices is non-empty
    */
-  void upload(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices) {
-    QE_REQUIRE(!vertices.empty(), "Mesh::upload: vertices must not be empty");
-    QE_REQUIRE(!indices.empty(), "Mesh::upload: indices must not be empty");
-
-    // Prevent GPU buffer leak on re-upload
-    if (vao)
-      destroy();
+  void upload(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+              GLenum usage = GL_STATIC_DRAW) {
+    upload(vertices.data(), vertices.size(), indices.data(), indices.size(), usage);
+  }
 
-    index_count = static_cast<GLsizei>(indices.size());
+  /** Upload from raw arrays (e.g. a memory-mapped file). */
+  void upload(const Vertex *vertices, size_t num_vertices, const unsigned int *indices,
+              size_t num_indices, GLenum usage = GL_STATIC_DRAW) {
+    upload_raw(vertices, num_vertices, indices, num_indices, GL_UNSIGNED_INT, usage);
+  }
 
-    gl::glGenVertexArrays(1, &vao);
-    gl::glGenBuffers(1, &vbo);
-    gl::glGenBuffers(1, &ebo);
+  /**
+   * Upload with 16-bit indices (half the index memory and bandwidth).
+   * @pre every index < 65536; larger meshes draw in chunks with
+   *      draw_base_vertex()
+   */
+  void upload(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices,
+              GLenum usage = GL_STATIC_DRAW) {
+    upload(vertices.data(), vertices.size(), indices.data(), indices.size(), usage);
+  }
 
-    gl::glBindVertexArray(vao);
+  void upload(const Vertex *vertices, size_t num_vertices, const uint16_t *indices,
+              size_t num_indices, GLenum usage = GL_STATIC_DRAW) {
+    upload_raw(vertices, num_vertices, indices, num_indices, GL_UNSIGNED_SHORT, usage);
+  }
 
+  /**
+   * Overwrite a contiguous range of the uploaded vertex buffer in place.
+   * @pre mesh has been uploaded (vao != 0)
+   * @pre first + count <= vertex_count
+   */
+  void update_vertices(size_t first, const Vertex *vertices, size_t count) {
+    QE_REQUIRE(vao != 0, "Mesh::update_vertices: mesh not uploaded");
+    QE_REQUIRE(first + count <= vertex_count, "Mesh::update_vertices: range out of bounds");
+    if (count == 0)
+      return;
     gl::glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    gl::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)),
-                     vertices.data(), GL_STATIC_DRAW);
-
-    gl::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    gl::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)), indices.data(),
-                     GL_STATIC_DRAW);
-
-    setup_vertex_attributes();
-    gl::glBindVertexArray(0);
+    gl::glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(Vertex)),
+                        static_cast<GLsizeiptr>(count * sizeof(Vertex)), vertices);
+    gl::glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
   /** @pre mesh has been uploaded (vao != 0) */
   void draw() const {
     QE_REQUIRE(vao != 0, "Mesh::draw: mesh not uploaded");
+    count_draw(index_count / 3);
     gl::glBindVertexArray(vao);
-    gl::glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr);
+    gl::glDrawElements(GL_TRIANGLES, index_count, index_type, nullptr);
+    gl::glBindVertexArray(0);
+  }
+
+  /**
+   * Draw the first count indices with base_vertex added to each index
+   * (one shared 16-bit index pattern reused for many vertex chunks).
+   * @pre mesh has been uploaded (vao != 0)
+   */
+  void draw_base_vertex(GLsizei count, GLint base_vertex) const {
+    QE_REQUIRE(vao != 0, "Mesh::draw_base_vertex: mesh not uploaded");
+    count_draw(count / 3);
+    gl::glBindVertexArray(vao);
+    gl::glDrawElementsBaseVertex(GL_TRIANGLES, count, index_type, nullptr, base_vertex);
     gl::glBindVertexArray(0);
   }
 
   /** Draw with GL_LINES mode (for grids and wireframes). */
   void draw_lines() const {
     QE_REQUIRE(vao != 0, "Mesh::draw_lines: mesh not uploaded");
+    count_draw(0);
     gl::glBindVertexArray(vao);
-    gl::glDrawElements(GL_LINES, index_count, GL_UNSIGNED_INT, nullptr);
+    gl::glDrawElements(GL_LINES, index_count, index_type, nullptr);
     gl::glBindVertexArray(0);
   }
 
   /** @pre mesh has been uploaded (vao != 0) */
   void draw_instanced(GLsizei instance_count) const {
     QE_REQUIRE(vao != 0, "Mesh::draw_instanced: mesh not uploaded");
+    count_draw(static_cast<size_t>(index_count / 3) * static_cast<size_t>(instance_count));
     gl::glBindVertexArray(vao);
-    gl::glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr,
+    gl::glDrawElementsInstanced(GL_TRIANGLES, index_count, index_type, nullptr,
                                 instance_count);
     gl::glBindVertexArray(0);
   }
@@ -156,6 +196,7 @@ class Mesh {
       vao = 0;
     }
     index_count = 0;
+    vertex_count = 0;
   }
 
   // ── Primitive Generators ────────────────────────────────────────────
@@ -369,6 +410,44 @@ class Mesh {
   }
 
  private:
+  static void count_draw(size_t triangles) {
+    QE_COUNTER_ADD("draw calls", 1);
+    QE_COUNTER_ADD("triangles", triangles);
+  }
+
+  void upload_raw(const Vertex *vertices, size_t num_vertices, const void *indices,
+                  size_t num_indices, GLenum type, GLenum usage) {
+    QE_REQUIRE(num_vertices > 0, "Mesh::upload: vertices must not be empty");
+    QE_REQUIRE(num_indices > 0, "Mesh::upload: indices must not be empty");
+
+    // Prevent GPU buffer leak on re-upload
+    if (vao)
+      destroy();
+
+    index_count = static_cast<GLsizei>(num_indices);
+    vertex_count = num_vertices;
+    index_type = type;
+    const size_t index_size = type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+    gl::glGenVertexArrays(1, &vao);
+    gl::glGenBuffers(1, &vbo);
+    gl::glGenBuffers(1, &ebo);
+
+    gl::glBindVertexArray(vao);
+
+    gl::glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(num_vertices * sizeof(Vertex)),
+                     vertices, usage);
+
+    gl::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    gl::glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(num_indices * index_size), indices,
+                     GL_STATIC_DRAW);
+
+    setup_vertex_attributes();
+    gl::glBindVertexArray(0);
+  }
+
   /**
    * Configure vertex attribute pointers for the standard vertex layout.
    * DRY: shared by upload() — all mesh creation goes through upload().
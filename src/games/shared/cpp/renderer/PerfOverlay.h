@@ -0,0 +1,259 @@
+#pragma once
+/**
+ * @file PerfOverlay.h
+ * @brief On-screen frame time graph and live counters, drawn in one call.
+ *
+ *   overlay.init();                  // After the GL context exists
+ *   Counters::end_frame();           // Each frame, after publishing
+ *   if (overlay.visible) {
+ *     hud_shader.use();              // Position in NDC, vertex color
+ *     overlay.update(width, height);
+ *     overlay.draw();
+ *   }
+ *
+ * Everything it shows comes from core/Counters.h: the frame time (the
+ * "frame" CPU time, which core/FrameTelemetry.h publishes) feeds a graph of
+ * the last kGraphFrames frames, then every CPU time, GPU time, per-frame
+ * counter and gauge is listed in registration order. A subsystem that
+ * publishes a new counter shows up without touching the overlay.
+ *
+ * Text is a built-in 3x5 pixel font. Each lit run of a glyph row, each
+ * graph bar and the background are quads in one vertex array, uploaded to
+ * a dynamic mesh and drawn with a single glDrawElementsBaseVertex.
+ * update() builds the quads without touching GL, so layouts are testable
+ * headless.
+ *
+ * Design by Contract:
+ *   - Precondition: init(), draw() and destroy() on the GL context's thread
+ *   - Postcondition: at most kMaxQuads quads; later rows are cut off
+ *   - Postcondition: update() and draw() do not allocate
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../core/Counters.h"
+#include "GLLoader.h"
+#include "Mesh.h"
+
+namespace qe {
+namespace renderer {
+
+/**
+ * 3x5 glyph: 15 bits, top row first, leftmost pixel highest. Lower case
+ * draws as upper case; characters without a glyph are blank.
+ */
+inline uint16_t overlay_glyph(char c) {
+  static constexpr uint16_t kGlyphs[] = {
+      // ' ' .. 'Z'
+      0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,
+      0x2922, 0x224A, 0x0000, 0x0000, 0x0000, 0x01C0, 0x0002, 0x12A4,
+      0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249,
+      0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+      0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+      0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+      0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+      0x5AAD, 0x5A92, 0x72A7,
+  };
+  if (c >= 'a' && c <= 'z')
+    c = static_cast<char>(c - 'a' + 'A');
+  return c >= ' ' && c <= 'Z' ? kGlyphs[c - ' '] : 0;
+}
+
+class PerfOverlay {
+ public:
+  static constexpr int kGraphFrames = 120;
+  static constexpr size_t kMaxQuads = 4096;
+
+  struct Config {
+    int scale = 2;            // Screen pixels per font pixel
+    float budget_ms = 16.7f;  // Graph reference line; bars are red past twice this
+  };
+  Config config;
+  bool visible = false;
+
+  PerfOverlay() {
+    verts_.reserve(kMaxQuads * 4);
+  }
+
+  /** Create the dynamic quad mesh. */
+  void init() {
+    std::vector<Vertex> vertices(kMaxQuads * 4);
+    std::vector<unsigned int> indices;
+    indices.reserve(kMaxQuads * 6);
+    for (unsigned int q = 0; q < kMaxQuads; ++q)
+      for (unsigned int i : {0u, 2u, 1u, 1u, 2u, 3u})
+        indices.push_back(q * 4 + i);
+    mesh_.upload(vertices, indices, GL_DYNAMIC_DRAW);
+  }
+
+  void destroy() {
+    mesh_.destroy();
+  }
+
+  /** Sample the counters latched by Counters::end_frame() and lay out the quads. */
+  void update(int width, int height) {
+    using core::CounterKind;
+    verts_.clear();
+    px_ = 2.0f * static_cast<float>(config.scale) / static_cast<float>(std::max(width, 1));
+    py_ = 2.0f * static_cast<float>(config.scale) / static_cast<float>(std::max(height, 1));
+
+    if (frame_counter_ < 0)
+      frame_counter_ = core::Counters::find("frame", CounterKind::CpuTime);
+    const float frame_ms = static_cast<float>(core::Counters::last(frame_counter_));
+    history_[next_] = frame_ms;
+    next_ = (next_ + 1) % kGraphFrames;
+
+    rect(0, 0, 0, 0, kBackground);  // Sized once the layout is known
+    float y = kPad;
+    char value[32];
+    std::snprintf(value, sizeof(value), "%.2f MS", frame_ms);
+    row(y, "FRAME", value, kText);
+    y += kLine;
+    graph(y);
+    y += kGraphHeight + kPad;
+
+    section(y, "CPU MS", CounterKind::CpuTime, CounterKind::CpuTime);
+    section(y, "GPU MS", CounterKind::GpuTime, CounterKind::GpuTime);
+    section(y, "COUNTERS", CounterKind::PerFrame, CounterKind::Gauge);
+
+    const float w = kGraphFrames + 2 * kPad;
+    const float h = y + kPad - kLine + kGlyphHeight;
+    Vertex* bg = verts_.data();
+    const float x0 = ndc_x(0), x1 = ndc_x(w), y0 = ndc_y(0), y1 = ndc_y(h);
+    const float corners[4][2] = {{x0, y0}, {x1, y0}, {x0, y1}, {x1, y1}};
+    for (int i = 0; i < 4; ++i) {
+      bg[i].position[0] = corners[i][0];
+      bg[i].position[1] = corners[i][1];
+    }
+  }
+
+  /** Upload the quads and draw them with one call, using the bound shader. */
+  void draw() {
+    if (!mesh_.vao || verts_.empty())
+      return;
+    mesh_.update_vertices(0, verts_.data(), verts_.size());
+    mesh_.draw_base_vertex(static_cast<GLsizei>(quads() * 6), 0);
+  }
+
+  size_t quads() const noexcept {
+    return verts_.size() / 4;
+  }
+  /** The last update()'s quads, four vertices each (NDC positions). */
+  const std::vector<Vertex>& vertices() const noexcept {
+    return verts_;
+  }
+
+ private:
+  // Layout in font pixels from the top-left corner
+  static constexpr float kPad = 3.0f;
+  static constexpr float kAdvance = 4.0f;  // Glyph width plus spacing
+  static constexpr float kGlyphHeight = 5.0f;
+  static constexpr float kLine = 7.0f;
+  static constexpr float kGraphHeight = 32.0f;  // Twice the budget at the top
+
+  static constexpr float kBackground[3] = {0.05f, 0.05f, 0.08f};
+  static constexpr float kText[3] = {0.9f, 0.9f, 0.9f};
+  static constexpr float kHeader[3] = {0.5f, 0.7f, 1.0f};
+  static constexpr float kGood[3] = {0.2f, 0.85f, 0.3f};
+  static constexpr float kSlow[3] = {0.95f, 0.8f, 0.2f};
+  static constexpr float kBad[3] = {0.95f, 0.25f, 0.2f};
+
+  Mesh mesh_;
+  std::vector<Vertex> verts_;
+  std::array<float, kGraphFrames> history_{};
+  int next_ = 0;  // Oldest graph sample
+  int frame_counter_ = -1;
+  float px_ = 0.0f;  // NDC size of a font pixel
+  float py_ = 0.0f;
+
+  float ndc_x(float x) const {
+    return -1.0f + (kPad + x) * px_;
+  }
+  float ndc_y(float y) const {
+    return 1.0f - (kPad + y) * py_;
+  }
+
+  void rect(float x, float y, float w, float h, const float* color) {
+    if (quads() == kMaxQuads)
+      return;
+    const float x0 = ndc_x(x), x1 = ndc_x(x + w), y0 = ndc_y(y), y1 = ndc_y(y + h);
+    const float corners[4][2] = {{x0, y0}, {x1, y0}, {x0, y1}, {x1, y1}};
+    for (const auto& c : corners) {
+      Vertex v;
+      v.position[0] = c[0];
+      v.position[1] = c[1];
+      v.color[0] = color[0];
+      v.color[1] = color[1];
+      v.color[2] = color[2];
+      verts_.push_back(v);
+    }
+  }
+
+  void text(float x, float y, const char* s, const float* color) {
+    for (; *s; ++s, x += kAdvance) {
+      const uint16_t g = overlay_glyph(*s);
+      for (int r = 0; r < 5; ++r) {
+        const int bits = (g >> (3 * (4 - r))) & 7;
+        // One quad per run of lit pixels in the row
+        for (int col = 0; col < 3;) {
+          if (!(bits & (4 >> col))) {
+            ++col;
+            continue;
+          }
+          int end = col;
+          while (end < 3 && (bits & (4 >> end)))
+            ++end;
+          rect(x + col, y + r, static_cast<float>(end - col), 1.0f, color);
+          col = end;
+        }
+      }
+    }
+  }
+
+  /** Label on the left, value right-aligned to the graph's width. */
+  void row(float y, const char* label, const char* value, const float* color) {
+    text(kPad, y, label, color);
+    const float w = static_cast<float>(std::strlen(value)) * kAdvance - 1.0f;
+    text(kPad + kGraphFrames - w, y, value, color);
+  }
+
+  void graph(float y) {
+    const float full = 2.0f * config.budget_ms;
+    for (int i = 0; i < kGraphFrames; ++i) {
+      const float ms = history_[(next_ + i) % kGraphFrames];
+      const float h = std::min(ms / full, 1.0f) * kGraphHeight;
+      const float* color = ms <= config.budget_ms ? kGood : ms <= full ? kSlow : kBad;
+      rect(kPad + static_cast<float>(i), y + kGraphHeight - h, 1.0f, h, color);
+    }
+    rect(kPad, y + kGraphHeight / 2, kGraphFrames, 0.5f, kText);  // The budget
+  }
+
+  /** Header and one row per counter of either kind, if there are any. */
+  void section(float& y, const char* header, core::CounterKind kind, core::CounterKind also) {
+    bool any = false;
+    char value[32];
+    for (int i = 0; i < core::Counters::count(); ++i) {
+      const core::CounterKind k = core::Counters::kind(i);
+      if ((k != kind && k != also) || i == frame_counter_)
+        continue;
+      if (!any) {
+        text(kPad, y, header, kHeader);
+        y += kLine;
+        any = true;
+      }
+      const double v = core::Counters::last(i);
+      const bool time = k == core::CounterKind::CpuTime || k == core::CounterKind::GpuTime;
+      std::snprintf(value, sizeof(value), time ? "%.2f" : "%.0f", v);
+      row(y, core::Counters::name(i), value, kText);
+      y += kLine;
+    }
+  }
+};
+
+}  // namespace renderer
+}  // namespace qe
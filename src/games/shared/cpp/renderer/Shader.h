@@ -9,6 +9,7 @@
 #include <sstream>
 #include <string>
 
+#include "../core/Counters.h"
 #include "../math/Mat4.h"
 #include "../math/Vec3.h"
 #include "GLLoader.h"
@@ -67,6 +68,7 @@ class Shader {
   }
 
   void use() const {
+    QE_COUNTER_ADD("state changes", 1);
     gl::glUseProgram(program_id);
   }
 
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "../core/Counters.h"
 #include "GLLoader.h"
 
 namespace qe {
@@ -48,6 +49,7 @@ class Texture {
 
   /** Bind to a texture unit (0-based). */
   void bind(int unit = 0) const {
+    QE_COUNTER_ADD("state changes", 1);
     gl::glActiveTexture(GL_TEXTURE0 + unit);
     gl::glBindTexture(GL_TEXTURE_2D, id);
   }
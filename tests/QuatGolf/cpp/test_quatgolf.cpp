@@ -5,28 +5,49 @@
  * Covers:
  *   - Surface: property lookup for every SurfaceType
  *   - Terrain: height/normal/surface queries from flat and sloped heightmaps
+ *   - Terrain queries: precomputed normal field, surface table, batch sampling
+ *   - Terrain raycast: min/max pyramid bounds, ray/segment hits and misses
+ *   - StreamingTerrain: coarse fallback, paging, eviction, ray queries vs. Terrain
  *   - Club: launch velocity direction and magnitude, spin axis
  *   - Hole: distance_m computation
  *   - BallPhysics: launch state, flight integration (gravity, drag, Magnus),
  *     terrain contact (bounce/rolling transitions), water hazard, rolling stop
+ *   - GolfSim: water penalty, holing out, shot scripts, headless determinism
+ *     (in memory and on streamed tiles),
+ *     allocation-free steady-state steps (this file installs core/AllocHooks.h)
  *
  * Uses the same lightweight test framework as tests/shared/cpp/test_math.cpp.
  * No OpenGL calls are made — Terrain::set_data() + query methods only.
  * QE_NO_SDL is defined via CMake so GLLoader.h compiles without SDL headers.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 // QuatGolf headers
+#include "core/AllocHooks.h"
+#include "course/CourseBuilder.h"
+#include "course/CourseFile.h"
 #include "course/Hole.h"
 #include "game/Club.h"
+#include "game/GolfSim.h"
+#include "game/HeadlessRunner.h"
+#include "game/Replay.h"
+#include "game/ShotScript.h"
+#include "game/Snapshot.h"
 #include "math/Vec3.h"
+#include "physics/AeroTables.h"
 #include "physics/BallPhysics.h"
+#include "terrain/HeightmapImport.h"
 #include "terrain/Surface.h"
+#include "terrain/StreamingTerrain.h"
 #include "terrain/Terrain.h"
 
 // ── Minimal Test Framework ───────────────────────────────────────────────────
@@ -79,6 +100,18 @@ static qg::terrain::Terrain make_flat_terrain(int w, int d, float height,
   return t;
 }
 
+// ── Helper: flat terrain with a one-vertex-wide ridge at grid column rx ─────
+
+static qg::terrain::Terrain make_ridge_terrain(int w, int d, int rx, float ridge_h) {
+  qg::terrain::Terrain t;
+  std::vector<float> heights(w * d, 0.0f);
+  for (int z = 0; z < d; ++z)
+    heights[z * w + rx] = ridge_h;
+  std::vector<qg::terrain::SurfaceType> surfaces(w * d, qg::terrain::SurfaceType::Fairway);
+  t.set_data(w, d, 1.0f, std::move(heights), std::move(surfaces));
+  return t;
+}
+
 // ============================================================================
 //  Surface Tests
 // ============================================================================
@@ -199,6 +232,598 @@ void test_terrain_sloped_normal_tilted() {
   ASSERT_TRUE(n.y > 0.0f);                 // Y must still be positive (faces "up")
 }
 
+void test_surface_table_indexed_by_type() {
+  using namespace qg::terrain;
+  for (int i = 0; i < static_cast<int>(SurfaceType::Count); ++i)
+    ASSERT_TRUE(kSurfaceTable[i].type == static_cast<SurfaceType>(i));
+  // Out-of-range values fall back to OutOfBounds
+  ASSERT_TRUE(surface_props(SurfaceType::Count).type == SurfaceType::OutOfBounds);
+}
+
+void test_terrain_normal_field_matches_differences() {
+  auto t = make_ridge_terrain(12, 12, 6, 2.0f);
+  for (int x = 0; x < 12; ++x) {
+    float hL = t.height_at(x - 1, 4), hR = t.height_at(x + 1, 4);
+    auto expected = qe::math::Vec3(hL - hR, 2.0f, 0.0f).normalized();
+    ASSERT_TRUE(t.normal_at(x, 4).approx_equal(expected, EPS));
+  }
+}
+
+void test_terrain_batch_matches_point_queries() {
+  auto t = make_ridge_terrain(16, 16, 9, 1.5f);
+  // Includes points outside the grid (edge-extended lookups)
+  std::vector<float> xs = {0.0f, 0.4f, 1.25f, -3.7f, 7.9f, 12.0f, -20.0f, 2.5f};
+  std::vector<float> zs = {0.0f, -2.3f, 5.5f, 3.1f, -7.9f, 0.2f, 30.0f, 2.5f};
+  size_t n = xs.size();
+  std::vector<float> h(n);
+  std::vector<qe::math::Vec3> nrm(n);
+  std::vector<qg::terrain::SurfaceType> surf(n);
+  t.sample_heights(xs.data(), zs.data(), h.data(), n);
+  t.sample_normals(xs.data(), zs.data(), nrm.data(), n);
+  t.sample_surfaces(xs.data(), zs.data(), surf.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_FLOAT_EQ(h[i], t.height_at_world(xs[i], zs[i]), EPS);
+    ASSERT_TRUE(nrm[i] == t.normal_at_world(xs[i], zs[i]));
+    ASSERT_TRUE(surf[i] == t.surface_at_world(xs[i], zs[i]));
+
+    auto s = t.sample(xs[i], zs[i]);
+    ASSERT_FLOAT_EQ(s.height, h[i], EPS);
+    ASSERT_TRUE(s.props == &qg::terrain::surface_props(s.surface));
+  }
+  // Bilinear midpoint between ridge (x=1 world) and its neighbour
+  ASSERT_FLOAT_EQ(t.height_at_world(0.5f, 0.0f), 0.75f, EPS);
+}
+
+void test_terrain_mesh_bands_replay_full_grid() {
+  auto t = make_ridge_terrain(300, 250, 150, 2.0f);
+  std::vector<qe::renderer::Vertex> verts;
+  std::vector<uint16_t> pattern;
+  t.build_geometry(verts, pattern);
+  const int rows = t.band_rows();
+  ASSERT_TRUE(rows == 65536 / 300 - 1);
+  ASSERT_TRUE(verts.size() == 300u * 250u);
+  ASSERT_TRUE(pattern.size() == static_cast<size_t>(rows) * 299 * 6);
+  ASSERT_FLOAT_EQ(verts[250 * 300 - 1].position[1], t.height_at(299, 249), EPS);
+  ASSERT_FLOAT_EQ(verts[120 * 300 + 150].position[1], t.height_at(150, 120), EPS);
+
+  // Replaying the pattern per band (as draw() does) yields every quad once
+  size_t quad = 0;
+  bool all_match = true;
+  for (int z = 0; z < 249; z += rows) {
+    int n = std::min(rows, 249 - z);
+    for (size_t k = 0; k < static_cast<size_t>(n) * 299 * 6; k += 6, ++quad) {
+      unsigned tl = static_cast<unsigned>(quad / 299 * 300 + quad % 299);
+      unsigned base = static_cast<unsigned>(z * 300);
+      all_match = all_match && pattern[k] + base == tl && pattern[k + 1] + base == tl + 300 &&
+                  pattern[k + 5] + base == tl + 301;
+    }
+  }
+  ASSERT_TRUE(all_match);
+  ASSERT_TRUE(quad == 299u * 249u);
+}
+
+void test_terrain_quantized_matches_float_within_step() {
+  // Rolling terrain with a different surface per stripe (exercises all nibbles)
+  const int w = 40, d = 37;
+  std::vector<float> heights(w * d);
+  std::vector<qg::terrain::SurfaceType> surfaces(w * d);
+  for (int z = 0; z < d; ++z)
+    for (int x = 0; x < w; ++x) {
+      heights[z * w + x] = 3.0f * std::sin(x * 0.3f) + 0.05f * z * z;
+      surfaces[z * w + x] = static_cast<qg::terrain::SurfaceType>(
+          (x + z) % static_cast<int>(qg::terrain::SurfaceType::Count));
+    }
+  qg::terrain::Terrain ref, q;
+  ref.set_data(w, d, 1.0f, heights, surfaces);
+  q.set_storage(qg::terrain::StorageMode::Quantized);
+  q.set_data(w, d, 1.0f, heights, surfaces);
+  ASSERT_TRUE(q.storage() == qg::terrain::StorageMode::Quantized);
+
+  // Worst-case tile range here is < 70 m → step < 1.1 mm
+  for (int z = 0; z < d; ++z)
+    for (int x = 0; x < w; ++x) {
+      ASSERT_FLOAT_EQ(q.height_at(x, z), ref.height_at(x, z), 1e-3f);
+      ASSERT_TRUE(q.surface_at(x, z) == ref.surface_at(x, z));
+      ASSERT_TRUE(q.normal_at(x, z).distance_to(ref.normal_at(x, z)) < 0.02f);
+    }
+  ASSERT_FLOAT_EQ(q.height_at_world(3.3f, -4.6f), ref.height_at_world(3.3f, -4.6f), 1e-3f);
+
+  qg::terrain::TerrainHit hq, hr;
+  ASSERT_TRUE(ref.raycast({-5.0f, 80.0f, 2.0f}, {0.2f, -1.0f, 0.1f}, 200.0f, hr));
+  ASSERT_TRUE(q.raycast({-5.0f, 80.0f, 2.0f}, {0.2f, -1.0f, 0.1f}, 200.0f, hq));
+  ASSERT_FLOAT_EQ(hq.t, hr.t, 1e-2f);
+
+  // 20 bytes per vertex in float mode vs. ~6.5 quantized
+  ASSERT_TRUE(q.memory_bytes() * 3 < ref.memory_bytes());
+}
+
+void test_terrain_storage_round_trip() {
+  auto t = make_ridge_terrain(20, 20, 7, 2.0f);
+  size_t float_bytes = t.memory_bytes();
+  t.set_storage(qg::terrain::StorageMode::Quantized);
+  ASSERT_FLOAT_EQ(t.height_at(7, 3), 2.0f, EPS);  // Tile extremes are exact
+  ASSERT_FLOAT_EQ(t.height_at(8, 3), 0.0f, EPS);
+  t.set_storage(qg::terrain::StorageMode::Float);
+  ASSERT_TRUE(t.storage() == qg::terrain::StorageMode::Float);
+  ASSERT_TRUE(t.memory_bytes() == float_bytes);
+  ASSERT_FLOAT_EQ(t.height_at(7, 3), 2.0f, EPS);
+  ASSERT_TRUE(t.surface_at(0, 0) == qg::terrain::SurfaceType::Fairway);
+}
+
+void test_terrain_edit_writes_back_and_refreshes() {
+  auto t = make_flat_terrain(24, 24, 0.0f, qg::terrain::SurfaceType::Rough);
+  ASSERT_TRUE(t.take_dirty() == (qg::terrain::GridRect{0, 0, 23, 23}));
+  {
+    auto e = t.edit({5, 5, 8, 8});
+    e.set_height(6, 6, 3.0f);
+    e.set_surface(6, 6, qg::terrain::SurfaceType::Sand);
+    ASSERT_FLOAT_EQ(e.height(6, 6), 3.0f, EPS);
+    ASSERT_FLOAT_EQ(t.height_at(6, 6), 0.0f, EPS);  // Not visible until commit
+  }
+  ASSERT_FLOAT_EQ(t.height_at(6, 6), 3.0f, EPS);
+  ASSERT_TRUE(t.surface_at(6, 6) == qg::terrain::SurfaceType::Sand);
+  ASSERT_TRUE(t.normal_at(5, 6).x < -0.5f);  // Neighbour normal tilts away
+  ASSERT_FLOAT_EQ(t.pyramid().root().max, 3.0f, EPS);
+  // Edited region plus the one-vertex normal ring
+  ASSERT_TRUE(t.dirty_rect() == (qg::terrain::GridRect{4, 4, 9, 9}));
+  ASSERT_TRUE(t.take_dirty() == (qg::terrain::GridRect{4, 4, 9, 9}));
+  ASSERT_TRUE(t.dirty_rect().empty());
+}
+
+void test_terrain_edit_regions_and_quantized_tiles() {
+  auto t = make_flat_terrain(40, 40, 1.0f, qg::terrain::SurfaceType::Fairway);
+  {
+    // Disjoint regions can be held together
+    auto a = t.edit({0, 0, 9, 9});
+    auto b = t.edit({10, 0, 19, 9});
+    a.set_height(2, 2, 2.0f);
+    b.set_height(12, 2, -1.0f);
+  }
+  ASSERT_FLOAT_EQ(t.height_at(2, 2), 2.0f, EPS);
+  ASSERT_FLOAT_EQ(t.height_at(12, 2), -1.0f, EPS);
+
+  t.set_storage(qg::terrain::StorageMode::Quantized);
+  {
+    auto e = t.edit({20, 20, 21, 21});
+    ASSERT_TRUE(e.rect() == (qg::terrain::GridRect{20, 20, 21, 21}));
+    e.set_height(20, 20, 5.0f);
+    e.set_surface(21, 21, qg::terrain::SurfaceType::Green);
+  }
+  ASSERT_FLOAT_EQ(t.height_at(20, 20), 5.0f, 1e-3f);
+  ASSERT_FLOAT_EQ(t.height_at(22, 22), 1.0f, 1e-3f);  // Same tile, untouched
+  ASSERT_TRUE(t.surface_at(21, 21) == qg::terrain::SurfaceType::Green);
+  ASSERT_TRUE(t.surface_at(20, 21) == qg::terrain::SurfaceType::Fairway);
+  ASSERT_FLOAT_EQ(t.height_at(2, 2), 2.0f, 1e-3f);
+}
+
+void test_course_stamps_paint_hole_features() {
+  qg::terrain::Terrain t;
+  qg::course::CourseBuilder::generate_base(t, 80, 80, 2.0f);
+  auto holes = qg::course::CourseBuilder::default_course();
+  qg::course::CourseBuilder::stamp_hole(t, holes[0]);
+  const auto& h = holes[0];
+  ASSERT_TRUE(t.surface_at_world(h.tee.position.x, h.tee.position.z) ==
+              qg::terrain::SurfaceType::Tee);
+  ASSERT_TRUE(t.surface_at_world(h.green.center.x, h.green.center.z) ==
+              qg::terrain::SurfaceType::Green);
+  ASSERT_TRUE(t.surface_at_world(h.bunkers[0].center.x, h.bunkers[0].center.z) ==
+              qg::terrain::SurfaceType::Sand);
+  ASSERT_TRUE(t.surface_at_world(0.0f, 0.0f) == qg::terrain::SurfaceType::Fairway);
+  ASSERT_TRUE(t.surface_at_world(70.0f, 0.0f) == qg::terrain::SurfaceType::Rough);
+  // Bunker is dug below its surroundings
+  float rim = t.height_at_world(h.bunkers[0].center.x + 6.0f, h.bunkers[0].center.z);
+  ASSERT_TRUE(t.height_at_world(h.bunkers[0].center.x, h.bunkers[0].center.z) < rim);
+}
+
+void test_fairway_distance_matches_swept_circles() {
+  // Brute force: min over densely sampled circles along each segment
+  auto holes = qg::course::CourseBuilder::default_course();
+  const auto& hole = holes[2];  // Dogleg with varying widths
+  for (float wz = 60.0f; wz >= -60.0f; wz -= 7.3f) {
+    for (float wx = -80.0f; wx <= -20.0f; wx += 3.1f) {
+      float ref = 1e9f;
+      for (size_t i = 0; i + 1 < hole.fairway.size(); ++i) {
+        const auto& p0 = hole.fairway[i];
+        const auto& p1 = hole.fairway[i + 1];
+        for (int k = 0; k <= 2000; ++k) {
+          float u = k / 2000.0f;
+          auto c = p0.position.lerp(p1.position, u);
+          float r = (p0.width + (p1.width - p0.width) * u) * 0.5f;
+          float dx = wx - c.x, dz = wz - c.z;
+          ref = std::min(ref, std::sqrt(dx * dx + dz * dz) - r);
+        }
+      }
+      ASSERT_FLOAT_EQ(qg::course::CourseBuilder::fairway_distance(hole, wx, wz), ref, 0.02f);
+    }
+  }
+}
+
+void test_course_file_round_trip() {
+  auto t = make_ridge_terrain(40, 30, 12, 3.0f);
+  t.edit({5, 7, 5, 7}).set_surface(5, 7, qg::terrain::SurfaceType::Sand);
+  auto holes = qg::course::CourseBuilder::default_course();
+  qe::ai::NavigationSystem nav;
+  nav.init(8, 6, 2.0f);
+  nav.nodes[9].walkable = false;
+
+  std::string path = "test_course_round_trip.qgc";
+  qg::course::CourseWriteOptions opts;
+  opts.nav = &nav;
+  ASSERT_TRUE(qg::course::CourseFile::write(path, holes, t, opts));
+
+  qg::course::CourseFile file;
+  ASSERT_TRUE(file.open(path));
+  ASSERT_TRUE(file.width() == 40 && file.depth() == 30);
+  ASSERT_TRUE(file.holes().size() == holes.size());
+  for (size_t i = 0; i < holes.size(); ++i) {
+    const auto& a = holes[i];
+    const auto& b = file.holes()[i];
+    ASSERT_TRUE(a.par == b.par && a.has_water == b.has_water);
+    ASSERT_TRUE(a.fairway.size() == b.fairway.size() && a.bunkers.size() == b.bunkers.size());
+    ASSERT_FLOAT_EQ(a.green.pin.x, b.green.pin.x, 0.0f);
+    ASSERT_FLOAT_EQ(a.fairway.back().width, b.fairway.back().width, 0.0f);
+  }
+
+  qg::terrain::Terrain loaded;
+  file.load_terrain(loaded);
+  for (int z = 0; z < 30; ++z)
+    for (int x = 0; x < 40; ++x) {
+      ASSERT_FLOAT_EQ(loaded.height_at(x, z), t.height_at(x, z), 0.0f);
+      ASSERT_TRUE(loaded.surface_at(x, z) == t.surface_at(x, z));
+    }
+  ASSERT_TRUE(file.has_mesh());
+
+  qe::ai::NavigationSystem nav2;
+  ASSERT_TRUE(file.load_nav(nav2));
+  ASSERT_TRUE(nav2.width == 8 && nav2.depth == 6 && !nav2.nodes[9].walkable);
+  std::remove(path.c_str());
+}
+
+void test_course_file_rejects_bad_input() {
+  qg::course::CourseFile file;
+  ASSERT_TRUE(!file.open("does_not_exist.qgc"));
+
+  std::string path = "test_course_bad.qgc";
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "QGCF garbage";
+  }
+  ASSERT_TRUE(!file.open(path));
+  std::remove(path.c_str());
+}
+
+// 3 x 2 tiles of 8 cells (25 x 17 vertices), coarse sample every 4th vertex
+float tile_test_height(int gx, int gz) {
+  return 0.5f * gx + 0.25f * gz + ((gx * 7 + gz * 3) % 5) * 0.1f;
+}
+
+qg::terrain::SurfaceType tile_test_surface(int gx, int gz) {
+  return gx < 12 ? qg::terrain::SurfaceType::Fairway
+                 : (gz < 8 ? qg::terrain::SurfaceType::Rough : qg::terrain::SurfaceType::Sand);
+}
+
+std::string write_tile_test_file() {
+  qg::terrain::TileLayout layout;
+  layout.tile_size = 8;
+  layout.tiles_x = 3;
+  layout.tiles_z = 2;
+  layout.coarse_step = 4;
+  std::string path = "test_tiles.qgt";
+  qg::terrain::TileFile::write(path, layout, tile_test_height, tile_test_surface);
+  return path;
+}
+
+void test_streaming_coarse_until_loaded_then_detail() {
+  std::string path = write_tile_test_file();
+  qg::terrain::StreamingTerrain st;
+  ASSERT_TRUE(st.open(path));
+  ASSERT_TRUE(st.layout().width() == 25 && st.layout().depth() == 17);
+
+  // Nothing resident: coarse overview answers without waiting
+  ASSERT_TRUE(!st.has_detail(0.0f, 0.0f));
+  ASSERT_FLOAT_EQ(st.height_at_world(-12.5f + 4.0f, -8.5f + 8.0f), tile_test_height(4, 8), EPS);
+
+  qe::math::Vec3 focus(0.0f, 0.0f, 0.0f);
+  st.update(&focus, 1);
+  st.wait_idle();
+  st.update(&focus, 1);
+  ASSERT_TRUE(st.resident_tiles() == 6);
+
+  // Full resolution everywhere, continuous across tile edges (gx = 8, 16; gz = 8)
+  for (float gz = 0.0f; gz <= 16.0f; gz += 0.75f) {
+    for (float gx = 0.0f; gx <= 24.0f; gx += 0.625f) {
+      int x0 = std::min(static_cast<int>(gx), 23), z0 = std::min(static_cast<int>(gz), 15);
+      float fx = gx - x0, fz = gz - z0;
+      float h0 = tile_test_height(x0, z0) * (1 - fx) + tile_test_height(x0 + 1, z0) * fx;
+      float h1 = tile_test_height(x0, z0 + 1) * (1 - fx) + tile_test_height(x0 + 1, z0 + 1) * fx;
+      float wx = gx - 12.5f, wz = gz - 8.5f;
+      ASSERT_TRUE(st.has_detail(wx, wz));
+      ASSERT_FLOAT_EQ(st.height_at_world(wx, wz), h0 + (h1 - h0) * fz, 1e-4f);
+      int vx = static_cast<int>(gx + 0.5f), vz = static_cast<int>(gz + 0.5f);
+      ASSERT_TRUE(st.surface_at_world(wx, wz) == tile_test_surface(vx, vz));
+    }
+  }
+  ASSERT_TRUE(st.normal_at_world(0.0f, 0.0f).y > 0.8f);
+
+  std::vector<qe::renderer::Vertex> verts;
+  std::vector<uint16_t> indices;
+  qg::terrain::TileMeshCache::build_geometry(st, *st.tile(1, 1), verts, indices);
+  ASSERT_TRUE(verts.size() == 81 && indices.size() == 8 * 8 * 6);
+  ASSERT_FLOAT_EQ(verts[0].position[0], 8.0f - 12.5f, EPS);
+  ASSERT_FLOAT_EQ(verts[0].position[1], tile_test_height(8, 8), EPS);
+  st.close();
+  ASSERT_TRUE(!st.is_open());  // The mapping is released
+  std::remove(path.c_str());
+}
+
+void test_streaming_evicts_least_recent_within_budget() {
+  std::string path = write_tile_test_file();
+  qg::terrain::StreamingConfig cfg;
+  cfg.load_radius = 1.0f;
+  cfg.memory_budget = 2 * 81 * 9;  // Two tiles of 9 x 9 vertices
+  qg::terrain::StreamingTerrain st(cfg);
+  ASSERT_TRUE(st.open(path));
+
+  // Walk the focus through the centres of tiles (0,0) → (1,0) → (2,0) → (2,1)
+  const int path_tiles[4][2] = {{0, 0}, {1, 0}, {2, 0}, {2, 1}};
+  for (const auto& t : path_tiles) {
+    qe::math::Vec3 focus(t[0] * 8 + 4 - 12.5f, 0.0f, t[1] * 8 + 4 - 8.5f);
+    st.update(&focus, 1);
+    st.wait_idle();
+    st.update(&focus, 1);
+    ASSERT_TRUE(st.tile(t[0], t[1]) != nullptr);
+    ASSERT_TRUE(st.resident_tiles() <= 2);
+  }
+  ASSERT_TRUE(st.tile(0, 0) == nullptr);  // Oldest went first
+  ASSERT_TRUE(st.tile(2, 0) != nullptr);
+  ASSERT_TRUE(!st.has_detail(-10.0f, -6.0f));
+  st.close();
+  std::remove(path.c_str());
+}
+
+void test_streaming_raycast_matches_terrain() {
+  std::string path = write_tile_test_file();
+  std::vector<float> heights;
+  std::vector<qg::terrain::SurfaceType> surfaces;
+  for (int gz = 0; gz < 17; ++gz)
+    for (int gx = 0; gx < 25; ++gx) {
+      heights.push_back(tile_test_height(gx, gz));
+      surfaces.push_back(tile_test_surface(gx, gz));
+    }
+  qg::terrain::Terrain t;
+  t.set_data(25, 17, 1.0f, std::move(heights), std::move(surfaces));
+
+  qg::terrain::StreamingTerrain st;
+  ASSERT_TRUE(st.open(path));
+  const qe::math::Vec3 origin(-14.0f, 30.0f, -9.0f), dir(1.0f, -1.1f, 0.55f);
+  qg::terrain::TerrainHit coarse, a, b;
+  ASSERT_TRUE(st.raycast(origin, dir, 100.0f, coarse));  // Answered before any tile loads
+
+  qe::math::Vec3 focus(0.0f, 0.0f, 0.0f);
+  st.page_in(&focus, 1);
+  ASSERT_TRUE(st.resident_tiles() == 6);
+  // Rays crossing tile edges in both directions, and straight down
+  const qe::math::Vec3 origins[] = {origin, {11.0f, 25.0f, 7.0f}, {3.3f, 20.0f, -2.7f}};
+  const qe::math::Vec3 dirs[] = {dir, {-0.9f, -1.0f, -0.6f}, {0.0f, -1.0f, 0.0f}};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(t.raycast(origins[i], dirs[i], 100.0f, a));
+    ASSERT_TRUE(st.raycast(origins[i], dirs[i], 100.0f, b));
+    ASSERT_FLOAT_EQ(b.t, a.t, 1e-3f);
+    ASSERT_FLOAT_EQ(b.point.y, a.point.y, 1e-3f);
+    ASSERT_TRUE(b.normal.dot(a.normal) > 0.999f && b.surface == a.surface);
+  }
+  ASSERT_TRUE(st.segment_cast({0.0f, 20.0f, 0.0f}, {0.5f, -5.0f, 0.5f}, b));
+  ASSERT_FLOAT_EQ(b.point.y, t.height_at_world(b.point.x, b.point.z), 1e-3f);
+  ASSERT_TRUE(!st.raycast({0.0f, 20.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, 100.0f, b));
+  ASSERT_TRUE(!st.raycast({0.0f, 20.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, 5.0f, b));
+  st.close();
+  std::remove(path.c_str());
+}
+
+uint16_t dem_sample(int x, int y) {
+  return static_cast<uint16_t>(1000 + x * 37 + y * 11 + (x * y) % 7);
+}
+
+/** 33 x 17 DEM as 16-bit PGM (big-endian) and RAW (little-endian), plus an 8-bit mask. */
+void write_dem_test_files() {
+  std::ofstream pgm("test_dem.pgm", std::ios::binary);
+  pgm << "P5\n# test DEM\n33 17\n65535\n";
+  std::ofstream raw("test_dem.raw", std::ios::binary);
+  for (int y = 0; y < 17; ++y)
+    for (int x = 0; x < 33; ++x) {
+      uint16_t v = dem_sample(x, y);
+      pgm.put(static_cast<char>(v >> 8)).put(static_cast<char>(v & 0xFF));
+      raw.put(static_cast<char>(v & 0xFF)).put(static_cast<char>(v >> 8));
+    }
+  std::ofstream mask("test_mask.pgm", std::ios::binary);
+  mask << "P5 17 9 255\n";
+  for (int y = 0; y < 9; ++y)
+    for (int x = 0; x < 17; ++x)
+      mask.put(static_cast<char>(x < 8 ? 1 : 4));  // Fairway | Sand
+}
+
+void test_import_pgm_and_raw_agree() {
+  write_dem_test_files();
+  qg::terrain::Raster pgm, raw, mask;
+  ASSERT_TRUE(pgm.open_pgm("test_dem.pgm"));
+  ASSERT_TRUE(raw.open_raw("test_dem.raw", 33, 17));
+  ASSERT_TRUE(mask.open_pgm("test_mask.pgm"));
+  ASSERT_TRUE(pgm.width() == 33 && pgm.height() == 17 && mask.width() == 17);
+  for (int y = 0; y < 17; ++y)
+    for (int x = 0; x < 33; ++x)
+      ASSERT_TRUE(pgm.sample(x, y) == dem_sample(x, y) && raw.sample(x, y) == dem_sample(x, y));
+  ASSERT_TRUE(!raw.open_raw("test_dem.raw", 64, 64));  // Truncated
+
+  // Same spacing: vertices land on samples
+  qg::terrain::ImportParams p;
+  p.height_scale = 0.01f;
+  qg::terrain::Terrain t;
+  qg::terrain::HeightmapImport::to_terrain(t, pgm, &mask, p);
+  ASSERT_TRUE(t.width == 33 && t.depth == 17);
+  ASSERT_FLOAT_EQ(t.height_at(5, 3), dem_sample(5, 3) * 0.01f, 1e-4f);
+  ASSERT_TRUE(t.surface_at(2, 2) == qg::terrain::SurfaceType::Fairway);
+  ASSERT_TRUE(t.surface_at(30, 2) == qg::terrain::SurfaceType::Sand);
+
+  // 4 m cells over 1 m samples: box filter over the 5 x 5 footprint
+  p.cell_size = 4.0f;
+  qg::terrain::HeightmapImport::to_terrain(t, pgm, &mask, p);
+  ASSERT_TRUE(t.width == 9 && t.depth == 5);
+  float sum = 0.0f;
+  for (int y = 2; y <= 6; ++y)
+    for (int x = 2; x <= 6; ++x)
+      sum += dem_sample(x, y);
+  ASSERT_FLOAT_EQ(t.height_at(1, 1), sum / 25.0f * 0.01f, 1e-3f);
+  std::remove("test_dem.raw");
+}
+
+void test_import_tiles_match_terrain_import() {
+  write_dem_test_files();
+  qg::terrain::Raster pgm, mask;
+  ASSERT_TRUE(pgm.open_pgm("test_dem.pgm"));
+  ASSERT_TRUE(mask.open_pgm("test_mask.pgm"));
+  qg::terrain::ImportParams p;
+  p.source_spacing = 2.0f;
+  p.cell_size = 1.0f;  // Upsample: bilinear
+  p.tile_size = 16;
+  p.coarse_step = 8;
+  qg::terrain::Terrain t;
+  qg::terrain::HeightmapImport::to_terrain(t, pgm, &mask, p);
+  ASSERT_TRUE(t.width == 65 && t.depth == 33);
+  ASSERT_TRUE(qg::terrain::HeightmapImport::to_tiles("test_dem.qgt", pgm, &mask, p));
+
+  qg::terrain::StreamingTerrain st;
+  ASSERT_TRUE(st.open("test_dem.qgt"));
+  ASSERT_TRUE(st.layout().tiles_x == 4 && st.layout().tiles_z == 2);
+  qe::math::Vec3 focus(0.0f, 0.0f, 0.0f);
+  st.update(&focus, 1);
+  st.wait_idle();
+  st.update(&focus, 1);
+  for (int gz = 0; gz < 33; gz += 3)
+    for (int gx = 0; gx < 65; gx += 5) {
+      float wx = gx - 32.5f, wz = gz - 16.5f;
+      ASSERT_FLOAT_EQ(st.height_at_world(wx, wz), t.height_at(gx, gz), 1e-4f);
+      ASSERT_TRUE(st.surface_at_world(wx, wz) == t.surface_at(gx, gz));
+      auto a = st.normal_at_world(wx, wz), b = t.normal_at(gx, gz);
+      ASSERT_TRUE(a.dot(b) > 0.99f);  // snorm8-packed in the tile
+    }
+  float lo = 0.0f, hi = 0.0f;
+  st.tile_bounds(1, 0, lo, hi);
+  ASSERT_FLOAT_EQ(lo, t.height_at(16, 0), 1e-4f);
+  ASSERT_FLOAT_EQ(hi, t.height_at(32, 16), 1e-4f);
+  st.close();
+  std::remove("test_dem.qgt");
+  std::remove("test_dem.pgm");
+  std::remove("test_dem.raw");
+  std::remove("test_mask.pgm");
+}
+
+void test_import_heightmap_files_to_tiles() {
+  // The --import-heightmap path: rasters opened by extension, written as tiles
+  write_dem_test_files();
+  qg::terrain::ImportParams p;
+  p.tile_size = 16;
+  p.coarse_step = 8;
+  using qg::terrain::HeightmapImport;
+  ASSERT_TRUE(HeightmapImport::import_tiles("test_dem.pgm", "test_mask.pgm", "test_dem.qgt", p));
+  qg::terrain::StreamingTerrain st;
+  ASSERT_TRUE(st.open("test_dem.qgt"));
+  ASSERT_TRUE(st.layout().tiles_x == 2 && st.layout().tiles_z == 1);
+  qe::math::Vec3 focus(0.0f, 0.0f, 0.0f);
+  st.page_in(&focus, 1);
+  ASSERT_FLOAT_EQ(st.height_at_world(5 - 16.5f, 3 - 8.5f), dem_sample(5, 3) * 0.01f, 1e-4f);
+  ASSERT_TRUE(st.surface_at_world(30 - 16.5f, 2 - 8.5f) == qg::terrain::SurfaceType::Sand);
+  st.close();
+
+  // RAW needs its size; no mask means Rough everywhere
+  ASSERT_TRUE(!HeightmapImport::import_tiles("test_dem.raw", "", "test_dem.qgt", p));
+  ASSERT_TRUE(HeightmapImport::import_tiles("test_dem.raw", "", "test_dem.qgt", p, 33, 17));
+  ASSERT_TRUE(st.open("test_dem.qgt"));
+  st.page_in(&focus, 1);
+  ASSERT_FLOAT_EQ(st.height_at_world(20 - 16.5f, 9 - 8.5f), dem_sample(20, 9) * 0.01f, 1e-4f);
+  ASSERT_TRUE(st.surface_at_world(0.0f, 0.0f) == qg::terrain::SurfaceType::Rough);
+  st.close();
+  ASSERT_TRUE(!HeightmapImport::import_tiles("missing.pgm", "", "test_dem.qgt", p));
+  std::remove("test_dem.qgt");
+  std::remove("test_dem.pgm");
+  std::remove("test_dem.raw");
+  std::remove("test_mask.pgm");
+}
+
+// ============================================================================
+//  Terrain Raycast Tests
+// ============================================================================
+
+void test_pyramid_root_bounds_heights() {
+  auto t = make_ridge_terrain(33, 17, 20, 4.0f);
+  auto root = t.pyramid().root();
+  ASSERT_FLOAT_EQ(root.min, 0.0f, EPS);
+  ASSERT_FLOAT_EQ(root.max, 4.0f, EPS);
+  ASSERT_TRUE(t.pyramid().level_count() > 1);
+}
+
+void test_raycast_down_hits_flat() {
+  auto t = make_flat_terrain(20, 20, 2.0f, qg::terrain::SurfaceType::Green);
+  qg::terrain::TerrainHit hit;
+  ASSERT_TRUE(t.raycast({1.3f, 10.0f, -2.7f}, {0, -1, 0}, 100.0f, hit));
+  ASSERT_FLOAT_EQ(hit.point.y, 2.0f, EPS);
+  ASSERT_FLOAT_EQ(hit.t, 8.0f, EPS);
+  ASSERT_FLOAT_EQ(hit.normal.y, 1.0f, EPS);
+  ASSERT_TRUE(hit.surface == qg::terrain::SurfaceType::Green);
+}
+
+void test_raycast_oblique_matches_bilinear_height() {
+  // Sloped terrain: the hit point must lie on the interpolated surface
+  int w = 16, d = 16;
+  std::vector<float> heights(w * d);
+  for (int z = 0; z < d; ++z)
+    for (int x = 0; x < w; ++x)
+      heights[z * w + x] = 0.3f * x + 0.01f * z * z;
+  qg::terrain::Terrain t;
+  t.set_data(w, d, 1.0f, std::move(heights),
+             std::vector<qg::terrain::SurfaceType>(w * d, qg::terrain::SurfaceType::Fairway));
+
+  qg::terrain::TerrainHit hit;
+  ASSERT_TRUE(t.raycast({-6.0f, 12.0f, -5.0f}, {1.0f, -0.8f, 0.6f}, 100.0f, hit));
+  ASSERT_FLOAT_EQ(hit.point.y, t.height_at_world(hit.point.x, hit.point.z), 1e-3f);
+  ASSERT_FLOAT_EQ(hit.normal.length(), 1.0f, EPS);
+  ASSERT_TRUE(hit.normal.x < 0.0f);  // Surface rises toward +x
+}
+
+void test_raycast_misses_upward_and_from_below() {
+  auto t = make_flat_terrain(20, 20, 0.0f, qg::terrain::SurfaceType::Fairway);
+  qg::terrain::TerrainHit hit;
+  ASSERT_TRUE(!t.raycast({0, 5, 0}, {0.3f, 1, 0}, 100.0f, hit));
+  // Starting under the surface never reports a hit on the way up
+  ASSERT_TRUE(!t.raycast({0, -1, 0}, {0, 1, 0}, 100.0f, hit));
+  // Max distance short of the ground
+  ASSERT_TRUE(!t.raycast({0, 5, 0}, {0, -1, 0}, 4.0f, hit));
+}
+
+void test_segment_cast_catches_ridge_between_samples() {
+  // Both endpoints are above ground, but the segment passes through a ridge
+  auto t = make_ridge_terrain(32, 32, 16, 3.0f);
+  qg::terrain::TerrainHit hit;
+  ASSERT_TRUE(t.segment_cast({-4.0f, 1.0f, 0.3f}, {4.0f, 1.0f, 0.3f}, hit));
+  ASSERT_TRUE(hit.t > 0.0f && hit.t < 1.0f);
+  ASSERT_FLOAT_EQ(hit.point.y, 1.0f, EPS);
+  ASSERT_TRUE(hit.point.x < 0.0f);  // Hits the near face of the ridge (x = 0 peak)
+}
+
+void test_ball_does_not_tunnel_through_ridge() {
+  // Fast, low shot: one 0.1 s step carries the ball straight over the ridge
+  auto t = make_ridge_terrain(64, 64, 32, 3.0f);
+  qg::physics::BallPhysics phys;
+  qg::physics::BallState ball;
+  ball.position = {-3.0f, 1.0f, 0.0f};
+  phys.launch(ball, {60.0f, 0.0f, 0.0f});
+
+  phys.update(ball, t, 0.1f);
+
+  // The ridge peak is at x = 0; the ball must not end up past it
+  ASSERT_TRUE(ball.position.x < 0.0f);
+  ASSERT_TRUE(ball.velocity.x < 60.0f);
+}
+
 // ============================================================================
 //  Club Tests
 // ============================================================================
@@ -498,6 +1123,532 @@ void test_ball_spin_decays_in_flight() {
   ASSERT_TRUE(ball.spin.length() < initial_spin);
 }
 
+void test_aero_table_matches_model() {
+  qg::physics::AeroModel model;
+  qg::physics::AeroTable table(model, 100.0f, 64, 600.0f, 32);
+
+  // Exact at nodes (speed step 1.5625 m/s, spin nodes at 600 * (j / 32)^2)
+  auto a = model.eval(50.0f, 600.0f * 0.25f), b = table.lookup(50.0f, 150.0f);
+  ASSERT_FLOAT_EQ(a.cd, b.cd, 1e-6f);
+  ASSERT_FLOAT_EQ(a.cl, b.cl, 1e-6f);
+
+  float worst_cd = 0.0f, worst_cl = 0.0f;
+  for (float v = 5.0f; v < 95.0f; v += 0.37f) {
+    for (float w = 0.0f; w < 580.0f; w += 3.1f) {
+      auto m = model.eval(v, w), t = table.lookup(v, w);
+      worst_cd = std::max(worst_cd, std::fabs(m.cd - t.cd));
+      worst_cl = std::max(worst_cl, std::fabs(m.cl - t.cl));
+    }
+  }
+  ASSERT_TRUE(worst_cd < 0.01f && worst_cl < 0.01f);
+
+  // Clamped outside the grid
+  auto far = table.lookup(500.0f, 5000.0f), edge = table.lookup(100.0f, 600.0f);
+  ASSERT_FLOAT_EQ(far.cd, edge.cd, 0.0f);
+  ASSERT_FLOAT_EQ(far.cl, edge.cl, 0.0f);
+
+  // Drag crisis: slow balls have far more drag; lift grows with spin
+  ASSERT_TRUE(table.lookup(10.0f, 50.0f).cd > table.lookup(60.0f, 50.0f).cd + 0.15f);
+  ASSERT_TRUE(table.lookup(50.0f, 300.0f).cl > table.lookup(50.0f, 60.0f).cl);
+  ASSERT_FLOAT_EQ(table.lookup(50.0f, 0.0f).cl, 0.0f, 0.0f);
+}
+
+void test_ball_flight_uses_aero_table() {
+  auto terrain = make_flat_terrain(20, 20, -500.0f, qg::terrain::SurfaceType::Fairway);
+  auto apex = [&](qg::physics::BallPhysics phys) {
+    qg::physics::BallState ball;
+    phys.launch(ball, {40.0f, 20.0f, 0.0f}, {0.0f, 0.0f, 150.0f});  // Backspin
+    float top = 0.0f;
+    for (int i = 0; i < 600 && ball.in_flight; ++i) {
+      phys.update(ball, terrain, 1.0f / 120.0f);
+      top = std::max(top, ball.position.y);
+    }
+    return top;
+  };
+  qg::physics::BallPhysics table_phys, no_lift, constant;
+  ASSERT_TRUE(table_phys.aero == qg::physics::AeroTable::standard());
+  qg::physics::AeroModel m;
+  m.cl_scale = 0.0f;
+  no_lift.aero = std::make_shared<const qg::physics::AeroTable>(m);
+  constant.aero = nullptr;
+
+  ASSERT_TRUE(apex(table_phys) > apex(no_lift) + 1.0f);
+  ASSERT_FLOAT_EQ(constant.coefficients(40.0f, 150.0f).cd, constant.constants.drag_coeff, 0.0f);
+  ASSERT_TRUE(apex(constant) != apex(table_phys));
+}
+
+// ============================================================================
+//  GolfSim Tests
+// ============================================================================
+
+static qg::course::Hole make_test_hole(int number, qe::math::Vec3 tee, qe::math::Vec3 pin) {
+  qg::course::Hole h;
+  h.number = number;
+  h.par = 3;
+  h.tee.position = tee;
+  h.green.pin = pin;
+  return h;
+}
+
+void test_sim_water_penalty_keeps_strokes() {
+  qg::game::GolfSim sim;
+  sim.terrain = make_flat_terrain(64, 64, 0.0f, qg::terrain::SurfaceType::Water);
+  sim.holes = {make_test_hole(1, {0, 0, 20}, {0, 0, -20})};
+  sim.setup_hole(0);
+
+  sim.shoot(5, sim.pin_yaw(), 0.5f);
+  qg::game::SimEvents ev;
+  for (int i = 0; i < 2000 && !ev.water; ++i)
+    ev = sim.step(1.0f / 120.0f);
+
+  ASSERT_TRUE(ev.water);
+  ASSERT_TRUE(sim.stroke_count == 2);  // The shot plus the penalty
+  ASSERT_TRUE(sim.ready());
+  ASSERT_FLOAT_EQ(sim.ball.position.z, 20.0f, EPS);
+}
+
+void test_sim_holes_out_on_horizontal_distance() {
+  // Ground at 5 m while the pin is at y = 0: holing must ignore height
+  qg::game::GolfSim sim;
+  sim.terrain = make_flat_terrain(64, 64, 5.0f, qg::terrain::SurfaceType::Green);
+  sim.holes = {make_test_hole(1, {0, 0, 10}, {0, 0, 10}),
+               make_test_hole(2, {10, 0, 10}, {10, 0, -10})};
+  sim.setup_hole(0);
+
+  sim.shoot(qg::game::NUM_CLUBS - 1, 0.0f, 0.01f);
+  qg::game::SimEvents ev;
+  for (int i = 0; i < 2000 && ev.holed < 0; ++i)
+    ev = sim.step(1.0f / 120.0f);
+
+  ASSERT_TRUE(ev.holed == 0);
+  ASSERT_TRUE(ev.hole_strokes == 1);
+  ASSERT_TRUE(!ev.picked_up && !ev.round_complete);
+  ASSERT_TRUE(sim.current_hole == 1);
+  ASSERT_TRUE(sim.scores.size() == 1 && sim.scores[0] == 1);
+  ASSERT_TRUE(sim.stroke_count == 0);
+}
+
+void test_sim_picks_up_at_stroke_limit() {
+  qg::game::GolfSim sim;
+  sim.terrain = make_flat_terrain(64, 64, 0.0f, qg::terrain::SurfaceType::Fairway);
+  sim.holes = {make_test_hole(1, {0, 0, 20}, {0, 0, -20})};
+  sim.max_strokes = 2;
+  sim.setup_hole(0);
+
+  qg::game::SimEvents ev;
+  for (int shot = 0; shot < 2; ++shot) {
+    sim.shoot(qg::game::NUM_CLUBS - 1, sim.pin_yaw(), 0.05f);  // Far too short
+    for (int i = 0; i < 4000 && !sim.ready(); ++i)
+      ev = sim.step(1.0f / 120.0f);
+  }
+  ASSERT_TRUE(ev.holed == 0 && ev.picked_up);
+  ASSERT_TRUE(ev.round_complete && ev.round_strokes == 2);
+  ASSERT_TRUE(sim.scores.empty());
+}
+
+void test_sim_sleeps_while_waiting_and_wakes_on_shot() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  sim.sleep_delay = 1.0f;
+  sim.setup_hole(0);
+  ASSERT_TRUE(!sim.enemies.enemies.empty());
+
+  const float dt = 1.0f / 120.0f;
+  for (int i = 0; i < 100; ++i)
+    sim.step(dt);
+  ASSERT_TRUE(!sim.asleep());
+  for (int i = 0; i < 30; ++i)
+    sim.step(dt);
+  ASSERT_TRUE(sim.asleep());
+
+  // Asleep: stepping changes nothing, enemies included
+  qe::core::ByteWriter before, after;
+  sim.save_state(before);
+  float timer = sim.enemies.enemies[0]->state_timer;
+  for (int i = 0; i < 60; ++i)
+    sim.step(dt);
+  sim.save_state(after);
+  ASSERT_TRUE(after.data() == before.data());
+  ASSERT_TRUE(sim.enemies.enemies[0]->sleeping);
+
+  // The sleep flag survives a snapshot round trip
+  qg::game::GolfSim copy;
+  copy.generate();
+  copy.spawn_enemies();
+  qe::core::ByteReader in(before.data());
+  ASSERT_TRUE(copy.restore_state(in) && copy.asleep());
+
+  sim.shoot(0, sim.pin_yaw(), 0.8f);
+  ASSERT_TRUE(!sim.asleep() && !sim.enemies.enemies[0]->sleeping);
+  sim.step(dt);
+  ASSERT_TRUE(sim.enemies.enemies[0]->state_timer > timer);
+}
+
+void test_sim_stays_awake_while_aiming() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  sim.sleep_delay = 1.0f;
+  sim.setup_hole(0);
+  ASSERT_TRUE(!sim.enemies.enemies.empty());
+
+  // Recorded ticks of mouse aim, applied the way game and headless
+  // playback both apply them
+  qg::game::ReplayTick aiming;
+  aiming.dt = 1.0f / 120.0f;
+  aiming.input.axes[3] = 4.0f;  // look_x
+  float timer = sim.enemies.enemies[0]->state_timer;
+  for (int i = 0; i < 240; ++i) {  // Twice sleep_delay
+    ASSERT_TRUE(qg::game::apply_replay_events(sim, aiming));
+    sim.step(aiming.dt);
+    ASSERT_TRUE(!sim.asleep());
+  }
+  ASSERT_TRUE(!sim.enemies.enemies[0]->sleeping);
+  ASSERT_TRUE(sim.enemies.enemies[0]->state_timer != timer);
+
+  // Hands off: asleep one sleep_delay after the last input
+  qg::game::ReplayTick idle;
+  idle.dt = aiming.dt;
+  for (int i = 0; i < 130; ++i) {
+    qg::game::apply_replay_events(sim, idle);
+    sim.step(idle.dt);
+  }
+  ASSERT_TRUE(sim.asleep() && sim.enemies.enemies[0]->sleeping);
+
+  // Input wakes a sleeping sim
+  qg::game::apply_replay_events(sim, aiming);
+  ASSERT_TRUE(!sim.asleep() && !sim.enemies.enemies[0]->sleeping);
+}
+
+void test_shot_script_parse() {
+  qg::game::ShotScript script;
+  ASSERT_TRUE(script.parse("# club power aim\n0 1.0\n\n8 0.4 -2.5  # putt\nauto\n"));
+  ASSERT_TRUE(script.size() == 3);
+  auto a = script.next();
+  ASSERT_TRUE(!a.automatic && a.club == 0);
+  ASSERT_FLOAT_EQ(a.power, 1.0f, EPS);
+  ASSERT_FLOAT_EQ(a.aim_deg, 0.0f, EPS);
+  auto b = script.next();
+  ASSERT_TRUE(!b.automatic && b.club == 8);
+  ASSERT_FLOAT_EQ(b.aim_deg, -2.5f, EPS);
+  ASSERT_TRUE(script.next().automatic);
+  ASSERT_TRUE(script.next().automatic);  // Past the end
+
+  ASSERT_TRUE(!script.parse("0 1.0\n12 0.5\n"));  // No club 12
+  ASSERT_TRUE(!script.parse("driver\n"));
+}
+
+void test_headless_runs_are_deterministic() {
+  auto run = [](uint32_t seed) {
+    qg::game::GolfSim sim;
+    sim.generate();
+    sim.spawn_enemies();
+    qg::game::ShotScript script;
+    script.parse("0 1.0 0\n");  // Scripted tee shot, then the caddie
+    qg::game::HeadlessConfig cfg;
+    cfg.rounds = 2;
+    cfg.seed = seed;
+    return qg::game::run_headless(sim, script, cfg);
+  };
+  auto a = run(1), b = run(1), c = run(2);
+
+  ASSERT_TRUE(a.rounds == 2 && a.round_strokes.size() == 2);
+  ASSERT_TRUE(a.shots >= 2 * 3);  // At least one shot per hole
+  ASSERT_TRUE(a.checksum == b.checksum);
+  ASSERT_TRUE(a.shots == b.shots && a.sim_steps == b.sim_steps);
+  ASSERT_TRUE(a.round_strokes == b.round_strokes);
+  ASSERT_TRUE(a.checksum != c.checksum);
+}
+
+void test_headless_plays_on_streamed_tiles() {
+  // The generated course's heightmap as 3 x 3 tiles of 85 cells (256 vertices across)
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  qg::terrain::TileLayout layout;
+  layout.tile_size = 85;
+  layout.tiles_x = layout.tiles_z = 3;
+  layout.coarse_step = 17;
+  const qg::terrain::Terrain& course = sim.terrain;
+  ASSERT_TRUE(qg::terrain::TileFile::write(
+      "test_course.qgt", layout, [&](int gx, int gz) { return course.height_at(gx, gz); },
+      [&](int gx, int gz) { return course.surface_at(gx, gz); }));
+
+  auto run = [&]() {
+    qg::terrain::StreamingConfig sc;
+    sc.load_radius = 60.0f;  // Page as the ball travels
+    qg::terrain::StreamingTerrain tiles(sc);
+    if (!tiles.open("test_course.qgt"))
+      return qg::game::HeadlessResult{};
+    sim.streamed = &tiles;
+    qg::game::ShotScript script;
+    qg::game::HeadlessConfig cfg;
+    auto r = qg::game::run_headless(sim, script, cfg);
+    sim.streamed = nullptr;
+    return r;
+  };
+  auto a = run(), b = run();
+  std::remove("test_course.qgt");
+
+  ASSERT_TRUE(a.rounds == 1 && a.shots >= 3);
+  ASSERT_TRUE(a.checksum == b.checksum && a.sim_steps == b.sim_steps);
+  ASSERT_FLOAT_EQ(sim.ball.position.y - sim.physics.constants.radius,
+                  sim.terrain.height_at_world(sim.ball.position.x, sim.ball.position.z), 0.2f);
+}
+
+void test_headless_steady_state_steps_do_not_allocate() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  qg::game::ShotScript script;
+  qg::game::HeadlessConfig cfg;
+  cfg.rounds = 3;
+  auto r = qg::game::run_headless(sim, script, cfg);
+  ASSERT_TRUE(qe::core::AllocTracker::installed());
+  ASSERT_TRUE(r.rounds == 3);
+  ASSERT_TRUE(r.steady_step_allocs == 0);
+}
+
+void test_replay_round_trips_ticks() {
+  qg::game::ReplayWriter w;
+  w.begin(2, 7);
+  std::vector<qg::game::ReplayTick> ticks(50);
+  for (size_t i = 0; i < ticks.size(); ++i) {
+    auto& t = ticks[i];
+    t.dt = i < 30 ? 1.0f / 60.0f : 1.0f / 144.0f;
+    t.input.axes[3] = i >= 10 && i < 12 ? 4.5f : 0.0f;  // Short mouse flick
+    t.input.buttons = i == 20 ? qe::input::kShootPressed | qe::input::kShootHeld : 0;
+  }
+  ticks[5].hole = 1;
+  ticks[40].has_shot = true;
+  ticks[40].shot = {3, 0.75f, -1.25f, {0.0f, 120.0f, -8.0f}, {10.0f, 2.5f, -30.0f}};
+  for (const auto& t : ticks)
+    w.write(t);
+  ASSERT_TRUE(w.ticks() == ticks.size());
+  ASSERT_TRUE(w.data().size() < 100);  // Runs of identical ticks collapse
+
+  qg::game::ReplayReader r;
+  ASSERT_TRUE(r.load(w.data()));
+  ASSERT_TRUE(r.start_hole() == 2 && r.max_strokes() == 7);
+  qg::game::ReplayTick t;
+  bool same = true;
+  for (const auto& want : ticks) {
+    same = same && r.next(t, 3) && t.dt == want.dt && t.hole == want.hole &&
+           t.has_shot == want.has_shot && t.input.buttons == want.input.buttons &&
+           t.input.look_x() == want.input.look_x();
+  }
+  ASSERT_TRUE(same);
+  ASSERT_TRUE(!r.next(t, 3) && !r.failed());  // Clean end
+
+  r.load(w.data());
+  for (int i = 0; i <= 40; ++i)
+    r.next(t, 3);
+  ASSERT_TRUE(t.has_shot && t.shot.club == 3);
+  ASSERT_FLOAT_EQ(t.shot.power, 0.75f, 0.0f);
+  ASSERT_FLOAT_EQ(t.shot.spin.y, 120.0f, 0.0f);
+  ASSERT_FLOAT_EQ(t.shot.lie.z, -30.0f, 0.0f);
+
+  // Truncated streams and foreign files are rejected
+  std::vector<uint8_t> cut(w.data().begin(), w.data().end() - 20);
+  ASSERT_TRUE(r.load(cut));
+  bool failed = false;
+  for (size_t i = 0; i < ticks.size() && !failed; ++i)
+    failed = !r.next(t, 3);
+  ASSERT_TRUE(failed && r.failed());
+  ASSERT_TRUE(!r.load(std::vector<uint8_t>{'Q', 'G', 'C', 'F', 1}));
+}
+
+void test_replay_rejects_out_of_range_indices() {
+  auto corrupt = [](int hole, int club) {
+    qg::game::ReplayWriter w;
+    w.begin(0, 5);
+    qg::game::ReplayTick t;
+    t.dt = 1.0f / 120.0f;
+    w.write(t);
+    t.hole = hole;
+    t.has_shot = true;
+    t.shot.club = club;
+    w.write(t);
+    t.hole = -1;
+    t.has_shot = false;
+    w.write(t);
+    return w.data();
+  };
+  qg::game::ReplayReader r;
+  qg::game::ReplayTick t;
+  ASSERT_TRUE(r.load(corrupt(2, 8)));  // Last hole, last club: valid
+  ASSERT_TRUE(r.next(t, 3) && r.next(t, 3) && t.hole == 2 && t.shot.club == 8);
+  ASSERT_TRUE(r.next(t, 3) && !r.next(t, 3) && !r.failed());
+
+  for (auto data : {corrupt(3, 0), corrupt(1000000, 0), corrupt(0, 9), corrupt(0, 4096)}) {
+    ASSERT_TRUE(r.load(data));
+    ASSERT_TRUE(r.next(t, 3));
+    ASSERT_TRUE(!r.next(t, 3) && r.failed());
+    ASSERT_TRUE(!r.next(t, 3));  // Stays failed rather than resyncing mid-record
+  }
+
+  // Playback of a corrupt replay stops at the bad tick instead of indexing past the course
+  qg::game::GolfSim sim;
+  sim.generate();
+  ASSERT_TRUE(r.load(corrupt(7, 0)));
+  auto res = qg::game::replay_headless(sim, r);
+  ASSERT_TRUE(r.failed() && res.sim_steps == 1 && res.shots == 0);
+}
+
+void test_replay_reproduces_headless_run() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  qg::game::ShotScript script;
+  qg::game::HeadlessConfig cfg;
+  qg::game::ReplayWriter rec;
+  auto live = qg::game::run_headless(sim, script, cfg, &rec);
+
+  qg::game::ReplayReader replay;
+  ASSERT_TRUE(replay.load(rec.data()));
+  int desyncs = -1;
+  auto played = qg::game::replay_headless(sim, replay, &desyncs);
+  ASSERT_TRUE(desyncs == 0);
+  ASSERT_TRUE(played.checksum == live.checksum);
+  ASSERT_TRUE(played.sim_steps == live.sim_steps && played.shots == live.shots);
+  ASSERT_TRUE(played.round_strokes == live.round_strokes);
+  ASSERT_TRUE(rec.data().size() < live.sim_steps);  // Well under a byte per tick
+
+  // A shot recorded from the wrong lie is reported, not silently applied
+  qg::game::ReplayTick t;
+  t.dt = cfg.dt;
+  sim.setup_hole(0);
+  t.has_shot = true;
+  t.shot = qg::game::record_shot(sim, 0, sim.pin_yaw(), 0.5f);
+  t.shot.lie.x += 1.0f;
+  ASSERT_TRUE(!qg::game::apply_replay_events(sim, t));
+}
+
+void test_world_snapshot_restores_and_replays() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  sim.setup_hole(0);
+  qe::game::ParticleSystem fx;
+  fx.seed(42);
+
+  const float dt = 1.0f / 120.0f;
+  sim.shoot(0, sim.pin_yaw(), 0.8f);
+  for (int i = 0; i < 90; ++i)
+    sim.step(dt);
+  fx.spawn(sim.ball.position, 20, {1, 1, 1});
+
+  qe::core::ByteWriter before, after, again;
+  qg::game::save_world(sim, &fx, before);
+  auto run = [&] {
+    for (int i = 0; i < 240; ++i) {
+      sim.step(dt);
+      fx.update(dt);
+    }
+    fx.spawn(sim.ball.position, 5, {1, 0, 0});
+  };
+  run();
+  qg::game::save_world(sim, &fx, after);
+
+  // Restoring puts back every byte, and the world then evolves identically
+  ASSERT_TRUE(qg::game::load_world(sim, &fx, before.data()));
+  qg::game::save_world(sim, &fx, again);
+  ASSERT_TRUE(again.data() == before.data());
+  run();
+  qg::game::save_world(sim, &fx, again);
+  ASSERT_TRUE(again.data() == after.data());
+
+  // Snapshots from a different enemy set are refused without changes
+  qg::game::GolfSim other;
+  other.generate();
+  other.setup_hole(1);
+  ASSERT_TRUE(!qg::game::load_world(other, nullptr, before.data()));
+  ASSERT_TRUE(other.current_hole == 1);
+}
+
+void test_world_snapshot_truncated_changes_nothing() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  sim.setup_hole(0);
+  qe::game::ParticleSystem fx;
+  fx.seed(7);
+  sim.shoot(0, sim.pin_yaw(), 0.8f);
+  for (int i = 0; i < 60; ++i)
+    sim.step(1.0f / 120.0f);
+  fx.spawn(sim.ball.position, 8, {1, 1, 1});
+  sim.scores = {4, 5};
+
+  qe::core::ByteWriter snap, now, check;
+  qg::game::save_world(sim, &fx, snap);
+  for (int i = 0; i < 120; ++i) {
+    sim.step(1.0f / 120.0f);
+    fx.update(1.0f / 120.0f);
+  }
+  sim.scores.push_back(3);
+  qg::game::save_world(sim, &fx, now);
+
+  // Every proper prefix is refused, leaving sim and particles untouched
+  bool unchanged = true;
+  for (size_t n = 0; n < snap.data().size(); ++n) {
+    unchanged = unchanged && !qg::game::load_world(sim, &fx, snap.data().data(), n);
+    qg::game::save_world(sim, &fx, check);
+    unchanged = unchanged && check.data() == now.data();
+  }
+  ASSERT_TRUE(unchanged);
+
+  // Corrupt score count (past the end): refused the same way
+  std::vector<uint8_t> bad = snap.data();
+  qe::core::ByteWriter sim_only;
+  sim.save_state(sim_only);
+  const size_t scores_at = sim_only.data().size() - 4 * (sim.scores.size() + 1);
+  bad[scores_at + 3] = 0x7F;
+  ASSERT_TRUE(!qg::game::load_world(sim, &fx, bad));
+  qg::game::save_world(sim, &fx, check);
+  ASSERT_TRUE(check.data() == now.data());
+
+  ASSERT_TRUE(qg::game::load_world(sim, &fx, snap.data()));
+  qg::game::save_world(sim, &fx, check);
+  ASSERT_TRUE(check.data() == snap.data());
+}
+
+void test_world_history_steps_back_frame_by_frame() {
+  qg::game::GolfSim sim;
+  sim.generate();
+  sim.spawn_enemies();
+  sim.setup_hole(0);
+  qe::game::ParticleSystem fx;
+
+  qg::game::WorldHistory history;
+  std::vector<std::vector<uint8_t>> frames;
+  qe::core::ByteWriter w;
+  sim.shoot(0, sim.pin_yaw(), 1.0f);
+  for (int i = 0; i < 600; ++i) {  // Five seconds at 120 Hz
+    sim.step(1.0f / 120.0f);
+    if (i == 30)
+      fx.spawn(sim.ball.position, 10, {1, 1, 1});
+    fx.update(1.0f / 120.0f);
+    history.capture(sim, &fx);
+    qg::game::save_world(sim, &fx, w);
+    frames.push_back(w.data());
+  }
+  size_t full_bytes = 0;
+  for (const auto& f : frames)
+    full_bytes += f.size();
+  ASSERT_TRUE(history.size() == 600);
+  ASSERT_TRUE(history.delta_bytes() < full_bytes / 3);
+
+  bool match = true;
+  for (int back = 1; back <= 300; ++back) {
+    match = match && history.step_back(sim, &fx);
+    qg::game::save_world(sim, &fx, w);
+    match = match && w.data() == frames[599 - back];
+  }
+  ASSERT_TRUE(match);
+  ASSERT_TRUE(history.size() == 300);
+}
+
 // ============================================================================
 //  main
 // ============================================================================
@@ -521,6 +1672,32 @@ int main() {
   RUN_TEST(test_terrain_surface_at_world);
   RUN_TEST(test_terrain_flat_normal_is_up);
   RUN_TEST(test_terrain_sloped_normal_tilted);
+  RUN_TEST(test_surface_table_indexed_by_type);
+  RUN_TEST(test_terrain_normal_field_matches_differences);
+  RUN_TEST(test_terrain_batch_matches_point_queries);
+  RUN_TEST(test_terrain_mesh_bands_replay_full_grid);
+  RUN_TEST(test_terrain_quantized_matches_float_within_step);
+  RUN_TEST(test_terrain_storage_round_trip);
+  RUN_TEST(test_terrain_edit_writes_back_and_refreshes);
+  RUN_TEST(test_terrain_edit_regions_and_quantized_tiles);
+  RUN_TEST(test_course_stamps_paint_hole_features);
+  RUN_TEST(test_fairway_distance_matches_swept_circles);
+  RUN_TEST(test_course_file_round_trip);
+  RUN_TEST(test_course_file_rejects_bad_input);
+  RUN_TEST(test_streaming_coarse_until_loaded_then_detail);
+  RUN_TEST(test_streaming_evicts_least_recent_within_budget);
+  RUN_TEST(test_streaming_raycast_matches_terrain);
+  RUN_TEST(test_import_pgm_and_raw_agree);
+  RUN_TEST(test_import_tiles_match_terrain_import);
+  RUN_TEST(test_import_heightmap_files_to_tiles);
+
+  std::cout << "\n--- Terrain Raycast ---" << std::endl;
+  RUN_TEST(test_pyramid_root_bounds_heights);
+  RUN_TEST(test_raycast_down_hits_flat);
+  RUN_TEST(test_raycast_oblique_matches_bilinear_height);
+  RUN_TEST(test_raycast_misses_upward_and_from_below);
+  RUN_TEST(test_segment_cast_catches_ridge_between_samples);
+  RUN_TEST(test_ball_does_not_tunnel_through_ridge);
 
   std::cout << "\n--- Club ---" << std::endl;
   RUN_TEST(test_club_driver_forward_launch);
@@ -549,6 +1726,25 @@ int main() {
   RUN_TEST(test_ball_rolling_on_water_enters_water);
   RUN_TEST(test_ball_speed_nonnegative_after_update);
   RUN_TEST(test_ball_spin_decays_in_flight);
+  RUN_TEST(test_aero_table_matches_model);
+  RUN_TEST(test_ball_flight_uses_aero_table);
+
+  std::cout << "\n--- GolfSim ---" << std::endl;
+  RUN_TEST(test_sim_water_penalty_keeps_strokes);
+  RUN_TEST(test_sim_holes_out_on_horizontal_distance);
+  RUN_TEST(test_sim_picks_up_at_stroke_limit);
+  RUN_TEST(test_sim_sleeps_while_waiting_and_wakes_on_shot);
+  RUN_TEST(test_sim_stays_awake_while_aiming);
+  RUN_TEST(test_shot_script_parse);
+  RUN_TEST(test_headless_runs_are_deterministic);
+  RUN_TEST(test_headless_plays_on_streamed_tiles);
+  RUN_TEST(test_headless_steady_state_steps_do_not_allocate);
+  RUN_TEST(test_replay_round_trips_ticks);
+  RUN_TEST(test_replay_rejects_out_of_range_indices);
+  RUN_TEST(test_replay_reproduces_headless_run);
+  RUN_TEST(test_world_snapshot_restores_and_replays);
+  RUN_TEST(test_world_snapshot_truncated_changes_nothing);
+  RUN_TEST(test_world_history_steps_back_frame_by_frame);
 
   std::cout << "\n=== Results: " << g_tests_passed << "/" << g_tests_run << " passed";
   if (g_tests_failed > 0) {
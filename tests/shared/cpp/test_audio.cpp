@@ -0,0 +1,745 @@
+/**
+ * @file test_audio.cpp
+ * @brief Tests for the SDL-free audio core: command ring and voice mixer.
+ *
+ * Covers:
+ *   - SpscRing: ordering, full/empty, cross-thread transfer
+ *   - Mixer: gain and pan, clipping, voice lifetime, looping, voice limit,
+ *     SIMD kernels vs. scalar reference
+ *   - Oscillator: waveforms, ADSR timing, synth voices in the mixer
+ *   - Assets: WAV parsing, PCM decoding, resampling, streaming vs. load-time
+ *     conversion
+ *   - Voice management: ranking, virtual voices, stealing, distance gain
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/AudioStream.h"
+#include "audio/Mixer.h"
+#include "audio/Oscillator.h"
+#include "audio/Resampler.h"
+#include "audio/WavReader.h"
+#include "core/SpscRing.h"
+
+// --- Minimal Test Framework ---
+
+static int g_tests_run = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define ASSERT_TRUE(expr)                                                                          \
+  do {                                                                                             \
+    ++g_tests_run;                                                                                 \
+    if (!(expr)) {                                                                                 \
+      std::cerr << "  FAIL: " << #expr << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+      ++g_tests_failed;                                                                            \
+    } else {                                                                                       \
+      ++g_tests_passed;                                                                            \
+    }                                                                                              \
+  } while (0)
+
+#define RUN_TEST(test_fn)                                                        \
+  do {                                                                           \
+    std::cout << "  " << #test_fn << "... ";                                     \
+    int before_fail = g_tests_failed;                                            \
+    test_fn();                                                                   \
+    std::cout << (g_tests_failed == before_fail ? "OK" : "FAILED") << std::endl; \
+  } while (0)
+
+using qe::audio::Mixer;
+using qe::audio::Oscillator;
+using qe::audio::PcmFormat;
+using qe::audio::Priority;
+using qe::audio::SampleFormat;
+using qe::audio::SynthParams;
+using qe::audio::VoiceId;
+using qe::audio::Waveform;
+
+/** Stereo clip whose left channel is +value and right channel is -value. */
+static std::vector<int16_t> make_stereo(size_t frames, int16_t value) {
+  std::vector<int16_t> v(2 * frames);
+  for (size_t i = 0; i < frames; ++i) {
+    v[2 * i] = value;
+    v[2 * i + 1] = static_cast<int16_t>(-value);
+  }
+  return v;
+}
+
+static std::vector<int16_t> mix(Mixer& m, size_t frames) {
+  std::vector<int16_t> out(2 * frames, 12345);
+  m.mix(out.data(), frames);
+  return out;
+}
+
+// ============================================================================
+//  SpscRing
+// ============================================================================
+
+void test_spsc_ring_order_and_bounds() {
+  qe::core::SpscRing<int, 4> ring;
+  int x = 0;
+  ASSERT_TRUE(ring.empty() && !ring.pop(x));
+  for (int i = 1; i <= 4; ++i)
+    ASSERT_TRUE(ring.push(i));
+  ASSERT_TRUE(!ring.push(5));
+  ASSERT_TRUE(ring.size() == 4);
+
+  // Wrap around the slot array several times
+  for (int i = 1; i <= 20; ++i) {
+    ASSERT_TRUE(ring.pop(x) && x == i);
+    ASSERT_TRUE(ring.push(i + 4));
+  }
+  ASSERT_TRUE(ring.size() == 4);
+}
+
+void test_spsc_ring_transfers_across_threads() {
+  qe::core::SpscRing<uint32_t, 64> ring;
+  const uint32_t n = 200000;
+  std::thread producer([&] {
+    for (uint32_t i = 1; i <= n; ++i)
+      while (!ring.push(i))
+        std::this_thread::yield();
+  });
+  uint32_t expected = 1, v = 0;
+  bool in_order = true;
+  while (expected <= n) {
+    if (!ring.pop(v)) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order &= v == expected;
+    ++expected;
+  }
+  producer.join();
+  ASSERT_TRUE(in_order);
+  ASSERT_TRUE(ring.empty());
+}
+
+// ============================================================================
+//  Mixer
+// ============================================================================
+
+void test_mixer_silence_without_voices() {
+  Mixer m;
+  auto out = mix(m, 100);
+  bool silent = true;
+  for (int16_t s : out)
+    silent &= s == 0;
+  ASSERT_TRUE(silent);
+  ASSERT_TRUE(m.active_voices() == 0);
+}
+
+void test_mixer_gain_and_pan() {
+  auto clip = make_stereo(64, 10000);
+  Mixer m;
+  m.play(clip.data(), 64, 2, 0.5f);
+  auto out = mix(m, 16);
+  ASSERT_TRUE(out[0] == 5000 && out[1] == -5000);
+  ASSERT_TRUE(out[30] == 5000 && out[31] == -5000);
+
+  // Hard left keeps the left channel at full gain and silences the right
+  Mixer left;
+  VoiceId id = left.play(clip.data(), 64, 2, 1.0f, -1.0f);
+  out = mix(left, 8);
+  ASSERT_TRUE(out[0] == 10000 && out[1] == 0);
+
+  // Commands take effect at the next mix() call
+  left.set_pan(id, 0.5f);
+  left.set_gain(id, 0.25f);
+  out = mix(left, 8);
+  ASSERT_TRUE(out[0] == 1250 && out[1] == -2500);
+
+  // Mono sources feed both channels
+  std::vector<int16_t> mono(32, 8000);
+  Mixer mm;
+  mm.play(mono.data(), 32, 1, 1.0f, 0.5f);
+  out = mix(mm, 8);
+  ASSERT_TRUE(out[0] == 4000 && out[1] == 8000 && out[14] == 4000 && out[15] == 8000);
+}
+
+void test_mixer_sums_and_clips() {
+  auto a = make_stereo(32, 20000);
+  auto b = make_stereo(32, 20000);
+  Mixer m;
+  m.play(a.data(), 32, 2, 1.0f);
+  m.play(b.data(), 32, 2, 1.0f);
+  auto out = mix(m, 32);
+  ASSERT_TRUE(out[0] == 32767 && out[1] == -32768);
+  ASSERT_TRUE(out[62] == 32767 && out[63] == -32768);
+}
+
+void test_mixer_voice_lifetime_and_loop() {
+  auto clip = make_stereo(10, 1000);
+  Mixer m;
+  m.play(clip.data(), 10, 2);
+  VoiceId looped = m.play(clip.data(), 10, 2, 1.0f, 0.0f, true);
+  auto out = mix(m, 25);
+  ASSERT_TRUE(out[2 * 9] == 2000);    // Both voices
+  ASSERT_TRUE(out[2 * 10] == 1000);   // One-shot ended, loop wrapped
+  ASSERT_TRUE(out[2 * 24] == 1000);
+  ASSERT_TRUE(m.active_voices() == 1);
+
+  m.stop(looped);
+  m.stop(12345);  // Unknown ids are ignored
+  out = mix(m, 4);
+  ASSERT_TRUE(out[0] == 0 && m.active_voices() == 0);
+}
+
+void test_mixer_voice_limit_and_large_blocks() {
+  auto clip = make_stereo(5000, 1);
+  Mixer m(64, 256);
+  for (int i = 0; i < 65; ++i)
+    m.play(clip.data(), 5000, 2);
+  auto out = mix(m, 1000);  // Split across accumulator blocks
+  ASSERT_TRUE(m.active_voices() == 64);
+  ASSERT_TRUE(m.dropped() == 1);
+  ASSERT_TRUE(out[0] == 64 && out[2 * 999 + 1] == -64);
+
+  m.stop_all();
+  mix(m, 1);
+  ASSERT_TRUE(m.active_voices() == 0);
+}
+
+void test_mixer_kernels_match_scalar() {
+  // Odd lengths exercise the SIMD bodies and the scalar tails
+  const size_t frames = 37;
+  std::vector<int16_t> stereo(2 * frames), mono(frames);
+  for (size_t i = 0; i < 2 * frames; ++i)
+    stereo[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+  for (size_t i = 0; i < frames; ++i)
+    mono[i] = static_cast<int16_t>((i * 104729) % 65536 - 32768);
+
+  std::vector<float> acc(2 * frames, 0.0f), ref(2 * frames, 0.0f);
+  qe::audio::mixer_detail::mix_stereo(stereo.data(), acc.data(), frames, 0.7f, -0.3f);
+  qe::audio::mixer_detail::mix_mono(mono.data(), acc.data(), frames, 1.3f, 0.9f);
+  for (size_t i = 0; i < frames; ++i) {
+    ref[2 * i] = stereo[2 * i] * 0.7f;
+    ref[2 * i + 1] = stereo[2 * i + 1] * -0.3f;
+    ref[2 * i] += mono[i] * 1.3f;
+    ref[2 * i + 1] += mono[i] * 0.9f;
+  }
+  ASSERT_TRUE(acc == ref);
+
+  std::vector<int16_t> out(2 * frames);
+  qe::audio::mixer_detail::to_s16(acc.data(), out.data(), out.size());
+  bool same = true;
+  for (size_t i = 0; i < out.size(); ++i) {
+    float c = std::fmin(std::fmax(ref[i], -32768.0f), 32767.0f);
+    same &= out[i] == static_cast<int16_t>(std::nearbyint(c));
+  }
+  ASSERT_TRUE(same);
+}
+
+// ============================================================================
+//  Oscillator
+// ============================================================================
+
+/** Render a whole note (up to max samples). */
+static std::vector<float> render_note(const SynthParams& p, int sample_rate, size_t max = 100000) {
+  Oscillator osc;
+  osc.start(p, sample_rate);
+  std::vector<float> out(max);
+  out.resize(osc.render(out.data(), max));
+  return out;
+}
+
+void test_oscillator_envelope_timing() {
+  SynthParams p;
+  p.wave = Waveform::Sine;
+  p.frequency = 250.0f;  // Four samples per period: peaks land on samples
+  p.amplitude = 1.0f;
+  p.duration = 0.5f;
+  p.env = {0.1f, 0.1f, 0.5f, 0.2f};
+  auto note = render_note(p, 1000);
+  // Held for 500 samples, then 200 samples of release
+  ASSERT_TRUE(note.size() >= 699 && note.size() <= 701);
+
+  Oscillator osc;
+  osc.start(p, 1000);
+  std::vector<float> buf(1000);
+  ASSERT_TRUE(osc.render(buf.data(), 100) == 100 && !osc.finished());
+  ASSERT_TRUE(osc.render(buf.data(), 1000) < 1000 && osc.finished());
+  ASSERT_TRUE(osc.render(buf.data(), 10) == 0);
+
+  // Peak near full scale during attack/decay, half during sustain
+  float early = 0, held = 0;
+  for (size_t i = 50; i < 150; ++i)
+    early = std::fmax(early, std::fabs(note[i]));
+  for (size_t i = 300; i < 480; ++i)
+    held = std::fmax(held, std::fabs(note[i]));
+  ASSERT_TRUE(early > 0.9f * 32767.0f && early <= 32767.0f);
+  ASSERT_TRUE(std::fabs(held - 0.5f * 32767.0f) < 0.01f * 32767.0f);
+}
+
+void test_oscillator_waveforms() {
+  SynthParams p;
+  p.amplitude = 1.0f;
+  p.duration = 1.0f;
+  p.env = {0.0f, 0.0f, 1.0f, 0.0f};
+
+  // Sine recurrence tracks sin() closely
+  p.wave = Waveform::Sine;
+  p.frequency = 441.0f;
+  auto sine = render_note(p, 44100);
+  double worst = 0.0;
+  for (size_t i = 0; i + 1 < sine.size(); ++i) {  // The last sample is the release
+    double expect = std::sin(2.0 * M_PI * 441.0 * static_cast<double>(i) / 44100.0);
+    worst = std::fmax(worst, std::fabs(sine[i] / 32767.0 - expect));
+  }
+  ASSERT_TRUE(worst < 1e-4);
+
+  // Square: +1 for the first half period, -1 for the second (away from edges)
+  p.wave = Waveform::Square;
+  p.frequency = 100.0f;
+  auto sq = render_note(p, 8000);
+  ASSERT_TRUE(std::fabs(sq[20] - 32767.0f) < 1.0f && std::fabs(sq[60] + 32767.0f) < 1.0f);
+
+  // Saw ramps up through a period
+  p.wave = Waveform::Saw;
+  auto saw = render_note(p, 8000);
+  ASSERT_TRUE(saw[10] < saw[30] && saw[30] < saw[60] && saw[30] < 0.0f && saw[60] > 0.0f);
+
+  // Noise: bounded, roughly zero-mean, and repeatable per seed
+  p.wave = Waveform::Noise;
+  auto a = render_note(p, 8000), b = render_note(p, 8000);
+  p.seed = 7;
+  auto c = render_note(p, 8000);
+  double mean = 0.0;
+  bool bounded = true;
+  for (float v : a) {
+    mean += v;
+    bounded &= std::fabs(v) <= 32767.0f;
+  }
+  mean /= a.size() * 32767.0;
+  ASSERT_TRUE(bounded && std::fabs(mean) < 0.05);
+  ASSERT_TRUE(a == b && a != c);
+}
+
+void test_mixer_plays_overlapping_synth_notes() {
+  SynthParams low, high;
+  low.wave = Waveform::Sine;
+  low.frequency = 220.0f;
+  low.duration = 0.01f;
+  high.wave = Waveform::Square;
+  high.frequency = 880.0f;
+  high.duration = 0.02f;
+
+  Mixer m;
+  m.set_sample_rate(8000);
+  m.play_synth(low);
+  m.play_synth(high, 0.5f);
+  auto out = mix(m, 100);
+  ASSERT_TRUE(m.active_voices() == 2);
+
+  // Each voice is rendered independently: the mix is the sum of both notes
+  auto a = render_note(low, 8000), b = render_note(high, 8000);
+  bool same = true;
+  for (size_t i = 0; i < 100; ++i) {
+    float expect = (i < a.size() ? a[i] : 0.0f) + (i < b.size() ? b[i] * 0.5f : 0.0f);
+    same &= std::abs(out[2 * i] - std::nearbyint(expect)) <= 1;
+    same &= out[2 * i] == out[2 * i + 1];
+  }
+  ASSERT_TRUE(same);
+
+  mix(m, 400);  // Past both releases
+  ASSERT_TRUE(m.active_voices() == 0);
+}
+
+// ============================================================================
+//  Assets
+// ============================================================================
+
+static void put_le(std::vector<uint8_t>& v, uint32_t x, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    v.push_back(static_cast<uint8_t>(x >> (8 * i)));
+}
+
+/** Write a WAV with an extra chunk before "fmt " (readers must skip it). */
+static void write_wav(const std::string& path, uint16_t tag, int bits, int channels, int rate,
+                      const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> f = {'R', 'I', 'F', 'F'};
+  put_le(f, static_cast<uint32_t>(4 + 14 + 24 + 8 + data.size()), 4);
+  for (char c : std::string("WAVELIST")) f.push_back(static_cast<uint8_t>(c));
+  put_le(f, 5, 4);
+  for (char c : std::string("info\0\0", 6)) f.push_back(static_cast<uint8_t>(c));  // Padded
+  for (char c : std::string("fmt ")) f.push_back(static_cast<uint8_t>(c));
+  put_le(f, 16, 4);
+  put_le(f, tag, 2);
+  put_le(f, static_cast<uint32_t>(channels), 2);
+  put_le(f, static_cast<uint32_t>(rate), 4);
+  put_le(f, static_cast<uint32_t>(rate * channels * bits / 8), 4);
+  put_le(f, static_cast<uint32_t>(channels * bits / 8), 2);
+  put_le(f, static_cast<uint32_t>(bits), 2);
+  for (char c : std::string("data")) f.push_back(static_cast<uint8_t>(c));
+  put_le(f, static_cast<uint32_t>(data.size()), 4);
+  f.insert(f.end(), data.begin(), data.end());
+  std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(f.data()),
+                                              static_cast<std::streamsize>(f.size()));
+}
+
+/** S16 stereo test signal: left ramps, right is a slow sine. */
+static std::vector<uint8_t> make_s16_stereo(size_t frames) {
+  std::vector<uint8_t> d;
+  for (size_t i = 0; i < frames; ++i) {
+    put_le(d, static_cast<uint16_t>(static_cast<int16_t>((i * 37) % 20000 - 10000)), 2);
+    put_le(d, static_cast<uint16_t>(static_cast<int16_t>(12000 * std::sin(i * 0.01))), 2);
+  }
+  return d;
+}
+
+void test_spsc_buffer_bulk_wraps() {
+  qe::core::SpscBuffer<int16_t> buf(10);
+  ASSERT_TRUE(buf.capacity() == 16);
+  std::vector<int16_t> in(40), out(40);
+  for (size_t i = 0; i < in.size(); ++i)
+    in[i] = static_cast<int16_t>(i);
+
+  ASSERT_TRUE(buf.write(in.data(), 12) == 12);
+  ASSERT_TRUE(buf.read(out.data(), 10) == 10);
+  ASSERT_TRUE(buf.write(in.data() + 12, 20) == 14);  // Wraps; 2 were still queued
+  ASSERT_TRUE(buf.writable() == 0 && buf.readable() == 16);
+  ASSERT_TRUE(buf.read(out.data() + 10, 40) == 16);
+  bool same = true;
+  for (int i = 0; i < 26; ++i)
+    same &= out[i] == i;
+  ASSERT_TRUE(same);
+}
+
+void test_wav_reader_formats_and_errors() {
+  const std::string path = "test_audio_formats.wav";
+  // The same four samples in every supported encoding
+  const float expect[4] = {0.0f, 16384.0f, -16384.0f, -32768.0f};
+  std::vector<uint8_t> u8 = {128, 192, 64, 0}, s16, s24, s32, f32;
+  for (float e : expect) {
+    int v = static_cast<int>(e);
+    put_le(s16, static_cast<uint32_t>(v) & 0xFFFF, 2);
+    put_le(s24, static_cast<uint32_t>(v * 256) & 0xFFFFFF, 3);
+    put_le(s32, static_cast<uint32_t>(v * 65536), 4);
+    float f = e / 32768.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &f, 4);
+    put_le(f32, bits, 4);
+  }
+  struct Case {
+    uint16_t tag;
+    int bits;
+    const std::vector<uint8_t>* data;
+    SampleFormat fmt;
+  };
+  const Case cases[] = {{1, 8, &u8, SampleFormat::U8},
+                        {1, 16, &s16, SampleFormat::S16},
+                        {1, 24, &s24, SampleFormat::S24},
+                        {1, 32, &s32, SampleFormat::S32},
+                        {3, 32, &f32, SampleFormat::F32}};
+  for (const Case& c : cases) {
+    write_wav(path, c.tag, c.bits, 1, 22050, *c.data);
+    qe::audio::WavReader r;
+    ASSERT_TRUE(r.open(path));
+    ASSERT_TRUE(r.format().sample == c.fmt && r.format().channels == 1);
+    ASSERT_TRUE(r.format().rate == 22050 && r.frames() == 4);
+    uint8_t raw[16];
+    ASSERT_TRUE(r.read(raw, 10) == 4 && r.read(raw, 1) == 0);
+    float got[4];
+    qe::audio::decode_pcm(raw, 4, r.format(), 1, got);
+    bool same = true;
+    for (int i = 0; i < 4; ++i)
+      same &= std::fabs(got[i] - expect[i]) < 1e-3f;
+    ASSERT_TRUE(same);
+    ASSERT_TRUE(r.rewind() && r.remaining() == 4);
+  }
+
+  qe::audio::WavReader r;
+  write_wav(path, 2, 4, 1, 22050, u8);  // ADPCM
+  ASSERT_TRUE(!r.open(path));
+  std::ofstream(path, std::ios::binary) << "RIFX1234WAVE";
+  ASSERT_TRUE(!r.open(path));
+  ASSERT_TRUE(!r.open("does_not_exist.wav"));
+  std::remove(path.c_str());
+}
+
+void test_decode_maps_channels() {
+  PcmFormat stereo{SampleFormat::S16, 2, 44100};
+  const std::vector<uint8_t> frame = {0x10, 0x27, 0xF0, 0xD8};  // L = 10000, R = -10000
+  float mono = 1.0f, both[2];
+  qe::audio::decode_pcm(frame.data(), 1, stereo, 1, &mono);
+  qe::audio::decode_pcm(frame.data(), 1, stereo, 2, both);
+  ASSERT_TRUE(mono == 0.0f && both[0] == 10000.0f && both[1] == -10000.0f);
+
+  PcmFormat single{SampleFormat::S16, 1, 44100};
+  qe::audio::decode_pcm(frame.data(), 1, single, 2, both);
+  ASSERT_TRUE(both[0] == 10000.0f && both[1] == 10000.0f);
+}
+
+void test_resampler_rates_and_chunking() {
+  std::vector<float> ramp(100);
+  for (size_t i = 0; i < ramp.size(); ++i)
+    ramp[i] = static_cast<float>(i);
+
+  // Equal rates pass samples through untouched
+  std::vector<float> out;
+  qe::audio::LinearResampler same(1, 44100, 44100);
+  same.process(ramp.data(), 100, out);
+  same.flush(out);
+  ASSERT_TRUE(out == ramp);
+
+  // 2x up: every other output sits halfway between inputs
+  out.clear();
+  qe::audio::LinearResampler up(1, 22050, 44100);
+  up.process(ramp.data(), 100, out);
+  up.flush(out);
+  ASSERT_TRUE(out.size() == 200);
+  ASSERT_TRUE(out[0] == 0.0f && out[1] == 0.5f && out[2] == 1.0f && out[197] == 98.5f);
+
+  // Any chunking gives the same stream as one call
+  std::vector<float> chunked;
+  qe::audio::LinearResampler a(1, 48000, 44100), b(1, 48000, 44100);
+  a.process(ramp.data(), 100, out = {});
+  a.flush(out);
+  for (size_t at = 0, n = 1; at < 100; at += n, n = n % 7 + 1)
+    b.process(ramp.data() + at, std::min<size_t>(n, 100 - at), chunked);
+  b.flush(chunked);
+  ASSERT_TRUE(chunked == out);
+  ASSERT_TRUE(out.size() >= 91 && out.size() <= 93);  // 100 * 44100 / 48000 = 91.9
+}
+
+void test_load_clip_converts_to_device_rate() {
+  const std::string path = "test_audio_clip.wav";
+  write_wav(path, 1, 16, 2, 22050, make_s16_stereo(1000));
+  qe::audio::SoundClip clip;
+  ASSERT_TRUE(qe::audio::load_clip(path, 44100, clip));
+  ASSERT_TRUE(clip.channels == 2 && clip.frames() == 2000);
+  // Original frames land on even output frames
+  ASSERT_TRUE(clip.samples[2 * 2 * 10] == static_cast<int16_t>(10 * 37 - 10000));
+  std::remove(path.c_str());
+  ASSERT_TRUE(!qe::audio::load_clip(path, 44100, clip));
+}
+
+void test_stream_matches_load_time_conversion() {
+  const std::string path = "test_audio_stream.wav";
+  const size_t frames = 30000;  // Several rings' worth at the small buffer below
+  write_wav(path, 1, 16, 2, 22050, make_s16_stereo(frames));
+  qe::audio::SoundClip clip;
+  ASSERT_TRUE(qe::audio::load_clip(path, 44100, clip));
+
+  qe::audio::AudioStream stream(2, 44100, 0.05f);
+  ASSERT_TRUE(stream.open(path));
+  ASSERT_TRUE(stream.buffered_seconds() > 0.04f);  // Pre-filled before returning
+  std::vector<int16_t> got, block(2 * 256);
+  for (int spins = 0; !stream.finished() && spins < 100000; ++spins) {
+    size_t n = stream.read(block.data(), 256);
+    got.insert(got.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(2 * n));
+    if (n == 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  ASSERT_TRUE(stream.finished());
+  ASSERT_TRUE(got == clip.samples);
+
+  // A looping stream keeps going past the end of the file
+  qe::audio::AudioStream loop(2, 44100, 0.05f);
+  ASSERT_TRUE(loop.open(path, true));
+  size_t total = 0;
+  for (int spins = 0; total < 3 * clip.frames() && spins < 100000; ++spins) {
+    size_t n = loop.read(block.data(), 256);
+    total += n;
+    if (n == 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  ASSERT_TRUE(total >= 3 * clip.frames() && !loop.finished());
+  loop.close();
+  std::remove(path.c_str());
+}
+
+/** Stream source the test feeds by hand. */
+struct ManualSource : qe::audio::StreamSource {
+  std::vector<int16_t> data;
+  size_t at = 0;
+  bool done = false;
+  int channels() const override {
+    return 1;
+  }
+  size_t read(int16_t* out, size_t frames) override {
+    size_t n = std::min(frames, data.size() - at);
+    std::copy(data.begin() + static_cast<std::ptrdiff_t>(at),
+              data.begin() + static_cast<std::ptrdiff_t>(at + n), out);
+    at += n;
+    return n;
+  }
+  bool finished() const override {
+    return done && at == data.size();
+  }
+};
+
+void test_mixer_stream_voice_underrun_and_end() {
+  ManualSource src;
+  src.data.assign(10, 1000);
+  Mixer m;
+  m.play_stream(&src, 1.0f, -1.0f);
+  auto out = mix(m, 16);
+  ASSERT_TRUE(out[2 * 9] == 1000 && out[2 * 9 + 1] == 0 && out[2 * 10] == 0);
+  ASSERT_TRUE(m.underruns() == 1 && m.active_voices() == 1);  // Starved, not finished
+
+  src.data.assign(4, 2000);
+  src.at = 0;
+  src.done = true;
+  out = mix(m, 8);
+  ASSERT_TRUE(out[0] == 2000 && out[2 * 4] == 0);
+  ASSERT_TRUE(m.underruns() == 1 && m.active_voices() == 0);
+}
+
+// ============================================================================
+//  Voice management
+// ============================================================================
+
+void test_mixer_mixes_only_top_ranked_voices() {
+  // Each voice's left channel counts its frames, so the output shows positions
+  std::vector<int16_t> ramp(2 * 200);
+  for (size_t i = 0; i < 200; ++i)
+    ramp[2 * i] = ramp[2 * i + 1] = static_cast<int16_t>(i);
+  Mixer m(8, 256, 2);
+  m.play(ramp.data(), 200, 2, 0.25f);
+  VoiceId loud = m.play(ramp.data(), 200, 2, 1.0f);
+  VoiceId mid = m.play(ramp.data(), 200, 2, 0.5f);
+  auto out = mix(m, 12);
+  ASSERT_TRUE(m.active_voices() == 3 && m.virtual_voices() == 1);
+  ASSERT_TRUE(out[2 * 4] == 6);  // 4 * (1.0 + 0.5): the quiet voice is virtual
+
+  // The virtual voice kept its place and resumes mid-clip
+  m.stop(loud);
+  m.stop(mid);
+  out = mix(m, 10);
+  ASSERT_TRUE(m.virtual_voices() == 0 && out[0] == 3);  // Frame 12 at 0.25
+
+  // Priority beats gain; silent voices never take a mixing slot
+  Mixer p(8, 256, 1);
+  auto clip = make_stereo(100, 1000);
+  p.play(clip.data(), 100, 2, 1.0f, 0.0f, false, Priority::Low);
+  p.play(clip.data(), 100, 2, 0.5f, 0.0f, false, Priority::High);
+  p.play(clip.data(), 100, 2, 0.0f, 0.0f, false, Priority::Critical);
+  out = mix(p, 4);
+  ASSERT_TRUE(out[0] == 500 && p.virtual_voices() == 2 && p.active_voices() == 3);
+}
+
+void test_mixer_virtual_voices_end_on_time() {
+  auto clip = make_stereo(50, 1000);
+  Mixer m(4, 256, 1);
+  m.play(clip.data(), 50, 2, 1.0f, 0.0f, false, Priority::High);
+  m.play(clip.data(), 30, 2);  // Virtual for its whole life
+  SynthParams note;
+  note.duration = 0.01f;
+  note.env.release = 0.0f;
+  m.set_sample_rate(1000);
+  m.play_synth(note);  // About 10 samples, also virtual
+  mix(m, 5);
+  ASSERT_TRUE(m.active_voices() == 3 && m.virtual_voices() == 2);
+  mix(m, 30);
+  ASSERT_TRUE(m.active_voices() == 1 && m.virtual_voices() == 0);
+}
+
+void test_mixer_steals_lower_priority_voices() {
+  auto clip = make_stereo(100, 1000);
+  Mixer m(2, 256);
+  m.play(clip.data(), 100, 2, 1.0f, 0.0f, false, Priority::Low);
+  m.play(clip.data(), 100, 2, 0.5f);
+  // Lower or equal rank than every playing voice: dropped
+  ASSERT_TRUE(m.play(clip.data(), 100, 2, 1.0f, 0.0f, false, Priority::Low) != 0);
+  mix(m, 1);
+  ASSERT_TRUE(m.dropped() == 1 && m.stolen() == 0);
+  // Outranks the Low voice: takes its slot
+  m.play(clip.data(), 100, 2, 0.25f, 0.0f, false, Priority::Critical);
+  auto out = mix(m, 1);
+  ASSERT_TRUE(m.stolen() == 1 && m.active_voices() == 2);
+  ASSERT_TRUE(out[0] == 750);  // 0.5 + 0.25; the 1.0 Low voice is gone
+}
+
+void test_oscillator_skip_matches_render() {
+  const Waveform waves[] = {Waveform::Square, Waveform::Sine, Waveform::Saw, Waveform::Noise};
+  for (Waveform w : waves) {
+    SynthParams p;
+    p.wave = w;
+    p.frequency = 330.0f;
+    p.duration = 1.0f;
+    p.amplitude = 1.0f;
+    Oscillator whole, skipped;
+    whole.start(p, 8000);
+    skipped.start(p, 8000);
+    std::vector<float> a(3000), b(1000);
+    whole.render(a.data(), a.size());
+    ASSERT_TRUE(skipped.skip(2000) == 2000);
+    skipped.render(b.data(), b.size());
+    float worst = 0.0f;
+    for (size_t i = 0; i < b.size(); ++i)
+      worst = std::max(worst, std::fabs(a[2000 + i] - b[i]));
+    ASSERT_TRUE(worst < 32767.0f * 1e-3f);
+  }
+  SynthParams p;
+  p.duration = 0.01f;
+  Oscillator o;
+  o.start(p, 1000);
+  ASSERT_TRUE(o.skip(100) < 100 && o.finished());
+}
+
+void test_distance_gain() {
+  using qe::audio::distance_gain;
+  ASSERT_TRUE(distance_gain(0.0f, 4.0f, 80.0f) == 1.0f);
+  ASSERT_TRUE(distance_gain(4.0f, 4.0f, 80.0f) == 1.0f);
+  ASSERT_TRUE(distance_gain(16.0f, 4.0f, 80.0f) == 0.25f);
+  ASSERT_TRUE(distance_gain(80.0f, 4.0f, 80.0f) == 0.0f);
+}
+
+// ============================================================================
+//  Main
+// ============================================================================
+
+int main() {
+  std::cout << "=== QuatEngine Audio Tests ===" << std::endl;
+
+  std::cout << "\n--- SpscRing ---" << std::endl;
+  RUN_TEST(test_spsc_ring_order_and_bounds);
+  RUN_TEST(test_spsc_ring_transfers_across_threads);
+
+  std::cout << "\n--- Mixer (SIMD: " << (Mixer::simd() ? "on" : "off") << ") ---" << std::endl;
+  RUN_TEST(test_mixer_silence_without_voices);
+  RUN_TEST(test_mixer_gain_and_pan);
+  RUN_TEST(test_mixer_sums_and_clips);
+  RUN_TEST(test_mixer_voice_lifetime_and_loop);
+  RUN_TEST(test_mixer_voice_limit_and_large_blocks);
+  RUN_TEST(test_mixer_kernels_match_scalar);
+
+  std::cout << "\n--- Oscillator ---" << std::endl;
+  RUN_TEST(test_oscillator_envelope_timing);
+  RUN_TEST(test_oscillator_waveforms);
+  RUN_TEST(test_mixer_plays_overlapping_synth_notes);
+
+  std::cout << "\n--- Assets ---" << std::endl;
+  RUN_TEST(test_spsc_buffer_bulk_wraps);
+  RUN_TEST(test_wav_reader_formats_and_errors);
+  RUN_TEST(test_decode_maps_channels);
+  RUN_TEST(test_resampler_rates_and_chunking);
+  RUN_TEST(test_load_clip_converts_to_device_rate);
+  RUN_TEST(test_stream_matches_load_time_conversion);
+  RUN_TEST(test_mixer_stream_voice_underrun_and_end);
+
+  std::cout << "\n--- Voice management ---" << std::endl;
+  RUN_TEST(test_mixer_mixes_only_top_ranked_voices);
+  RUN_TEST(test_mixer_virtual_voices_end_on_time);
+  RUN_TEST(test_mixer_steals_lower_priority_voices);
+  RUN_TEST(test_oscillator_skip_matches_render);
+  RUN_TEST(test_distance_gain);
+
+  std::cout << "\n=== Results ===" << std::endl;
+  std::cout << "  Total assertions: " << g_tests_run << std::endl;
+  std::cout << "  Passed: " << g_tests_passed << std::endl;
+  std::cout << "  Failed: " << g_tests_failed << std::endl;
+
+  return g_tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,24 +1,47 @@
 /**
  * @file test_game.cpp
- * @brief Tests for game components: AABB, Entity, Projectile, Combat.
+ * @brief Tests for game components: AABB, Entity, Projectile, Combat, InputTimeline,
+ *        Profiler, GpuProfiler, AllocTracker, FrameTelemetry, Counters, PerfOverlay.
  *
  * Validates:
  *   - AABB: containment, overlap, ray intersection (slab method)
  *   - Entity: damage, kill, respawn cycle
  *   - Projectile: lifetime, movement, deactivation
  *   - Combat: shoot + hitscan, collision resolution
+ *   - InputTimeline: per-tick motion, late-latch remainder, compaction, latency
+ *   - Profiler: scope nesting, per-thread rings, track scopes, ring overwrite, Chrome trace
+ *   - GpuProfiler: delayed readback, query ring overrun, missing timer queries
+ *     (against fake GL entry points; QE_NO_SDL is defined via CMake)
+ *   - AllocTracker: tag scopes, per-frame deltas, per-thread counts,
+ *     TaggedAllocator (this file installs core/AllocHooks.h)
+ *   - FrameTelemetry: histogram precision, phase percentiles, discarded frames,
+ *     hitch trace capture window, CSV export
+ *   - Counters: per-frame sums vs gauges, kinds, concurrent publishing
+ *   - PerfOverlay: font, layout within the screen, new counters appear
  */
 
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "core/AABB.h"
+#include "core/AllocHooks.h"
+#include "core/Counters.h"
 #include "core/Entity.h"
+#include "core/FrameTelemetry.h"
+#include "core/Profiler.h"
 #include "core/Projectile.h"
 #include "game/Combat.h"
+#include "input/InputTimeline.h"
 #include "math/Vec3.h"
+#include "renderer/GpuProfiler.h"
+#include "renderer/PerfOverlay.h"
 
 static int total_assertions = 0;
 static int passed = 0;
@@ -237,6 +260,678 @@ void test_combat_accuracy() {
   ASSERT_NEAR(stats.accuracy(), 70.0f, 1e-3f);
 }
 
+// ── InputTimeline Tests ─────────────────────────────────────────────────────
+
+static qe::input::InputSample motion(double time, float dx, float dy) {
+  qe::input::InputSample s;
+  s.time = time;
+  s.dx = dx;
+  s.dy = dy;
+  return s;
+}
+
+void test_input_timeline_splits_motion_by_tick() {
+  qe::input::InputTimeline tl;
+  tl.push(motion(1.000, 4, 1));
+  tl.push(motion(1.004, 2, 0));
+  tl.push(motion(1.011, 8, -2));  // Arrives during the second tick
+
+  auto first = tl.take_until(1.0083);
+  ASSERT_NEAR(first.dx, 6.0f, 1e-6f);
+  ASSERT_NEAR(first.dy, 1.0f, 1e-6f);
+  ASSERT_TRUE(tl.size() == 1);
+
+  // Late latch sees what no tick has consumed; the sim still gets it later
+  ASSERT_NEAR(tl.pending().dx, 8.0f, 1e-6f);
+  auto second = tl.take_until(1.0167);
+  ASSERT_NEAR(second.dx, 8.0f, 1e-6f);
+  ASSERT_NEAR(second.dy, -2.0f, 1e-6f);
+  ASSERT_TRUE(tl.size() == 0);
+  ASSERT_NEAR(tl.take_until(1.025).dx, 0.0f, 1e-6f);
+}
+
+void test_input_timeline_orders_late_stamps() {
+  qe::input::InputTimeline tl;
+  tl.push(motion(2.0, 1, 0));
+  tl.push(motion(1.5, 1, 0));  // Out of order: treated as arriving at 2.0
+  ASSERT_NEAR(tl.take_until(1.9).dx, 0.0f, 1e-6f);
+  ASSERT_NEAR(tl.take_until(2.0).dx, 2.0f, 1e-6f);
+}
+
+void test_input_timeline_drops_taken_samples() {
+  // Motion that never stops: a newer sample is always queued at tick end
+  qe::input::InputTimeline tl;
+  double t = 0.0;
+  float taken = 0.0f;
+  for (int tick = 0; tick < 10000; ++tick) {
+    tl.push(motion(t + 0.002, 1, 0));
+    tl.push(motion(t + 0.009, 1, 0));  // After this tick's end
+    t += 0.008;
+    taken += tl.take_until(t).dx;
+    ASSERT_TRUE(tl.size() >= 1 && tl.stored() < 600);
+  }
+  ASSERT_NEAR(taken + tl.pending().dx, 20000.0f, 1e-3f);
+
+  tl.clear();
+  ASSERT_TRUE(tl.stored() == 0 && tl.pending().dx == 0.0f);
+}
+
+void test_input_timeline_latency() {
+  qe::input::InputTimeline tl;
+  ASSERT_TRUE(tl.present(1.0) < 0.0);  // No input, no sample
+  tl.push(motion(1.000, 1, 0));
+  tl.push(motion(1.010, 1, 0));
+  ASSERT_NEAR(static_cast<float>(tl.present(1.020)), 0.020f, 1e-6f);
+  ASSERT_TRUE(tl.present(1.036) < 0.0);  // Already shown
+  tl.push(motion(1.040, 1, 0));
+  tl.present(1.050);
+  ASSERT_TRUE(tl.latency().frames == 2);
+  ASSERT_NEAR(tl.latency().last_ms, 10.0f, 1e-3f);
+  ASSERT_NEAR(tl.latency().max_ms, 20.0f, 1e-3f);
+}
+
+// ── Profiler Tests ──────────────────────────────────────────────────────────
+
+using qe::core::Profiler;
+using qe::core::TraceEvent;
+
+static std::vector<TraceEvent> recorded() {
+  std::vector<TraceEvent> events;
+  Profiler::instance().snapshot(events);
+  return events;
+}
+
+void test_profiler_nested_scopes() {
+  Profiler::instance().clear();
+  Profiler::set_enabled(true);
+  {
+    QE_PROFILE_SCOPE("outer");
+    { QE_PROFILE_SCOPE("inner"); }
+    QE_PROFILE_COUNTER("voices", 3);
+  }
+  Profiler::set_enabled(false);
+
+  auto events = recorded();
+  ASSERT_TRUE(events.size() == 3);
+  if (events.size() != 3)
+    return;
+  // Scopes are recorded as they close: inner first
+  ASSERT_TRUE(std::string(events[0].name) == "inner");
+  ASSERT_TRUE(events[0].depth == 1);
+  ASSERT_TRUE(events[1].kind == TraceEvent::Counter);
+  ASSERT_NEAR(events[1].value, 3.0, 1e-12);
+  ASSERT_TRUE(std::string(events[2].name) == "outer");
+  ASSERT_TRUE(events[2].depth == 0);
+  ASSERT_TRUE(events[2].start_ns <= events[0].start_ns);
+  ASSERT_TRUE(events[0].end_ns <= events[2].end_ns);
+  ASSERT_TRUE(Profiler::depth() == 0);
+}
+
+void test_profiler_disabled_records_nothing() {
+  Profiler::instance().clear();
+  {
+    QE_PROFILE_SCOPE("off");
+    QE_PROFILE_COUNTER("off", 1);
+  }
+  ASSERT_TRUE(recorded().empty());
+}
+
+void test_profiler_per_thread_rings() {
+  Profiler::instance().clear();
+  Profiler::instance().set_thread_name("main");
+  Profiler::set_enabled(true);
+  std::thread worker([] {
+    Profiler::instance().set_thread_name("worker");
+    QE_PROFILE_SCOPE("work");
+  });
+  worker.join();
+  { QE_PROFILE_SCOPE("wait"); }
+  Profiler::set_enabled(false);
+
+  auto names = Profiler::instance().thread_names();
+  auto events = recorded();
+  bool work_on_worker = false, wait_on_main = false;
+  for (const auto& e : events) {
+    const std::string& thread = names[e.thread];
+    work_on_worker |= std::string(e.name) == "work" && thread == "worker";
+    wait_on_main |= std::string(e.name) == "wait" && thread == "main";
+  }
+  ASSERT_TRUE(events.size() == 2);
+  ASSERT_TRUE(work_on_worker);
+  ASSERT_TRUE(wait_on_main);
+}
+
+void test_profiler_track_scope() {
+  Profiler::instance().clear();
+  Profiler::Ring* track = Profiler::instance().add_track("audio");
+  const size_t rings = Profiler::instance().thread_names().size();
+  Profiler::set_enabled(true);
+  std::thread device([track] { QE_PROFILE_TRACK_SCOPE("mix", track); });
+  device.join();
+  Profiler::set_enabled(false);
+
+  // The device thread recorded onto the track and registered no ring
+  auto names = Profiler::instance().thread_names();
+  auto events = recorded();
+  ASSERT_TRUE(names.size() == rings);
+  ASSERT_TRUE(events.size() == 1);
+  if (events.size() != 1)
+    return;
+  ASSERT_TRUE(std::string(events[0].name) == "mix");
+  ASSERT_TRUE(names[events[0].thread] == "audio");
+  ASSERT_TRUE(events[0].start_ns <= events[0].end_ns);
+}
+
+void test_profiler_ring_keeps_newest() {
+  Profiler::instance().clear();
+  Profiler::set_enabled(true);
+  for (size_t i = 0; i < Profiler::kRingEvents + 10; ++i)
+    QE_PROFILE_COUNTER("n", static_cast<double>(i));
+  Profiler::set_enabled(false);
+
+  auto events = recorded();
+  ASSERT_TRUE(events.size() == Profiler::kRingEvents - 1);
+  if (events.empty())
+    return;
+  ASSERT_NEAR(events.back().value, Profiler::kRingEvents + 9.0, 1e-9);
+  ASSERT_NEAR(events.front().value, 11.0, 1e-9);
+}
+
+void test_profiler_chrome_trace() {
+  Profiler::instance().clear();
+  Profiler::set_enabled(true);
+  { QE_PROFILE_SCOPE("say \"hi\""); }
+  QE_PROFILE_COUNTER("fps", 60);
+  Profiler::set_enabled(false);
+
+  const char* path = "test_profiler_trace.json";
+  ASSERT_TRUE(Profiler::instance().write_chrome_trace(path));
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  in.close();
+  std::remove(path);
+  const std::string json = text.str();
+  ASSERT_TRUE(json.find("\"traceEvents\"") != std::string::npos);
+  ASSERT_TRUE(json.find("\"name\":\"say \\\"hi\\\"\",\"ph\":\"X\"") != std::string::npos);
+  ASSERT_TRUE(json.find("\"ph\":\"C\"") != std::string::npos);
+  ASSERT_TRUE(json.find("\"thread_name\"") != std::string::npos);
+  ASSERT_TRUE(json.rfind("]}") != std::string::npos);
+}
+
+// ── GpuProfiler Tests ───────────────────────────────────────────────────────
+
+// Fake timer queries: every glQueryCounter advances the GPU clock by 1 ms,
+// and a query's result is available once `completed` counters have finished
+namespace fake_gl {
+std::vector<GLuint64> stamp;  // Indexed by query id - 1
+std::vector<uint64_t> order;  // Issue number of each query's counter
+GLint64 clock = 0;
+uint64_t issued = 0, completed = 0, blocking_reads = 0;
+
+void gen(GLsizei n, GLuint* ids) {
+  for (GLsizei i = 0; i < n; ++i) {
+    stamp.push_back(0);
+    order.push_back(0);
+    ids[i] = static_cast<GLuint>(stamp.size());
+  }
+}
+void del(GLsizei, const GLuint*) {}
+void counter(GLuint id, GLenum) {
+  clock += 1000000;
+  stamp[id - 1] = static_cast<GLuint64>(clock);
+  order[id - 1] = ++issued;
+}
+void counter_bits(GLenum, GLenum, GLint* bits) {
+  *bits = 64;
+}
+void available(GLuint id, GLenum, GLint* v) {
+  *v = order[id - 1] <= completed;
+}
+void result(GLuint id, GLenum, GLuint64* v) {
+  blocking_reads += order[id - 1] > completed;
+  *v = stamp[id - 1];
+}
+void now(GLenum, GLint64* v) {
+  *v = clock;
+}
+
+void install(bool on) {
+  using namespace qe::renderer::gl;
+  glGenQueries = on ? gen : nullptr;
+  glDeleteQueries = on ? del : nullptr;
+  glQueryCounter = on ? counter : nullptr;
+  glGetQueryiv = on ? counter_bits : nullptr;
+  glGetQueryObjectiv = on ? available : nullptr;
+  glGetQueryObjectui64v = on ? result : nullptr;
+  glGetInteger64v = on ? now : nullptr;
+}
+}  // namespace fake_gl
+
+void test_gpu_profiler_without_timer_queries() {
+  fake_gl::install(false);
+  qe::renderer::GpuProfiler gpu;
+  ASSERT_TRUE(!gpu.init());
+  ASSERT_TRUE(!gpu.available());
+  gpu.begin_frame();
+  { QE_GPU_SCOPE(gpu, "terrain"); }
+  gpu.end_frame();
+  ASSERT_TRUE(gpu.results().empty());
+}
+
+void test_gpu_profiler_reads_passes_later() {
+  fake_gl::install(true);
+  qe::renderer::GpuProfiler gpu;
+  ASSERT_TRUE(gpu.init());
+  Profiler::instance().clear();
+  Profiler::set_enabled(true);
+
+  gpu.begin_frame();
+  {
+    QE_GPU_SCOPE(gpu, "world");
+    { QE_GPU_SCOPE(gpu, "terrain"); }
+  }
+  gpu.end_frame();
+  gpu.begin_frame();  // Not finished yet: nothing read
+  ASSERT_TRUE(gpu.results().empty());
+  gpu.end_frame();
+
+  fake_gl::completed = fake_gl::issued;
+  gpu.begin_frame();
+  gpu.end_frame();
+  Profiler::set_enabled(false);
+  ASSERT_TRUE(fake_gl::blocking_reads == 0);
+
+  // Newest frame read was the empty second one; the first went to the trace
+  ASSERT_TRUE(gpu.results().empty());
+  ASSERT_NEAR(gpu.frame_ms(), 1.0f, 1e-4f);
+  auto names = Profiler::instance().thread_names();
+  int gpu_events = 0;
+  for (const auto& e : recorded()) {
+    if (names[e.thread] != "GPU")
+      continue;
+    ++gpu_events;
+    if (std::string(e.name) == "world")
+      ASSERT_NEAR((e.end_ns - e.start_ns) * 1e-6, 3.0, 1e-9);
+    if (std::string(e.name) == "terrain") {
+      ASSERT_NEAR((e.end_ns - e.start_ns) * 1e-6, 1.0, 1e-9);
+      ASSERT_TRUE(e.depth == 2);  // Under "gpu frame" and "world"
+    }
+  }
+  ASSERT_TRUE(gpu_events == 4);  // Two frames, two passes
+  gpu.destroy();
+  fake_gl::install(false);
+}
+
+void test_gpu_profiler_pass_results() {
+  fake_gl::install(true);
+  qe::renderer::GpuProfiler gpu;
+  gpu.init();
+  gpu.begin_frame();
+  { QE_GPU_SCOPE(gpu, "terrain"); }
+  { QE_GPU_SCOPE(gpu, "hud"); }
+  gpu.end_frame();
+  fake_gl::completed = fake_gl::issued;
+  gpu.begin_frame();
+
+  const auto& passes = gpu.results();
+  ASSERT_TRUE(passes.size() == 2);
+  if (passes.size() == 2) {
+    ASSERT_TRUE(std::string(passes[0].name) == "terrain");
+    ASSERT_NEAR(passes[0].ms, 1.0f, 1e-4f);
+    ASSERT_TRUE(std::string(passes[1].name) == "hud");
+    ASSERT_TRUE(passes[1].depth == 0);
+  }
+  ASSERT_NEAR(gpu.frame_ms(), 5.0f, 1e-4f);
+  gpu.destroy();
+  fake_gl::install(false);
+}
+
+void test_gpu_profiler_drops_frames_instead_of_waiting() {
+  fake_gl::install(true);
+  qe::renderer::GpuProfiler gpu;
+  gpu.init();
+  const uint64_t reads = fake_gl::blocking_reads;
+  for (int i = 0; i < qe::renderer::GpuProfiler::kFramesInFlight + 3; ++i) {
+    gpu.begin_frame();
+    { QE_GPU_SCOPE(gpu, "terrain"); }
+    gpu.end_frame();
+  }
+  ASSERT_TRUE(gpu.dropped() == 3);
+  ASSERT_TRUE(fake_gl::blocking_reads == reads);
+
+  // Once the GPU catches up, measuring resumes
+  fake_gl::completed = fake_gl::issued;
+  gpu.begin_frame();
+  { QE_GPU_SCOPE(gpu, "terrain"); }
+  gpu.end_frame();
+  ASSERT_TRUE(gpu.dropped() == 3);
+  ASSERT_TRUE(gpu.results().size() == 1);
+  gpu.destroy();
+  fake_gl::install(false);
+}
+
+// ── AllocTracker Tests ──────────────────────────────────────────────────────
+
+using qe::core::AllocFrame;
+using qe::core::AllocTag;
+using qe::core::AllocTracker;
+
+void test_alloc_hooks_installed() {
+  ASSERT_TRUE(AllocTracker::installed());
+}
+
+void test_alloc_tag_scope_charges_tag() {
+  AllocFrame frame;
+  frame.begin();
+  {
+    QE_ALLOC_TAG(Particles);
+    auto block = std::make_unique<char[]>(100);
+    {
+      QE_ALLOC_TAG(Audio);  // Nested: the inner tag wins, then the outer returns
+      std::vector<int> v(8);
+    }
+    std::vector<int> w(4);
+  }
+  frame.end();
+  ASSERT_TRUE(AllocTracker::tag() == AllocTag::Other);
+  ASSERT_TRUE(frame[AllocTag::Particles].allocs == 2);
+  ASSERT_TRUE(frame[AllocTag::Particles].bytes == 100 + 4 * sizeof(int));
+  ASSERT_TRUE(frame[AllocTag::Particles].frees == 2);
+  ASSERT_TRUE(frame[AllocTag::Audio].allocs == 1);
+  ASSERT_TRUE(frame.total().allocs >= 3);
+}
+
+void test_alloc_thread_counts_are_per_thread() {
+  uint64_t worker_allocs = 0;
+  std::thread worker([&] {
+    const uint64_t start = AllocTracker::thread_allocs();
+    std::vector<int> v(16);
+    worker_allocs = AllocTracker::thread_allocs() - start;
+  });
+  const uint64_t spawned = AllocTracker::thread_allocs();  // std::thread's own state
+  worker.join();
+  ASSERT_TRUE(worker_allocs == 1);
+  ASSERT_TRUE(AllocTracker::thread_allocs() == spawned);
+
+  // Steady state: reusing capacity does not allocate
+  std::vector<int> reuse;
+  reuse.reserve(64);
+  const uint64_t steady = AllocTracker::thread_allocs();
+  for (int i = 0; i < 64; ++i)
+    reuse.push_back(i);
+  reuse.clear();
+  ASSERT_TRUE(AllocTracker::thread_allocs() == steady);
+}
+
+void test_alloc_tagged_allocator() {
+  AllocFrame frame;
+  frame.begin();
+  std::vector<int, qe::core::TaggedAllocator<int, AllocTag::Enemies>> v;
+  for (int i = 0; i < 100; ++i)
+    v.push_back(i);
+  frame.end();
+  ASSERT_TRUE(frame[AllocTag::Enemies].allocs > 0);
+  ASSERT_TRUE(frame[AllocTag::Enemies].bytes >= 100 * sizeof(int));
+  ASSERT_TRUE(frame[AllocTag::Other].allocs == 0);
+  ASSERT_TRUE(std::string(qe::core::alloc_tag_name(AllocTag::Enemies)) == "enemies");
+}
+
+// ── FrameTelemetry Tests ────────────────────────────────────────────────────
+
+using qe::core::FrameTelemetry;
+using qe::core::LogHistogram;
+
+std::string read_file(const char* path) {
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+void test_log_histogram_precision() {
+  // Small values are exact; larger ones land in a bucket within 1/32 of them
+  for (uint64_t v : {0ull, 1ull, 31ull, 32ull, 1000ull, 16667ull, 123456789ull}) {
+    const uint64_t hi = LogHistogram::highest(LogHistogram::index(v));
+    ASSERT_TRUE(hi >= v);
+    ASSERT_TRUE(hi - v <= v / 32);
+  }
+  ASSERT_TRUE(LogHistogram::index(31) == 31);
+  ASSERT_TRUE(LogHistogram::highest(LogHistogram::index(31)) == 31);
+  // Buckets are contiguous: the next value starts the next bucket
+  for (size_t b = 0; b + 1 < LogHistogram::kBuckets; ++b)
+    ASSERT_TRUE(LogHistogram::index(LogHistogram::highest(b) + 1) == b + 1);
+}
+
+void test_log_histogram_percentiles() {
+  LogHistogram h;
+  ASSERT_TRUE(h.percentile(50.0) == 0);
+  for (uint64_t v = 1; v <= 1000; ++v)
+    h.record(v * 100);  // 0.1 .. 100 ms in microseconds
+  ASSERT_TRUE(h.count() == 1000);
+  ASSERT_NEAR(static_cast<double>(h.percentile(50.0)), 50000.0, 50000.0 / 32);
+  ASSERT_NEAR(static_cast<double>(h.percentile(99.0)), 99000.0, 99000.0 / 32);
+  ASSERT_TRUE(h.percentile(100.0) == 100000);  // Capped at the true max
+  ASSERT_TRUE(h.max() == 100000);
+  ASSERT_NEAR(h.mean(), 50050.0, 1e-9);
+  h.clear();
+  ASSERT_TRUE(h.count() == 0 && h.max() == 0);
+}
+
+void test_telemetry_phase_stats() {
+  FrameTelemetry t;
+  t.config.hitch_ms = 0.0f;
+  const int sim = t.phase("sim");
+  const int render = t.phase("render");
+  ASSERT_TRUE(t.phase("sim") == sim);
+  ASSERT_TRUE(t.phase("frame") == FrameTelemetry::kFrame);
+
+  for (int i = 0; i < 1000; ++i) {
+    t.add(sim, 1.0f);
+    t.add(sim, 1.0f);  // Two ticks in one frame sum to 2 ms
+    if (i % 2 == 0)
+      t.add(render, 4.0f);
+    t.record_frame(i == 999 ? 40.0f : 8.0f);
+  }
+  const auto frame = t.stats(FrameTelemetry::kFrame);
+  ASSERT_TRUE(frame.frames == 1000);
+  ASSERT_NEAR(frame.p50_ms, 8.0, 8.0 / 32);
+  ASSERT_NEAR(frame.p99_ms, 8.0, 8.0 / 32);
+  ASSERT_NEAR(frame.p999_ms, 8.0, 8.0 / 32);
+  ASSERT_NEAR(frame.max_ms, 40.0, 1e-3);
+  ASSERT_NEAR(t.stats(sim).p99_ms, 2.0, 2.0 / 32);
+  ASSERT_TRUE(t.stats(render).frames == 500);
+  ASSERT_TRUE(t.hitches() == 0);
+
+  std::ostringstream report;
+  t.report(report);
+  ASSERT_TRUE(report.str().find("render") != std::string::npos);
+}
+
+void test_telemetry_discarded_frames_record_nothing() {
+  FrameTelemetry t;
+  t.config.hitch_ms = 0.0f;
+  const int sim = t.phase("sim");
+  t.add(sim, 3.0f);
+  t.record_frame(16.0f);
+
+  // An idle pass: begun and timed, then dropped with its phase time
+  t.begin_frame();
+  t.add(sim, 5.0f);
+  t.discard_frame();
+  ASSERT_TRUE(t.frames() == 1);
+
+  t.add(sim, 3.0f);
+  t.record_frame(16.0f);
+  ASSERT_TRUE(t.frames() == 2);
+  ASSERT_TRUE(t.stats(sim).frames == 2);
+  ASSERT_NEAR(t.stats(sim).max_ms, 3.0, 3.0 / 32);
+  ASSERT_NEAR(t.stats(FrameTelemetry::kFrame).max_ms, 16.0, 16.0 / 32);
+}
+
+void test_telemetry_hitch_captures_trace_window() {
+  Profiler::instance().clear();
+  Profiler::set_enabled(true);
+  FrameTelemetry t;
+  t.config.hitch_ms = 30.0f;
+  t.config.capture_before_ms = 100.0f;
+  t.config.capture_after_frames = 2;
+  t.config.capture_prefix = "test_telemetry_hitch";
+
+  // An event long before the hitch falls outside the captured window
+  qe::core::TraceEvent stale;
+  stale.name = "stale";
+  stale.start_ns = Profiler::now_ns() - 10'000'000'000;
+  stale.end_ns = stale.start_ns + 1000;
+  Profiler::record_on(Profiler::instance().add_track("test"), stale);
+
+  t.record_frame(16.0f);
+  { QE_PROFILE_SCOPE("slow load"); }
+  t.record_frame(80.0f);  // Hitch: capture after two more frames
+  ASSERT_TRUE(t.hitches() == 1);
+  ASSERT_TRUE(t.captures() == 0);
+  t.record_frame(16.0f);
+  t.record_frame(16.0f);
+  Profiler::set_enabled(false);
+  ASSERT_TRUE(t.captures() == 1);
+
+  const char* path = "test_telemetry_hitch_0.json";
+  const std::string json = read_file(path);
+  std::remove(path);
+  ASSERT_TRUE(json.find("\"slow load\"") != std::string::npos);
+  ASSERT_TRUE(json.find("\"stale\"") == std::string::npos);
+}
+
+void test_telemetry_csv_export() {
+  FrameTelemetry t;
+  t.config.hitch_ms = 20.0f;
+  t.config.export_path = "test_telemetry.csv";
+  t.config.export_interval_s = 3600.0f;  // Export by hand only
+  const int sim = t.phase("sim");
+  for (int i = 0; i < 10; ++i) {
+    t.add(sim, 2.0f);
+    t.record_frame(i == 0 ? 25.0f : 10.0f);
+  }
+  ASSERT_TRUE(t.export_interval());
+  t.record_frame(10.0f);  // Next interval: frame only
+  ASSERT_TRUE(t.export_interval());
+
+  const std::string csv = read_file("test_telemetry.csv");
+  std::remove("test_telemetry.csv");
+  std::vector<std::string> lines;
+  std::istringstream in(csv);
+  for (std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  ASSERT_TRUE(lines.size() == 4);
+  if (lines.size() != 4)
+    return;
+  ASSERT_TRUE(lines[0].rfind("time_s,phase,frames,p50_ms", 0) == 0);
+  ASSERT_TRUE(lines[1].find(",frame,10,") != std::string::npos);
+  ASSERT_TRUE(lines[1].substr(lines[1].size() - 2) == ",1");  // One hitch
+  ASSERT_TRUE(lines[2].find(",sim,10,") != std::string::npos);
+  ASSERT_TRUE(lines[3].find(",frame,1,") != std::string::npos);
+  ASSERT_TRUE(lines[3].substr(lines[3].size() - 2) == ",0");
+}
+
+// ── Counters Tests ──────────────────────────────────────────────────────────
+
+using qe::core::CounterKind;
+using qe::core::Counters;
+
+void test_counters_frame_sums_and_gauges() {
+  for (int i = 0; i < 3; ++i)
+    QE_COUNTER_ADD("test draws", 2);
+  QE_COUNTER_SET("test level", 5);
+  Counters::end_frame();
+  const int draws = Counters::find("test draws", CounterKind::PerFrame);
+  const int level = Counters::find("test level", CounterKind::Gauge);
+  ASSERT_TRUE(draws >= 0 && level >= 0);
+  ASSERT_NEAR(Counters::last(draws), 6.0, 1e-9);
+  ASSERT_NEAR(Counters::last(level), 5.0, 1e-9);
+
+  // Next frame: the sum restarts, the gauge keeps its level
+  Counters::end_frame();
+  ASSERT_NEAR(Counters::last(draws), 0.0, 1e-9);
+  ASSERT_NEAR(Counters::last(level), 5.0, 1e-9);
+  ASSERT_TRUE(std::string(Counters::name(draws)) == "test draws");
+}
+
+void test_counters_kinds_are_separate() {
+  const int gauge = Counters::id("test pass", CounterKind::Gauge);
+  const int gpu = Counters::id("test pass", CounterKind::GpuTime);
+  ASSERT_TRUE(gauge >= 0 && gpu >= 0 && gauge != gpu);
+  ASSERT_TRUE(Counters::id("test pass", CounterKind::Gauge) == gauge);
+  ASSERT_TRUE(Counters::kind(gpu) == CounterKind::GpuTime);
+  ASSERT_TRUE(Counters::find("test missing", CounterKind::Gauge) == -1);
+  ASSERT_NEAR(Counters::last(-1), 0.0, 1e-9);
+}
+
+void test_counters_concurrent_adds() {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i)
+        QE_COUNTER_ADD("test concurrent", 1);
+    });
+  for (auto& t : threads)
+    t.join();
+  Counters::end_frame();
+  ASSERT_NEAR(Counters::last(Counters::find("test concurrent", CounterKind::PerFrame)), 4000.0,
+              1e-9);
+}
+
+// ── PerfOverlay Tests ───────────────────────────────────────────────────────
+
+using qe::renderer::PerfOverlay;
+
+void test_perf_overlay_glyphs() {
+  using qe::renderer::overlay_glyph;
+  ASSERT_TRUE(overlay_glyph('a') == overlay_glyph('A'));
+  ASSERT_TRUE(overlay_glyph(' ') == 0);
+  ASSERT_TRUE(overlay_glyph('~') == 0);
+  int lit = 0;
+  for (uint16_t g = overlay_glyph('8'); g; g >>= 1)
+    lit += g & 1;
+  ASSERT_TRUE(lit == 13);  // Full 3x5 box minus the two holes
+}
+
+void test_perf_overlay_layout() {
+  Counters::set(Counters::id("frame", CounterKind::CpuTime), 20.0);
+  Counters::end_frame();
+  PerfOverlay overlay;
+  overlay.update(1280, 720);
+  ASSERT_TRUE(overlay.quads() > static_cast<size_t>(PerfOverlay::kGraphFrames));
+  ASSERT_TRUE(overlay.quads() <= PerfOverlay::kMaxQuads);
+
+  // The background comes first and holds every other quad, all on screen
+  const auto& v = overlay.vertices();
+  const float left = v[0].position[0], top = v[0].position[1];
+  const float right = v[3].position[0], bottom = v[3].position[1];
+  bool inside = true;
+  for (const auto& vert : v)
+    inside = inside && vert.position[0] >= left - 1e-5f && vert.position[0] <= right + 1e-5f &&
+             vert.position[1] <= top + 1e-5f && vert.position[1] >= bottom - 1e-5f;
+  ASSERT_TRUE(inside);
+  ASSERT_TRUE(left >= -1.0f && right <= 1.0f && top <= 1.0f && bottom >= -1.0f);
+
+  // 20 ms is over the 16.7 ms budget but under twice it: the newest bar is yellow
+  bool slow_bar = false;
+  for (const auto& vert : v)
+    slow_bar = slow_bar || (vert.color[0] == 0.95f && vert.color[1] == 0.8f);
+  ASSERT_TRUE(slow_bar);
+}
+
+void test_perf_overlay_lists_new_counters() {
+  Counters::end_frame();
+  PerfOverlay overlay;
+  overlay.update(1280, 720);
+  const size_t before = overlay.quads();
+  QE_COUNTER_SET("test overlay row", 42);
+  Counters::end_frame();
+  overlay.update(1280, 720);
+  ASSERT_TRUE(overlay.quads() > before);
+}
+
 // ── Main ────────────────────────────────────────────────────────────────────
 int main() {
   std::cout << "=== QuatEngine Game Tests ===" << std::endl;
@@ -267,6 +962,50 @@ int main() {
   RUN_TEST(test_combat_shoot_miss);
   RUN_TEST(test_combat_accuracy);
 
+  std::cout << "\n--- InputTimeline ---" << std::endl;
+  RUN_TEST(test_input_timeline_splits_motion_by_tick);
+  RUN_TEST(test_input_timeline_orders_late_stamps);
+  RUN_TEST(test_input_timeline_drops_taken_samples);
+  RUN_TEST(test_input_timeline_latency);
+
+  std::cout << "\n--- Profiler ---" << std::endl;
+  RUN_TEST(test_profiler_nested_scopes);
+  RUN_TEST(test_profiler_disabled_records_nothing);
+  RUN_TEST(test_profiler_per_thread_rings);
+  RUN_TEST(test_profiler_track_scope);
+  RUN_TEST(test_profiler_ring_keeps_newest);
+  RUN_TEST(test_profiler_chrome_trace);
+
+  std::cout << "\n--- GpuProfiler ---" << std::endl;
+  RUN_TEST(test_gpu_profiler_without_timer_queries);
+  RUN_TEST(test_gpu_profiler_reads_passes_later);
+  RUN_TEST(test_gpu_profiler_pass_results);
+  RUN_TEST(test_gpu_profiler_drops_frames_instead_of_waiting);
+
+  std::cout << "\n--- AllocTracker ---" << std::endl;
+  RUN_TEST(test_alloc_hooks_installed);
+  RUN_TEST(test_alloc_tag_scope_charges_tag);
+  RUN_TEST(test_alloc_thread_counts_are_per_thread);
+  RUN_TEST(test_alloc_tagged_allocator);
+
+  std::cout << "\n--- FrameTelemetry ---" << std::endl;
+  RUN_TEST(test_log_histogram_precision);
+  RUN_TEST(test_log_histogram_percentiles);
+  RUN_TEST(test_telemetry_phase_stats);
+  RUN_TEST(test_telemetry_discarded_frames_record_nothing);
+  RUN_TEST(test_telemetry_hitch_captures_trace_window);
+  RUN_TEST(test_telemetry_csv_export);
+
+  std::cout << "\n--- Counters ---" << std::endl;
+  RUN_TEST(test_counters_frame_sums_and_gauges);
+  RUN_TEST(test_counters_kinds_are_separate);
+  RUN_TEST(test_counters_concurrent_adds);
+
+  std::cout << "\n--- PerfOverlay ---" << std::endl;
+  RUN_TEST(test_perf_overlay_glyphs);
+  RUN_TEST(test_perf_overlay_layout);
+  RUN_TEST(test_perf_overlay_lists_new_counters);
+
   std::cout << "\n=== Results ===" << std::endl;
   std::cout << "  Total: " << total_assertions << std::endl;
   std::cout << "  Passed: " << passed << std::endl;
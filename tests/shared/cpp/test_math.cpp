@@ -10,15 +10,24 @@
  *   - Quaternion: construction, multiplication, rotation, SLERP edge cases
  *   - Mat4: identity, TRS, perspective, look-at, point/direction transform
  *   - Transform: movement, interpolation, direction vectors
+ *   - Noise: determinism, range, SIMD batches vs. scalar
+ *   - parallel_for: range coverage
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
+#include "core/ByteStream.h"
+#include "core/Parallel.h"
+#include "core/SnapshotRing.h"
 #include "core/Transform.h"
 #include "math/Mat4.h"
+#include "math/Noise.h"
 #include "math/Quaternion.h"
 #include "math/Vec3.h"
 
@@ -475,6 +484,198 @@ void test_transform_matrix() {
   ASSERT_VEC3_EQ(result, 3.0f, 2.0f, 3.0f, EPS);
 }
 
+// ============================================================================
+//  Noise Tests
+// ============================================================================
+
+void test_noise_deterministic_and_seeded() {
+  Noise a(42), b(42), c(43);
+  FractalParams p;
+  int differ = 0;
+  for (int i = 0; i < 64; ++i) {
+    float x = i * 0.37f - 11.0f, y = i * 0.91f + 3.0f;
+    ASSERT_TRUE(a.fbm(x, y, p) == b.fbm(x, y, p));
+    if (a.fbm(x, y, p) != c.fbm(x, y, p))
+      ++differ;
+  }
+  ASSERT_TRUE(differ > 48);
+}
+
+void test_noise_ranges() {
+  Noise n(7);
+  FractalParams p;
+  FractalParams sp;
+  sp.basis = NoiseBasis::Simplex;
+  float lo = 1.0f, hi = -1.0f;
+  for (int i = 0; i < 2000; ++i) {
+    float x = (i % 50) * 0.173f - 4.0f, y = (i / 50) * 0.219f - 4.0f;
+    float v = n.value(x, y), s = n.simplex(x, y), r = n.ridged(x, y, p);
+    ASSERT_TRUE(v >= -1.0f && v <= 1.0f);
+    ASSERT_TRUE(s >= -1.0f && s <= 1.0f);
+    ASSERT_TRUE(r >= 0.0f && r <= 1.0f);
+    float f = n.fbm(x, y, sp);
+    ASSERT_TRUE(f >= -1.0f && f <= 1.0f);
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+  }
+  ASSERT_TRUE(lo < -0.5f && hi > 0.5f);  // Not degenerate
+}
+
+void test_noise_value_continuous_across_cells() {
+  Noise n(3);
+  // Quintic fade: value is continuous at integer lattice lines
+  for (float y : {-2.3f, 0.4f, 5.8f}) {
+    ASSERT_FLOAT_EQ(n.value(1.0f - 1e-4f, y), n.value(1.0f + 1e-4f, y), 1e-3f);
+    ASSERT_FLOAT_EQ(n.value(-3.0f - 1e-4f, y), n.value(-3.0f + 1e-4f, y), 1e-3f);
+  }
+}
+
+void test_noise_batches_match_scalar() {
+  Noise n(99);
+  FractalParams p;
+  p.frequency = 0.05f;
+  const size_t count = 37;  // Not a multiple of 4: exercises the scalar tail
+  std::vector<float> xs(count), ys(count), f(count), r(count), w(count);
+  for (size_t i = 0; i < count; ++i) {
+    xs[i] = static_cast<float>(i) * 3.1f - 60.0f;
+    ys[i] = static_cast<float>(i % 5) * -7.3f + 2.0f;
+  }
+  n.fbm_batch(xs.data(), ys.data(), f.data(), count, p);
+  n.ridged_batch(xs.data(), ys.data(), r.data(), count, p);
+  n.warped_batch(xs.data(), ys.data(), w.data(), count, p, 20.0f);
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_FLOAT_EQ(f[i], n.fbm(xs[i], ys[i], p), 1e-5f);
+    ASSERT_FLOAT_EQ(r[i], n.ridged(xs[i], ys[i], p), 1e-5f);
+    ASSERT_FLOAT_EQ(w[i], n.warped(xs[i], ys[i], p, 20.0f), 1e-4f);
+  }
+}
+
+void test_parallel_for_covers_range_once() {
+  std::vector<int> hits(1000, 0);
+  parallel_for(
+      0, 1000,
+      [&](int lo, int hi) {
+        for (int i = lo; i < hi; ++i)
+          ++hits[i];
+      },
+      10, 4);
+  bool all_once = true;
+  for (int h : hits)
+    all_once = all_once && h == 1;
+  ASSERT_TRUE(all_once);
+
+  int calls = 0;
+  parallel_for(5, 5, [&](int, int) { ++calls; });
+  ASSERT_TRUE(calls == 0);
+}
+
+void test_byte_stream_varints_round_trip() {
+  ASSERT_TRUE(zigzag_encode(0) == 0 && zigzag_encode(-1) == 1);
+  ASSERT_TRUE(zigzag_encode(1) == 2 && zigzag_decode(3) == -2);
+
+  ByteWriter w;
+  w.put_varint(0);
+  ASSERT_TRUE(w.size() == 1);
+  w.put_varint(300);
+  ASSERT_TRUE(w.size() == 3);  // Two 7-bit groups
+  w.put_svarint(-64);
+  w.put_svarint(INT64_MIN);
+  w.put_varint(UINT64_MAX);
+  w.put_f32(-1.5f);
+  w.put_u32(0xDEADBEEFu);
+
+  ByteReader r(w.data());
+  ASSERT_TRUE(r.get_varint() == 0);
+  ASSERT_TRUE(r.get_varint() == 300);
+  ASSERT_TRUE(r.get_svarint() == -64);
+  ASSERT_TRUE(r.get_svarint() == INT64_MIN);
+  ASSERT_TRUE(r.get_varint() == UINT64_MAX);
+  ASSERT_TRUE(r.get_f32() == -1.5f);
+  ASSERT_TRUE(r.get_u32() == 0xDEADBEEFu);
+  ASSERT_TRUE(r.ok() && r.at_end());
+
+  // Reading past the end yields zeros and latches the error
+  ASSERT_TRUE(r.get_u8() == 0 && !r.ok());
+  uint8_t truncated[] = {0x80, 0x80};
+  ByteReader t(truncated, sizeof(truncated));
+  ASSERT_TRUE(t.get_varint() == 0 && !t.ok() && t.at_end());
+}
+
+void test_xor_rle_delta_round_trips_resized_snapshots() {
+  std::vector<uint8_t> older(300, 7), newer(older);
+  newer[10] ^= 0x55;
+  newer[11] ^= 0x01;
+  newer[200] = 9;
+  ByteWriter d;
+  xor_rle_encode(older.data(), older.size(), newer.data(), newer.size(), d);
+  ASSERT_TRUE(d.size() < 16);  // Three changed bytes, not 300
+
+  ByteReader r(d.data());
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(xor_rle_apply(newer.data(), newer.size(), r, out));
+  ASSERT_TRUE(out == older);
+
+  // Snapshots may grow or shrink between pushes
+  std::vector<uint8_t> longer(older);
+  longer.resize(420, 3);
+  for (auto pair : {std::make_pair(&older, &longer), std::make_pair(&longer, &older)}) {
+    d.clear();
+    xor_rle_encode(pair.first->data(), pair.first->size(), pair.second->data(),
+                   pair.second->size(), d);
+    ByteReader rr(d.data());
+    ASSERT_TRUE(xor_rle_apply(pair.second->data(), pair.second->size(), rr, out));
+    ASSERT_TRUE(out == *pair.first);
+  }
+
+  // Runs past the snapshot are rejected
+  uint8_t bad[] = {4, 0, 9, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  ByteReader br(bad, sizeof(bad));
+  ASSERT_TRUE(!xor_rle_apply(newer.data(), 4, br, out));
+}
+
+void test_snapshot_ring_rewinds_and_evicts_oldest() {
+  auto frame = [](int i) {
+    std::vector<uint8_t> f(64, 0);
+    f[0] = static_cast<uint8_t>(i);
+    f[1] = static_cast<uint8_t>(i * 7);
+    f.resize(64 + i % 5, 0xAB);
+    return f;
+  };
+  SnapshotRing ring(4096, 100);
+  ASSERT_TRUE(ring.size() == 0);
+  for (int i = 0; i < 50; ++i)
+    ring.push(frame(i));
+  ASSERT_TRUE(ring.size() == 50);
+  ASSERT_TRUE(ring.delta_bytes() < 50 * 16);
+
+  std::vector<uint8_t> out;
+  bool all_match = true;
+  for (int back = 0; back < 50; ++back)
+    all_match = all_match && ring.restore(back, out) && out == frame(49 - back);
+  ASSERT_TRUE(all_match);
+  ASSERT_TRUE(!ring.restore(50, out));
+
+  ASSERT_TRUE(ring.rewind(10));
+  ASSERT_TRUE(ring.size() == 40 && ring.newest() == frame(39));
+  ring.push(frame(100));
+  ASSERT_TRUE(ring.restore(1, out) && out == frame(39));
+
+  // The entry limit and a small arena both drop the oldest frames first
+  SnapshotRing small(4096, 8);
+  SnapshotRing tight(48, 100);
+  for (int i = 0; i < 40; ++i) {
+    small.push(frame(i));
+    tight.push(frame(i));
+  }
+  ASSERT_TRUE(small.size() == 8);
+  ASSERT_TRUE(small.restore(7, out) && out == frame(32));
+  ASSERT_TRUE(tight.size() > 1 && tight.size() < 40 && tight.delta_bytes() <= 48);
+  all_match = true;
+  for (size_t back = 0; back < tight.size(); ++back)
+    all_match = all_match && tight.restore(back, out) && out == frame(39 - static_cast<int>(back));
+  ASSERT_TRUE(all_match);
+}
+
 // ============================================================================
 //  Main
 // ============================================================================
@@ -530,6 +731,16 @@ int main() {
   RUN_TEST(test_transform_interpolation);
   RUN_TEST(test_transform_matrix);
 
+  std::cout << "\n--- Noise ---" << std::endl;
+  RUN_TEST(test_noise_deterministic_and_seeded);
+  RUN_TEST(test_noise_ranges);
+  RUN_TEST(test_noise_value_continuous_across_cells);
+  RUN_TEST(test_noise_batches_match_scalar);
+  RUN_TEST(test_parallel_for_covers_range_once);
+  RUN_TEST(test_byte_stream_varints_round_trip);
+  RUN_TEST(test_xor_rle_delta_round_trips_resized_snapshots);
+  RUN_TEST(test_snapshot_ring_rewinds_and_evicts_oldest);
+
   std::cout << "\n=== Results ===" << std::endl;
   std::cout << "  Total assertions: " << g_tests_run << std::endl;
   std::cout << "  Passed: " << g_tests_passed << std::endl;